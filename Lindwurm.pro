@@ -22,10 +22,15 @@ SUBDIRS += \
 	lindwurmlib \
 	plugins
 
+# the headless recorder relies on POSIX signals
+unix: SUBDIRS += lindwurm-headless
+
 lindwurm.subdir     = src/lindwurm
 pluginsystem.subdir = src/pluginsystem
 lindwurmlib.subdir  = src/lindwurmlib
 plugins.subdir      = src/plugins
+lindwurm-headless.subdir = src/lindwurm-headless
 
 lindwurm.depends    = pluginsystem lindwurmlib plugins
 plugins.depends     = pluginsystem lindwurmlib
+lindwurm-headless.depends = lindwurmlib
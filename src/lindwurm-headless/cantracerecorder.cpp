@@ -0,0 +1,111 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracerecorder.h"
+
+#include <caninterface/icaninterfacehandle.h>
+#include <caninterface/icaninterfacemanager.h>
+
+#include <QLoggingCategory>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.headless.recorder")
+}
+
+namespace Lindwurm::Headless
+{
+    CanTraceRecorder::CanTraceRecorder(QObject *parent)
+        : QObject(parent)
+    {
+
+    }
+
+    CanTraceRecorder::~CanTraceRecorder()
+    {
+        stop();
+    }
+
+    bool CanTraceRecorder::start(Lib::ICanInterfaceHandleSharedPtr canInterface, const QString &fileName)
+    {
+        stop();
+
+        m_writer = Lib::ICanTraceFileWriter::createWriter(fileName);
+
+        if ( ! m_writer )
+        {
+            qCritical(LOG_TAG) << "Unsupported trace file format:" << fileName;
+            return false;
+        }
+
+        if ( ! m_writer->open(fileName) )
+        {
+            qCritical(LOG_TAG) << "Failed to create" << fileName << ":" << m_writer->errorString();
+            m_writer.reset();
+            return false;
+        }
+
+        m_canInterface      = canInterface;
+        m_fileName          = fileName;
+        m_recordedFrames    = 0;
+
+        connect(m_canInterface.get(), &Lib::ICanInterfaceHandle::framesReceived, this, &CanTraceRecorder::writeFrames);
+        m_canInterface->subscribeAll();
+
+        qInfo(LOG_TAG) << "Recording" << m_canInterface->name() << "to" << fileName;
+
+        return true;
+    }
+
+    void CanTraceRecorder::stop()
+    {
+        if ( m_canInterface )
+        {
+            disconnect(m_canInterface.get(), nullptr, this, nullptr);
+            m_canInterface->unmount();
+            m_canInterface.reset();
+        }
+
+        if ( m_writer )
+        {
+            m_writer->close();
+            m_writer.reset();
+
+            qInfo(LOG_TAG) << "Recorded" << m_recordedFrames << "frames to" << m_fileName;
+        }
+    }
+
+    quint64 CanTraceRecorder::recordedFrames() const
+    {
+        return m_recordedFrames;
+    }
+
+    void CanTraceRecorder::writeFrames(const QVector<QCanBusFrame> &frames, Lib::CanInterfaceIndex sourceInterface)
+    {
+        if ( ! m_writer )
+        {
+            return;
+        }
+
+        const QString interfaceName = Lib::ICanInterfaceManager::instance()->interfaceNameOf(sourceInterface);
+
+        if ( m_writer->writeFrames(frames, interfaceName) )
+        {
+            m_recordedFrames += quint64( frames.size() );
+        }
+    }
+}
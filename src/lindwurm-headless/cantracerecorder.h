@@ -0,0 +1,77 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANTRACERECORDER_H
+#define CANTRACERECORDER_H
+
+#include <caninterface/icaninterfacehandlesharedptr.h>
+#include <caninterface/caninterfaceindex.h>
+#include <cantracefile/icantracefilewriter.h>
+
+#include <QCanBusFrame>
+#include <QObject>
+#include <QVector>
+
+namespace Lindwurm::Headless
+{
+    /**
+     * @brief The CanTraceRecorder class records all frames of a mounted CAN interface to a trace file.
+     *
+     * The frames are written in the batches they are delivered by the interface handle, so no frames are kept
+     * in memory and captures are only limited by the available disk space.
+     */
+    class CanTraceRecorder : public QObject
+    {
+        Q_OBJECT
+        public:
+
+            explicit        CanTraceRecorder(QObject *parent = nullptr);
+                            ~CanTraceRecorder();
+
+            /**
+             * @brief Starts recording the frames of the given interface
+             * @param canInterface  the mounted interface to record.
+             * @param fileName      the trace file, its format is determined by the file extension.
+             * @return `true` if the recording was started.
+             */
+            bool            start(Lib::ICanInterfaceHandleSharedPtr canInterface, const QString &fileName);
+
+            /**
+             * @brief Stops the recording and closes the trace file
+             */
+            void            stop();
+
+            /**
+             * @brief Returns the number of recorded frames
+             * @return the number of recorded frames.
+             */
+            quint64         recordedFrames() const;
+
+        private slots:
+
+            void            writeFrames(const QVector<QCanBusFrame> &frames, Lib::CanInterfaceIndex sourceInterface);
+
+        private:
+
+            Lib::ICanInterfaceHandleSharedPtr   m_canInterface = {};
+            Lib::ICanTraceFileWriterPtr         m_writer = {};
+            QString                             m_fileName = {};
+            quint64                             m_recordedFrames = {0};
+    };
+}
+
+#endif // CANTRACERECORDER_H
@@ -0,0 +1,282 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headlesssession.h"
+#include "cantracerecorder.h"
+
+#include <caninterface/caninterfaceconfig.h>
+#include <caninterface/caninterfaceinfo.h>
+#include <caninterface/caninterfacemanager.h>
+#include <diagnostic/udsecudiscoveryscanner.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QTimer>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.headless.session")
+
+    const char* COMPONENT_NAME = "Headless";
+
+    quint32 toAddress(const QJsonValue &value, quint32 defaultValue)
+    {
+        if ( value.isDouble() )
+        {
+            return quint32( value.toDouble() );
+        }
+
+        bool            valid   = false;
+        const quint32   address = value.toString().toUInt(&valid, 0);
+
+        return valid ? address : defaultValue;
+    }
+}
+
+namespace Lindwurm::Headless
+{
+    HeadlessSession::HeadlessSession(QObject *parent)
+        : QObject(parent)
+    {
+        m_interfaceManager = new Lib::CanInterfaceManager(this);
+    }
+
+    HeadlessSession::~HeadlessSession()
+    {
+        stop();
+    }
+
+    bool HeadlessSession::start(const QString &fileName)
+    {
+        QFile file(fileName);
+
+        if ( ! file.open(QIODevice::ReadOnly) )
+        {
+            qCritical(LOG_TAG) << "Failed to open" << fileName << ":" << file.errorString();
+            return false;
+        }
+
+        QJsonParseError     parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+        if ( ! document.isObject() )
+        {
+            qCritical(LOG_TAG) << "Invalid configuration" << fileName << ":" << parseError.errorString();
+            return false;
+        }
+
+        const QJsonObject config = document.object();
+
+        for (const QJsonValue &value : config.value("interfaces").toArray())
+        {
+            if ( ! addInterface( value.toObject() ) )
+            {
+                return false;
+            }
+        }
+
+        for (const QJsonValue &value : config.value("recorders").toArray())
+        {
+            if ( ! startRecorder( value.toObject() ) )
+            {
+                return false;
+            }
+        }
+
+        for (const QJsonValue &value : config.value("scans").toArray())
+        {
+            if ( ! startScan( value.toObject() ) )
+            {
+                return false;
+            }
+        }
+
+        const int duration = config.value("duration").toInt(0);
+
+        if ( duration > 0 )
+        {
+            QTimer::singleShot(duration * 1000, this, &HeadlessSession::finished);
+        }
+
+        return true;
+    }
+
+    void HeadlessSession::stop()
+    {
+        for (CanTraceRecorder *recorder : qAsConst(m_recorders))
+        {
+            recorder->stop();
+        }
+
+        for (Lib::UdsEcuDiscoveryScanner *scanner : qAsConst(m_scanners))
+        {
+            scanner->unmountCANInterface();
+        }
+
+        // disconnect bridges before their ports
+        for (auto it = m_interfaceIds.crbegin(); it != m_interfaceIds.crend(); ++it)
+        {
+            m_interfaceManager->disconnectInterface(*it);
+        }
+
+        m_interfaceIds.clear();
+    }
+
+    bool HeadlessSession::addInterface(const QJsonObject &config)
+    {
+        Lib::CanInterfaceConfig interfaceConfig;
+
+        interfaceConfig.name                    = config.value("name").toString();
+        interfaceConfig.interfaceType           = config.value("type").toString();
+        interfaceConfig.device                  = config.value("device").toString(interfaceConfig.name);
+        interfaceConfig.bitRate                 = config.value("bitRate").toInt(500000);
+        interfaceConfig.enableFlexibleDataRate  = config.value("flexibleDataRate").toBool(false);
+        interfaceConfig.dataBitRate             = config.value("dataBitRate").toInt(0);
+        interfaceConfig.enableLocalEcho         = config.value("localEcho").toBool(true);
+        interfaceConfig.targetBusLoad           = config.value("targetBusLoad").toInt(0);
+        interfaceConfig.replaySpeed             = config.value("replaySpeed").toDouble(1.0);
+
+        for (const QJsonValue &port : config.value("interfaces").toArray())
+        {
+            const QString portId = interfaceIdOf( port.toString() );
+
+            if ( portId.isEmpty() )
+            {
+                qCritical(LOG_TAG) << "Unknown interface" << port.toString() << "bridged by" << interfaceConfig.name;
+                return false;
+            }
+
+            interfaceConfig.bridgedInterfaces.append(portId);
+        }
+
+        const Lib::ICanInterfaceManager::InterfaceError error = m_interfaceManager->addInterface(interfaceConfig);
+
+        if ( error != Lib::ICanInterfaceManager::InterfaceError::NoError )
+        {
+            qCritical(LOG_TAG) << "Failed to add interface" << interfaceConfig.name << ": error" << int(error);
+            return false;
+        }
+
+        const QString interfaceId = interfaceIdOf(interfaceConfig.name);
+        m_interfaceIds.append(interfaceId);
+
+        if ( config.value("connect").toBool(true) && ! m_interfaceManager->connectInterface(interfaceId) )
+        {
+            qCritical(LOG_TAG) << "Failed to connect interface" << interfaceConfig.name;
+            return false;
+        }
+
+        qInfo(LOG_TAG) << "Added" << interfaceConfig.interfaceType << "interface" << interfaceConfig.name;
+
+        return true;
+    }
+
+    bool HeadlessSession::startRecorder(const QJsonObject &config)
+    {
+        const QString interfaceName = config.value("interface").toString();
+        const QString interfaceId   = interfaceIdOf(interfaceName);
+
+        if ( interfaceId.isEmpty() )
+        {
+            qCritical(LOG_TAG) << "Unknown interface" << interfaceName << "to record";
+            return false;
+        }
+
+        Lib::ICanInterfaceHandleSharedPtr canInterface = m_interfaceManager->mountInterface(interfaceId, COMPONENT_NAME);
+
+        if ( ! canInterface )
+        {
+            qCritical(LOG_TAG) << "Failed to mount interface" << interfaceName;
+            return false;
+        }
+
+        CanTraceRecorder *recorder = new CanTraceRecorder(this);
+        m_recorders.append(recorder);
+
+        return recorder->start( canInterface, config.value("file").toString() );
+    }
+
+    bool HeadlessSession::startScan(const QJsonObject &config)
+    {
+        const QString interfaceName = config.value("interface").toString();
+        const QString interfaceId   = interfaceIdOf(interfaceName);
+
+        if ( interfaceId.isEmpty() )
+        {
+            qCritical(LOG_TAG) << "Unknown interface" << interfaceName << "to scan";
+            return false;
+        }
+
+        Lib::UdsEcuDiscoveryScanner *scanner    = new Lib::UdsEcuDiscoveryScanner(this);
+        const QString               typeName    = config.value("type").toString("Default session");
+
+        if ( ! scanner->scanTypes().contains(typeName) )
+        {
+            qCritical(LOG_TAG) << "Unknown scan type" << typeName << "- available:" << scanner->scanTypes().keys();
+            delete scanner;
+            return false;
+        }
+
+        Lib::ICanInterfaceHandleSharedPtr canInterface = m_interfaceManager->mountInterface(interfaceId, COMPONENT_NAME);
+
+        if ( ! canInterface )
+        {
+            qCritical(LOG_TAG) << "Failed to mount interface" << interfaceName;
+            delete scanner;
+            return false;
+        }
+
+        m_scanners.append(scanner);
+
+        connect(scanner, &Lib::UdsEcuDiscoveryScanner::ecuDiscovered, this, [interfaceName](quint32 sourceAddress, quint32 targetAddress)
+        {
+            qInfo(LOG_TAG) << "Discovered ECU on" << interfaceName
+                           << "- source:" << QString("0x%1").arg(sourceAddress, 0, 16)
+                           << "target:" << QString("0x%1").arg(targetAddress, 0, 16);
+        });
+
+        connect(scanner, &Lib::UdsEcuDiscoveryScanner::discoveryFinished, this, [interfaceName]
+        {
+            qInfo(LOG_TAG) << "Discovery on" << interfaceName << "finished";
+        });
+
+        const quint32 startAddress  = toAddress(config.value("start"), 0x700);
+        const quint32 endAddress    = toAddress(config.value("end"),   0x7FF);
+
+        scanner->mountCANInterface(canInterface);
+        scanner->startDiscovery( startAddress, endAddress, scanner->scanTypes().value(typeName) );
+
+        return true;
+    }
+
+    QString HeadlessSession::interfaceIdOf(const QString &name) const
+    {
+        const QList<Lib::CanInterfaceInfo> interfaces = m_interfaceManager->availableInterfaces();
+
+        for (const Lib::CanInterfaceInfo &info : interfaces)
+        {
+            if ( info.name() == name )
+            {
+                return info.id();
+            }
+        }
+
+        return QString();
+    }
+}
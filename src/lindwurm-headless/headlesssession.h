@@ -0,0 +1,85 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEADLESSSESSION_H
+#define HEADLESSSESSION_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+namespace Lindwurm::Lib
+{
+    class CanInterfaceManager;
+    class UdsEcuDiscoveryScanner;
+}
+
+namespace Lindwurm::Headless
+{
+    class CanTraceRecorder;
+
+    /**
+     * @brief The HeadlessSession class sets up interfaces, recorders and scans from a JSON configuration file.
+     *
+     * The configuration holds the arrays `interfaces`, `recorders` and `scans` and an optional `duration` in
+     * seconds, after which the session finishes. Interfaces are created in the order of the file, so the ports
+     * of a bridge have to be listed before the bridge itself. See `example.json` for all supported keys.
+     */
+    class HeadlessSession : public QObject
+    {
+        Q_OBJECT
+        public:
+
+            explicit        HeadlessSession(QObject *parent = nullptr);
+                            ~HeadlessSession();
+
+            /**
+             * @brief Loads the configuration file and starts all configured interfaces, recorders and scans
+             * @param fileName the name of the JSON configuration file.
+             * @return `true` if the session was started; otherwise the error has been logged.
+             */
+            bool            start(const QString &fileName);
+
+            /**
+             * @brief Stops all recorders and disconnects all interfaces
+             */
+            void            stop();
+
+        signals:
+
+            /**
+             * @brief This signal is emitted when the configured duration has elapsed
+             */
+            void            finished();
+
+        private:
+
+            bool            addInterface(const QJsonObject &config);
+            bool            startRecorder(const QJsonObject &config);
+            bool            startScan(const QJsonObject &config);
+
+            QString         interfaceIdOf(const QString &name) const;
+
+            Lib::CanInterfaceManager*           m_interfaceManager = {nullptr};
+            QList<CanTraceRecorder*>            m_recorders = {};
+            QList<Lib::UdsEcuDiscoveryScanner*> m_scanners = {};
+            QStringList                         m_interfaceIds = {};
+    };
+}
+
+#endif // HEADLESSSESSION_H
@@ -0,0 +1,118 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headlesssession.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSettings>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using Lindwurm::Headless::HeadlessSession;
+
+namespace
+{
+    // SIGINT and SIGTERM are forwarded to the event loop through this socket pair
+    int s_signalSockets[2] = { -1, -1 };
+
+    void handleSignal(int)
+    {
+        // only async-signal-safe calls are allowed here, so a failed write cannot be reported
+        // errno is restored, as the handler may interrupt code which is about to evaluate it
+        const int   savedErrno  = errno;
+        const char  signal      = 1;
+
+        const ssize_t written = ::write(s_signalSockets[0], &signal, sizeof(signal));
+        Q_UNUSED(written);
+
+        errno = savedErrno;
+    }
+
+    bool installSignalHandlers()
+    {
+        if ( ::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalSockets) != 0 )
+        {
+            return false;
+        }
+
+        struct sigaction action = {};
+        action.sa_handler = handleSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+
+        return ::sigaction(SIGINT, &action, nullptr) == 0 && ::sigaction(SIGTERM, &action, nullptr) == 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QSettings::setDefaultFormat( QSettings::IniFormat );
+    QCoreApplication::setOrganizationName("lindwurm");
+    QCoreApplication::setApplicationName("lindwurm-headless");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Records CAN traffic and runs scans without the graphical user interface.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("config", "The JSON configuration file of the session.");
+    parser.process(app);
+
+    if ( parser.positionalArguments().size() != 1 )
+    {
+        parser.showHelp(1);
+    }
+
+    if ( ! installSignalHandlers() )
+    {
+        qCritical() << "Failed to install signal handlers: Abort";
+        return 1;
+    }
+
+    QSocketNotifier signalNotifier(s_signalSockets[1], QSocketNotifier::Read);
+
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, [&signalNotifier]
+    {
+        char signal;
+
+        while ( ::read(int(signalNotifier.socket()), &signal, sizeof(signal)) < 0 && errno == EINTR )
+        {
+            // retry, the signal is pending in the socket
+        }
+
+        QCoreApplication::quit();
+    });
+
+    HeadlessSession session;
+
+    if ( ! session.start( parser.positionalArguments().first() ) )
+    {
+        qCritical() << "Failed to start session: Abort";
+        return 1;
+    }
+
+    QObject::connect(&session, &HeadlessSession::finished, &app, &QCoreApplication::quit);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &session, &HeadlessSession::stop);
+
+    return app.exec();
+}
@@ -32,6 +32,9 @@ namespace Lindwurm::Lib
         , m_updateFrameCounter(0)
         , m_updateFrameLimit(0)
         , m_loopComposing(false)
+        , m_rejectedFrame()
+        , m_frameRejected(false)
+        , m_waitingForTransmitQueue(false)
     {
         m_sendTimer.setSingleShot(false);
         connect(&m_sendTimer, &QTimer::timeout, this, &CanFrameComposer::sendNextFrame);
@@ -42,12 +45,18 @@ namespace Lindwurm::Lib
         unmountCANInterface();
 
         m_canInterface = interface;
+
+        if ( m_canInterface )
+        {
+            connect(m_canInterface.get(), &ICanInterfaceHandle::readyToSend, this, &CanFrameComposer::transmitQueueReady);
+        }
     }
 
     void CanFrameComposer::unmountCANInterface()
     {
         if ( m_canInterface )
         {
+            disconnect(m_canInterface.get(), &ICanInterfaceHandle::readyToSend, this, &CanFrameComposer::transmitQueueReady);
             m_canInterface->unmount();
             m_canInterface.reset();
         }
@@ -80,6 +89,7 @@ namespace Lindwurm::Lib
     void CanFrameComposer::pauseComposing()
     {
         m_sendTimer.stop();
+        m_waitingForTransmitQueue = false;
         emit composingPaused();
     }
 
@@ -92,18 +102,29 @@ namespace Lindwurm::Lib
     void CanFrameComposer::stopComposing()
     {
         m_sendTimer.stop();
+        m_frameRejected             = false;
+        m_waitingForTransmitQueue   = false;
         emit composingFinished();
     }
 
     void CanFrameComposer::sendNextFrame()
     {
-        if ( m_frameComposit.hasNext() )
+        if ( m_frameRejected || m_frameComposit.hasNext() )
         {
-            QCanBusFrame frame = m_frameComposit.next();
+            QCanBusFrame frame = m_frameRejected ? m_rejectedFrame : m_frameComposit.next();
+            m_frameRejected = false;
 
             if ( frame.isValid() )
             {
-                m_canInterface->sendFrame(frame);
+                if ( ! m_canInterface->sendFrame(frame) && m_canInterface->connected() )
+                {
+                    // the transmit queue of the interface is full, so the frame is sent again as soon as it has drained
+                    m_rejectedFrame             = frame;
+                    m_frameRejected             = true;
+                    m_waitingForTransmitQueue   = true;
+                    m_sendTimer.stop();
+                    return;
+                }
 
                 m_updateFrameCounter++;
 
@@ -132,6 +153,20 @@ namespace Lindwurm::Lib
         }
     }
 
+    void CanFrameComposer::transmitQueueReady()
+    {
+        if ( ! m_waitingForTransmitQueue )
+        {
+            return;
+        }
+
+        m_waitingForTransmitQueue = false;
+
+        // the timer is stopped again if the frame gets rejected or the last frame was sent
+        m_sendTimer.start();
+        sendNextFrame();
+    }
+
     void CanFrameComposer::setSendInterval(int interval)
     {
         m_sendTimer.setInterval(interval);
@@ -141,7 +176,7 @@ namespace Lindwurm::Lib
             // if the send interval is below 150 ms we want to send an update signal only every few frames
             // to avoid flooding the GUI thread
 
-            m_updateFrameLimit = 150.0f / interval;
+            m_updateFrameLimit = 150.0f / qMax(interval, 1);
 
             if ( m_frameComposit.frameCount() < m_updateFrameLimit )
             {
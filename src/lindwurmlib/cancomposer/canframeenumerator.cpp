@@ -24,6 +24,14 @@
 namespace
 {
     const int BASE_16 = 16;
+
+    // payload limits of classical CAN and CAN FD frames
+    const int MAX_CLASSIC_PAYLOAD = 8;
+    const int MAX_FD_PAYLOAD = 64;
+
+    // flags following the CAN FD marker of the frame ID, as used by candump
+    const int FD_FLAG_BRS = 0x01;
+    const int FD_FLAG_ESI = 0x02;
     Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.composer")
 }
 
@@ -95,6 +103,13 @@ namespace Lindwurm::Lib
             }
         }
 
+        if ( m_flexibleDataRate || frame.payload().size() > MAX_CLASSIC_PAYLOAD )
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(m_bitrateSwitch);
+            frame.setErrorStateIndicator(m_errorStateIndicator);
+        }
+
         return frame;
     }
 
@@ -116,6 +131,12 @@ namespace Lindwurm::Lib
             return false;
         }
 
+        if ( ! parseFrameFormat( frameElements[0] ) )
+        {
+            qCritical(LOG_TAG) << "Failed to parse CAN FD flags of frame ID";
+            return false;
+        }
+
         if ( ! parseFrameID( frameElements.at(0) ) )
         {
             qCritical(LOG_TAG) << "Failed to parse frame ID";
@@ -159,6 +180,46 @@ namespace Lindwurm::Lib
         m_dynamicPayload.reset();
     }
 
+    bool CanFrameEnumerator::parseFrameFormat(QString &idElement)
+    {
+        m_flexibleDataRate      = false;
+        m_bitrateSwitch         = false;
+        m_errorStateIndicator   = false;
+
+        const int fdMarker = idElement.indexOf("##");
+
+        if ( fdMarker < 0 )
+        {
+            return true;
+        }
+
+        const QString flagsElement = idElement.mid(fdMarker + 2);
+
+        // the frame ID is parsed without the marker
+        idElement.truncate(fdMarker);
+
+        m_flexibleDataRate = true;
+
+        if ( flagsElement.isEmpty() )
+        {
+            return true;
+        }
+
+        bool toIntOk;
+        const int flags = flagsElement.toInt(&toIntOk, BASE_16);
+
+        if ( ! toIntOk || flagsElement.size() != 1 )
+        {
+            qCritical(LOG_TAG) << "Invalid CAN FD flags at: " << flagsElement;
+            return false;
+        }
+
+        m_bitrateSwitch         = flags & FD_FLAG_BRS;
+        m_errorStateIndicator   = flags & FD_FLAG_ESI;
+
+        return true;
+    }
+
     bool CanFrameEnumerator::parseFrameID(const QString &idElement)
     {
         bool toIntOk;
@@ -241,6 +302,12 @@ namespace Lindwurm::Lib
             m_staticPayload.append(payloadByte);
         }
 
+        if ( m_staticPayload.size() > MAX_FD_PAYLOAD )
+        {
+            qCritical(LOG_TAG) << "A frame cannot have more than" << MAX_FD_PAYLOAD << "bytes of payload!";
+            return false;
+        }
+
         return true;
     }
 }
@@ -17,12 +17,27 @@
 
 #include "caninterface/abstractcaninterface.h"
 
+#include <QMutexLocker>
+#include <QMetaMethod>
+
+#include <array>
+
+namespace
+{
+    // minimum interval between two samples the rates of the statistics are averaged over
+    const qint64 STATISTICS_SAMPLE_NSECS = 500000000;
+}
+
 namespace Lindwurm::Lib
 {
     AbstractCanInterface::AbstractCanInterface(const QString &id, const QString &interfaceType, const QString &device)
         : ICanInterface(), m_id(id), m_interfaceType(interfaceType), m_device(device)
     {
+        // frames are passed from the I/O threads by queued connections
+        qRegisterMetaType<QVector<QCanBusFrame>>();
+        qRegisterMetaType<CanInterfaceIndex>("CanInterfaceIndex");
 
+        m_statisticsClock.start();
     }
 
     QString AbstractCanInterface::id() const
@@ -32,9 +47,17 @@ namespace Lindwurm::Lib
 
     QString AbstractCanInterface::name() const
     {
+        // the name is also read by the I/O thread when dispatching frames
+        QMutexLocker locker( &m_nameMutex );
+
         return m_name;
     }
 
+    CanInterfaceIndex AbstractCanInterface::interfaceIndex() const
+    {
+        return m_interfaceIndex;
+    }
+
     QString AbstractCanInterface::interfaceType() const
     {
         return m_interfaceType;
@@ -47,9 +70,16 @@ namespace Lindwurm::Lib
 
     void AbstractCanInterface::setName(const QString &name)
     {
+        QMutexLocker locker( &m_nameMutex );
+
         m_name = name;
     }
 
+    void AbstractCanInterface::setInterfaceIndex(CanInterfaceIndex interfaceIndex)
+    {
+        m_interfaceIndex = interfaceIndex;
+    }
+
     void AbstractCanInterface::mountComponent(const QString &component)
     {
         // don't mount components twice
@@ -73,8 +103,391 @@ namespace Lindwurm::Lib
     {
         return m_mountedComponents;
     }
-}
 
+    void AbstractCanInterface::attachReceiver(const CanFrameReceiverSharedPtr &receiver)
+    {
+        QMutexLocker locker( &m_receiversMutex );
+
+        if ( ! m_receivers.contains(receiver) )
+        {
+            m_receivers.append(receiver);
+            updateFrameFilters();
+        }
+    }
+
+    void AbstractCanInterface::detachReceiver(const CanFrameReceiverSharedPtr &receiver)
+    {
+        QMutexLocker locker( &m_receiversMutex );
+
+        m_receivers.removeAll(receiver);
+        updateFrameFilters();
+    }
+
+    void AbstractCanInterface::setReceiverFilters(const CanFrameReceiverSharedPtr &receiver, const CanIdFilters &filters)
+    {
+        QMutexLocker locker( &m_receiversMutex );
 
+        // the receiver's filters are read while delivering, which is also done with locked mutex
+        receiver->setFilters(filters);
+        updateFrameFilters();
+    }
 
+    bool AbstractCanInterface::sendFrame(const QCanBusFrame &frame)
+    {
+        return sendFrames( QVector<QCanBusFrame>{frame} ) == 1;
+    }
+
+    int AbstractCanInterface::sendFrames(const QVector<QCanBusFrame> &frames)
+    {
+        if ( frames.isEmpty() || ! connected() )
+        {
+            return 0;
+        }
+
+        const int acceptedCount = m_transmitQueue.enqueue(frames);
+
+        if ( acceptedCount > 0 )
+        {
+            transmitQueuedFrames();
+        }
+
+        notifyTransmitQueue(false);
+
+        return acceptedCount;
+    }
+
+    int AbstractCanInterface::transmitQueueDepth() const
+    {
+        return m_transmitQueue.depth();
+    }
 
+    CanTransmitStatistics AbstractCanInterface::transmitStatistics() const
+    {
+        return m_transmitQueue.statistics();
+    }
+
+    CanInterfaceStatistics AbstractCanInterface::statistics() const
+    {
+        CanInterfaceStatistics statistics;
+
+        const CanTransmitStatistics transmitStatistics = m_transmitQueue.statistics();
+
+        statistics.rxFrames         = m_rxFrames;
+        statistics.rxBytes          = m_rxBytes;
+        statistics.txFrames         = m_txFrames;
+        statistics.txBytes          = m_txBytes;
+        statistics.errorFrames      = m_errorFrames;
+        statistics.txFailures       = transmitStatistics.failedFrames;
+        statistics.txDroppedFrames  = transmitStatistics.droppedFrames;
+        statistics.rxOverflowFrames = m_overflowFrames;
+
+        const quint64 busTimeNSecs  = m_busTimeNSecs;
+
+        {
+            QMutexLocker locker( &m_receiversMutex );
+
+            for (const CanFrameReceiverSharedPtr &receiver : m_receivers)
+            {
+                statistics.receiverDroppedFrames += receiver->droppedFrameCount();
+            }
+        }
+
+        QMutexLocker locker( &m_statisticsMutex );
+
+        const qint64 nowNSecs       = m_statisticsClock.nsecsElapsed();
+        const qint64 intervalNSecs  = nowNSecs - m_statisticsSample.timeNSecs;
+
+        // the rates are only updated once the interval is long enough to average over, so they don't
+        // depend on how often the statistics are read
+        if ( intervalNSecs >= STATISTICS_SAMPLE_NSECS )
+        {
+            const double intervalSecs = double(intervalNSecs) / 1000000000.0;
+
+            m_statisticsRates.rxFramesPerSecond = double(statistics.rxFrames - m_statisticsSample.rxFrames) / intervalSecs;
+            m_statisticsRates.rxBytesPerSecond  = double(statistics.rxBytes  - m_statisticsSample.rxBytes)  / intervalSecs;
+            m_statisticsRates.txFramesPerSecond = double(statistics.txFrames - m_statisticsSample.txFrames) / intervalSecs;
+            m_statisticsRates.txBytesPerSecond  = double(statistics.txBytes  - m_statisticsSample.txBytes)  / intervalSecs;
+
+            if ( m_transmitScheduler.bitRate() > 0 )
+            {
+                // the worst case bit stuffing slightly overestimates the load, which must not exceed the bus
+                m_statisticsRates.busLoad = qMin( double(busTimeNSecs - m_statisticsSample.busTimeNSecs) * 100.0 / double(intervalNSecs), 100.0 );
+            }
+            else
+            {
+                m_statisticsRates.busLoad = -1.0;
+            }
+
+            m_statisticsSample.timeNSecs    = nowNSecs;
+            m_statisticsSample.rxFrames     = statistics.rxFrames;
+            m_statisticsSample.rxBytes      = statistics.rxBytes;
+            m_statisticsSample.txFrames     = statistics.txFrames;
+            m_statisticsSample.txBytes      = statistics.txBytes;
+            m_statisticsSample.busTimeNSecs = busTimeNSecs;
+        }
+
+        statistics.rxFramesPerSecond    = m_statisticsRates.rxFramesPerSecond;
+        statistics.rxBytesPerSecond     = m_statisticsRates.rxBytesPerSecond;
+        statistics.txFramesPerSecond    = m_statisticsRates.txFramesPerSecond;
+        statistics.txBytesPerSecond     = m_statisticsRates.txBytesPerSecond;
+        statistics.busLoad              = m_statisticsRates.busLoad;
+
+        return statistics;
+    }
+
+    int AbstractCanInterface::targetBusLoad() const
+    {
+        return m_transmitScheduler.targetBusLoad();
+    }
+
+    void AbstractCanInterface::setTargetBusLoad(int percent)
+    {
+        m_transmitScheduler.setTargetBusLoad(percent);
+
+        // frames held back by the previous limit are sent at the new pace
+        transmitQueuedFrames();
+    }
+
+    QVector<QCanBusFrame> AbstractCanInterface::peekTransmitQueue(int maxCount) const
+    {
+        return m_transmitQueue.peek(maxCount);
+    }
+
+    bool AbstractCanInterface::acknowledgeTransmittedFrames(int writtenCount, int failedCount)
+    {
+        QVector<QCanBusFrame> writtenFrames;
+
+        const bool drained = m_transmitQueue.acknowledge(writtenCount, failedCount, &writtenFrames);
+
+        countFrames(writtenFrames, false);
+
+        return drained;
+    }
+
+    void AbstractCanInterface::countOverflowFrames(quint64 droppedCount)
+    {
+        m_overflowFrames.fetch_add(droppedCount, std::memory_order_relaxed);
+    }
+
+    void AbstractCanInterface::clearTransmitQueue()
+    {
+        // senders waiting for the queue to drain are woken up, their frames are rejected now as the interface is disconnected
+        notifyTransmitQueue( m_transmitQueue.clear() );
+    }
+
+    void AbstractCanInterface::notifyTransmitQueue(bool drained)
+    {
+        if ( isSignalConnected( QMetaMethod::fromSignal(&ICanInterface::transmitQueueDepthChanged) ) )
+        {
+            emit transmitQueueDepthChanged( m_transmitQueue.depth() );
+        }
+
+        if ( drained )
+        {
+            emit readyToSend();
+        }
+    }
+
+    void AbstractCanInterface::applyFrameFilters(const CanIdFilters &filters)
+    {
+        Q_UNUSED(filters)
+    }
+
+    void AbstractCanInterface::countFrames(const QVector<QCanBusFrame> &frames, bool received)
+    {
+        if ( frames.isEmpty() )
+        {
+            return;
+        }
+
+        const int bitRate       = m_transmitScheduler.bitRate();
+        const int dataBitRate   = m_transmitScheduler.dataBitRate();
+
+        quint64 frameCount      = 0;
+        quint64 byteCount       = 0;
+        quint64 errorCount      = 0;
+        quint64 busTimeNSecs    = 0;
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            if ( frame.frameType() == QCanBusFrame::ErrorFrame )
+            {
+                errorCount++;
+                continue;
+            }
+
+            if ( received && frame.hasLocalEcho() )
+            {
+                // already counted when it was written
+                continue;
+            }
+
+            frameCount++;
+            byteCount += quint64( frame.payload().size() );
+
+            if ( bitRate > 0 )
+            {
+                busTimeNSecs += quint64( CanTransmitScheduler::frameDurationNSecs(frame, bitRate, dataBitRate) );
+            }
+        }
+
+        // one atomic update per counter and batch keeps the overhead in the I/O threads low
+        std::atomic<quint64> &frameCounter  = received ? m_rxFrames : m_txFrames;
+        std::atomic<quint64> &byteCounter   = received ? m_rxBytes : m_txBytes;
+
+        frameCounter.fetch_add(frameCount, std::memory_order_relaxed);
+        byteCounter.fetch_add(byteCount, std::memory_order_relaxed);
+        m_errorFrames.fetch_add(errorCount, std::memory_order_relaxed);
+        m_busTimeNSecs.fetch_add(busTimeNSecs, std::memory_order_relaxed);
+    }
+
+    void AbstractCanInterface::updateFrameFilters()
+    {
+        // called with locked receivers mutex
+        for (int slot = 0; slot < CanFrameDispatchTable::MaxSubscribers; slot++)
+        {
+            if ( slot < m_receivers.size() )
+            {
+                m_dispatchTable.setSubscriber( slot, m_receivers.at(slot)->filters() );
+            }
+            else
+            {
+                m_dispatchTable.removeSubscriber(slot);
+            }
+        }
+
+        CanIdFilters frameFilters;
+
+        for (const CanFrameReceiverSharedPtr &receiver : qAsConst(m_receivers) )
+        {
+            const CanIdFilters receiverFilters = receiver->filters();
+
+            if ( receiverFilters.isEmpty() )
+            {
+                // at least one receiver is interested in all frames
+                frameFilters.clear();
+                break;
+            }
+
+            for (const CanIdFilter &filter : receiverFilters)
+            {
+                if ( ! frameFilters.contains(filter) )
+                {
+                    frameFilters.append(filter);
+                }
+            }
+        }
+
+        if ( frameFilters != m_frameFilters )
+        {
+            m_frameFilters = frameFilters;
+            applyFrameFilters(m_frameFilters);
+        }
+    }
+
+    void AbstractCanInterface::deliverFiltered(const CanFrameReceiverSharedPtr &receiver, const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
+    {
+        const CanIdFilters filters = receiver->filters();
+
+        if ( filters.isEmpty() )
+        {
+            receiver->deliver(frames, sourceInterface);
+            return;
+        }
+
+        QVector<QCanBusFrame> filteredFrames;
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            for (const CanIdFilter &filter : filters)
+            {
+                if ( filter.matches(frame) )
+                {
+                    filteredFrames.append(frame);
+                    break;
+                }
+            }
+        }
+
+        if ( ! filteredFrames.isEmpty() )
+        {
+            receiver->deliver(filteredFrames, sourceInterface);
+        }
+    }
+
+    void AbstractCanInterface::dispatchFrames(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
+    {
+        if ( frames.isEmpty() )
+        {
+            return;
+        }
+
+        countFrames(frames, true);
+
+        {
+            // the mutex is only contended while attaching or detaching a receiver
+            // holding it while delivering guarantees a single producer per receiver
+            QMutexLocker locker( &m_receiversMutex );
+
+            const int       receiverCount       = m_receivers.size();
+            const int       tableReceiverCount  = qMin( receiverCount, int(CanFrameDispatchTable::MaxSubscribers) );
+            const quint64   tableReceivers      = (tableReceiverCount == CanFrameDispatchTable::MaxSubscribers) ? ~quint64(0) : (quint64(1) << tableReceiverCount) - 1;
+            const quint64   allFramesReceivers  = m_dispatchTable.allFramesSubscribers();
+
+            // receivers interested in all frames share the received batch
+            std::array<QVector<QCanBusFrame>, CanFrameDispatchTable::MaxSubscribers> receiverFrames;
+
+            if ( (tableReceivers & ~allFramesReceivers) != 0 )
+            {
+                for (const QCanBusFrame &frame : frames)
+                {
+                    quint64 frameReceivers = m_dispatchTable.subscribers( frame.frameId() ) & ~allFramesReceivers;
+
+                    while ( frameReceivers != 0 )
+                    {
+                        receiverFrames[ qCountTrailingZeroBits(frameReceivers) ].append(frame);
+                        frameReceivers &= frameReceivers - 1;
+                    }
+                }
+            }
+
+            for (int slot = 0; slot < tableReceiverCount; slot++)
+            {
+                if ( allFramesReceivers & (quint64(1) << slot) )
+                {
+                    m_receivers.at(slot)->deliver(frames, sourceInterface);
+                }
+                else if ( ! receiverFrames[slot].isEmpty() )
+                {
+                    m_receivers.at(slot)->deliver(receiverFrames[slot], sourceInterface);
+                }
+            }
+
+            for (int i = tableReceiverCount; i < receiverCount; i++)
+            {
+                // receivers exceeding the dispatch table are filtered one by one
+                deliverFiltered(m_receivers.at(i), frames, sourceInterface);
+            }
+        }
+
+        if ( isSignalConnected( QMetaMethod::fromSignal(&ICanInterface::framesReceived) ) )
+        {
+            emit framesReceived(frames, sourceInterface);
+        }
+    }
+
+    bool AbstractCanInterface::receiversBacklogged() const
+    {
+        QMutexLocker locker( &m_receiversMutex );
+
+        for (const CanFrameReceiverSharedPtr &receiver : m_receivers)
+        {
+            if ( receiver->pendingBatchCount() * 2 >= receiver->capacity() )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
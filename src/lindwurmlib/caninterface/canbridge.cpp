@@ -16,25 +16,86 @@
  */
 
 #include "caninterface/canbridge.h"
+#include "canroutingtable.h"
 
 #include <QDebug>
 #include <QLoggingCategory>
 
+#include <chrono>
+#include <cmath>
+
 namespace
 {
     Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
+
+    const int TRANSMIT_BATCH_SIZE = 256;
 }
 
 namespace Lindwurm::Lib
 {
+    int CanBridgeLatencyHistogram::bucketIndex(qint64 latencyUSecs)
+    {
+        int index = 0;
+
+        while ( latencyUSecs > 0 && index < BucketCount - 1 )
+        {
+            latencyUSecs >>= 1;
+            index++;
+        }
+
+        return index;
+    }
+
+    qint64 CanBridgeLatencyHistogram::percentileUSecs(double fraction) const
+    {
+        if ( frameCount == 0 )
+        {
+            return 0;
+        }
+
+        const quint64 threshold = quint64( std::ceil( fraction * double(frameCount) ) );
+        quint64 count = 0;
+
+        for (int i = 0; i < BucketCount - 1; i++)
+        {
+            count += buckets[i];
+
+            if ( count >= threshold )
+            {
+                return qint64(1) << i;
+            }
+        }
+
+        return maxLatencyUSecs;
+    }
+
     CanBridge::CanBridge(const QString &id)
         : AbstractCanInterface(id, "bridge", "")
+        , m_routingTable( std::make_shared<const CanRoutingTable>(CanRoutingRules(), CanRoutingAction::Forward, QStringList()) )
     {
+        // the forwarding thread only runs the event loop the receivers post their notifications to
+        m_forwardingContext = new QObject();
+        m_forwardingContext->moveToThread(&m_forwardingThread);
 
+        m_forwardingThread.setObjectName( QString("CAN bridge %1").arg(id) );
+        m_forwardingThread.start();
     }
 
     CanBridge::~CanBridge()
     {
+        {
+            QMutexLocker locker( &m_portsMutex );
+
+            for (const BridgePort &port : qAsConst(m_ports) )
+            {
+                port.interface->detachReceiver(port.receiver);
+            }
+        }
+
+        m_forwardingThread.quit();
+        m_forwardingThread.wait();
+
+        delete m_forwardingContext;
     }
 
     bool CanBridge::connected() const
@@ -51,78 +112,308 @@ namespace Lindwurm::Lib
     bool CanBridge::disconnectInterface()
     {
         m_bridgeConnected = false;
+
+        {
+            QMutexLocker transmitLocker( &m_transmitMutex );
+            QMutexLocker locker( &m_portsMutex );
+
+            for (const BridgePort &port : qAsConst(m_ports) )
+            {
+                port.backlog->clear();
+            }
+        }
+
+        clearTransmitQueue();
+
+        for (const CanBridgeLatencyHistogram &histogram : forwardingLatencies() )
+        {
+            if ( histogram.frameCount > 0 )
+            {
+                qInfo(LOG_TAG).nospace() << "Bridge " << m_name << " forwarded " << histogram.frameCount << " frames from "
+                                         << histogram.sourceInterfaceId << " to " << histogram.targetInterfaceId
+                                         << " (latency p50 <= " << histogram.percentileUSecs(0.5) << " us, p99 <= "
+                                         << histogram.percentileUSecs(0.99) << " us, max " << histogram.maxLatencyUSecs << " us)";
+            }
+        }
+
         return true;
     }
 
-    bool CanBridge::sendFrame(const QCanBusFrame &frame)
+    void CanBridge::transmitQueuedFrames()
     {
-        if ( ! m_bridgeConnected )
+        // one sender at a time passes the queued frames on, the ports are not locked while sending to them,
+        // as a port may emit readyToSend() or deliver frames to the bridge while taking them
+        QMutexLocker transmitLocker( &m_transmitMutex );
+
+        QVector<BridgePort> ports;
+
         {
-            return false;
+            QMutexLocker locker( &m_portsMutex );
+            ports = m_ports;
         }
 
-        for (const ICanInterfaceSharedPtr &interface : qAsConst(m_mountedInterfaces) )
+        bool drained = false;
+
+        forever
         {
-            interface->sendFrame(frame);
+            // frames rejected by a port are retried before further frames are taken from the queue,
+            // so each port gets every frame exactly once and in order
+            bool backlogged = false;
+
+            for (const BridgePort &port : qAsConst(ports) )
+            {
+                QVector<QCanBusFrame> &backlog = *port.backlog;
+
+                if ( backlog.isEmpty() )
+                {
+                    continue;
+                }
+
+                if ( ! port.interface->connected() )
+                {
+                    // a disconnected port would stall the bridge, so its frames are dropped
+                    backlog.clear();
+                    continue;
+                }
+
+                backlog.remove( 0, port.interface->sendFrames(backlog) );
+                backlogged = backlogged || ! backlog.isEmpty();
+            }
+
+            if ( backlogged )
+            {
+                // retried as soon as the full port emits readyToSend()
+                break;
+            }
+
+            const QVector<QCanBusFrame> frames = peekTransmitQueue(TRANSMIT_BATCH_SIZE);
+
+            if ( frames.isEmpty() )
+            {
+                break;
+            }
+
+            for (const BridgePort &port : qAsConst(ports) )
+            {
+                *port.backlog = frames;
+            }
+
+            drained |= acknowledgeTransmittedFrames( frames.size() );
         }
 
-        return true;
+        transmitLocker.unlock();
+
+        notifyTransmitQueue(drained);
     }
 
     QString CanBridge::device() const
     {
+        QMutexLocker locker( &m_portsMutex );
         QString bridgedInterfaces;
 
-        for ( const ICanInterfaceSharedPtr &interface : m_mountedInterfaces )
+        for ( const BridgePort &port : m_ports )
         {
             if ( bridgedInterfaces.isEmpty() )
             {
-                bridgedInterfaces.append( interface->name() );
+                bridgedInterfaces.append( port.interface->name() );
             }
             else
             {
-                bridgedInterfaces.append( "|" + interface->name() );
+                bridgedInterfaces.append( "|" + port.interface->name() );
             }
         }
 
         return bridgedInterfaces;
     }
 
-    void CanBridge::frameReceivedForBridge(const QCanBusFrame &frame, const QString &sourceInterface)
+    void CanBridge::forwardFrames(const CanFrameReceiver *receiver)
     {
-        if ( ! m_bridgeConnected )
+        // executed in the forwarding thread
+        QVector<CanFrameBatch> batches;
+
+        // the frames of a batch routed to one target port, they are sent after unlocking the ports, as the target
+        // may emit readyToSend() or deliver frames to the bridge while taking them
+        struct ForwardedFrames
+        {
+            int                     targetPort;
+            QVector<QCanBusFrame>   frames;
+            qint64                  deliveredNSecs;
+        };
+
+        QVector<ForwardedFrames>        forwardedFrames;
+        QVector<ICanInterfaceSharedPtr> portInterfaces;
+        int                             sourcePort = -1;
+
         {
-            return;
+            QMutexLocker locker( &m_portsMutex );
+
+            const int portCount = m_ports.size();
+
+            for (int i = 0; i < portCount; i++)
+            {
+                if ( m_ports.at(i).receiver.get() == receiver )
+                {
+                    sourcePort = i;
+                    break;
+                }
+            }
+
+            if ( sourcePort < 0 )
+            {
+                // the interface was unmounted meanwhile
+                return;
+            }
+
+            batches = m_ports.at(sourcePort).receiver->takeBatches();
+
+            if ( ! m_bridgeConnected )
+            {
+                return;
+            }
+
+            for (const BridgePort &port : qAsConst(m_ports) )
+            {
+                portInterfaces.append(port.interface);
+            }
+
+            const CanRoutingTable &routingTable = *m_routingTable;
+
+            // the frames of a batch are queued per target port at once
+            QVector<QVector<QCanBusFrame>> targetFrames(portCount);
+
+            for (const CanFrameBatch &batch : qAsConst(batches) )
+            {
+                for (const QCanBusFrame &frame : batch.frames)
+                {
+                    if ( frame.hasLocalEcho() )
+                    {
+                        // this is a frame which was (probably) send by this bride
+                        // ignore to avoid a loop
+                        continue;
+                    }
+
+                    for (int targetPort = 0; targetPort < portCount; targetPort++)
+                    {
+                        if ( targetPort == sourcePort )
+                        {
+                            continue;
+                        }
+
+                        quint32 frameId = frame.frameId();
+
+                        if ( ! routingTable.route(sourcePort, targetPort, frame.hasExtendedFrameFormat(), frameId) )
+                        {
+                            continue;
+                        }
+
+                        if ( frameId == frame.frameId() )
+                        {
+                            targetFrames[targetPort].append(frame);
+                        }
+                        else
+                        {
+                            QCanBusFrame remappedFrame = frame;
+                            remappedFrame.setFrameId(frameId);
+
+                            targetFrames[targetPort].append(remappedFrame);
+                        }
+                    }
+                }
+
+                for (int targetPort = 0; targetPort < portCount; targetPort++)
+                {
+                    if ( ! targetFrames.at(targetPort).isEmpty() )
+                    {
+                        forwardedFrames.append( ForwardedFrames{ targetPort, targetFrames.at(targetPort), batch.deliveredNSecs } );
+                        targetFrames[targetPort].clear();
+                    }
+                }
+            }
         }
 
-        emit frameReceived(frame, sourceInterface);
+        // the latency of each forwarded batch, recorded after sending
+        QVector<qint64> latenciesUSecs;
+        latenciesUSecs.reserve( forwardedFrames.size() );
 
-        if ( frame.hasLocalEcho() )
+        for (const ForwardedFrames &forwarded : qAsConst(forwardedFrames) )
         {
-            // this is a frame which was (probably) send by this bride
-            // ignore to avoid a loop
-            return;
+            // frames rejected by a full transmit queue are counted as dropped by the target interface
+            portInterfaces.at(forwarded.targetPort)->sendFrames(forwarded.frames);
+
+            // measured on the steady clock from the delivery by the source interface, as the frame
+            // timestamps may be taken by a driver or the hardware or even be recorded
+            const qint64 nowNSecs = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+            latenciesUSecs.append( ( nowNSecs - forwarded.deliveredNSecs ) / 1000 );
         }
 
-        for (const ICanInterfaceSharedPtr &interface : qAsConst(m_mountedInterfaces) )
+        if ( ! forwardedFrames.isEmpty() )
         {
-            if ( interface->name() != sourceInterface )
+            QMutexLocker locker( &m_portsMutex );
+
+            const int portCount = m_ports.size();
+
+            // unless a port was mounted or unmounted meanwhile, which has reset the histograms
+            bool portsUnchanged = portCount == portInterfaces.size();
+
+            for (int i = 0; portsUnchanged && i < portCount; i++)
             {
-                interface->sendFrame(frame);
+                portsUnchanged = m_ports.at(i).interface == portInterfaces.at(i);
+            }
+
+            for (int i = 0; portsUnchanged && i < forwardedFrames.size(); i++)
+            {
+                const ForwardedFrames   &forwarded      = forwardedFrames.at(i);
+                const qint64             latencyUSecs   = latenciesUSecs.at(i);
+                const int                frameCount     = forwarded.frames.size();
+
+                CanBridgeLatencyHistogram &histogram = m_forwardingLatencies[sourcePort * portCount + forwarded.targetPort];
+
+                histogram.frameCount += frameCount;
+                histogram.maxLatencyUSecs = qMax( histogram.maxLatencyUSecs, latencyUSecs );
+                histogram.buckets[ CanBridgeLatencyHistogram::bucketIndex(latencyUSecs) ] += frameCount;
             }
         }
+
+        // the frames are passed to the handles of the bridge after forwarding them, so they do not delay forwarding
+        for (const CanFrameBatch &batch : qAsConst(batches) )
+        {
+            dispatchFrames(batch.frames, batch.sourceInterface);
+        }
     }
 
     bool CanBridge::mountInterface(const ICanInterfaceSharedPtr &interface)
     {
-        if ( m_mountedInterfaces.contains(interface) )
+        QMutexLocker locker( &m_portsMutex );
+
+        for (const BridgePort &port : qAsConst(m_ports) )
         {
-            qWarning(LOG_TAG) << "Interface already connected to this bridge";
-            return false;
+            if ( port.interface == interface )
+            {
+                qWarning(LOG_TAG) << "Interface already connected to this bridge";
+                return false;
+            }
         }
 
-        connect(interface.get(), &ICanInterface::frameReceived, this, &CanBridge::frameReceivedForBridge);
-        m_mountedInterfaces.append(interface);
+        BridgePort port;
+
+        port.interface  = interface;
+        port.receiver   = std::make_shared<CanFrameReceiver>(m_forwardingContext, nullptr);
+        port.backlog    = std::make_shared<QVector<QCanBusFrame>>();
+
+        // the receiver must not own itself through its callback, so it is identified by its address
+        const CanFrameReceiver *receiver = port.receiver.get();
+        port.receiver->setFramesAvailableCallback( [this, receiver]() { forwardFrames(receiver); } );
+
+        m_ports.append(port);
+        m_routingTable = compileRoutingTable();
+        resetForwardingLatencies();
+
+        interface->attachReceiver(port.receiver);
+
+        // frames held back by a full port are passed on in the forwarding thread as soon as the port has drained,
+        // always queued, as the port may emit the signal in the forwarding thread while frames are sent to it
+        connect( interface.get(), &ICanInterface::readyToSend, m_forwardingContext, [this]() { transmitQueuedFrames(); }, Qt::QueuedConnection );
 
         // TODO: This label is displayed to the user when trying to delete a mounted interface. It would be better
         // to display the name of the bridge, the interfaces is mounted to. However, because the name is changeable
@@ -141,8 +432,21 @@ namespace Lindwurm::Lib
             return false;
         }
 
-        m_mountedInterfaces.removeAll(interface);
-        disconnect(interface.get(), &ICanInterface::frameReceived, this, &CanBridge::frameReceivedForBridge);
+        QMutexLocker locker( &m_portsMutex );
+
+        for (int i = 0; i < m_ports.size(); i++)
+        {
+            if ( m_ports.at(i).interface == interface )
+            {
+                interface->detachReceiver( m_ports.at(i).receiver );
+                disconnect( interface.get(), &ICanInterface::readyToSend, m_forwardingContext, nullptr );
+                m_ports.remove(i);
+                break;
+            }
+        }
+
+        m_routingTable = compileRoutingTable();
+        resetForwardingLatencies();
         interface->unmountComponent( "bridge." + id() );
 
         return true;
@@ -150,28 +454,131 @@ namespace Lindwurm::Lib
 
     QStringList CanBridge::bridgedInterfaceIds() const
     {
+        QMutexLocker locker( &m_portsMutex );
         QStringList bridgedInterfaceIDs;
 
-        for ( const ICanInterfaceSharedPtr &interface : m_mountedInterfaces )
+        for ( const BridgePort &port : m_ports )
         {
-            bridgedInterfaceIDs.append( interface->id() );
+            bridgedInterfaceIDs.append( port.interface->id() );
         }
 
         return bridgedInterfaceIDs;
     }
 
-    // functions unsupported by CAN bridge
+    QVector<CanBridgeLatencyHistogram> CanBridge::forwardingLatencies() const
+    {
+        QMutexLocker locker( &m_portsMutex );
+        QVector<CanBridgeLatencyHistogram> latencies;
+
+        for (const CanBridgeLatencyHistogram &histogram : m_forwardingLatencies)
+        {
+            if ( histogram.sourceInterfaceId != histogram.targetInterfaceId )
+            {
+                latencies.append(histogram);
+            }
+        }
+
+        return latencies;
+    }
+
+    void CanBridge::setRoutingRules(const CanRoutingRules &rules, CanRoutingAction defaultAction)
+    {
+        QMutexLocker locker( &m_portsMutex );
+
+        m_routingRules          = rules;
+        m_defaultRoutingAction  = (defaultAction == CanRoutingAction::Drop) ? CanRoutingAction::Drop : CanRoutingAction::Forward;
+        m_routingTable          = compileRoutingTable();
+    }
+
+    CanRoutingRules CanBridge::routingRules() const
+    {
+        QMutexLocker locker( &m_portsMutex );
+
+        return m_routingRules;
+    }
+
+    CanRoutingAction CanBridge::defaultRoutingAction() const
+    {
+        QMutexLocker locker( &m_portsMutex );
+
+        return m_defaultRoutingAction;
+    }
+
+    std::shared_ptr<const CanRoutingTable> CanBridge::compileRoutingTable() const
+    {
+        // called with locked ports mutex
+        QStringList portInterfaceIds;
+
+        for (const BridgePort &port : m_ports)
+        {
+            portInterfaceIds.append( port.interface->id() );
+        }
+
+        return std::make_shared<const CanRoutingTable>(m_routingRules, m_defaultRoutingAction, portInterfaceIds);
+    }
+
+    void CanBridge::resetForwardingLatencies()
+    {
+        // called with locked ports mutex
+        const int portCount = m_ports.size();
+
+        m_forwardingLatencies.fill( CanBridgeLatencyHistogram(), portCount * portCount );
+
+        for (int source = 0; source < portCount; source++)
+        {
+            for (int target = 0; target < portCount; target++)
+            {
+                CanBridgeLatencyHistogram &histogram = m_forwardingLatencies[source * portCount + target];
+
+                histogram.sourceInterfaceId = m_ports.at(source).interface->id();
+                histogram.targetInterfaceId = m_ports.at(target).interface->id();
+            }
+        }
+    }
 
     bool CanBridge::supportsFlexibleDataRate() const
     {
-        return false;
+        QMutexLocker locker( &m_portsMutex );
+
+        if ( m_ports.isEmpty() )
+        {
+            return false;
+        }
+
+        // CAN FD frames can only be forwarded, if every port is able to send them
+        for (const BridgePort &port : m_ports)
+        {
+            if ( ! port.interface->supportsFlexibleDataRate() )
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 
     bool CanBridge::flexibleDataRateEnabled() const
     {
-        return false;
+        QMutexLocker locker( &m_portsMutex );
+
+        if ( m_ports.isEmpty() )
+        {
+            return false;
+        }
+
+        for (const BridgePort &port : m_ports)
+        {
+            if ( ! port.interface->flexibleDataRateEnabled() )
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 
+    // functions unsupported by CAN bridge
+
     int CanBridge::bitRate() const
     {
         return 0;
@@ -187,6 +594,26 @@ namespace Lindwurm::Lib
         return false;
     }
 
+    CanTimestampSource CanBridge::timestampSource() const
+    {
+        QMutexLocker locker( &m_portsMutex );
+
+        if ( m_ports.isEmpty() )
+        {
+            return CanTimestampSource::Unknown;
+        }
+
+        // the bridge can only guarantee the accuracy of its least accurate interface
+        CanTimestampSource source = CanTimestampSource::Simulated;
+
+        for (const BridgePort &port : m_ports )
+        {
+            source = qMin( source, port.interface->timestampSource() );
+        }
+
+        return source;
+    }
+
     void CanBridge::setFlexibleDataRateEnabled(bool enabled)
     {
         Q_UNUSED(enabled)
@@ -17,49 +17,98 @@
 
 #include "caninterface/candevice.h"
 #include <QVariant>
+#include <QTimer>
+
+#include <type_traits>
+
+namespace
+{
+    // frames handed to the QCanBusDevice which are not yet written; further frames stay in the transmit queue
+    const qint64 MAX_DEVICE_PENDING_FRAMES = 64;
+}
 
 namespace Lindwurm::Lib
 {
-    CanDevice::CanDevice(QCanBusDevice *canBusDevice, const QString &id, QString interfaceType, QString device)
-        : AbstractCanInterface(id, interfaceType, device), m_canBusDevice(canBusDevice)
+    template <typename Function>
+    auto CanDevice::runInDeviceThread(Function function) const
+    {
+        // QCanBusDevice is not thread-safe, so every call is executed in the I/O thread the device lives in
+        const Qt::ConnectionType connectionType = ( QThread::currentThread() == m_canBusDevice->thread() ) ? Qt::DirectConnection : Qt::BlockingQueuedConnection;
+
+        if constexpr ( std::is_void<decltype(function())>::value )
+        {
+            QMetaObject::invokeMethod(m_canBusDevice, function, connectionType);
+        }
+        else
+        {
+            decltype(function()) result = {};
+            QMetaObject::invokeMethod(m_canBusDevice, function, connectionType, &result);
+
+            return result;
+        }
+    }
+
+    CanDevice::CanDevice(QCanBusDevice *canBusDevice, const QString &id, QString interfaceType, QString device, bool supportsFlexibleDataRate)
+        : AbstractCanInterface(id, interfaceType, device), m_canBusDevice(canBusDevice), m_supportsFlexibleDataRate(supportsFlexibleDataRate)
     {
         connect(m_canBusDevice, &QCanBusDevice::stateChanged, this, &CanDevice::stateChanged);
-        connect(m_canBusDevice, &QCanBusDevice::framesReceived, this, &CanDevice::framesReceived);
+
+        // the device is the context of this connection, so frames are read in the I/O thread
+        connect(m_canBusDevice, &QCanBusDevice::framesReceived, m_canBusDevice, [this]() { readFrames(); });
+        connect(m_canBusDevice, &QCanBusDevice::framesWritten, m_canBusDevice, [this]() { writeFrames(); });
+
+        m_ioThread.setObjectName( QString("CAN I/O %1").arg(device) );
+        m_canBusDevice->moveToThread(&m_ioThread);
+        m_ioThread.start();
     }
 
     CanDevice::~CanDevice()
     {
         disconnect(m_canBusDevice, &QCanBusDevice::stateChanged, this, &CanDevice::stateChanged);
-        disconnect(m_canBusDevice, &QCanBusDevice::framesReceived, this, &CanDevice::framesReceived);
 
-        delete m_canBusDevice;
+        // the device has to be destroyed in the thread it lives in
+        runInDeviceThread([this]()
+        {
+            delete m_canBusDevice;
+        });
+
+        m_ioThread.quit();
+        m_ioThread.wait();
     }
 
     bool CanDevice::supportsFlexibleDataRate() const
     {
-        // TODO: QCanBusDevice does not seem to have a way to check the support for CAN FD
-        return false;
+        // QCanBusDevice itself does not report CAN FD support, it is taken from the device info of the plugin
+        return m_supportsFlexibleDataRate;
     }
 
     bool CanDevice::flexibleDataRateEnabled() const
     {
-        return m_canBusDevice->configurationParameter(QCanBusDevice::CanFdKey).toBool();
+        return runInDeviceThread([this]() { return m_canBusDevice->configurationParameter(QCanBusDevice::CanFdKey).toBool(); });
     }
 
     int CanDevice::bitRate() const
     {
-        return m_canBusDevice->configurationParameter(QCanBusDevice::BitRateKey).toInt();
+        return runInDeviceThread([this]() { return m_canBusDevice->configurationParameter(QCanBusDevice::BitRateKey).toInt(); });
     }
 
     int CanDevice::dataBitRate() const
     {
-        return m_canBusDevice->configurationParameter(QCanBusDevice::DataBitRateKey).toInt();
+        return runInDeviceThread([this]() { return m_canBusDevice->configurationParameter(QCanBusDevice::DataBitRateKey).toInt(); });
     }
 
     bool CanDevice::localEchoEnabled() const
     {
-        return m_canBusDevice->configurationParameter(QCanBusDevice::LoopbackKey).toBool() ||
-                m_canBusDevice->configurationParameter(QCanBusDevice::ReceiveOwnKey).toBool();
+        return runInDeviceThread([this]()
+        {
+            return m_canBusDevice->configurationParameter(QCanBusDevice::LoopbackKey).toBool() ||
+                    m_canBusDevice->configurationParameter(QCanBusDevice::ReceiveOwnKey).toBool();
+        });
+    }
+
+    CanTimestampSource CanDevice::timestampSource() const
+    {
+        return CanTimestampSource::Driver;
     }
 
     bool CanDevice::connected() const
@@ -69,46 +118,47 @@ namespace Lindwurm::Lib
 
     bool CanDevice::connectInterface()
     {
-        if ( ! m_canBusDevice->connectDevice() )
+        if ( ! runInDeviceThread([this]() { return m_canBusDevice->connectDevice(); }) )
         {
             return false;
         }
 
-        m_connected = true;
+        // the device may still be connecting, frames are accepted as soon as it has reached the connected state
         return true;
     }
 
     bool CanDevice::disconnectInterface()
     {
-        m_canBusDevice->disconnectDevice();
+        runInDeviceThread([this]() { m_canBusDevice->disconnectDevice(); });
         m_connected = false;
+        clearTransmitQueue();
         return true;
     }
 
-    bool CanDevice::sendFrame(const QCanBusFrame &frame)
-    {
-        return m_canBusDevice->writeFrame(frame);
-    }
-
     void CanDevice::setFlexibleDataRateEnabled(bool enabled)
     {
-        m_canBusDevice->setConfigurationParameter(QCanBusDevice::CanFdKey, enabled);
+        runInDeviceThread([this, enabled]() { m_canBusDevice->setConfigurationParameter(QCanBusDevice::CanFdKey, enabled); });
     }
 
     void CanDevice::setBitRate(int bitRate)
     {
-        m_canBusDevice->setConfigurationParameter(QCanBusDevice::BitRateKey, bitRate);
+        runInDeviceThread([this, bitRate]() { m_canBusDevice->setConfigurationParameter(QCanBusDevice::BitRateKey, bitRate); });
+        m_transmitScheduler.setBitRate(bitRate);
     }
 
     void CanDevice::setDataBitRate(int dataBitRate)
     {
-        m_canBusDevice->setConfigurationParameter(QCanBusDevice::DataBitRateKey, dataBitRate);
+        runInDeviceThread([this, dataBitRate]() { m_canBusDevice->setConfigurationParameter(QCanBusDevice::DataBitRateKey, dataBitRate); });
+        m_transmitScheduler.setDataBitRate(dataBitRate);
     }
 
     void CanDevice::setLocalEchoEnabled(bool enable)
     {
-        m_canBusDevice->setConfigurationParameter(QCanBusDevice::LoopbackKey, enable);
-        m_canBusDevice->setConfigurationParameter(QCanBusDevice::ReceiveOwnKey, enable);
+        runInDeviceThread([this, enable]()
+        {
+            m_canBusDevice->setConfigurationParameter(QCanBusDevice::LoopbackKey, enable);
+            m_canBusDevice->setConfigurationParameter(QCanBusDevice::ReceiveOwnKey, enable);
+        });
     }
 
     void CanDevice::stateChanged(QCanBusDevice::CanBusDeviceState state)
@@ -123,7 +173,8 @@ namespace Lindwurm::Lib
 
             case QCanBusDevice::UnconnectedState:
 
-                m_connected = true;
+                m_connected = false;
+                clearTransmitQueue();
                 emit interfaceDisconnected();
                 break;
 
@@ -132,15 +183,72 @@ namespace Lindwurm::Lib
         }
     }
 
-    void CanDevice::framesReceived()
+    void CanDevice::readFrames()
     {
+        // executed in the I/O thread
         QVector<QCanBusFrame> frames = m_canBusDevice->readAllFrames();
 
-       for (const QCanBusFrame &frame : frames)
-       {
-           emit frameReceived(frame, m_name );
-       }
+        if ( frames.isEmpty() )
+        {
+            return;
+        }
+
+        dispatchFrames(frames, interfaceIndex());
     }
-}
 
+    void CanDevice::transmitQueuedFrames()
+    {
+        // frames queued before the I/O thread got to write are written at once
+        if ( ! m_writeScheduled.exchange(true) )
+        {
+            QMetaObject::invokeMethod(m_canBusDevice, [this]() { writeFrames(); }, Qt::QueuedConnection);
+        }
+    }
+
+    void CanDevice::writeFrames()
+    {
+        // executed in the I/O thread
+        m_writeScheduled = false;
+
+        bool drained = false;
+
+        while ( m_connected && m_canBusDevice->framesToWrite() < MAX_DEVICE_PENDING_FRAMES )
+        {
+            const QVector<QCanBusFrame> frames = peekTransmitQueue( int(MAX_DEVICE_PENDING_FRAMES - m_canBusDevice->framesToWrite()) );
+
+            if ( frames.isEmpty() )
+            {
+                break;
+            }
+
+            // frames exceeding the target bus load are held back until the scheduler admits them
+            const int admittedCount = m_transmitScheduler.admit(frames);
+
+            if ( admittedCount == 0 )
+            {
+                if ( ! m_writeScheduled.exchange(true) )
+                {
+                    const int delayMSecs = int( qMax( (m_transmitScheduler.admissionDelayUSecs() + 999) / 1000, qint64(1) ) );
+
+                    QTimer::singleShot(delayMSecs, Qt::PreciseTimer, m_canBusDevice, [this]() { writeFrames(); });
+                }
+
+                break;
+            }
+
+            int writtenCount = 0;
 
+            while ( writtenCount < admittedCount && m_canBusDevice->writeFrame( frames.at(writtenCount) ) )
+            {
+                writtenCount++;
+            }
+
+            // a refused frame is removed from the queue, so it does not block the following frames
+            const int failedCount = (writtenCount < admittedCount) ? 1 : 0;
+
+            drained |= acknowledgeTransmittedFrames(writtenCount, failedCount);
+        }
+
+        notifyTransmitQueue(drained);
+    }
+}
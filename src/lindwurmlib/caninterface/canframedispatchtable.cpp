@@ -0,0 +1,95 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/canframedispatchtable.h"
+
+namespace Lindwurm::Lib
+{
+    CanFrameDispatchTable::CanFrameDispatchTable()
+    {
+
+    }
+
+    void CanFrameDispatchTable::setSubscriber(int slot, const CanIdFilters &filters)
+    {
+        m_subscriptions[slot]   = filters;
+        m_usedSlots            |= (quint64(1) << slot);
+
+        rebuild();
+    }
+
+    void CanFrameDispatchTable::removeSubscriber(int slot)
+    {
+        m_subscriptions[slot].clear();
+        m_usedSlots &= ~(quint64(1) << slot);
+
+        rebuild();
+    }
+
+    void CanFrameDispatchTable::rebuild()
+    {
+        // subscriptions change rarely (when a handle is mounted or changes its subscriptions), so the table is rebuilt completely
+        m_allFramesSubscribers = 0;
+        m_standardSubscribers.fill(0);
+        m_extendedSubscribers.clear();
+        m_maskedExtendedSubscriptions.clear();
+
+        for (int slot = 0; slot < MaxSubscribers; slot++)
+        {
+            const quint64 subscriber = quint64(1) << slot;
+
+            if ( (m_usedSlots & subscriber) == 0 )
+            {
+                continue;
+            }
+
+            if ( m_subscriptions[slot].isEmpty() )
+            {
+                m_allFramesSubscribers |= subscriber;
+                continue;
+            }
+
+            for (const CanIdFilter &filter : qAsConst(m_subscriptions[slot]) )
+            {
+                for (quint32 frameId = 0; frameId < StandardFrameIdCount; frameId++)
+                {
+                    if ( (frameId & filter.mask) == (filter.frameId & filter.mask) )
+                    {
+                        m_standardSubscribers[frameId] |= subscriber;
+                    }
+                }
+
+                const quint32 extendedFrameIdBits = CanIdFilter::ExactMatchMask & ~(StandardFrameIdCount - 1);
+
+                if ( (filter.mask & extendedFrameIdBits) == extendedFrameIdBits && (filter.frameId & extendedFrameIdBits) == 0 )
+                {
+                    // the filter only matches standard frame IDs
+                    continue;
+                }
+
+                if ( filter.mask == CanIdFilter::ExactMatchMask )
+                {
+                    m_extendedSubscribers[filter.frameId] |= subscriber;
+                }
+                else
+                {
+                    m_maskedExtendedSubscriptions.append( MaskedSubscription{ filter, subscriber } );
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/canframereceiver.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <chrono>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
+}
+
+namespace Lindwurm::Lib
+{
+    CanFrameReceiver::CanFrameReceiver(QObject *context, std::function<void()> framesAvailable, int capacity)
+        : m_ring(capacity)
+        , m_context(context)
+        , m_framesAvailable(framesAvailable)
+    {
+
+    }
+
+    void CanFrameReceiver::setFramesAvailableCallback(std::function<void()> framesAvailable)
+    {
+        m_framesAvailable = framesAvailable;
+    }
+
+    void CanFrameReceiver::setFilters(const CanIdFilters &filters)
+    {
+        m_filters = filters;
+    }
+
+    CanIdFilters CanFrameReceiver::filters() const
+    {
+        return m_filters;
+    }
+
+    void CanFrameReceiver::deliver(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
+    {
+        // the frames' own timestamps may come from a driver, the hardware or a recording, so the
+        // delivery is stamped with a clock all consumers share
+        const qint64 deliveredNSecs = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+        if ( ! m_ring.push( CanFrameBatch{ frames, sourceInterface, deliveredNSecs } ) )
+        {
+            if ( m_droppedFrames.fetch_add( frames.size(), std::memory_order_relaxed ) == 0 )
+            {
+                qWarning(LOG_TAG) << "Receive buffer overflow, consumer is not able to keep up. Dropping frames.";
+            }
+
+            return;
+        }
+
+        // only post a new notification if the consumer already picked up the previous one
+        if ( ! m_notificationPending.exchange(true, std::memory_order_acq_rel) )
+        {
+            QMetaObject::invokeMethod(m_context, m_framesAvailable, Qt::QueuedConnection);
+        }
+    }
+
+    QVector<CanFrameBatch> CanFrameReceiver::takeBatches()
+    {
+        // reset the flag before draining, so batches pushed while draining trigger a new notification
+        m_notificationPending.store(false, std::memory_order_release);
+
+        QVector<CanFrameBatch> batches;
+        m_ring.popAll(batches);
+
+        return batches;
+    }
+
+    quint64 CanFrameReceiver::droppedFrameCount() const
+    {
+        return m_droppedFrames.load(std::memory_order_relaxed);
+    }
+
+    int CanFrameReceiver::pendingBatchCount() const
+    {
+        return m_ring.size();
+    }
+
+    int CanFrameReceiver::capacity() const
+    {
+        return m_ring.capacity();
+    }
+}
@@ -27,7 +27,12 @@ namespace Lindwurm::Lib
         {
             connect(m_interface.get(), &ICanInterface::interfaceConnected, this, &CanInterfaceHandle::interfaceConnected);
             connect(m_interface.get(), &ICanInterface::interfaceDisconnected, this, &CanInterfaceHandle::interfaceDisconnected);
-            connect(m_interface.get(), &ICanInterface::frameReceived, this, &CanInterfaceHandle::frameReceived);
+            connect(m_interface.get(), &ICanInterface::transmitQueueDepthChanged, this, &CanInterfaceHandle::transmitQueueDepthChanged);
+            connect(m_interface.get(), &ICanInterface::readyToSend, this, &CanInterfaceHandle::readyToSend);
+
+            // received frames are buffered in the receiver's ring and drained in the thread of this handle
+            m_receiver = std::make_shared<CanFrameReceiver>(this, [this]() { drainReceivedFrames(); });
+            m_interface->attachReceiver(m_receiver);
 
             m_interface->mountComponent(component);
         }
@@ -46,6 +51,11 @@ namespace Lindwurm::Lib
         {
             CanInterfaceHandle::unmount();
         }
+        else if ( m_interface )
+        {
+            // the receiver must not outlive the handle it posts its notifications to
+            m_interface->detachReceiver(m_receiver);
+        }
     }
 
     QString CanInterfaceHandle::id() const
@@ -68,6 +78,16 @@ namespace Lindwurm::Lib
         return "";
     }
 
+    CanInterfaceIndex CanInterfaceHandle::interfaceIndex() const
+    {
+        if (m_interface)
+        {
+            return m_interface->interfaceIndex();
+        }
+
+        return InvalidCanInterfaceIndex;
+    }
+
     QString CanInterfaceHandle::interfaceType() const
     {
         if (m_interface)
@@ -138,6 +158,16 @@ namespace Lindwurm::Lib
         return false;
     }
 
+    CanTimestampSource CanInterfaceHandle::timestampSource() const
+    {
+        if (m_interface)
+        {
+            return m_interface->timestampSource();
+        }
+
+        return CanTimestampSource::Unknown;
+    }
+
     bool CanInterfaceHandle::connected() const
     {
         if (m_interface)
@@ -158,16 +188,96 @@ namespace Lindwurm::Lib
         return false;
     }
 
+    int CanInterfaceHandle::sendFrames(const QVector<QCanBusFrame> &frames)
+    {
+        if (m_interface)
+        {
+            return m_interface->sendFrames(frames);
+        }
+
+        return 0;
+    }
+
+    int CanInterfaceHandle::transmitQueueDepth() const
+    {
+        if (m_interface)
+        {
+            return m_interface->transmitQueueDepth();
+        }
+
+        return 0;
+    }
+
+    CanTransmitStatistics CanInterfaceHandle::transmitStatistics() const
+    {
+        if (m_interface)
+        {
+            return m_interface->transmitStatistics();
+        }
+
+        return CanTransmitStatistics();
+    }
+
+    void CanInterfaceHandle::setFrameFilters(const CanIdFilters &filters)
+    {
+        if (m_interface)
+        {
+            m_interface->setReceiverFilters(m_receiver, filters);
+        }
+    }
+
+    CanIdFilters CanInterfaceHandle::frameFilters() const
+    {
+        if (m_receiver)
+        {
+            return m_receiver->filters();
+        }
+
+        return CanIdFilters();
+    }
+
+    void CanInterfaceHandle::subscribe(quint32 frameId)
+    {
+        subscribe( Range<quint32>(frameId, frameId) );
+    }
+
+    void CanInterfaceHandle::subscribe(const Range<quint32> &frameIds)
+    {
+        CanIdFilters filters = frameFilters();
+
+        for (const CanIdFilter &filter : canIdFiltersFromRange( frameIds.begin(), frameIds.end() ) )
+        {
+            if ( ! filters.contains(filter) )
+            {
+                filters.append(filter);
+            }
+        }
+
+        setFrameFilters(filters);
+    }
+
+    void CanInterfaceHandle::subscribeAll()
+    {
+        setFrameFilters( CanIdFilters() );
+    }
+
     bool CanInterfaceHandle::unmount()
     {
-        if ( m_interface )
+        if ( ! m_interface )
         {
-            disconnect(m_interface.get(), &ICanInterface::frameReceived, this, &CanInterfaceHandle::frameReceived);
+            return false;
         }
 
+        disconnect(m_interface.get(), &ICanInterface::interfaceConnected, this, &CanInterfaceHandle::interfaceConnected);
+        disconnect(m_interface.get(), &ICanInterface::interfaceDisconnected, this, &CanInterfaceHandle::interfaceDisconnected);
+        disconnect(m_interface.get(), &ICanInterface::transmitQueueDepthChanged, this, &CanInterfaceHandle::transmitQueueDepthChanged);
+        disconnect(m_interface.get(), &ICanInterface::readyToSend, this, &CanInterfaceHandle::readyToSend);
+        m_interface->detachReceiver(m_receiver);
+
         m_interface->unmountComponent(m_mountedComponent);
 
         m_interface.reset();
+        m_receiver.reset();
         m_mountedComponent = "";
 
         return true;
@@ -185,6 +295,40 @@ namespace Lindwurm::Lib
         }
     }
 
-}
+    void CanInterfaceHandle::drainReceivedFrames()
+    {
+        if ( ! m_receiver )
+        {
+            // handle was unmounted while the notification was pending
+            return;
+        }
+
+        const QVector<CanFrameBatch> batches = m_receiver->takeBatches();
+
+        if ( batches.isEmpty() )
+        {
+            return;
+        }
 
+        // merge consecutive batches of the same source, so a consumer which fell behind gets a single signal
+        QVector<QCanBusFrame>   frames          = batches.first().frames;
+        CanInterfaceIndex       sourceInterface = batches.first().sourceInterface;
 
+        for (int i = 1; i < batches.size(); i++)
+        {
+            if ( batches.at(i).sourceInterface != sourceInterface )
+            {
+                emit framesReceived(frames, sourceInterface);
+
+                frames          = batches.at(i).frames;
+                sourceInterface = batches.at(i).sourceInterface;
+            }
+            else
+            {
+                frames.append( batches.at(i).frames );
+            }
+        }
+
+        emit framesReceived(frames, sourceInterface);
+    }
+}
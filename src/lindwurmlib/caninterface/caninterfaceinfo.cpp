@@ -158,6 +158,30 @@ namespace Lindwurm::Lib
         return false;
     }
 
+    int CanInterfaceInfo::targetBusLoad() const
+    {
+        auto interface = m_Interface.lock();
+
+        if ( interface )
+        {
+            return interface->targetBusLoad();
+        }
+
+        return 0;
+    }
+
+    CanInterfaceStatistics CanInterfaceInfo::statistics() const
+    {
+        auto interface = m_Interface.lock();
+
+        if ( interface )
+        {
+            return interface->statistics();
+        }
+
+        return CanInterfaceStatistics();
+    }
+
     bool CanInterfaceInfo::connected() const
     {
         auto interface = m_Interface.lock();
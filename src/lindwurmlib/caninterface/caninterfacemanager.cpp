@@ -20,6 +20,11 @@
 #include "caninterface/caninterfacehandle.h"
 #include "caninterface/candevice.h"
 #include "caninterface/canbridge.h"
+#include "caninterface/virtualcaninterface.h"
+#include "caninterface/tracereplayinterface.h"
+#ifdef Q_OS_LINUX
+#include "caninterface/socketcaninterface.h"
+#endif
 #include "caninterface/caninterfacelistmodel.h"
 
 #include <QCanBus>
@@ -28,6 +33,8 @@
 #include <QDebug>
 #include <QLoggingCategory>
 
+#include <algorithm>
+
 namespace
 {
     Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
@@ -50,6 +57,13 @@ namespace Lindwurm::Lib
     QStringList CanInterfaceManager::interfaceTypes() const
     {
         QStringList types = QCanBus::instance()->plugins();
+
+#ifdef Q_OS_LINUX
+        types.append(SocketCanInterface::InterfaceType);
+#endif
+
+        types.append(VirtualCanInterface::InterfaceType);
+        types.append(TraceReplayInterface::InterfaceType);
         types.append("bridge");
 
         return types;
@@ -57,6 +71,24 @@ namespace Lindwurm::Lib
 
     QStringList CanInterfaceManager::availableDevicesOf(const QString &interfaceType) const
     {
+        if ( interfaceType == VirtualCanInterface::InterfaceType )
+        {
+            return VirtualCanBus::availableBuses();
+        }
+
+        if ( interfaceType == TraceReplayInterface::InterfaceType )
+        {
+            // the trace file is entered by the user
+            return QStringList();
+        }
+
+#ifdef Q_OS_LINUX
+        if ( interfaceType == SocketCanInterface::InterfaceType )
+        {
+            return SocketCanInterface::availableDevices();
+        }
+#endif
+
         QList<QCanBusDeviceInfo> availableDevices = QCanBus::instance()->availableDevices(interfaceType);
         QStringList devices;
 
@@ -102,6 +134,11 @@ namespace Lindwurm::Lib
         return CanInterfaceInfo();
     }
 
+    QString CanInterfaceManager::interfaceNameOf(CanInterfaceIndex interfaceIndex) const
+    {
+        return m_interfaceNamesByIndex.value(interfaceIndex);
+    }
+
     ICanInterfaceSharedPtr CanInterfaceManager::interfaceById(const QString &interfaceId)
     {
         return m_interfacesById[interfaceId];
@@ -146,6 +183,20 @@ namespace Lindwurm::Lib
         {
             newCANInterface = createBridge(config);
         }
+        else if ( config.interfaceType == VirtualCanInterface::InterfaceType )
+        {
+            newCANInterface = createVirtualCanInterface(config);
+        }
+        else if ( config.interfaceType == TraceReplayInterface::InterfaceType )
+        {
+            newCANInterface = createTraceReplayInterface(config);
+        }
+#ifdef Q_OS_LINUX
+        else if ( config.interfaceType == SocketCanInterface::InterfaceType )
+        {
+            newCANInterface = createSocketCanInterface(config);
+        }
+#endif
         else
         {
             newCANInterface = createInterface(config);
@@ -156,8 +207,18 @@ namespace Lindwurm::Lib
             return InterfaceError::UnknownError;
         }
 
+        if ( m_interfaceNamesByIndex.size() >= InvalidCanInterfaceIndex )
+        {
+            qCritical(LOG_TAG) << "Maximum number of interfaces exceeded.";
+            return InterfaceError::UnknownError;
+        }
+
         newCANInterface->setName(config.name);
 
+        // indices are never reused, so frames recorded from removed interfaces still resolve to their name
+        newCANInterface->setInterfaceIndex( CanInterfaceIndex( m_interfaceNamesByIndex.size() ) );
+        m_interfaceNamesByIndex.append(config.name);
+
         m_interfacesById.insert( newCANInterface->id(), newCANInterface );
         m_interfacesIdByName.insert( newCANInterface->name(), newCANInterface->id() );
 
@@ -194,6 +255,7 @@ namespace Lindwurm::Lib
             }
 
             interface->setName(config.name);
+            m_interfaceNamesByIndex[ interface->interfaceIndex() ] = config.name;
         }
 
         if ( interface->interfaceType() == "bridge" )
@@ -209,9 +271,17 @@ namespace Lindwurm::Lib
             QStringList currentlyBridgedInterfaceIDs;
             currentlyBridgedInterfaceIDs = bridge->bridgedInterfaceIds();
 
-            bool bridgeWasConnected = bridge->connected();
+            // routing rules are applied without interrupting the bridge
+            bridge->setRoutingRules(config.routingRules, config.defaultRoutingAction);
+
+            QStringList requestedBridgeInterfaceIDs = config.bridgedInterfaces;
+
+            std::sort(requestedBridgeInterfaceIDs.begin(), requestedBridgeInterfaceIDs.end());
+            std::sort(currentlyBridgedInterfaceIDs.begin(), currentlyBridgedInterfaceIDs.end());
+
+            bool reconnectBridge = bridge->connected() && (requestedBridgeInterfaceIDs != currentlyBridgedInterfaceIDs);
 
-            if ( bridgeWasConnected )
+            if ( reconnectBridge )
             {
                 // for precaution we disconnect the bridge while changing it's mount configuration
                 bridge->disconnectInterface();
@@ -244,12 +314,23 @@ namespace Lindwurm::Lib
                     }
                 }
 
-            if ( bridgeWasConnected )
+            if ( reconnectBridge )
             {
-                // if the bridge was connected before reconnect it
+                // if the bridge was disconnected for the mount change reconnect it
                 bridge->connectInterface();
             }
         }
+        else if ( interface->interfaceType() == TraceReplayInterface::InterfaceType )
+        {
+            std::shared_ptr<TraceReplayInterface> replayInterface = std::dynamic_pointer_cast<TraceReplayInterface>(interface);
+
+            if ( replayInterface )
+            {
+                // the bit rates of a replay are given by the recording
+                replayInterface->setReplaySpeed( config.replaySpeed );
+                replayInterface->setLocalEchoEnabled( config.enableLocalEcho );
+            }
+        }
         else
         {
             // these settings are not supported by bridge interfaces
@@ -273,6 +354,11 @@ namespace Lindwurm::Lib
             {
                 interface->setLocalEchoEnabled( config.enableLocalEcho );
             }
+
+            if ( interface->targetBusLoad() != config.targetBusLoad )
+            {
+                interface->setTargetBusLoad( config.targetBusLoad );
+            }
         }
 
         emit interfaceModified( CanInterfaceInfo(interface) );
@@ -346,11 +432,42 @@ namespace Lindwurm::Lib
             return ICanInterfaceSharedPtr();
         }
 
-        newCANInterface = std::make_shared<CanDevice>(canBusDevice, QUuid::createUuid().toString(), config.interfaceType, config.device);
+        bool supportsFlexibleDataRate = false;
+
+        const QList<QCanBusDeviceInfo> deviceInfos = QCanBus::instance()->availableDevices(config.interfaceType);
+
+        for (const QCanBusDeviceInfo &info : deviceInfos)
+        {
+            if ( info.name() == config.device )
+            {
+                supportsFlexibleDataRate = info.hasFlexibleDataRate();
+                break;
+            }
+        }
+
+        newCANInterface = std::make_shared<CanDevice>(canBusDevice, QUuid::createUuid().toString(), config.interfaceType, config.device, supportsFlexibleDataRate);
+
+        newCANInterface->setLocalEchoEnabled(config.enableLocalEcho);
+        newCANInterface->setFlexibleDataRateEnabled(config.enableFlexibleDataRate);
+        newCANInterface->setBitRate(config.bitRate);
+        newCANInterface->setTargetBusLoad(config.targetBusLoad);
+
+        if ( config.enableFlexibleDataRate )
+        {
+            newCANInterface->setDataBitRate(config.dataBitRate);
+        }
+
+        return newCANInterface;
+    }
+
+    ICanInterfaceSharedPtr CanInterfaceManager::createVirtualCanInterface(const CanInterfaceConfig &config)
+    {
+        ICanInterfaceSharedPtr newCANInterface = std::make_shared<VirtualCanInterface>(QUuid::createUuid().toString(), config.device);
 
         newCANInterface->setLocalEchoEnabled(config.enableLocalEcho);
         newCANInterface->setFlexibleDataRateEnabled(config.enableFlexibleDataRate);
         newCANInterface->setBitRate(config.bitRate);
+        newCANInterface->setTargetBusLoad(config.targetBusLoad);
 
         if ( config.enableFlexibleDataRate )
         {
@@ -360,10 +477,41 @@ namespace Lindwurm::Lib
         return newCANInterface;
     }
 
+    ICanInterfaceSharedPtr CanInterfaceManager::createTraceReplayInterface(const CanInterfaceConfig &config)
+    {
+        std::shared_ptr<TraceReplayInterface> newReplayInterface = std::make_shared<TraceReplayInterface>(QUuid::createUuid().toString(), config.device);
+
+        newReplayInterface->setLocalEchoEnabled(config.enableLocalEcho);
+        newReplayInterface->setReplaySpeed(config.replaySpeed);
+
+        return newReplayInterface;
+    }
+
+#ifdef Q_OS_LINUX
+    ICanInterfaceSharedPtr CanInterfaceManager::createSocketCanInterface(const CanInterfaceConfig &config)
+    {
+        ICanInterfaceSharedPtr newCANInterface = std::make_shared<SocketCanInterface>(QUuid::createUuid().toString(), config.device);
+
+        newCANInterface->setLocalEchoEnabled(config.enableLocalEcho);
+        newCANInterface->setFlexibleDataRateEnabled(config.enableFlexibleDataRate);
+        newCANInterface->setBitRate(config.bitRate);
+        newCANInterface->setTargetBusLoad(config.targetBusLoad);
+
+        if ( config.enableFlexibleDataRate )
+        {
+            newCANInterface->setDataBitRate(config.dataBitRate);
+        }
+
+        return newCANInterface;
+    }
+#endif
+
     ICanInterfaceSharedPtr CanInterfaceManager::createBridge(const CanInterfaceConfig &config)
     {
         std::shared_ptr<CanBridge> newBridge = std::make_shared<CanBridge>( QUuid::createUuid().toString() );
 
+        newBridge->setRoutingRules(config.routingRules, config.defaultRoutingAction);
+
         for (const QString &requestedBridgeInterfaceId : qAsConst(config.bridgedInterfaces) )
         {
             if ( m_interfacesById.contains( requestedBridgeInterfaceId ) )
@@ -21,6 +21,18 @@
 #include "caninterface/icaninterfacesharedptr.h"
 #include <QSize>
 
+namespace
+{
+    // the columns following the configuration show the live statistics of the interfaces
+    const int FIRST_STATISTICS_COLUMN   = 8;
+    const int COLUMN_COUNT              = 14;
+
+    QString formatRate(double rate)
+    {
+        return QString::number(rate, 'f', 0);
+    }
+}
+
 namespace Lindwurm::Lib
 {
     CanInterfaceManagerModel::CanInterfaceManagerModel(CanInterfaceManager *manager, QObject *parent)
@@ -47,7 +59,7 @@ namespace Lindwurm::Lib
     {
         if ( ! parent.isValid() )
         {
-            return 8;
+            return COLUMN_COUNT;
         }
 
         return 0;
@@ -102,8 +114,25 @@ namespace Lindwurm::Lib
 
                 case 7:     return QVariant();
 
-                default:    return QVariant();
+                default:    break;
+            }
+
+            if ( index.column() >= FIRST_STATISTICS_COLUMN )
+            {
+                return statisticsData( info.statistics(), index.column() );
             }
+
+            return QVariant();
+        }
+
+        if ( role == Qt::ToolTipRole && index.column() >= FIRST_STATISTICS_COLUMN )
+        {
+            return statisticsToolTip( info.statistics(), index.column() );
+        }
+
+        if ( role == Qt::TextAlignmentRole && index.column() >= FIRST_STATISTICS_COLUMN )
+        {
+            return QVariant( Qt::AlignRight | Qt::AlignVCenter );
         }
 
         if ( role == Qt::CheckStateRole )
@@ -216,6 +245,12 @@ namespace Lindwurm::Lib
                 case 5:     return "FD";
                 case 6:     return "Data Bitrate";
                 case 7:     return "Local Echo";
+                case 8:     return "Frames/s";
+                case 9:     return "Bytes/s";
+                case 10:    return "Bus Load";
+                case 11:    return "Error Frames";
+                case 12:    return "Dropped";
+                case 13:    return "TX Failures";
                 default:    return QVariant();
             }
         }
@@ -231,6 +266,9 @@ namespace Lindwurm::Lib
                 case 4:     return QSize(100, 24);
                 case 5:     return QSize(30, 24);
                 case 6:     return QSize(130, 24);
+                case 8:     return QSize(90, 24);
+                case 9:     return QSize(90, 24);
+                case 10:    return QSize(80, 24);
                 default:    return QVariant();
             }
         }
@@ -270,6 +308,16 @@ namespace Lindwurm::Lib
         return createIndex(row, column);
     }
 
+    void CanInterfaceManagerModel::refreshStatistics()
+    {
+        if ( m_interfaceList.isEmpty() )
+        {
+            return;
+        }
+
+        emit dataChanged( createIndex(0, FIRST_STATISTICS_COLUMN), createIndex(m_interfaceList.size() - 1, COLUMN_COUNT - 1), { Qt::DisplayRole, Qt::ToolTipRole } );
+    }
+
     void CanInterfaceManagerModel::interfaceAdded(const CanInterfaceInfo &interface)
     {
         beginInsertRows( QModelIndex(), m_interfaceList.size(), m_interfaceList.size());
@@ -285,7 +333,7 @@ namespace Lindwurm::Lib
 
         if ( row >= 0 )
         {
-            emit dataChanged( createIndex(row, 0), createIndex(row, 7) );
+            emit dataChanged( createIndex(row, 0), createIndex(row, COLUMN_COUNT - 1) );
         }
     }
 
@@ -303,6 +351,52 @@ namespace Lindwurm::Lib
         }
     }
 
+    QVariant CanInterfaceManagerModel::statisticsData(const CanInterfaceStatistics &statistics, int column) const
+    {
+        switch ( column )
+        {
+            case 8:     return formatRate( statistics.rxFramesPerSecond + statistics.txFramesPerSecond );
+            case 9:     return formatRate( statistics.rxBytesPerSecond + statistics.txBytesPerSecond );
+            case 10:
+
+                if ( statistics.busLoad >= 0.0 )
+                {
+                    return QString("%1 %").arg(statistics.busLoad, 0, 'f', 1);
+                }
+                else
+                {
+                    return "";
+                }
+
+            case 11:    return statistics.errorFrames;
+            case 12:    return statistics.txDroppedFrames + statistics.rxOverflowFrames + statistics.receiverDroppedFrames;
+            case 13:    return statistics.txFailures;
+            default:    return QVariant();
+        }
+    }
+
+    QVariant CanInterfaceManagerModel::statisticsToolTip(const CanInterfaceStatistics &statistics, int column) const
+    {
+        switch ( column )
+        {
+            case 8:     return QString("RX: %1 frames/s\nTX: %2 frames/s\n\nTotal RX: %3\nTotal TX: %4")
+                                .arg( formatRate(statistics.rxFramesPerSecond), formatRate(statistics.txFramesPerSecond) )
+                                .arg(statistics.rxFrames).arg(statistics.txFrames);
+
+            case 9:     return QString("RX: %1 bytes/s\nTX: %2 bytes/s\n\nTotal RX: %3 bytes\nTotal TX: %4 bytes")
+                                .arg( formatRate(statistics.rxBytesPerSecond), formatRate(statistics.txBytesPerSecond) )
+                                .arg(statistics.rxBytes).arg(statistics.txBytes);
+
+            case 10:    return "Estimated from the bit rate and the worst case length of the frames on the bus";
+
+            case 12:    return QString("Transmit queue full: %1\nDriver receive queue overflow: %2\nReceivers too slow: %3")
+                                .arg(statistics.txDroppedFrames).arg(statistics.rxOverflowFrames).arg(statistics.receiverDroppedFrames);
+
+            case 13:    return "Frames the driver refused to write";
+            default:    return QVariant();
+        }
+    }
+
     int CanInterfaceManagerModel::findRowForInterfaceId(const QString &interfaceId) const
     {
         for (int row = 0; row < m_interfaceList.size(); row++)
@@ -0,0 +1,84 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/canroutingtable.h"
+
+namespace Lindwurm::Lib
+{
+    CanRoutingTable::CanRoutingTable(const CanRoutingRules &rules, CanRoutingAction defaultAction, const QStringList &portInterfaceIds)
+        : m_portCount( portInterfaceIds.size() )
+        , m_defaultRoute( defaultAction == CanRoutingAction::Drop ? DropFlag : 0 )
+        , m_standardRoutes( m_portCount * m_portCount * StandardFrameIdCount )
+        , m_extendedRoutes( m_portCount * m_portCount )
+    {
+        for (int sourcePort = 0; sourcePort < m_portCount; sourcePort++)
+        {
+            for (int targetPort = 0; targetPort < m_portCount; targetPort++)
+            {
+                const int direction         = sourcePort * m_portCount + targetPort;
+                quint32  *standardRoutes    = m_standardRoutes.data() + direction * StandardFrameIdCount;
+
+                for (quint32 frameId = 0; frameId < quint32(StandardFrameIdCount); frameId++)
+                {
+                    standardRoutes[frameId] = m_defaultRoute | frameId;
+                }
+
+                // rules are applied in reverse order, so the first matching rule overwrites all others
+                for (int i = rules.size() - 1; i >= 0; i--)
+                {
+                    const CanRoutingRule &rule = rules.at(i);
+
+                    if ( ! rule.sourceInterfaceId.isEmpty() && rule.sourceInterfaceId != portInterfaceIds.at(sourcePort) )
+                    {
+                        continue;
+                    }
+
+                    if ( ! rule.targetInterfaceId.isEmpty() && rule.targetInterfaceId != portInterfaceIds.at(targetPort) )
+                    {
+                        continue;
+                    }
+
+                    if ( rule.extendedFrameFormat )
+                    {
+                        m_extendedRoutes[direction].insert( rule.frameId & ExtendedFrameIdMask, compileRoute(rule) );
+                    }
+                    else
+                    {
+                        standardRoutes[ rule.frameId & StandardFrameIdMask ] = compileRoute(rule);
+                    }
+                }
+            }
+        }
+    }
+
+    quint32 CanRoutingTable::compileRoute(const CanRoutingRule &rule) const
+    {
+        const quint32 frameIdMask = rule.extendedFrameFormat ? ExtendedFrameIdMask : StandardFrameIdMask;
+
+        switch (rule.action)
+        {
+            case CanRoutingAction::Drop:
+                return DropFlag;
+
+            case CanRoutingAction::Remap:
+                return rule.remappedFrameId & frameIdMask;
+
+            default:
+                return rule.frameId & frameIdMask;
+        }
+    }
+}
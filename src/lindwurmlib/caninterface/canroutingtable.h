@@ -0,0 +1,90 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANROUTINGTABLE_H
+#define CANROUTINGTABLE_H
+
+#include "caninterface/canroutingrule.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanRoutingTable class is the compiled form of the routing rules of a bridge.
+     *
+     * The rules are resolved for every direction between the bridge's ports, so routing a frame is a single
+     * lookup: standard frame IDs index a flat table per direction, extended frame IDs are looked up in a hash
+     * per direction which only contains the IDs with a rule. A table is immutable after it was compiled.
+     */
+    class CanRoutingTable
+    {
+        public:
+
+            CanRoutingTable(const CanRoutingRules &rules, CanRoutingAction defaultAction, const QStringList &portInterfaceIds);
+
+            /**
+             * @brief Routes a frame from one port to another.
+             * @param sourcePort            the index of the port the frame was received on.
+             * @param targetPort            the index of the port the frame should be forwarded to.
+             * @param extendedFrameFormat   `true` if the frame uses the extended frame format.
+             * @param frameId               the frame ID, replaced by the remapped frame ID if the frame is remapped.
+             * @return `true` if the frame is forwarded, `false` if it is dropped.
+             */
+            inline bool     route(int sourcePort, int targetPort, bool extendedFrameFormat, quint32 &frameId) const
+            {
+                const int direction = sourcePort * m_portCount + targetPort;
+                quint32 route;
+
+                if ( ! extendedFrameFormat )
+                {
+                    route = m_standardRoutes[ direction * StandardFrameIdCount + (frameId & StandardFrameIdMask) ];
+                }
+                else
+                {
+                    route = m_extendedRoutes[direction].value(frameId, m_defaultRoute | frameId);
+                }
+
+                if ( route & DropFlag )
+                {
+                    return false;
+                }
+
+                frameId = route;
+                return true;
+            }
+
+        private:
+
+            static const int        StandardFrameIdCount = 2048;
+            static const quint32    StandardFrameIdMask = 0x7FF;
+            static const quint32    ExtendedFrameIdMask = 0x1FFFFFFF;
+            static const quint32    DropFlag = 0x80000000;
+
+            // a route is the frame ID to forward the frame with or the drop flag
+            quint32 compileRoute(const CanRoutingRule &rule) const;
+
+            int                                 m_portCount;
+            quint32                             m_defaultRoute;
+            QVector<quint32>                    m_standardRoutes;
+            QVector<QHash<quint32, quint32>>    m_extendedRoutes;
+    };
+}
+
+#endif // CANROUTINGTABLE_H
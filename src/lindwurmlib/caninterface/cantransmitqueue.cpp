@@ -0,0 +1,140 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/cantransmitqueue.h"
+
+#include <QMutexLocker>
+
+#include <utility>
+
+namespace Lindwurm::Lib
+{
+    CanTransmitQueue::CanTransmitQueue(int capacity)
+        : m_capacity(capacity)
+    {
+
+    }
+
+    int CanTransmitQueue::enqueue(const QVector<QCanBusFrame> &frames)
+    {
+        QMutexLocker locker( &m_mutex );
+
+        const int acceptedCount = qMin( frames.size(), m_capacity - int(m_frames.size()) );
+
+        for (int i = 0; i < acceptedCount; i++)
+        {
+            m_frames.push_back( frames.at(i) );
+        }
+
+        if ( acceptedCount < frames.size() )
+        {
+            m_full = true;
+            m_droppedFrames += quint64( frames.size() - acceptedCount );
+        }
+
+        m_queuedFrames += quint64(acceptedCount);
+        m_depth = int( m_frames.size() );
+
+        return acceptedCount;
+    }
+
+    QVector<QCanBusFrame> CanTransmitQueue::peek(int maxCount) const
+    {
+        QMutexLocker locker( &m_mutex );
+
+        const int count = qMin( maxCount, int(m_frames.size()) );
+
+        QVector<QCanBusFrame> frames;
+        frames.reserve(count);
+
+        for (int i = 0; i < count; i++)
+        {
+            frames.append( m_frames[i] );
+        }
+
+        return frames;
+    }
+
+    bool CanTransmitQueue::acknowledge(int writtenCount, int failedCount, QVector<QCanBusFrame> *writtenFrames)
+    {
+        QMutexLocker locker( &m_mutex );
+
+        const int count = qMin( writtenCount + failedCount, int(m_frames.size()) );
+
+        if ( writtenFrames != nullptr )
+        {
+            const int writtenInQueue = qMin( writtenCount, count );
+
+            writtenFrames->reserve(writtenInQueue);
+
+            for (int i = 0; i < writtenInQueue; i++)
+            {
+                writtenFrames->append( std::move(m_frames[i]) );
+            }
+        }
+
+        m_frames.erase( m_frames.begin(), m_frames.begin() + count );
+
+        m_writtenFrames += quint64(writtenCount);
+        m_failedFrames  += quint64(failedCount);
+        m_depth          = int( m_frames.size() );
+
+        if ( m_full && int(m_frames.size()) <= m_capacity / 2 )
+        {
+            m_full = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool CanTransmitQueue::clear()
+    {
+        QMutexLocker locker( &m_mutex );
+
+        const bool wasFull = m_full;
+
+        m_droppedFrames += quint64( m_frames.size() );
+        m_frames.clear();
+        m_full  = false;
+        m_depth = 0;
+
+        return wasFull;
+    }
+
+    int CanTransmitQueue::depth() const
+    {
+        return m_depth;
+    }
+
+    int CanTransmitQueue::capacity() const
+    {
+        return m_capacity;
+    }
+
+    CanTransmitStatistics CanTransmitQueue::statistics() const
+    {
+        CanTransmitStatistics statistics;
+
+        statistics.queuedFrames     = m_queuedFrames;
+        statistics.writtenFrames    = m_writtenFrames;
+        statistics.droppedFrames    = m_droppedFrames;
+        statistics.failedFrames     = m_failedFrames;
+
+        return statistics;
+    }
+}
@@ -0,0 +1,223 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/cantransmitscheduler.h"
+
+#include <QMutexLocker>
+
+namespace
+{
+    // bits of the frame fields which are subject to bit stuffing (SOF up to and including the CRC sequence)
+    const int CLASSIC_BASE_STUFFED_BITS     = 34;   // SOF, 11 bit ID, RTR, IDE, r0, DLC, CRC-15
+    const int CLASSIC_EXTENDED_STUFFED_BITS = 54;   // SOF, 29 bit ID, SRR, IDE, RTR, r1, r0, DLC, CRC-15
+
+    // CRC delimiter, ACK slot and delimiter, end of frame and interframe space
+    const int CLASSIC_TRAILER_BITS          = 13;
+
+    // CAN FD arbitration phase, sent with the nominal bit rate: SOF and ID up to the BRS bit
+    const int FD_BASE_ARBITRATION_BITS      = 17;
+    const int FD_EXTENDED_ARBITRATION_BITS  = 36;
+
+    // CAN FD data phase before the payload: ESI and DLC
+    const int FD_DATA_HEADER_BITS           = 5;
+
+    // the CRC field of a CAN FD frame starts with the stuff bit count and has fixed stuff bits every 4 bits
+    const int FD_STUFF_COUNT_BITS           = 4;
+
+    // ACK slot and delimiter, end of frame and interframe space, sent with the nominal bit rate
+    const int FD_TRAILER_BITS               = 12;
+
+    int fdPayloadLength(int payloadSize)
+    {
+        // CAN FD frames are padded to the next valid data length
+        static const int validLengths[] = { 12, 16, 20, 24, 32, 48, 64 };
+
+        if ( payloadSize <= 8 )
+        {
+            return payloadSize;
+        }
+
+        for (int length : validLengths)
+        {
+            if ( payloadSize <= length )
+            {
+                return length;
+            }
+        }
+
+        return 64;
+    }
+
+    qint64 bitsToNSecs(qint64 bitCount, int bitRate)
+    {
+        return (bitCount * 1000000000 + bitRate - 1) / bitRate;
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    CanTransmitScheduler::CanTransmitScheduler()
+    {
+        m_clock.start();
+    }
+
+    void CanTransmitScheduler::setTargetBusLoad(int percent)
+    {
+        QMutexLocker locker( &m_mutex );
+
+        m_targetBusLoad = qBound(0, percent, 100);
+        m_balanceNSecs  = 0;
+    }
+
+    int CanTransmitScheduler::targetBusLoad() const
+    {
+        QMutexLocker locker( &m_mutex );
+
+        return m_targetBusLoad;
+    }
+
+    void CanTransmitScheduler::setBitRate(int bitRate)
+    {
+        QMutexLocker locker( &m_mutex );
+
+        m_bitRate = bitRate;
+    }
+
+    int CanTransmitScheduler::bitRate() const
+    {
+        QMutexLocker locker( &m_mutex );
+
+        return m_bitRate;
+    }
+
+    void CanTransmitScheduler::setDataBitRate(int dataBitRate)
+    {
+        QMutexLocker locker( &m_mutex );
+
+        m_dataBitRate = dataBitRate;
+    }
+
+    int CanTransmitScheduler::dataBitRate() const
+    {
+        QMutexLocker locker( &m_mutex );
+
+        return m_dataBitRate;
+    }
+
+    bool CanTransmitScheduler::isActive() const
+    {
+        QMutexLocker locker( &m_mutex );
+
+        return m_targetBusLoad > 0 && m_targetBusLoad < 100 && m_bitRate > 0;
+    }
+
+    int CanTransmitScheduler::admit(const QVector<QCanBusFrame> &frames)
+    {
+        if ( ! isActive() )
+        {
+            return frames.size();
+        }
+
+        QMutexLocker locker( &m_mutex );
+
+        refill();
+
+        int admittedCount = 0;
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            if ( m_balanceNSecs < 0 )
+            {
+                break;
+            }
+
+            m_balanceNSecs -= frameDurationNSecs(frame, m_bitRate, m_dataBitRate);
+            admittedCount++;
+        }
+
+        return admittedCount;
+    }
+
+    qint64 CanTransmitScheduler::admissionDelayUSecs()
+    {
+        if ( ! isActive() )
+        {
+            return 0;
+        }
+
+        QMutexLocker locker( &m_mutex );
+
+        refill();
+
+        if ( m_balanceNSecs >= 0 )
+        {
+            return 0;
+        }
+
+        // the debt is paid back with the target bus load
+        return ( -m_balanceNSecs * 100 / m_targetBusLoad + 999 ) / 1000;
+    }
+
+    qint64 CanTransmitScheduler::frameDurationNSecs(const QCanBusFrame &frame, int bitRate, int dataBitRate)
+    {
+        if ( bitRate <= 0 )
+        {
+            return 0;
+        }
+
+        const bool extended = frame.hasExtendedFrameFormat();
+
+        if ( ! frame.hasFlexibleDataRateFormat() )
+        {
+            const int payloadBits   = (frame.frameType() == QCanBusFrame::RemoteRequestFrame) ? 0 : 8 * qMin( frame.payload().size(), 8 );
+            const int stuffedBits   = (extended ? CLASSIC_EXTENDED_STUFFED_BITS : CLASSIC_BASE_STUFFED_BITS) + payloadBits;
+
+            // in the worst case every fifth bit is a stuff bit
+            const int stuffBits     = (stuffedBits - 1) / 4;
+
+            return bitsToNSecs( stuffedBits + stuffBits + CLASSIC_TRAILER_BITS, bitRate );
+        }
+
+        const int arbitrationBits   = extended ? FD_EXTENDED_ARBITRATION_BITS : FD_BASE_ARBITRATION_BITS;
+        const int payloadLength     = fdPayloadLength( frame.payload().size() );
+        const int dataBits          = FD_DATA_HEADER_BITS + 8 * payloadLength;
+        const int crcBits           = (payloadLength <= 16) ? 17 : 21;
+
+        // dynamic stuff bits up to the payload, fixed stuff bits within the CRC field
+        const int dynamicStuffBits  = (arbitrationBits + dataBits - 1) / 4;
+        const int fixedStuffBits    = (FD_STUFF_COUNT_BITS + crcBits + 3) / 4;
+
+        // stuff bits of the arbitration phase are sent with the nominal bit rate, the data phase ends with the CRC delimiter
+        const int arbitrationStuffBits  = (arbitrationBits - 1) / 4;
+        const int dataPhaseBits         = dataBits + (dynamicStuffBits - arbitrationStuffBits) + FD_STUFF_COUNT_BITS + crcBits + fixedStuffBits + 1;
+        const int nominalBits           = arbitrationBits + arbitrationStuffBits + FD_TRAILER_BITS;
+
+        const int dataPhaseBitRate = ( frame.hasBitrateSwitch() && dataBitRate > 0 ) ? dataBitRate : bitRate;
+
+        return bitsToNSecs(nominalBits, bitRate) + bitsToNSecs(dataPhaseBits, dataPhaseBitRate);
+    }
+
+    void CanTransmitScheduler::refill()
+    {
+        // called with locked mutex
+        const qint64 nowNSecs       = m_clock.nsecsElapsed();
+        const qint64 elapsedNSecs   = nowNSecs - m_lastRefillNSecs;
+
+        m_lastRefillNSecs   = nowNSecs;
+        m_balanceNSecs      = qMin( m_balanceNSecs + elapsedNSecs * m_targetBusLoad / 100, MaxBurstNSecs );
+    }
+}
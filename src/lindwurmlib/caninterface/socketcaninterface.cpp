@@ -0,0 +1,903 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/socketcaninterface.h"
+
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/can/error.h>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
+
+    // number of frames moved with a single recvmmsg()/sendmmsg() call
+    const int MESSAGE_BATCH_SIZE = 64;
+
+    // delay before retrying to write frames, if the device's transmit queue is full (ENOBUFS)
+    const int TX_QUEUE_FULL_RETRY_MSEC = 1;
+
+    const int ARPHRD_CAN_TYPE = 280;
+
+    // more filters are not accepted by the kernel (CAN_RAW_FILTER_MAX)
+    const int MAX_KERNEL_FILTERS = 512;
+
+    // timestamps and the number of frames the socket dropped so far (SO_RXQ_OVFL)
+    const size_t RX_CONTROL_SIZE = CMSG_SPACE( sizeof(struct scm_timestamping) ) + CMSG_SPACE( sizeof(quint32) );
+
+    // request software timestamps and, if supported by the controller, raw hardware timestamps
+    const int TIMESTAMPING_FLAGS = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                                   SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+    qint64 toMicroSeconds(const struct timespec &time)
+    {
+        return qint64(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    const char* const SocketCanInterface::InterfaceType = "socketcan-native";
+
+    /**
+     * @brief The MessageBuffers struct holds the preallocated kernel message structures for batched socket I/O.
+     */
+    struct SocketCanInterface::MessageBuffers
+    {
+        struct canfd_frame      rxFrames[MESSAGE_BATCH_SIZE];
+        struct iovec            rxVectors[MESSAGE_BATCH_SIZE];
+        struct mmsghdr          rxMessages[MESSAGE_BATCH_SIZE];
+        alignas(struct cmsghdr) char rxControl[MESSAGE_BATCH_SIZE][RX_CONTROL_SIZE];
+
+        struct canfd_frame      txFrames[MESSAGE_BATCH_SIZE];
+        struct iovec            txVectors[MESSAGE_BATCH_SIZE];
+        struct mmsghdr          txMessages[MESSAGE_BATCH_SIZE];
+    };
+
+    SocketCanInterface::SocketCanInterface(const QString &id, const QString &device)
+        : AbstractCanInterface(id, InterfaceType, device)
+        , m_buffers( new MessageBuffers() )
+    {
+        std::memset( m_buffers.get(), 0, sizeof(MessageBuffers) );
+
+        for (int i = 0; i < MESSAGE_BATCH_SIZE; i++)
+        {
+            m_buffers->rxVectors[i].iov_base = &m_buffers->rxFrames[i];
+            m_buffers->rxVectors[i].iov_len  = sizeof(struct canfd_frame);
+
+            m_buffers->rxMessages[i].msg_hdr.msg_iov    = &m_buffers->rxVectors[i];
+            m_buffers->rxMessages[i].msg_hdr.msg_iovlen = 1;
+
+            m_buffers->txVectors[i].iov_base = &m_buffers->txFrames[i];
+
+            m_buffers->txMessages[i].msg_hdr.msg_iov    = &m_buffers->txVectors[i];
+            m_buffers->txMessages[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    SocketCanInterface::~SocketCanInterface()
+    {
+        closeSocket();
+    }
+
+    QStringList SocketCanInterface::availableDevices()
+    {
+        QStringList devices;
+        const QStringList networkDevices = QDir("/sys/class/net").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+        for (const QString &networkDevice : networkDevices)
+        {
+            QFile typeFile( QString("/sys/class/net/%1/type").arg(networkDevice) );
+
+            if ( ! typeFile.open(QIODevice::ReadOnly) )
+            {
+                continue;
+            }
+
+            if ( typeFile.readAll().trimmed().toInt() == ARPHRD_CAN_TYPE )
+            {
+                devices.append(networkDevice);
+            }
+        }
+
+        return devices;
+    }
+
+    bool SocketCanInterface::connectInterface()
+    {
+        if ( m_connected )
+        {
+            return true;
+        }
+
+        if ( ! openSocket() )
+        {
+            return false;
+        }
+
+        // the hardware clock offset is estimated again, as the controller might have been reset meanwhile
+        m_timestampSource           = CanTimestampSource::Kernel;
+        m_hardwareClockOffsetValid  = false;
+
+        // the kernel counts the dropped frames per socket
+        m_socketDroppedFrames       = 0;
+
+        if ( ! startReaderThread() )
+        {
+            closeSocket();
+            return false;
+        }
+
+        m_writeNotifier = new QSocketNotifier(m_socket, QSocketNotifier::Write, this);
+        m_writeNotifier->setEnabled(false);
+        connect(m_writeNotifier, &QSocketNotifier::activated, this, &SocketCanInterface::writeFrames);
+
+        m_connected = true;
+        emit interfaceConnected();
+
+        return true;
+    }
+
+    bool SocketCanInterface::disconnectInterface()
+    {
+        closeSocket();
+
+        {
+            QMutexLocker locker( &m_txMutex );
+
+            m_writeBlocked = false;
+        }
+
+        clearTransmitQueue();
+
+        if ( m_connected )
+        {
+            m_connected = false;
+            emit interfaceDisconnected();
+        }
+
+        return true;
+    }
+
+    bool SocketCanInterface::supportsFlexibleDataRate() const
+    {
+        // a SocketCAN device supports CAN FD if it accepts frames with the CAN FD MTU
+        QFile mtuFile( QString("/sys/class/net/%1/mtu").arg(m_device) );
+
+        if ( ! mtuFile.open(QIODevice::ReadOnly) )
+        {
+            return false;
+        }
+
+        return mtuFile.readAll().trimmed().toInt() == int(CANFD_MTU);
+    }
+
+    bool SocketCanInterface::flexibleDataRateEnabled() const
+    {
+        return m_flexibleDataRateEnabled;
+    }
+
+    int SocketCanInterface::bitRate() const
+    {
+        return m_bitRate;
+    }
+
+    int SocketCanInterface::dataBitRate() const
+    {
+        return m_dataBitRate;
+    }
+
+    bool SocketCanInterface::localEchoEnabled() const
+    {
+        return m_localEchoEnabled;
+    }
+
+    CanTimestampSource SocketCanInterface::timestampSource() const
+    {
+        return m_timestampSource;
+    }
+
+    bool SocketCanInterface::connected() const
+    {
+        return m_connected;
+    }
+
+    void SocketCanInterface::setFlexibleDataRateEnabled(bool enabled)
+    {
+        m_flexibleDataRateEnabled = enabled;
+        applySocketOptions();
+    }
+
+    void SocketCanInterface::setBitRate(int bitRate)
+    {
+        m_bitRate = bitRate;
+        m_transmitScheduler.setBitRate(bitRate);
+    }
+
+    void SocketCanInterface::setDataBitRate(int dataBitRate)
+    {
+        m_dataBitRate = dataBitRate;
+        m_transmitScheduler.setDataBitRate(dataBitRate);
+    }
+
+    void SocketCanInterface::setLocalEchoEnabled(bool enable)
+    {
+        m_localEchoEnabled = enable;
+        applySocketOptions();
+    }
+
+    void SocketCanInterface::applyFrameFilters(const CanIdFilters &filters)
+    {
+        QMutexLocker locker( &m_filterMutex );
+
+        m_frameFilters = filters;
+        applyKernelFilters();
+    }
+
+    void SocketCanInterface::readerLoop()
+    {
+        // executed in the reader thread
+        struct pollfd descriptors[2];
+
+        descriptors[0].fd       = m_socket;
+        descriptors[0].events   = POLLIN;
+        descriptors[1].fd       = m_wakeupFd;
+        descriptors[1].events   = POLLIN;
+
+        forever
+        {
+            descriptors[0].revents = 0;
+            descriptors[1].revents = 0;
+
+            if ( ::poll(descriptors, 2, -1) < 0 )
+            {
+                if ( errno == EINTR )
+                {
+                    continue;
+                }
+
+                qWarning(LOG_TAG) << "Failed to wait for frames on" << m_device << ":" << std::strerror(errno);
+                socketFailed();
+                return;
+            }
+
+            if ( descriptors[1].revents != 0 )
+            {
+                // woken up by closeSocket()
+                return;
+            }
+
+            if ( descriptors[0].revents & (POLLERR | POLLHUP | POLLNVAL) )
+            {
+                qWarning(LOG_TAG) << "CAN socket of" << m_device << "failed, stop reading frames.";
+                socketFailed();
+                return;
+            }
+
+            readFrames();
+        }
+    }
+
+    void SocketCanInterface::socketFailed()
+    {
+        // executed in the reader thread, senders are rejected from now on
+        m_connected = false;
+
+        QThread *readerThread = QThread::currentThread();
+
+        // the socket is closed in the thread of the interface, which also joins the reader thread
+        QMetaObject::invokeMethod(this, [this, readerThread]()
+        {
+            // unless the interface was reconnected meanwhile
+            if ( m_readerThread == readerThread )
+            {
+                disconnectInterface();
+                emit interfaceDisconnected();
+            }
+        }, Qt::QueuedConnection);
+    }
+
+    void SocketCanInterface::readFrames()
+    {
+        // executed in the reader thread, the socket's receive queue is drained batch by batch
+        forever
+        {
+            for (int i = 0; i < MESSAGE_BATCH_SIZE; i++)
+            {
+                // the kernel updates the control length and flags on every call
+                m_buffers->rxMessages[i].msg_hdr.msg_control    = m_buffers->rxControl[i];
+                m_buffers->rxMessages[i].msg_hdr.msg_controllen = RX_CONTROL_SIZE;
+                m_buffers->rxMessages[i].msg_hdr.msg_flags      = 0;
+            }
+
+            int messageCount = ::recvmmsg(m_socket, m_buffers->rxMessages, MESSAGE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+            if ( messageCount < 0 )
+            {
+                if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+                {
+                    qWarning(LOG_TAG) << "Failed to read frames from" << m_device << ":" << std::strerror(errno);
+                }
+
+                return;
+            }
+
+            QVector<QCanBusFrame> frames;
+            frames.reserve(messageCount);
+
+            for (int i = 0; i < messageCount; i++)
+            {
+                const struct msghdr      &message    = m_buffers->rxMessages[i].msg_hdr;
+                const struct canfd_frame &rawFrame   = m_buffers->rxFrames[i];
+                const unsigned int        frameSize  = m_buffers->rxMessages[i].msg_len;
+
+                if ( frameSize != CAN_MTU && frameSize != CANFD_MTU )
+                {
+                    qWarning(LOG_TAG) << "Ignoring frame with unexpected size" << frameSize << "on" << m_device;
+                    continue;
+                }
+
+                QCanBusFrame frame;
+
+                if ( rawFrame.can_id & CAN_ERR_FLAG )
+                {
+                    // the error class is passed in the ID of an error frame
+                    frame.setFrameType(QCanBusFrame::ErrorFrame);
+                    frame.setError( QCanBusFrame::FrameErrors( int(rawFrame.can_id & CAN_ERR_MASK) ) );
+                }
+                else
+                {
+                    if ( rawFrame.can_id & CAN_RTR_FLAG )
+                    {
+                        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+                    }
+
+                    frame.setExtendedFrameFormat( rawFrame.can_id & CAN_EFF_FLAG );
+                    frame.setFrameId( rawFrame.can_id & CAN_EFF_MASK );
+                }
+                frame.setPayload( QByteArray( reinterpret_cast<const char*>(rawFrame.data), rawFrame.len ) );
+
+                if ( frameSize == CANFD_MTU )
+                {
+                    frame.setFlexibleDataRateFormat(true);
+                    frame.setBitrateSwitch( rawFrame.flags & CANFD_BRS );
+                    frame.setErrorStateIndicator( rawFrame.flags & CANFD_ESI );
+                }
+
+                // frames sent by this socket are flagged by the kernel
+                frame.setLocalEcho( message.msg_flags & MSG_CONFIRM );
+
+                frame.setTimeStamp( QCanBusFrame::TimeStamp::fromMicroSeconds( receiveTimestampUSecs(message) ) );
+
+                frames.append(frame);
+            }
+
+            if ( messageCount > 0 )
+            {
+                // the drop counter is cumulative, so the last message of the batch has the current value
+                countSocketDrops( m_buffers->rxMessages[messageCount - 1].msg_hdr );
+            }
+
+            if ( ! frames.isEmpty() )
+            {
+                dispatchFrames(frames, interfaceIndex());
+            }
+
+            if ( messageCount < MESSAGE_BATCH_SIZE )
+            {
+                // the socket's receive queue is drained
+                return;
+            }
+        }
+    }
+
+    void SocketCanInterface::transmitQueuedFrames()
+    {
+        bool drained = false;
+
+        {
+            QMutexLocker locker( &m_txMutex );
+
+            if ( m_writeScheduled || m_writeBlocked )
+            {
+                // the pending write takes the new frames along
+                return;
+            }
+
+            if ( QThread::currentThread() != thread() )
+            {
+                // Frames sent from another thread (e.g. a bridge's forwarding thread) are written immediately, as
+                // scheduling them in the event loop of this interface's thread would add its latency to every frame.
+                drained = flushTransmitQueue();
+            }
+            else
+            {
+                // frames sent within the same event loop iteration are collected and written with a single sendmmsg() call
+                m_writeScheduled = true;
+                QMetaObject::invokeMethod(this, &SocketCanInterface::writeFrames, Qt::QueuedConnection);
+            }
+        }
+
+        notifyTransmitQueue(drained);
+    }
+
+    void SocketCanInterface::writeFrames()
+    {
+        bool drained = false;
+
+        {
+            QMutexLocker locker( &m_txMutex );
+
+            m_writeScheduled = false;
+            drained = flushTransmitQueue();
+        }
+
+        // the signals are emitted unlocked, as the receivers may send further frames
+        notifyTransmitQueue(drained);
+    }
+
+    bool SocketCanInterface::flushTransmitQueue()
+    {
+        // called with locked tx mutex
+        bool drained = false;
+
+        if ( m_socket < 0 )
+        {
+            return drained;
+        }
+
+        forever
+        {
+            const QVector<QCanBusFrame> frames = peekTransmitQueue(MESSAGE_BATCH_SIZE);
+
+            if ( frames.isEmpty() )
+            {
+                break;
+            }
+
+            int batchSize = 0;
+
+            while ( batchSize < frames.size() && ( m_flexibleDataRateEnabled || ! frames.at(batchSize).hasFlexibleDataRateFormat() ) )
+            {
+                m_buffers->txVectors[batchSize].iov_len = toRawFrame( frames.at(batchSize), m_buffers->txFrames[batchSize] );
+                batchSize++;
+            }
+
+            if ( batchSize == 0 )
+            {
+                qWarning(LOG_TAG) << "Cannot send CAN FD frame on" << name() << "as CAN FD is not enabled.";
+                drained |= acknowledgeTransmittedFrames(0, 1);
+                continue;
+            }
+
+            // frames exceeding the target bus load are held back until the scheduler admits them
+            batchSize = m_transmitScheduler.admit( frames.mid(0, batchSize) );
+
+            if ( batchSize == 0 )
+            {
+                retryWriteLater( int( qMax( (m_transmitScheduler.admissionDelayUSecs() + 999) / 1000, qint64(1) ) ) );
+                return drained;
+            }
+
+            int sentCount = ::sendmmsg(m_socket, m_buffers->txMessages, batchSize, MSG_DONTWAIT);
+
+            if ( sentCount < 0 )
+            {
+                if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                {
+                    // the socket's send buffer is full, continue as soon as the socket gets writable again
+                    setWriteBlocked(true);
+                    return drained;
+                }
+
+                if ( errno == ENOBUFS )
+                {
+                    // the device's transmit queue is full, which is not signaled by the socket notifier
+                    retryWriteLater(TX_QUEUE_FULL_RETRY_MSEC);
+                    return drained;
+                }
+
+                qWarning(LOG_TAG) << "Failed to write frames to" << name() << ":" << std::strerror(errno);
+                drained |= acknowledgeTransmittedFrames(0, transmitQueueDepth());
+                break;
+            }
+
+            drained |= acknowledgeTransmittedFrames(sentCount);
+
+            if ( sentCount < batchSize )
+            {
+                setWriteBlocked(true);
+                return drained;
+            }
+        }
+
+        if ( m_writeBlocked )
+        {
+            setWriteBlocked(false);
+        }
+
+        return drained;
+    }
+
+    void SocketCanInterface::setWriteBlocked(bool blocked)
+    {
+        // called with locked tx mutex, possibly from a sending thread
+        m_writeBlocked = blocked;
+
+        // the notifier belongs to the thread of this interface and is deleted there when the socket gets closed
+        QMetaObject::invokeMethod(this, [this, blocked]()
+        {
+            if ( m_writeNotifier )
+            {
+                m_writeNotifier->setEnabled(blocked);
+            }
+        });
+    }
+
+    void SocketCanInterface::retryWriteLater(int delayMSecs)
+    {
+        // called with locked tx mutex, possibly from a sending thread
+        m_writeScheduled = true;
+
+        QMetaObject::invokeMethod(this, [this, delayMSecs]()
+        {
+            QTimer::singleShot(delayMSecs, Qt::PreciseTimer, this, &SocketCanInterface::writeFrames);
+        });
+    }
+
+    size_t SocketCanInterface::toRawFrame(const QCanBusFrame &frame, struct canfd_frame &rawFrame)
+    {
+        const QByteArray    payload     = frame.payload();
+        const bool          isFdFrame   = frame.hasFlexibleDataRateFormat();
+
+        std::memset( &rawFrame, 0, sizeof(rawFrame) );
+
+        rawFrame.can_id = frame.frameId();
+
+        if ( frame.hasExtendedFrameFormat() )
+        {
+            rawFrame.can_id |= CAN_EFF_FLAG;
+        }
+
+        if ( frame.frameType() == QCanBusFrame::RemoteRequestFrame )
+        {
+            rawFrame.can_id |= CAN_RTR_FLAG;
+        }
+
+        rawFrame.len = quint8( qMin( payload.size(), isFdFrame ? int(CANFD_MAX_DLEN) : int(CAN_MAX_DLEN) ) );
+        std::memcpy( rawFrame.data, payload.constData(), rawFrame.len );
+
+        if ( isFdFrame )
+        {
+            if ( frame.hasBitrateSwitch() )
+            {
+                rawFrame.flags |= CANFD_BRS;
+            }
+
+            if ( frame.hasErrorStateIndicator() )
+            {
+                rawFrame.flags |= CANFD_ESI;
+            }
+        }
+
+        return isFdFrame ? CANFD_MTU : CAN_MTU;
+    }
+
+    bool SocketCanInterface::openSocket()
+    {
+        m_socket = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+
+        if ( m_socket < 0 )
+        {
+            qCritical(LOG_TAG) << "Failed to create CAN socket:" << std::strerror(errno);
+            return false;
+        }
+
+        unsigned int interfaceIndex = ::if_nametoindex( m_device.toLatin1().constData() );
+
+        if ( interfaceIndex == 0 )
+        {
+            qCritical(LOG_TAG) << "Unknown SocketCAN device" << m_device;
+            closeSocket();
+            return false;
+        }
+
+        struct sockaddr_can address;
+        std::memset( &address, 0, sizeof(address) );
+
+        address.can_family  = AF_CAN;
+        address.can_ifindex = int(interfaceIndex);
+
+        if ( ::bind(m_socket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0 )
+        {
+            qCritical(LOG_TAG) << "Failed to bind CAN socket to" << m_device << ":" << std::strerror(errno);
+            closeSocket();
+            return false;
+        }
+
+        if ( ! applySocketOptions() )
+        {
+            closeSocket();
+            return false;
+        }
+
+        enableHardwareTimestamps();
+
+        return true;
+    }
+
+    void SocketCanInterface::enableHardwareTimestamps()
+    {
+        struct hwtstamp_config config;
+        std::memset( &config, 0, sizeof(config) );
+
+        config.tx_type   = HWTSTAMP_TX_OFF;
+        config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+        struct ifreq request;
+        std::memset( &request, 0, sizeof(request) );
+
+        std::strncpy( request.ifr_name, m_device.toLatin1().constData(), IFNAMSIZ - 1 );
+        request.ifr_data = reinterpret_cast<char*>(&config);
+
+        // most CAN controllers either timestamp all frames anyway or do not support hardware timestamps at all,
+        // enabling it may also require CAP_NET_ADMIN, so a failure here is not an error
+        if ( ::ioctl(m_socket, SIOCSHWTSTAMP, &request) < 0 )
+        {
+            qDebug(LOG_TAG) << "Hardware timestamping not enabled on" << m_device << ":" << std::strerror(errno);
+        }
+    }
+
+    void SocketCanInterface::countSocketDrops(const struct msghdr &message)
+    {
+        for (struct cmsghdr *controlMessage = CMSG_FIRSTHDR(&message); controlMessage != nullptr; controlMessage = CMSG_NXTHDR(const_cast<struct msghdr*>(&message), controlMessage))
+        {
+            if ( controlMessage->cmsg_level != SOL_SOCKET || controlMessage->cmsg_type != SO_RXQ_OVFL )
+            {
+                continue;
+            }
+
+            quint32 droppedFrames = 0;
+            std::memcpy( &droppedFrames, CMSG_DATA(controlMessage), sizeof(droppedFrames) );
+
+            // the unsigned difference also holds if the kernel's counter wraps around
+            if ( droppedFrames != m_socketDroppedFrames )
+            {
+                countOverflowFrames( quint32(droppedFrames - m_socketDroppedFrames) );
+                m_socketDroppedFrames = droppedFrames;
+            }
+
+            return;
+        }
+    }
+
+    qint64 SocketCanInterface::receiveTimestampUSecs(const struct msghdr &message)
+    {
+        for (struct cmsghdr *controlMessage = CMSG_FIRSTHDR(&message); controlMessage != nullptr; controlMessage = CMSG_NXTHDR(const_cast<struct msghdr*>(&message), controlMessage))
+        {
+            if ( controlMessage->cmsg_level != SOL_SOCKET || controlMessage->cmsg_type != SCM_TIMESTAMPING )
+            {
+                continue;
+            }
+
+            struct scm_timestamping timestamps;
+            std::memcpy( &timestamps, CMSG_DATA(controlMessage), sizeof(timestamps) );
+
+            // ts[0] holds the software timestamp, ts[2] the raw hardware timestamp
+            const qint64 softwareUSecs = toMicroSeconds( timestamps.ts[0] );
+            const qint64 hardwareUSecs = toMicroSeconds( timestamps.ts[2] );
+
+            if ( hardwareUSecs != 0 && softwareUSecs != 0 )
+            {
+                // The controller's clock runs in its own time domain. Map it into the system time domain with the
+                // offset to the software timestamp. The software timestamp is taken after the hardware timestamp,
+                // so the smallest offset seen is the one with the least interrupt and scheduling latency.
+                const qint64 offsetUSecs = softwareUSecs - hardwareUSecs;
+
+                if ( ! m_hardwareClockOffsetValid || offsetUSecs < m_hardwareClockOffsetUSecs )
+                {
+                    m_hardwareClockOffsetUSecs = offsetUSecs;
+                    m_hardwareClockOffsetValid = true;
+                }
+
+                m_timestampSource = CanTimestampSource::Hardware;
+
+                return hardwareUSecs + m_hardwareClockOffsetUSecs;
+            }
+
+            if ( softwareUSecs != 0 )
+            {
+                return softwareUSecs;
+            }
+        }
+
+        // no timestamp provided by the kernel, fall back to the current system time
+        struct timespec now;
+        ::clock_gettime(CLOCK_REALTIME, &now);
+
+        return toMicroSeconds(now);
+    }
+
+    bool SocketCanInterface::startReaderThread()
+    {
+        m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if ( m_wakeupFd < 0 )
+        {
+            qCritical(LOG_TAG) << "Failed to create wakeup event for" << m_device << ":" << std::strerror(errno);
+            return false;
+        }
+
+        m_readerThread = QThread::create([this]() { readerLoop(); });
+        m_readerThread->setObjectName( QString("CAN RX %1").arg(m_device) );
+        m_readerThread->start();
+
+        return true;
+    }
+
+    void SocketCanInterface::stopReaderThread()
+    {
+        if ( m_readerThread != nullptr )
+        {
+            const quint64 wakeup = 1;
+
+            if ( ::write(m_wakeupFd, &wakeup, sizeof(wakeup)) < 0 )
+            {
+                qWarning(LOG_TAG) << "Failed to wake up reader thread of" << m_device << ":" << std::strerror(errno);
+            }
+
+            m_readerThread->wait();
+
+            delete m_readerThread;
+            m_readerThread = nullptr;
+        }
+
+        if ( m_wakeupFd >= 0 )
+        {
+            ::close(m_wakeupFd);
+            m_wakeupFd = -1;
+        }
+    }
+
+    void SocketCanInterface::closeSocket()
+    {
+        // the reader thread has to be stopped before its socket gets closed
+        stopReaderThread();
+
+        // other threads may write to the socket until it is closed
+        QMutexLocker locker( &m_txMutex );
+
+        delete m_writeNotifier;
+        m_writeNotifier = nullptr;
+
+        if ( m_socket >= 0 )
+        {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    bool SocketCanInterface::applySocketOptions()
+    {
+        if ( m_socket < 0 )
+        {
+            // options are applied as soon as the socket gets opened
+            return true;
+        }
+
+        const int localEcho         = m_localEchoEnabled ? 1 : 0;
+        const int flexibleDataRate  = m_flexibleDataRateEnabled ? 1 : 0;
+        const int timestamps        = TIMESTAMPING_FLAGS;
+        const can_err_mask_t errors = CAN_ERR_MASK;
+        const int dropCounter       = 1;
+
+        bool success = true;
+
+        success &= ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_LOOPBACK,        &localEcho,         sizeof(localEcho))          == 0;
+        success &= ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS,   &localEcho,         sizeof(localEcho))          == 0;
+        success &= ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER,      &errors,            sizeof(errors))             == 0;
+        success &= ::setsockopt(m_socket, SOL_SOCKET,  SO_TIMESTAMPING,         &timestamps,        sizeof(timestamps))         == 0;
+        success &= ::setsockopt(m_socket, SOL_SOCKET,  SO_RXQ_OVFL,             &dropCounter,       sizeof(dropCounter))        == 0;
+
+        if ( ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &flexibleDataRate, sizeof(flexibleDataRate)) != 0 && m_flexibleDataRateEnabled )
+        {
+            qWarning(LOG_TAG) << "Failed to enable CAN FD on" << m_device << ":" << std::strerror(errno);
+            success = false;
+        }
+
+        {
+            QMutexLocker locker( &m_filterMutex );
+            success &= applyKernelFilters();
+        }
+
+        if ( ! success )
+        {
+            qCritical(LOG_TAG) << "Failed to configure CAN socket for" << m_device;
+        }
+
+        return success;
+    }
+
+    bool SocketCanInterface::applyKernelFilters()
+    {
+        // called with locked filter mutex
+        if ( m_socket < 0 )
+        {
+            // filters are applied as soon as the socket gets opened
+            return true;
+        }
+
+        QVector<struct can_filter> kernelFilters;
+
+        if ( m_frameFilters.isEmpty() || m_frameFilters.size() > MAX_KERNEL_FILTERS )
+        {
+            // receive all frames, the filters are applied by the receivers anyway
+            struct can_filter acceptAll;
+
+            acceptAll.can_id    = 0;
+            acceptAll.can_mask  = 0;
+
+            kernelFilters.append(acceptAll);
+        }
+        else
+        {
+            for (const CanIdFilter &filter : qAsConst(m_frameFilters) )
+            {
+                struct can_filter kernelFilter;
+
+                // the frame format is not part of the mask, so standard and extended frames match both
+                kernelFilter.can_id     = filter.frameId & filter.mask;
+                kernelFilter.can_mask   = filter.mask;
+
+                kernelFilters.append(kernelFilter);
+            }
+        }
+
+        if ( ::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, kernelFilters.constData(), socklen_t( kernelFilters.size() * sizeof(struct can_filter) )) != 0 )
+        {
+            qWarning(LOG_TAG) << "Failed to install frame filters on" << m_device << ":" << std::strerror(errno);
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,354 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/tracereplayinterface.h"
+#include "cantracefile/icantracefilereader.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
+
+    // frames read from the trace file at once
+    const int REPLAY_BATCH_SIZE = 256;
+
+    // the replay thread checks for a stop request at least this often while waiting for the next frame
+    const qint64 STOP_CHECK_INTERVAL_NSECS = 50000000;
+
+    // while replaying as fast as possible, the replay thread polls this often for the receivers to catch up
+    const qint64 BACKLOG_POLL_INTERVAL_NSECS = 100000;
+
+    qint64 steadyClockNSecs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    qint64 timestampUSecs(const QCanBusFrame &frame)
+    {
+        return frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    const char* const TraceReplayInterface::InterfaceType = "replay";
+
+    TraceReplayInterface::TraceReplayInterface(const QString &id, const QString &fileName)
+        : AbstractCanInterface(id, InterfaceType, fileName)
+    {
+
+    }
+
+    TraceReplayInterface::~TraceReplayInterface()
+    {
+        stopReplayThread();
+    }
+
+    void TraceReplayInterface::setReplaySpeed(double speed)
+    {
+        m_replaySpeed = qMax(speed, 0.0);
+    }
+
+    double TraceReplayInterface::replaySpeed() const
+    {
+        return m_replaySpeed;
+    }
+
+    bool TraceReplayInterface::connectInterface()
+    {
+        if ( m_connected )
+        {
+            return true;
+        }
+
+        // the file is opened here, so a missing file is reported to the caller
+        ICanTraceFileReaderPtr reader = ICanTraceFileReader::createReader(m_device);
+
+        if ( ! reader )
+        {
+            qCritical(LOG_TAG) << "Unsupported trace file format:" << m_device;
+            return false;
+        }
+
+        if ( ! reader->open(m_device) )
+        {
+            qCritical(LOG_TAG) << "Failed to open trace file" << m_device << ":" << reader->errorString();
+            return false;
+        }
+
+        std::shared_ptr<ICanTraceFileReader> sharedReader( reader.release() );
+
+        m_stopRequested = false;
+        m_replayThread  = QThread::create([this, sharedReader]()
+        {
+            replayLoop(*sharedReader);
+        });
+
+        m_connected = true;
+
+        m_replayThread->setObjectName( QString("CAN replay %1").arg(m_name) );
+        m_replayThread->start();
+
+        emit interfaceConnected();
+
+        return true;
+    }
+
+    bool TraceReplayInterface::disconnectInterface()
+    {
+        stopReplayThread();
+        clearTransmitQueue();
+
+        if ( m_connected )
+        {
+            m_connected = false;
+            emit interfaceDisconnected();
+        }
+
+        return true;
+    }
+
+    bool TraceReplayInterface::supportsFlexibleDataRate() const
+    {
+        return true;
+    }
+
+    bool TraceReplayInterface::flexibleDataRateEnabled() const
+    {
+        return m_flexibleDataRateEnabled;
+    }
+
+    int TraceReplayInterface::bitRate() const
+    {
+        return m_bitRate;
+    }
+
+    int TraceReplayInterface::dataBitRate() const
+    {
+        return m_dataBitRate;
+    }
+
+    bool TraceReplayInterface::localEchoEnabled() const
+    {
+        return m_localEchoEnabled;
+    }
+
+    CanTimestampSource TraceReplayInterface::timestampSource() const
+    {
+        // the frames keep the timestamps of the recording, whose origin is not known
+        return CanTimestampSource::Unknown;
+    }
+
+    bool TraceReplayInterface::connected() const
+    {
+        return m_connected;
+    }
+
+    void TraceReplayInterface::setFlexibleDataRateEnabled(bool enabled)
+    {
+        m_flexibleDataRateEnabled = enabled;
+    }
+
+    void TraceReplayInterface::setBitRate(int bitRate)
+    {
+        m_bitRate = bitRate;
+
+        // frames are not paced while replaying, the bit rate is only used to estimate the bus load of the trace
+        m_transmitScheduler.setBitRate(bitRate);
+    }
+
+    void TraceReplayInterface::setDataBitRate(int dataBitRate)
+    {
+        m_dataBitRate = dataBitRate;
+        m_transmitScheduler.setDataBitRate(dataBitRate);
+    }
+
+    void TraceReplayInterface::setLocalEchoEnabled(bool enable)
+    {
+        m_localEchoEnabled = enable;
+    }
+
+    void TraceReplayInterface::transmitQueuedFrames()
+    {
+        // senders may call this concurrently, the frames are taken from the queue by one sender at a time
+        QMutexLocker locker( &m_transmitMutex );
+
+        const QVector<QCanBusFrame> frames = peekTransmitQueue( transmitQueueDepth() );
+
+        if ( frames.isEmpty() )
+        {
+            return;
+        }
+
+        const bool drained = acknowledgeTransmittedFrames( frames.size() );
+
+        if ( m_localEchoEnabled )
+        {
+            const qint64            nowUSecs    = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+            QVector<QCanBusFrame>   echoFrames  = frames;
+
+            for (QCanBusFrame &frame : echoFrames)
+            {
+                frame.setLocalEcho(true);
+                frame.setTimeStamp( QCanBusFrame::TimeStamp::fromMicroSeconds(nowUSecs) );
+            }
+
+            dispatchFrames(echoFrames, interfaceIndex());
+        }
+
+        locker.unlock();
+
+        notifyTransmitQueue(drained);
+    }
+
+    void TraceReplayInterface::replayLoop(ICanTraceFileReader &reader)
+    {
+        // executed in the replay thread
+        QVector<QCanBusFrame> frames;
+        frames.reserve(REPLAY_BATCH_SIZE);
+
+        qint64  firstTimestampUSecs = 0;
+        qint64  startNSecs          = 0;
+        bool    started             = false;
+
+        while ( ! m_stopRequested && reader.readFrames(frames, REPLAY_BATCH_SIZE) > 0 )
+        {
+            const double speed = m_replaySpeed;
+
+            if ( ! started )
+            {
+                firstTimestampUSecs = timestampUSecs( frames.first() );
+                startNSecs          = steadyClockNSecs();
+                started             = true;
+            }
+
+            if ( speed <= 0.0 )
+            {
+                // the pace is set by the slowest receiver, so no frames are dropped
+                if ( ! waitForReceivers() )
+                {
+                    return;
+                }
+
+                dispatchFrames(frames, interfaceIndex());
+                frames.clear();
+                continue;
+            }
+
+            // frames which are due at the same time are delivered together
+            int batchBegin = 0;
+
+            while ( batchBegin < frames.size() )
+            {
+                const qint64 dueNSecs = startNSecs + qint64( double( timestampUSecs( frames.at(batchBegin) ) - firstTimestampUSecs ) * 1000.0 / speed );
+
+                if ( ! waitUntil(dueNSecs) )
+                {
+                    return;
+                }
+
+                const qint64 nowNSecs = steadyClockNSecs();
+                int batchEnd = batchBegin + 1;
+
+                while ( batchEnd < frames.size() && startNSecs + qint64( double( timestampUSecs( frames.at(batchEnd) ) - firstTimestampUSecs ) * 1000.0 / speed ) <= nowNSecs )
+                {
+                    batchEnd++;
+                }
+
+                dispatchFrames( frames.mid(batchBegin, batchEnd - batchBegin), interfaceIndex() );
+                batchBegin = batchEnd;
+            }
+
+            frames.clear();
+        }
+
+        reader.close();
+
+        if ( ! m_stopRequested )
+        {
+            qInfo(LOG_TAG) << "Replay of" << m_device << "finished.";
+
+            // the interface disconnects itself in its own thread, which also joins this thread
+            QThread *replayThread = QThread::currentThread();
+
+            QMetaObject::invokeMethod(this, [this, replayThread]()
+            {
+                // unless the interface was reconnected meanwhile
+                if ( m_replayThread == replayThread )
+                {
+                    disconnectInterface();
+                }
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    bool TraceReplayInterface::waitUntil(qint64 steadyNSecs)
+    {
+        forever
+        {
+            if ( m_stopRequested )
+            {
+                return false;
+            }
+
+            const qint64 nowNSecs = steadyClockNSecs();
+
+            if ( nowNSecs >= steadyNSecs )
+            {
+                return true;
+            }
+
+            const qint64 sleepUntilNSecs = qMin( steadyNSecs, nowNSecs + STOP_CHECK_INTERVAL_NSECS );
+
+            std::this_thread::sleep_until( std::chrono::steady_clock::time_point( std::chrono::nanoseconds(sleepUntilNSecs) ) );
+        }
+    }
+
+    bool TraceReplayInterface::waitForReceivers()
+    {
+        while ( receiversBacklogged() )
+        {
+            if ( ! waitUntil( steadyClockNSecs() + BACKLOG_POLL_INTERVAL_NSECS ) )
+            {
+                return false;
+            }
+        }
+
+        return ! m_stopRequested;
+    }
+
+    void TraceReplayInterface::stopReplayThread()
+    {
+        if ( m_replayThread != nullptr )
+        {
+            m_stopRequested = true;
+
+            m_replayThread->wait();
+
+            delete m_replayThread;
+            m_replayThread = nullptr;
+        }
+    }
+}
@@ -0,0 +1,363 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/virtualcanbus.h"
+#include "caninterface/virtualcaninterface.h"
+
+#include <QMap>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QThread>
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    const int AVAILABLE_BUS_COUNT = 4;
+
+    QMutex s_busesMutex;
+    QMap<QString, std::weak_ptr<Lindwurm::Lib::VirtualCanBus>> s_buses;
+
+    qint64 steadyClockNSecs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    VirtualCanBusSharedPtr VirtualCanBus::bus(const QString &name)
+    {
+        QMutexLocker locker( &s_busesMutex );
+
+        VirtualCanBusSharedPtr bus = s_buses.value(name).lock();
+
+        if ( ! bus )
+        {
+            bus = std::make_shared<VirtualCanBus>(name);
+            s_buses.insert(name, bus);
+        }
+
+        return bus;
+    }
+
+    QStringList VirtualCanBus::availableBuses()
+    {
+        QStringList buses;
+
+        for (int i = 0; i < AVAILABLE_BUS_COUNT; i++)
+        {
+            buses.append( QString("vbus%1").arg(i) );
+        }
+
+        return buses;
+    }
+
+    VirtualCanBus::VirtualCanBus(const QString &name)
+        : m_name(name)
+    {
+        m_busThread = QThread::create([this]() { busLoop(); });
+        m_busThread->setObjectName( QString("Virtual CAN bus %1").arg(name) );
+        m_busThread->start();
+    }
+
+    VirtualCanBus::~VirtualCanBus()
+    {
+        {
+            QMutexLocker locker( &m_wakeMutex );
+
+            m_stopRequested = true;
+            m_wakeCondition.wakeAll();
+        }
+
+        m_busThread->wait();
+        delete m_busThread;
+    }
+
+    QString VirtualCanBus::name() const
+    {
+        return m_name;
+    }
+
+    void VirtualCanBus::setArbitrationEnabled(bool enabled)
+    {
+        m_arbitrationEnabled = enabled;
+    }
+
+    bool VirtualCanBus::arbitrationEnabled() const
+    {
+        return m_arbitrationEnabled;
+    }
+
+    void VirtualCanBus::setFrameLossProbability(double probability)
+    {
+        m_frameLossProbability = qBound(0.0, probability, 1.0);
+    }
+
+    double VirtualCanBus::frameLossProbability() const
+    {
+        return m_frameLossProbability;
+    }
+
+    void VirtualCanBus::setJitterUSecs(int jitterUSecs)
+    {
+        m_jitterUSecs = qMax(jitterUSecs, 0);
+    }
+
+    int VirtualCanBus::jitterUSecs() const
+    {
+        return m_jitterUSecs;
+    }
+
+    quint64 VirtualCanBus::transmittedFrameCount() const
+    {
+        return m_transmittedFrames;
+    }
+
+    quint64 VirtualCanBus::lostFrameCount() const
+    {
+        return m_lostFrames;
+    }
+
+    void VirtualCanBus::attach(VirtualCanInterface *endpoint)
+    {
+        {
+            QMutexLocker locker( &m_endpointsMutex );
+
+            for (const Endpoint &attachedEndpoint : qAsConst(m_endpoints) )
+            {
+                if ( attachedEndpoint.interface == endpoint )
+                {
+                    return;
+                }
+            }
+
+            m_endpoints.append( Endpoint{endpoint, m_nextGeneration++} );
+        }
+
+        // the endpoint might have queued frames before it was connected
+        wake();
+    }
+
+    void VirtualCanBus::detach(VirtualCanInterface *endpoint)
+    {
+        QMutexLocker locker( &m_endpointsMutex );
+
+        for (int i = 0; i < m_endpoints.size(); i++)
+        {
+            if ( m_endpoints.at(i).interface == endpoint )
+            {
+                m_endpoints.remove(i);
+                break;
+            }
+        }
+    }
+
+    void VirtualCanBus::wake()
+    {
+        QMutexLocker locker( &m_wakeMutex );
+
+        m_wakePending = true;
+        m_wakeCondition.wakeOne();
+    }
+
+    void VirtualCanBus::busLoop()
+    {
+        // executed in the bus thread
+        qint64 busIdleAtNSecs = 0;
+
+        forever
+        {
+            {
+                QMutexLocker locker( &m_wakeMutex );
+
+                if ( m_stopRequested )
+                {
+                    return;
+                }
+
+                // frames queued after this point wake the bus again
+                m_wakePending = false;
+            }
+
+            Endpoint        sender          = {nullptr, 0};
+            QCanBusFrame    frame;
+            qint64          durationNSecs   = 0;
+            qint64          waitUSecs       = -1;
+
+            if ( ! nextTransmission(sender, frame, durationNSecs, waitUSecs) )
+            {
+                waitForFrames(waitUSecs);
+                continue;
+            }
+
+            const int jitterUSecs = m_jitterUSecs;
+
+            if ( jitterUSecs > 0 )
+            {
+                durationNSecs += qint64( QRandomGenerator::global()->bounded(jitterUSecs + 1) ) * 1000;
+            }
+
+            // the frame occupies the bus from the end of the previous frame on, so oversleeping does not lower the bus load
+            busIdleAtNSecs = qMax( busIdleAtNSecs, steadyClockNSecs() ) + durationNSecs;
+
+            if ( durationNSecs > 0 )
+            {
+                std::this_thread::sleep_until( std::chrono::steady_clock::time_point( std::chrono::nanoseconds(busIdleAtNSecs) ) );
+            }
+
+            completeTransmission(sender, frame);
+        }
+    }
+
+    bool VirtualCanBus::nextTransmission(Endpoint &sender, QCanBusFrame &frame, qint64 &durationNSecs, qint64 &waitUSecs)
+    {
+        QMutexLocker locker( &m_endpointsMutex );
+
+        const int   endpointCount   = m_endpoints.size();
+        int         winner          = -1;
+        quint64     winnerKey       = 0;
+
+        for (int i = 0; i < endpointCount; i++)
+        {
+            // without arbitration the endpoints take turns
+            const int       endpoint = (m_nextEndpoint + i) % endpointCount;
+            QCanBusFrame    candidate;
+            qint64          admissionDelayUSecs = 0;
+
+            if ( ! m_endpoints.at(endpoint).interface->nextFrame(candidate, admissionDelayUSecs) )
+            {
+                if ( admissionDelayUSecs > 0 )
+                {
+                    // the endpoint's frame is held back by its target bus load
+                    waitUSecs = (waitUSecs < 0) ? admissionDelayUSecs : qMin(waitUSecs, admissionDelayUSecs);
+                }
+
+                continue;
+            }
+
+            const quint64 candidateKey = arbitrationKey(candidate);
+
+            if ( winner < 0 || candidateKey < winnerKey )
+            {
+                winner      = endpoint;
+                winnerKey   = candidateKey;
+                frame       = candidate;
+            }
+
+            if ( ! m_arbitrationEnabled )
+            {
+                break;
+            }
+        }
+
+        if ( winner < 0 )
+        {
+            return false;
+        }
+
+        m_nextEndpoint  = (winner + 1) % endpointCount;
+        sender          = m_endpoints.at(winner);
+        durationNSecs   = sender.interface->frameDurationNSecs(frame);
+
+        return true;
+    }
+
+    void VirtualCanBus::completeTransmission(const Endpoint &sender, QCanBusFrame frame)
+    {
+        QMutexLocker locker( &m_endpointsMutex );
+
+        bool senderAttached = false;
+
+        for (const Endpoint &endpoint : qAsConst(m_endpoints) )
+        {
+            if ( endpoint.generation == sender.generation )
+            {
+                senderAttached = true;
+                break;
+            }
+        }
+
+        if ( ! senderAttached )
+        {
+            // the sender was disconnected while its frame was on the bus
+            return;
+        }
+
+        const qint64 nowUSecs = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+        frame.setTimeStamp( QCanBusFrame::TimeStamp::fromMicroSeconds(nowUSecs) );
+
+        m_transmittedFrames++;
+
+        sender.interface->frameTransmitted(frame);
+
+        const double lossProbability = m_frameLossProbability;
+
+        for (const Endpoint &endpoint : qAsConst(m_endpoints) )
+        {
+            if ( endpoint.generation == sender.generation )
+            {
+                continue;
+            }
+
+            if ( lossProbability > 0.0 && QRandomGenerator::global()->generateDouble() < lossProbability )
+            {
+                m_lostFrames++;
+                continue;
+            }
+
+            endpoint.interface->frameReceived(frame);
+        }
+    }
+
+    void VirtualCanBus::waitForFrames(qint64 waitUSecs)
+    {
+        QMutexLocker locker( &m_wakeMutex );
+
+        if ( m_wakePending || m_stopRequested )
+        {
+            return;
+        }
+
+        if ( waitUSecs < 0 )
+        {
+            m_wakeCondition.wait( &m_wakeMutex );
+        }
+        else
+        {
+            m_wakeCondition.wait( &m_wakeMutex, (unsigned long)( (waitUSecs + 999) / 1000 ) );
+        }
+    }
+
+    quint64 VirtualCanBus::arbitrationKey(const QCanBusFrame &frame)
+    {
+        // the bits are compared in the order they are sent: base ID, RTR or SRR, IDE, extended ID and RTR
+        // a dominant bit (0) wins, so data frames win over remote frames and base frames over extended frames
+        const quint64 remote = (frame.frameType() == QCanBusFrame::RemoteRequestFrame) ? 1 : 0;
+
+        if ( frame.hasExtendedFrameFormat() )
+        {
+            const quint64 baseId        = (frame.frameId() >> 18) & 0x7FF;
+            const quint64 extendedId    = frame.frameId() & 0x3FFFF;
+
+            return (baseId << 21) | (quint64(1) << 20) | (quint64(1) << 19) | (extendedId << 1) | remote;
+        }
+
+        return (quint64(frame.frameId() & 0x7FF) << 21) | (remote << 20);
+    }
+}
@@ -0,0 +1,195 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "caninterface/virtualcaninterface.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.interface")
+}
+
+namespace Lindwurm::Lib
+{
+    const char* const VirtualCanInterface::InterfaceType = "virtual";
+
+    VirtualCanInterface::VirtualCanInterface(const QString &id, const QString &device)
+        : AbstractCanInterface(id, InterfaceType, device), m_bus( VirtualCanBus::bus(device) )
+    {
+
+    }
+
+    VirtualCanInterface::~VirtualCanInterface()
+    {
+        // the bus must not access this endpoint anymore
+        m_bus->detach(this);
+    }
+
+    VirtualCanBusSharedPtr VirtualCanInterface::bus() const
+    {
+        return m_bus;
+    }
+
+    bool VirtualCanInterface::connectInterface()
+    {
+        if ( m_connected )
+        {
+            return true;
+        }
+
+        m_connected = true;
+        m_bus->attach(this);
+
+        emit interfaceConnected();
+
+        return true;
+    }
+
+    bool VirtualCanInterface::disconnectInterface()
+    {
+        m_bus->detach(this);
+        clearTransmitQueue();
+
+        if ( m_connected )
+        {
+            m_connected = false;
+            emit interfaceDisconnected();
+        }
+
+        return true;
+    }
+
+    bool VirtualCanInterface::supportsFlexibleDataRate() const
+    {
+        return true;
+    }
+
+    bool VirtualCanInterface::flexibleDataRateEnabled() const
+    {
+        return m_flexibleDataRateEnabled;
+    }
+
+    int VirtualCanInterface::bitRate() const
+    {
+        return m_bitRate;
+    }
+
+    int VirtualCanInterface::dataBitRate() const
+    {
+        return m_dataBitRate;
+    }
+
+    bool VirtualCanInterface::localEchoEnabled() const
+    {
+        return m_localEchoEnabled;
+    }
+
+    CanTimestampSource VirtualCanInterface::timestampSource() const
+    {
+        return CanTimestampSource::Simulated;
+    }
+
+    bool VirtualCanInterface::connected() const
+    {
+        return m_connected;
+    }
+
+    void VirtualCanInterface::setFlexibleDataRateEnabled(bool enabled)
+    {
+        m_flexibleDataRateEnabled = enabled;
+    }
+
+    void VirtualCanInterface::setBitRate(int bitRate)
+    {
+        m_bitRate = bitRate;
+        m_transmitScheduler.setBitRate(bitRate);
+    }
+
+    void VirtualCanInterface::setDataBitRate(int dataBitRate)
+    {
+        m_dataBitRate = dataBitRate;
+        m_transmitScheduler.setDataBitRate(dataBitRate);
+    }
+
+    void VirtualCanInterface::setLocalEchoEnabled(bool enable)
+    {
+        m_localEchoEnabled = enable;
+    }
+
+    void VirtualCanInterface::transmitQueuedFrames()
+    {
+        // the bus thread takes the frames from the transmit queue as soon as they win the arbitration
+        m_bus->wake();
+    }
+
+    bool VirtualCanInterface::nextFrame(QCanBusFrame &frame, qint64 &admissionDelayUSecs)
+    {
+        forever
+        {
+            const QVector<QCanBusFrame> frames = peekTransmitQueue(1);
+
+            if ( frames.isEmpty() )
+            {
+                return false;
+            }
+
+            if ( frames.first().hasFlexibleDataRateFormat() && ! m_flexibleDataRateEnabled )
+            {
+                qWarning(LOG_TAG) << "Cannot send CAN FD frame on" << name() << "as CAN FD is not enabled.";
+                notifyTransmitQueue( acknowledgeTransmittedFrames(0, 1) );
+                continue;
+            }
+
+            admissionDelayUSecs = m_transmitScheduler.admissionDelayUSecs();
+
+            if ( admissionDelayUSecs > 0 )
+            {
+                return false;
+            }
+
+            frame = frames.first();
+            return true;
+        }
+    }
+
+    qint64 VirtualCanInterface::frameDurationNSecs(const QCanBusFrame &frame) const
+    {
+        return CanTransmitScheduler::frameDurationNSecs(frame, m_bitRate, m_flexibleDataRateEnabled ? int(m_dataBitRate) : 0);
+    }
+
+    void VirtualCanInterface::frameTransmitted(const QCanBusFrame &frame)
+    {
+        // the frame is charged to the target bus load after it won the arbitration
+        m_transmitScheduler.admit( QVector<QCanBusFrame>{frame} );
+        notifyTransmitQueue( acknowledgeTransmittedFrames(1) );
+
+        if ( m_localEchoEnabled )
+        {
+            QCanBusFrame echoFrame = frame;
+            echoFrame.setLocalEcho(true);
+
+            dispatchFrames( QVector<QCanBusFrame>{echoFrame}, interfaceIndex() );
+        }
+    }
+
+    void VirtualCanInterface::frameReceived(const QCanBusFrame &frame)
+    {
+        dispatchFrames( QVector<QCanBusFrame>{frame}, interfaceIndex() );
+    }
+}
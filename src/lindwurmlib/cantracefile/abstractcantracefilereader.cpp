@@ -0,0 +1,253 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cantracefile/abstractcantracefilereader.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+}
+
+namespace Lindwurm::Lib
+{
+    AbstractCanTraceFileReader::AbstractCanTraceFileReader()
+    {
+
+    }
+
+    AbstractCanTraceFileReader::~AbstractCanTraceFileReader()
+    {
+
+    }
+
+    bool AbstractCanTraceFileReader::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::ReadOnly) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_errorString.clear();
+        m_skippedRecords    = 0;
+        m_pendingIndex      = 0;
+        m_blocksFinished    = false;
+
+        if ( ! readHeader() )
+        {
+            m_file.close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void AbstractCanTraceFileReader::close()
+    {
+        if ( m_file.isOpen() )
+        {
+            if ( m_skippedRecords > 0 )
+            {
+                qWarning(LOG_TAG) << "Skipped" << m_skippedRecords.load() << "invalid records of" << m_file.fileName();
+            }
+
+            m_file.close();
+        }
+
+        m_carry.clear();
+        m_carryContext.clear();
+        m_pendingFrames.clear();
+    }
+
+    bool AbstractCanTraceFileReader::atEnd() const
+    {
+        return ! m_file.isOpen() || ( m_blocksFinished && m_pendingIndex >= m_pendingFrames.size() );
+    }
+
+    int AbstractCanTraceFileReader::readFrames(QVector<QCanBusFrame> &frames, int maxCount)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            return 0;
+        }
+
+        while ( m_pendingFrames.size() - m_pendingIndex < maxCount && ! m_blocksFinished )
+        {
+            CanTraceFileBlock block;
+
+            if ( readBlock(block) )
+            {
+                decodeBlock(block);
+                completeBlock(block);
+            }
+            else
+            {
+                finishBlocks(block);
+                m_blocksFinished = true;
+            }
+
+            m_pendingFrames.remove(0, m_pendingIndex);
+            m_pendingFrames.append(block.frames);
+            m_pendingIndex = 0;
+        }
+
+        const int readCount = qMin( maxCount, m_pendingFrames.size() - m_pendingIndex );
+
+        frames.append( m_pendingFrames.mid(m_pendingIndex, readCount) );
+        m_pendingIndex += readCount;
+
+        return readCount;
+    }
+
+    bool AbstractCanTraceFileReader::readBlock(CanTraceFileBlock &block)
+    {
+        if ( ! m_file.isOpen() || m_file.atEnd() )
+        {
+            return false;
+        }
+
+        block.data = m_file.read(BlockSize);
+
+        if ( block.data.isEmpty() )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    void AbstractCanTraceFileReader::decodeBlock(CanTraceFileBlock &block) const
+    {
+        // a text block is split behind the first and the last line break
+        const int firstBreak    = block.data.indexOf('\n');
+        const int lastBreak     = block.data.lastIndexOf('\n');
+
+        if ( firstBreak < 0 )
+        {
+            block.hasBoundary   = false;
+            block.head          = block.data;
+        }
+        else
+        {
+            block.hasBoundary   = true;
+            block.head          = block.data.left(firstBreak + 1);
+            block.tail          = block.data.mid(lastBreak + 1);
+
+            decodeRecords( block.data.mid(firstBreak + 1, lastBreak - firstBreak), block.context, block );
+        }
+
+        block.data.clear();
+    }
+
+    void AbstractCanTraceFileReader::completeBlock(CanTraceFileBlock &block)
+    {
+        if ( m_carry.isEmpty() )
+        {
+            m_carryContext = block.context;
+        }
+
+        m_carry.append(block.head);
+        block.head.clear();
+
+        if ( ! block.hasBoundary )
+        {
+            // the whole block belongs to a record which continues in the next block
+            return;
+        }
+
+        if ( ! m_carry.isEmpty() )
+        {
+            CanTraceFileBlock seam;
+            decodeRecords(m_carry, m_carryContext, seam);
+
+            if ( ! seam.frames.isEmpty() )
+            {
+                // the frames of the seam precede the frames of the block, whose channels are mapped to the seam's
+                QVector<quint16> channelMap;
+
+                for (const QString &channelName : qAsConst(block.channelNames))
+                {
+                    int channel = seam.channelNames.indexOf(channelName);
+
+                    if ( channel < 0 )
+                    {
+                        channel = seam.channelNames.size();
+                        seam.channelNames.append(channelName);
+                    }
+
+                    channelMap.append( quint16(channel) );
+                }
+
+                seam.frames.append(block.frames);
+
+                for (const quint16 channel : qAsConst(block.channels))
+                {
+                    seam.channels.append( channelMap.at(channel) );
+                }
+
+                block.frames        = seam.frames;
+                block.channels      = seam.channels;
+                block.channelNames  = seam.channelNames;
+            }
+        }
+
+        m_carry         = block.tail;
+        m_carryContext  = block.context;
+        block.tail.clear();
+    }
+
+    void AbstractCanTraceFileReader::finishBlocks(CanTraceFileBlock &block)
+    {
+        if ( ! m_carry.isEmpty() )
+        {
+            decodeRecords(m_carry, m_carryContext, block);
+            m_carry.clear();
+        }
+    }
+
+    qint64 AbstractCanTraceFileReader::position() const
+    {
+        return m_file.isOpen() ? m_file.pos() : 0;
+    }
+
+    qint64 AbstractCanTraceFileReader::size() const
+    {
+        return m_file.size();
+    }
+
+    QString AbstractCanTraceFileReader::errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool AbstractCanTraceFileReader::readHeader()
+    {
+        return true;
+    }
+
+    void AbstractCanTraceFileReader::skipRecord() const
+    {
+        m_skippedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,355 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/asctracefilereader.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QLocale>
+#include <QLoggingCategory>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    // formats of the measurement start in the header, depending on the version of the writing tool
+    const char* const DATE_FORMATS[] =
+    {
+        "ddd MMM d hh:mm:ss.zzz ap yyyy",
+        "ddd MMM d hh:mm:ss ap yyyy",
+        "ddd MMM d HH:mm:ss.zzz yyyy",
+        "ddd MMM d HH:mm:ss yyyy"
+    };
+
+    // flags of CAN FD events
+    const quint32 ASC_FLAG_REMOTE   = 0x0010U;
+    const quint32 ASC_FLAG_EDL      = 0x1000U;
+
+    const int MAX_CLASSIC_PAYLOAD   = 8;
+    const int MAX_FD_PAYLOAD        = 64;
+
+    bool isDigit(char character)
+    {
+        return character >= '0' && character <= '9';
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    AscTraceFileReader::AscTraceFileReader()
+    {
+
+    }
+
+    bool AscTraceFileReader::readHeader()
+    {
+        m_startTimeUSecs    = 0;
+        m_base              = 16;
+
+        while ( ! m_file.atEnd() )
+        {
+            const qint64        lineStart   = m_file.pos();
+            const QByteArray    line        = m_file.readLine().simplified();
+
+            if ( line.startsWith("date ") )
+            {
+                const QString   date    = QString::fromLatin1( line.mid(5) );
+                QDateTime       start;
+
+                for (const char *format : DATE_FORMATS)
+                {
+                    start = QLocale::c().toDateTime( date, QString::fromLatin1(format) );
+
+                    if ( start.isValid() )
+                    {
+                        m_startTimeUSecs = start.toMSecsSinceEpoch() * 1000;
+                        break;
+                    }
+                }
+
+                if ( ! start.isValid() )
+                {
+                    qWarning(LOG_TAG) << "Unknown date format" << date << "in" << m_file.fileName() << ", timestamps are relative to the start";
+                }
+            }
+            else if ( line.startsWith("base ") )
+            {
+                // base <hex|dec> timestamps <absolute|relative>
+                const QList<QByteArray> fields = line.split(' ');
+
+                m_base = ( fields.value(1) == "dec" ) ? 10 : 16;
+
+                if ( fields.contains("relative") )
+                {
+                    m_errorString = QStringLiteral("Relative timestamps are not supported");
+                    return false;
+                }
+            }
+            else if ( line.startsWith("Begin Triggerblock") )
+            {
+                break;
+            }
+            else if ( ! line.isEmpty() && isDigit( line.at(0) ) )
+            {
+                // the file has no trigger block, this is already the first event
+                m_file.seek(lineStart);
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    void AscTraceFileReader::decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const
+    {
+        Q_UNUSED(context)
+
+        QByteArray  lastChannel;
+        QString     channelName;
+        int         lineStart = 0;
+
+        while ( lineStart < data.size() )
+        {
+            int lineEnd = data.indexOf('\n', lineStart);
+
+            if ( lineEnd < 0 )
+            {
+                lineEnd = data.size();
+            }
+
+            const QList<QByteArray> fields = data.mid(lineStart, lineEnd - lineStart).simplified().split(' ');
+            lineStart = lineEnd + 1;
+
+            // events start with their timestamp, other lines are comments or mark trigger blocks
+            if ( fields.size() < 3 || fields.at(0).isEmpty() || ! isDigit( fields.at(0).at(0) ) )
+            {
+                continue;
+            }
+
+            QCanBusFrame    frame;
+            QByteArray      channel;
+            bool            valid = false;
+
+            if ( fields.at(1) == "CANFD" )
+            {
+                channel = fields.at(2);
+                valid   = parseFdFrame(fields, frame);
+            }
+            else if ( fields.at(2) == "ErrorFrame" )
+            {
+                channel = fields.at(1);
+                valid   = true;
+
+                frame.setFrameType(QCanBusFrame::ErrorFrame);
+                frame.setError(QCanBusFrame::UnknownError);
+            }
+            else if ( fields.size() >= 5 && ( fields.at(3) == "Rx" || fields.at(3) == "Tx" ) )
+            {
+                channel = fields.at(1);
+                valid   = parseClassicFrame(fields, frame);
+            }
+            else
+            {
+                // e.g. statistics or trigger events
+                continue;
+            }
+
+            if ( ! valid || ! parseTimestamp(fields.at(0), frame) )
+            {
+                skipRecord();
+                continue;
+            }
+
+            if ( channel != lastChannel )
+            {
+                lastChannel = channel;
+                channelName = QStringLiteral("CAN ") + QString::fromLatin1(channel);
+            }
+
+            block.appendFrame(frame, channelName);
+        }
+    }
+
+    bool AscTraceFileReader::parseTimestamp(const QByteArray &field, QCanBusFrame &frame) const
+    {
+        // <seconds>.<fraction> since the start of the measurement
+        const int   separator       = field.indexOf('.');
+        bool        secondsValid    = false;
+        bool        fractionValid   = true;
+
+        const qint64 seconds        = field.left(separator).toLongLong(&secondsValid);
+        const qint64 microSeconds   = separator < 0 ? 0 : field.mid(separator + 1).leftJustified(6, '0', true).toLongLong(&fractionValid);
+
+        if ( ! secondsValid || ! fractionValid )
+        {
+            return false;
+        }
+
+        const qint64 timestampUSecs = m_startTimeUSecs + seconds * 1000000 + microSeconds;
+
+        frame.setTimeStamp( QCanBusFrame::TimeStamp(timestampUSecs / 1000000, timestampUSecs % 1000000) );
+
+        return true;
+    }
+
+    bool AscTraceFileReader::parseFrameId(const QByteArray &field, QCanBusFrame &frame) const
+    {
+        // extended frame IDs are marked with a trailing x
+        const bool      extended    = field.endsWith('x') || field.endsWith('X');
+        bool            idValid     = false;
+        const quint32   frameId     = ( extended ? field.left(field.size() - 1) : field ).toUInt(&idValid, m_base);
+
+        frame.setFrameId(frameId);
+        frame.setExtendedFrameFormat(extended);
+
+        return idValid;
+    }
+
+    bool AscTraceFileReader::parsePayload(const QList<QByteArray> &fields, int first, int count, QCanBusFrame &frame) const
+    {
+        if ( fields.size() < first + count )
+        {
+            return false;
+        }
+
+        QByteArray payload(count, 0);
+
+        for (int index = 0; index < count; index++)
+        {
+            bool        byteValid   = false;
+            const uint  byte        = fields.at(first + index).toUInt(&byteValid, m_base);
+
+            if ( ! byteValid || byte > 0xFF )
+            {
+                return false;
+            }
+
+            payload[index] = char(byte);
+        }
+
+        frame.setPayload(payload);
+
+        return true;
+    }
+
+    bool AscTraceFileReader::parseClassicFrame(const QList<QByteArray> &fields, QCanBusFrame &frame) const
+    {
+        // <time> <channel> <id> <Rx|Tx> d <dlc> <data>... or <time> <channel> <id> <Rx|Tx> r [<dlc>]
+        if ( ! parseFrameId(fields.at(2), frame) )
+        {
+            return false;
+        }
+
+        if ( fields.at(4) == "r" )
+        {
+            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        }
+        else if ( fields.at(4) == "d" && fields.size() > 5 )
+        {
+            bool        dlcValid    = false;
+            const int   dlc         = fields.at(5).toInt(&dlcValid, 16);
+
+            if ( ! dlcValid || ! parsePayload( fields, 6, qMin(dlc, MAX_CLASSIC_PAYLOAD), frame ) )
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+
+        frame.setLocalEcho( fields.at(3) == "Tx" );
+
+        return frame.isValid();
+    }
+
+    bool AscTraceFileReader::parseFdFrame(const QList<QByteArray> &fields, QCanBusFrame &frame) const
+    {
+        // <time> CANFD <channel> <Rx|Tx> <id> [<symbolic name>] <brs> <esi> <dlc> <length> <data>... <duration> <bits> <flags> ...
+        if ( fields.size() < 5 )
+        {
+            return false;
+        }
+
+        if ( fields.at(4) == "ErrorFrame" )
+        {
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+            frame.setError(QCanBusFrame::UnknownError);
+            return true;
+        }
+
+        if ( ! parseFrameId(fields.at(4), frame) )
+        {
+            return false;
+        }
+
+        int field = 5;
+
+        if ( fields.value(field) != "0" && fields.value(field) != "1" )
+        {
+            // skip the symbolic name of the message
+            field++;
+        }
+
+        if ( fields.size() < field + 4 )
+        {
+            return false;
+        }
+
+        const bool  bitrateSwitch           = fields.at(field) == "1";
+        const bool  errorStateIndicator     = fields.at(field + 1) == "1";
+        bool        lengthValid             = false;
+        const int   length                  = fields.at(field + 3).toInt(&lengthValid);
+
+        if ( ! lengthValid || length > MAX_FD_PAYLOAD || ! parsePayload(fields, field + 4, length, frame) )
+        {
+            return false;
+        }
+
+        // the flags tell classic frames sent on a CAN FD channel apart, older tools omit them
+        const int   flagsField  = field + 4 + length + 2;
+        quint32     flags       = ASC_FLAG_EDL;
+
+        if ( fields.size() > flagsField )
+        {
+            bool flagsValid = false;
+            flags = fields.at(flagsField).toUInt(&flagsValid, 16);
+
+            if ( ! flagsValid )
+            {
+                return false;
+            }
+        }
+
+        if ( flags & ASC_FLAG_EDL )
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch(bitrateSwitch);
+            frame.setErrorStateIndicator(errorStateIndicator);
+        }
+        else if ( flags & ASC_FLAG_REMOTE )
+        {
+            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+            frame.setPayload( QByteArray() );
+        }
+
+        frame.setLocalEcho( fields.at(3) == "Tx" );
+
+        return frame.isValid();
+    }
+}
@@ -0,0 +1,257 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/asctracefilewriter.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <QLoggingCategory>
+
+#include <chrono>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    const char* const DATE_FORMAT = "ddd MMM d hh:mm:ss.zzz ap yyyy";
+
+    // flags of CAN FD events
+    const quint32 ASC_FLAG_EDL      = 0x1000U;
+    const quint32 ASC_FLAG_BRS      = 0x2000U;
+    const quint32 ASC_FLAG_ESI      = 0x4000U;
+
+    const int TIMESTAMP_WIDTH       = 11;
+    const int FRAME_ID_WIDTH        = 15;
+
+    // payload sizes of CAN FD frames above 8 bytes, whose DLC is 9 + their index
+    const int FD_PAYLOAD_SIZES[] = { 12, 16, 20, 24, 32, 48, 64 };
+
+    int fdDataLengthCode(int payloadSize)
+    {
+        if ( payloadSize <= 8 )
+        {
+            return payloadSize;
+        }
+
+        for (int index = 0; index < int( sizeof(FD_PAYLOAD_SIZES) / sizeof(int) ); index++)
+        {
+            if ( FD_PAYLOAD_SIZES[index] >= payloadSize )
+            {
+                return 9 + index;
+            }
+        }
+
+        return 15;
+    }
+
+    QByteArray formatHex(quint32 value, int digits = 2)
+    {
+        return QByteArray::number(value, 16).toUpper().rightJustified(digits, '0');
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    AscTraceFileWriter::AscTraceFileWriter()
+    {
+
+    }
+
+    AscTraceFileWriter::~AscTraceFileWriter()
+    {
+        close();
+    }
+
+    bool AscTraceFileWriter::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_errorString.clear();
+        m_channelNames.clear();
+        m_headerWritten = false;
+
+        return true;
+    }
+
+    void AscTraceFileWriter::close()
+    {
+        if ( ! m_file.isOpen() )
+        {
+            return;
+        }
+
+        // a trace without frames still gets a valid header
+        if ( ! m_headerWritten )
+        {
+            writeHeader( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count() );
+        }
+
+        write("End TriggerBlock\n");
+
+        m_file.close();
+    }
+
+    bool AscTraceFileWriter::writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            m_errorString = QStringLiteral("Trace file is not open");
+            return false;
+        }
+
+        if ( frames.isEmpty() )
+        {
+            return true;
+        }
+
+        if ( ! m_headerWritten )
+        {
+            const QCanBusFrame::TimeStamp timeStamp = frames.first().timeStamp();
+
+            if ( ! writeHeader( timeStamp.seconds() * 1000000 + timeStamp.microSeconds() ) )
+            {
+                return false;
+            }
+        }
+
+        int channelIndex = m_channelNames.indexOf(interfaceName);
+
+        if ( channelIndex < 0 )
+        {
+            channelIndex = m_channelNames.size();
+            m_channelNames.append(interfaceName);
+        }
+
+        QByteArray buffer;
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            buffer.append( formatLine(frame, channelIndex + 1, m_startTimeUSecs) );
+            buffer.append('\n');
+        }
+
+        return write(buffer);
+    }
+
+    QString AscTraceFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    QByteArray AscTraceFileWriter::formatLine(const QCanBusFrame &frame, int channel, qint64 startTimeUSecs)
+    {
+        const QCanBusFrame::TimeStamp   timeStamp   = frame.timeStamp();
+        const qint64                    timeUSecs   = timeStamp.seconds() * 1000000 + timeStamp.microSeconds() - startTimeUSecs;
+        const qint64                    absUSecs    = qAbs(timeUSecs);
+
+        const QByteArray time = ( timeUSecs < 0 ? "-" : "" ) + QByteArray::number(absUSecs / 1000000) + "."
+                              + QByteArray::number(absUSecs % 1000000).rightJustified(6, '0');
+
+        QByteArray line = time.rightJustified(TIMESTAMP_WIDTH, ' ') + " ";
+
+        if ( frame.frameType() == QCanBusFrame::ErrorFrame )
+        {
+            return line + QByteArray::number(channel) + "  ErrorFrame";
+        }
+
+        const QByteArray frameId    = QByteArray::number(frame.frameId(), 16).toUpper() + ( frame.hasExtendedFrameFormat() ? "x" : "" );
+        const QByteArray direction  = frame.hasLocalEcho() ? "Tx" : "Rx";
+        const QByteArray payload    = frame.payload();
+
+        if ( frame.hasFlexibleDataRateFormat() )
+        {
+            // <time> CANFD <channel> <Rx|Tx> <id> <brs> <esi> <dlc> <length> <data>... <duration> <bits> <flags>
+            quint32 flags = ASC_FLAG_EDL;
+
+            if ( frame.hasBitrateSwitch() )
+            {
+                flags |= ASC_FLAG_BRS;
+            }
+
+            if ( frame.hasErrorStateIndicator() )
+            {
+                flags |= ASC_FLAG_ESI;
+            }
+
+            line += "CANFD " + QByteArray::number(channel).rightJustified(3, ' ') + " " + direction + " "
+                  + frameId.rightJustified(8, ' ') + " "
+                  + ( frame.hasBitrateSwitch() ? "1 " : "0 " )
+                  + ( frame.hasErrorStateIndicator() ? "1 " : "0 " )
+                  + QByteArray::number(fdDataLengthCode( payload.size() ), 16) + " "
+                  + QByteArray::number( payload.size() ).rightJustified(2, ' ');
+
+            for (const char byte : payload)
+            {
+                line += " " + formatHex( quint8(byte) );
+            }
+
+            return line + "        0    0 " + formatHex(flags, 8);
+        }
+
+        // <time> <channel> <id> <Rx|Tx> d <dlc> <data>... or <time> <channel> <id> <Rx|Tx> r
+        line += QByteArray::number(channel) + "  " + frameId.leftJustified(FRAME_ID_WIDTH, ' ') + " " + direction + "   ";
+
+        if ( frame.frameType() == QCanBusFrame::RemoteRequestFrame )
+        {
+            return line + "r";
+        }
+
+        line += "d " + QByteArray::number( payload.size() );
+
+        for (const char byte : payload)
+        {
+            line += " " + formatHex( quint8(byte) );
+        }
+
+        return line;
+    }
+
+    bool AscTraceFileWriter::writeHeader(qint64 startTimeUSecs)
+    {
+        const QByteArray date = QLocale::c().toString( QDateTime::fromMSecsSinceEpoch(startTimeUSecs / 1000), QString::fromLatin1(DATE_FORMAT) ).toLatin1();
+
+        m_startTimeUSecs    = startTimeUSecs;
+        m_headerWritten     = true;
+
+        return write( "date " + date + "\n"
+                      "base hex  timestamps absolute\n"
+                      "internal events logged\n"
+                      "// version 9.0.0\n"
+                      "Begin Triggerblock " + date + "\n"
+                      "   0.000000 Start of measurement\n" );
+    }
+
+    bool AscTraceFileWriter::write(const QByteArray &data)
+    {
+        if ( m_file.write(data) != data.size() )
+        {
+            m_errorString = m_file.errorString();
+            qWarning(LOG_TAG) << "Failed to write to" << m_file.fileName() << ":" << m_errorString;
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,93 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLFFORMAT_H
+#define BLFFORMAT_H
+
+#include <QtGlobal>
+
+namespace Lindwurm::Lib::BlfFormat
+{
+    /*
+     * Layout of a Vector binary logging file (*.blf), all values little endian:
+     *
+     *   file header:   "LOGG", header size, application and version, file size, uncompressed size, object count,
+     *                  start and stop of the measurement as SYSTEMTIME, padding to the header size
+     *   objects:       "LOBJ", header size, header version, object size, object type, padded to 4 bytes
+     *
+     * The objects at the top level are log containers, whose zlib compressed data is a continuous stream of objects,
+     * so an object may continue in the next container. Within containers the padding of the objects depends on the
+     * writing tool, the next object starts within the following PaddingWindow bytes. The header of an object is
+     * followed by its flags and its timestamp relative to the start of the measurement.
+     */
+
+    const char      FileSignature[4]        = { 'L', 'O', 'G', 'G' };
+    const char      ObjectSignature[4]      = { 'L', 'O', 'B', 'J' };
+
+    const int       FileHeaderSize          = 144;
+    const int       MinFileHeaderSize       = 72;
+    const int       StartTimeOffset         = 40;
+    const int       StopTimeOffset          = 56;
+
+    const int       ObjectHeaderBaseSize    = 16;
+    const int       ObjectHeaderV1Size      = 32;
+    const int       ObjectFlagsOffset       = 16;
+    const int       ObjectTimestampOffset   = 24;
+    const int       ContainerHeaderSize     = 16;
+    const int       PaddingWindow           = 8;
+
+    // object types
+    const quint32   CanMessage              = 1;
+    const quint32   CanError                = 2;
+    const quint32   LogContainer            = 10;
+    const quint32   CanErrorExt             = 73;
+    const quint32   CanMessage2             = 86;
+    const quint32   CanFdMessage            = 100;
+    const quint32   CanFdMessage64          = 101;
+
+    // object flags, the unit of the timestamp
+    const quint32   TimeTenMicroSeconds     = 1;
+    const quint32   TimeOneNanoSecond       = 2;
+
+    // compression methods of log containers
+    const quint16   NoCompression           = 0;
+    const quint16   ZlibCompression         = 2;
+
+    // flags of CAN messages
+    const quint8    MessageDirectionTx      = 0x01;
+    const quint8    MessageRemote           = 0x80;
+    const quint32   MessageExtendedId       = 0x80000000U;
+
+    // flags of CAN FD messages
+    const quint8    FdMessageEdl            = 0x01;
+    const quint8    FdMessageBrs            = 0x02;
+    const quint8    FdMessageEsi            = 0x04;
+
+    // flags of 64 byte CAN FD messages
+    const quint32   FdMessage64Remote       = 0x0010U;
+    const quint32   FdMessage64Edl          = 0x1000U;
+    const quint32   FdMessage64Brs          = 0x2000U;
+    const quint32   FdMessage64Esi          = 0x4000U;
+
+    const int       CanMessageSize          = 16;
+    const int       CanErrorExtSize         = 32;
+    const int       CanFdMessageSize        = 84;
+    const int       CanFdMessage64Size      = 40;
+    const int       MaxPayloadLength        = 64;
+}
+
+#endif // BLFFORMAT_H
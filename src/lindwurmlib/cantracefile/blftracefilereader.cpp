@@ -0,0 +1,444 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/blftracefilereader.h"
+#include "cantracefile/blfformat.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    // the compressed size of the containers read as one block, which inflate to about ten times the size
+    const int BLOCK_SIZE = 1024 * 1024;
+
+    template <typename T>
+    T readValue(const char *data)
+    {
+        return qFromLittleEndian<T>(data);
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    using namespace BlfFormat;
+
+    BlfTraceFileReader::BlfTraceFileReader()
+    {
+
+    }
+
+    bool BlfTraceFileReader::readBlock(CanTraceFileBlock &block)
+    {
+        if ( ! m_file.isOpen() || m_file.atEnd() )
+        {
+            return false;
+        }
+
+        while ( block.data.size() < BLOCK_SIZE && ! m_file.atEnd() )
+        {
+            const qint64    objectOffset    = m_file.pos();
+            QByteArray      object          = m_file.read(ObjectHeaderBaseSize);
+
+            if ( object.size() == ObjectHeaderBaseSize && ! object.startsWith( QByteArray::fromRawData(ObjectSignature, 4) ) )
+            {
+                m_errorString = QString("Invalid object at offset %1").arg(objectOffset);
+                return false;
+            }
+
+            const int objectSize = object.size() == ObjectHeaderBaseSize ? int( readValue<quint32>( object.constData() + 8 ) ) : 0;
+
+            if ( object.size() == ObjectHeaderBaseSize && objectSize < ObjectHeaderBaseSize )
+            {
+                m_errorString = QString("Invalid object size at offset %1").arg(objectOffset);
+                return false;
+            }
+
+            object.append( m_file.read( qMax(objectSize - ObjectHeaderBaseSize, 0) ) );
+
+            if ( object.size() < ObjectHeaderBaseSize || object.size() < objectSize )
+            {
+                // the recording has been aborted, the objects read so far are kept
+                qWarning(LOG_TAG) << "Truncated object at offset" << objectOffset << "in" << m_file.fileName();
+                m_file.seek( m_file.size() );
+                break;
+            }
+
+            // objects at the top level are padded to 4 bytes
+            m_file.read(objectSize % 4);
+
+            block.data.append(object);
+        }
+
+        return ! block.data.isEmpty();
+    }
+
+    void BlfTraceFileReader::decodeBlock(CanTraceFileBlock &block) const
+    {
+        QByteArray  objects;
+        int         position = 0;
+
+        // inflate the containers into a continuous stream of objects
+        while ( position + ObjectHeaderBaseSize <= block.data.size() )
+        {
+            const char      *object     = block.data.constData() + position;
+            const int       headerSize  = readValue<quint16>(object + 4);
+            const int       objectSize  = int( readValue<quint32>(object + 8) );
+            const quint32   objectType  = readValue<quint32>(object + 12);
+
+            position += objectSize;
+
+            if ( objectType != LogContainer )
+            {
+                // files without compression may hold the objects at the top level
+                objects.append(object, objectSize);
+                continue;
+            }
+
+            if ( objectSize < headerSize + ContainerHeaderSize )
+            {
+                skipRecord();
+                continue;
+            }
+
+            const char      *container          = object + headerSize;
+            const quint16   compressionMethod   = readValue<quint16>(container);
+            const quint32   uncompressedSize    = readValue<quint32>(container + 8);
+            const char      *data               = container + ContainerHeaderSize;
+            const int       dataSize            = objectSize - headerSize - ContainerHeaderSize;
+
+            if ( compressionMethod == NoCompression )
+            {
+                objects.append(data, dataSize);
+            }
+            else if ( compressionMethod == ZlibCompression )
+            {
+                // qUncompress() expects the uncompressed size in front of the zlib stream
+                QByteArray compressed(4 + dataSize, Qt::Uninitialized);
+                qToBigEndian<quint32>( uncompressedSize, compressed.data() );
+                std::memcpy(compressed.data() + 4, data, size_t(dataSize));
+
+                const QByteArray inflated = qUncompress(compressed);
+
+                if ( inflated.isEmpty() )
+                {
+                    skipRecord();
+                }
+
+                objects.append(inflated);
+            }
+            else
+            {
+                skipRecord();
+            }
+        }
+
+        block.data.clear();
+
+        // the stream starts with the rest of an object of the previous block, the first object starts a valid chain
+        const QByteArray    signature   = QByteArray::fromRawData(ObjectSignature, 4);
+        int                 start       = objects.indexOf(signature);
+
+        while ( start >= 0 )
+        {
+            CanTraceFileBlock   decoded;
+            const int           tailPosition = decodeObjects(objects, start, decoded);
+
+            if ( tailPosition >= 0 )
+            {
+                block.hasBoundary   = true;
+                block.head          = objects.left(start);
+                block.tail          = objects.mid(tailPosition);
+                block.frames        = decoded.frames;
+                block.channels      = decoded.channels;
+                block.channelNames  = decoded.channelNames;
+                return;
+            }
+
+            start = objects.indexOf(signature, start + 1);
+        }
+
+        block.hasBoundary   = false;
+        block.head          = objects;
+    }
+
+    bool BlfTraceFileReader::readHeader()
+    {
+        const QByteArray header = m_file.read(MinFileHeaderSize);
+
+        if ( header.size() < MinFileHeaderSize || ! header.startsWith( QByteArray::fromRawData(FileSignature, 4) ) )
+        {
+            m_errorString = QStringLiteral("Not a BLF file");
+            return false;
+        }
+
+        const quint32 headerSize = readValue<quint32>( header.constData() + 4 );
+
+        if ( headerSize < quint32(MinFileHeaderSize) || ! m_file.seek(headerSize) )
+        {
+            m_errorString = QStringLiteral("Invalid BLF file header");
+            return false;
+        }
+
+        // SYSTEMTIME: year, month, day of week, day, hour, minute, second, milliseconds
+        const char *startTime = header.constData() + StartTimeOffset;
+
+        const QDateTime start( QDate( readValue<quint16>(startTime), readValue<quint16>(startTime + 2), readValue<quint16>(startTime + 6) ),
+                               QTime( readValue<quint16>(startTime + 8), readValue<quint16>(startTime + 10),
+                                      readValue<quint16>(startTime + 12), readValue<quint16>(startTime + 14) ) );
+
+        if ( start.isValid() )
+        {
+            m_startTimeUSecs = start.toMSecsSinceEpoch() * 1000;
+        }
+        else
+        {
+            qWarning(LOG_TAG) << "Invalid start of measurement in" << m_file.fileName() << ", timestamps are relative to the start";
+            m_startTimeUSecs = 0;
+        }
+
+        return true;
+    }
+
+    void BlfTraceFileReader::decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const
+    {
+        Q_UNUSED(context)
+
+        if ( decodeObjects(data, 0, block) < 0 )
+        {
+            skipRecord();
+        }
+    }
+
+    int BlfTraceFileReader::decodeObjects(const QByteArray &objects, int position, CanTraceFileBlock &block) const
+    {
+        int     lastChannel = -1;
+        QString channelName;
+
+        forever
+        {
+            // the next object starts behind the padding of the previous one
+            int objectStart = position;
+
+            while ( objectStart < position + PaddingWindow && objectStart + 4 <= objects.size()
+                    && std::memcmp(objects.constData() + objectStart, ObjectSignature, 4) != 0 )
+            {
+                objectStart++;
+            }
+
+            if ( objectStart + 4 > objects.size() )
+            {
+                // the data ends within the padding or the signature
+                return position;
+            }
+
+            if ( objectStart == position + PaddingWindow )
+            {
+                return -1;
+            }
+
+            if ( objectStart + ObjectHeaderBaseSize > objects.size() )
+            {
+                return objectStart;
+            }
+
+            const int objectSize = int( readValue<quint32>( objects.constData() + objectStart + 8 ) );
+
+            if ( objectSize < ObjectHeaderBaseSize )
+            {
+                return -1;
+            }
+
+            if ( objectSize > objects.size() - objectStart )
+            {
+                // the object continues in the next block
+                return objectStart;
+            }
+
+            QCanBusFrame    frame;
+            int             channel = 0;
+
+            if ( decodeObject(objects.constData() + objectStart, objectSize, frame, channel) )
+            {
+                if ( channel != lastChannel )
+                {
+                    lastChannel = channel;
+                    channelName = QString("CAN %1").arg(channel);
+                }
+
+                block.appendFrame(frame, channelName);
+            }
+
+            position = objectStart + objectSize;
+        }
+    }
+
+    bool BlfTraceFileReader::decodeObject(const char *object, int size, QCanBusFrame &frame, int &channel) const
+    {
+        const int       headerSize  = readValue<quint16>(object + 4);
+        const quint32   objectType  = readValue<quint32>(object + 12);
+
+        if ( objectType != CanMessage && objectType != CanMessage2 && objectType != CanFdMessage
+             && objectType != CanFdMessage64 && objectType != CanError && objectType != CanErrorExt )
+        {
+            return false;
+        }
+
+        if ( headerSize < ObjectHeaderV1Size || headerSize > size )
+        {
+            skipRecord();
+            return false;
+        }
+
+        const char      *body       = object + headerSize;
+        const int       bodySize    = size - headerSize;
+        const quint32   flags       = readValue<quint32>(object + ObjectFlagsOffset);
+        const quint64   timestamp   = readValue<quint64>(object + ObjectTimestampOffset);
+
+        const qint64 timestampUSecs = m_startTimeUSecs + qint64( flags == TimeTenMicroSeconds ? timestamp * 10 : timestamp / 1000 );
+
+        frame.setTimeStamp( QCanBusFrame::TimeStamp(timestampUSecs / 1000000, timestampUSecs % 1000000) );
+
+        if ( objectType == CanMessage || objectType == CanMessage2 )
+        {
+            // channel u16, flags u8, dlc u8, id u32, data[8]
+            if ( bodySize < CanMessageSize )
+            {
+                skipRecord();
+                return false;
+            }
+
+            const quint8    messageFlags    = quint8( body[2] );
+            const int       length          = qMin( int( quint8( body[3] ) ), 8 );
+            const quint32   frameId         = readValue<quint32>(body + 4);
+
+            channel = readValue<quint16>(body);
+
+            frame.setFrameId( frameId & ~MessageExtendedId );
+            frame.setExtendedFrameFormat( frameId & MessageExtendedId );
+            frame.setLocalEcho( messageFlags & MessageDirectionTx );
+
+            if ( messageFlags & MessageRemote )
+            {
+                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+            }
+            else
+            {
+                frame.setPayload( QByteArray(body + 8, length) );
+            }
+        }
+        else if ( objectType == CanFdMessage )
+        {
+            // channel u16, flags u8, dlc u8, id u32, frame length u32, bit count u8, fd flags u8, valid bytes u8, reserved, data[64]
+            if ( bodySize < CanFdMessageSize )
+            {
+                skipRecord();
+                return false;
+            }
+
+            const quint8    messageFlags    = quint8( body[2] );
+            const quint32   frameId         = readValue<quint32>(body + 4);
+            const quint8    fdFlags         = quint8( body[13] );
+            const int       length          = qMin( int( quint8( body[14] ) ), MaxPayloadLength );
+
+            channel = readValue<quint16>(body);
+
+            frame.setFrameId( frameId & ~MessageExtendedId );
+            frame.setExtendedFrameFormat( frameId & MessageExtendedId );
+            frame.setLocalEcho( messageFlags & MessageDirectionTx );
+
+            if ( fdFlags & FdMessageEdl )
+            {
+                frame.setPayload( QByteArray(body + 20, length) );
+                frame.setFlexibleDataRateFormat(true);
+                frame.setBitrateSwitch( fdFlags & FdMessageBrs );
+                frame.setErrorStateIndicator( fdFlags & FdMessageEsi );
+            }
+            else if ( messageFlags & MessageRemote )
+            {
+                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+            }
+            else
+            {
+                frame.setPayload( QByteArray( body + 20, qMin(length, 8) ) );
+            }
+        }
+        else if ( objectType == CanFdMessage64 )
+        {
+            // channel u8, dlc u8, valid bytes u8, tx count u8, id u32, frame length u32, flags u32, ..., direction u8 at 34, data
+            if ( bodySize < CanFdMessage64Size )
+            {
+                skipRecord();
+                return false;
+            }
+
+            const int       length          = qMin( int( quint8( body[2] ) ), qMin(bodySize - CanFdMessage64Size, MaxPayloadLength) );
+            const quint32   frameId         = readValue<quint32>(body + 4);
+            const quint32   messageFlags    = readValue<quint32>(body + 12);
+
+            channel = quint8( body[0] );
+
+            frame.setFrameId( frameId & ~MessageExtendedId );
+            frame.setExtendedFrameFormat( frameId & MessageExtendedId );
+            frame.setLocalEcho( body[34] != 0 );
+
+            if ( messageFlags & FdMessage64Edl )
+            {
+                frame.setPayload( QByteArray(body + CanFdMessage64Size, length) );
+                frame.setFlexibleDataRateFormat(true);
+                frame.setBitrateSwitch( messageFlags & FdMessage64Brs );
+                frame.setErrorStateIndicator( messageFlags & FdMessage64Esi );
+            }
+            else if ( messageFlags & FdMessage64Remote )
+            {
+                frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+            }
+            else
+            {
+                frame.setPayload( QByteArray( body + CanFdMessage64Size, qMin(length, 8) ) );
+            }
+        }
+        else
+        {
+            // error frames only tell their channel, the cause is not mapped
+            if ( bodySize < 2 )
+            {
+                skipRecord();
+                return false;
+            }
+
+            channel = readValue<quint16>(body);
+
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+            frame.setError(QCanBusFrame::UnknownError);
+        }
+
+        if ( ! frame.isValid() )
+        {
+            skipRecord();
+            return false;
+        }
+
+        return true;
+    }
+}
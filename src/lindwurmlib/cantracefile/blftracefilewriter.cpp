@@ -0,0 +1,297 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/blftracefilewriter.h"
+#include "cantracefile/blfformat.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QLoggingCategory>
+
+#include <chrono>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    // the version of the binary logging library the files are compatible with
+    const quint8 APPLICATION_ID     = 5;
+    const quint8 BIN_LOG_VERSION[]  = { 2, 6, 8, 1 };
+
+    qint64 currentTimeUSecs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+    }
+
+    qint64 timestampUSecsOf(const QCanBusFrame &frame)
+    {
+        return frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+    }
+
+    void writeSystemTime(QDataStream &stream, qint64 timeUSecs)
+    {
+        const QDateTime time = QDateTime::fromMSecsSinceEpoch(timeUSecs / 1000);
+
+        // SYSTEMTIME counts the days of the week from sunday
+        stream << quint16( time.date().year() ) << quint16( time.date().month() ) << quint16( time.date().dayOfWeek() % 7 )
+               << quint16( time.date().day() ) << quint16( time.time().hour() ) << quint16( time.time().minute() )
+               << quint16( time.time().second() ) << quint16( time.time().msec() );
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    using namespace BlfFormat;
+
+    BlfTraceFileWriter::BlfTraceFileWriter()
+    {
+
+    }
+
+    BlfTraceFileWriter::~BlfTraceFileWriter()
+    {
+        close();
+    }
+
+    bool BlfTraceFileWriter::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_errorString.clear();
+        m_channelNames.clear();
+        m_objects.clear();
+        m_hasFrames         = false;
+        m_objectCount       = 0;
+        m_uncompressedSize  = FileHeaderSize;
+
+        // the header is written again when the file is closed
+        return writeFileHeader();
+    }
+
+    void BlfTraceFileWriter::close()
+    {
+        if ( ! m_file.isOpen() )
+        {
+            return;
+        }
+
+        if ( ! m_hasFrames )
+        {
+            m_startTimeUSecs    = currentTimeUSecs();
+            m_stopTimeUSecs     = m_startTimeUSecs;
+        }
+
+        if ( writeContainer() && m_file.seek(0) )
+        {
+            writeFileHeader();
+        }
+
+        m_file.close();
+    }
+
+    bool BlfTraceFileWriter::writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            m_errorString = QStringLiteral("Trace file is not open");
+            return false;
+        }
+
+        if ( frames.isEmpty() )
+        {
+            return true;
+        }
+
+        if ( ! m_hasFrames )
+        {
+            m_startTimeUSecs    = timestampUSecsOf( frames.first() );
+            m_hasFrames         = true;
+        }
+
+        int channelIndex = m_channelNames.indexOf(interfaceName);
+
+        if ( channelIndex < 0 )
+        {
+            channelIndex = m_channelNames.size();
+            m_channelNames.append(interfaceName);
+        }
+
+        const quint16 channel = quint16(channelIndex + 1);
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            const qint64    timestampUSecs  = timestampUSecsOf(frame);
+            const QByteArray payload        = frame.payload();
+            const quint32   frameId         = frame.frameId() | ( frame.hasExtendedFrameFormat() ? MessageExtendedId : 0 );
+            QByteArray      body;
+            QDataStream     stream(&body, QIODevice::WriteOnly);
+
+            stream.setByteOrder(QDataStream::LittleEndian);
+
+            if ( frame.frameType() == QCanBusFrame::ErrorFrame )
+            {
+                // channel, length, flags, ecc, position, dlc, reserved, frame length, id, extended flags, reserved, data[8]
+                stream << channel << quint16(0) << quint32(0) << quint8(0) << quint8(0) << quint8(0) << quint8(0)
+                       << quint32(0) << quint32(0) << quint16(0) << quint16(0) << quint64(0);
+
+                appendObject(CanErrorExt, timestampUSecs, body);
+            }
+            else if ( frame.hasFlexibleDataRateFormat() )
+            {
+                quint32 messageFlags = FdMessage64Edl;
+
+                if ( frame.hasBitrateSwitch() )
+                {
+                    messageFlags |= FdMessage64Brs;
+                }
+
+                if ( frame.hasErrorStateIndicator() )
+                {
+                    messageFlags |= FdMessage64Esi;
+                }
+
+                // channel, dlc, valid bytes, tx count, id, frame length, flags, bit timings, time offsets, bit count,
+                // direction, extended data offset, crc, data
+                stream << quint8(channel) << quint8(0) << quint8( payload.size() ) << quint8(0) << frameId << quint32(0)
+                       << messageFlags << quint32(0) << quint32(0) << quint32(0) << quint32(0) << quint16(0)
+                       << quint8( frame.hasLocalEcho() ? 1 : 0 ) << quint8(0) << quint32(0);
+
+                stream.writeRawData( payload.constData(), payload.size() );
+
+                appendObject(CanFdMessage64, timestampUSecs, body);
+            }
+            else
+            {
+                quint8 messageFlags = frame.hasLocalEcho() ? MessageDirectionTx : 0;
+
+                if ( frame.frameType() == QCanBusFrame::RemoteRequestFrame )
+                {
+                    messageFlags |= MessageRemote;
+                }
+
+                // channel, flags, dlc, id, data[8]
+                stream << channel << messageFlags << quint8( payload.size() ) << frameId;
+
+                stream.writeRawData( payload.leftJustified(8, '\0', true).constData(), 8 );
+
+                appendObject(CanMessage, timestampUSecs, body);
+            }
+
+            m_stopTimeUSecs = qMax(m_stopTimeUSecs, timestampUSecs);
+        }
+
+        if ( m_objects.size() >= ContainerSize )
+        {
+            return writeContainer();
+        }
+
+        return true;
+    }
+
+    QString BlfTraceFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    void BlfTraceFileWriter::appendObject(quint32 objectType, qint64 timestampUSecs, const QByteArray &body)
+    {
+        const quint32   objectSize  = quint32(ObjectHeaderV1Size + body.size());
+        QDataStream     stream(&m_objects, QIODevice::Append);
+
+        stream.setByteOrder(QDataStream::LittleEndian);
+
+        // base header, followed by the flags, client index, object version and timestamp of version 1
+        stream.writeRawData(ObjectSignature, 4);
+        stream << quint16(ObjectHeaderV1Size) << quint16(1) << objectSize << objectType;
+        stream << TimeOneNanoSecond << quint16(0) << quint16(0) << quint64( qMax(timestampUSecs - m_startTimeUSecs, qint64(0)) * 1000 );
+
+        stream.writeRawData( body.constData(), body.size() );
+        stream.writeRawData( "\0\0\0", int(objectSize % 4) );
+
+        m_objectCount++;
+    }
+
+    bool BlfTraceFileWriter::writeContainer()
+    {
+        if ( m_objects.isEmpty() )
+        {
+            return true;
+        }
+
+        // qCompress() puts the uncompressed size in front of the zlib stream
+        const QByteArray    compressed  = qCompress(m_objects).mid(4);
+        const quint32       objectSize  = quint32(ObjectHeaderBaseSize + ContainerHeaderSize + compressed.size());
+        QByteArray          container;
+        QDataStream         stream(&container, QIODevice::WriteOnly);
+
+        stream.setByteOrder(QDataStream::LittleEndian);
+
+        // base header, compression method, reserved, uncompressed size, reserved
+        stream.writeRawData(ObjectSignature, 4);
+        stream << quint16(ObjectHeaderBaseSize) << quint16(1) << objectSize << LogContainer;
+        stream << ZlibCompression << quint16(0) << quint32(0) << quint32( m_objects.size() ) << quint32(0);
+
+        stream.writeRawData( compressed.constData(), compressed.size() );
+        stream.writeRawData( "\0\0\0", int(objectSize % 4) );
+
+        m_uncompressedSize += quint64(ObjectHeaderBaseSize + ContainerHeaderSize + m_objects.size());
+        m_objects.clear();
+
+        return write(container);
+    }
+
+    bool BlfTraceFileWriter::writeFileHeader()
+    {
+        QByteArray  header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+
+        stream.setByteOrder(QDataStream::LittleEndian);
+
+        // signature, header size, application, version, file size, uncompressed size, object count, objects read
+        stream.writeRawData(FileSignature, 4);
+        stream << quint32(FileHeaderSize) << APPLICATION_ID << quint8(0) << quint8(0) << quint8(0);
+        stream << BIN_LOG_VERSION[0] << BIN_LOG_VERSION[1] << BIN_LOG_VERSION[2] << BIN_LOG_VERSION[3];
+        stream << quint64( m_file.size() ) << m_uncompressedSize << m_objectCount << m_objectCount;
+
+        writeSystemTime(stream, m_startTimeUSecs);
+        writeSystemTime(stream, m_stopTimeUSecs);
+
+        header.append( QByteArray(FileHeaderSize - header.size(), '\0') );
+
+        return write(header);
+    }
+
+    bool BlfTraceFileWriter::write(const QByteArray &data)
+    {
+        if ( m_file.write(data) != data.size() )
+        {
+            m_errorString = m_file.errorString();
+            qWarning(LOG_TAG) << "Failed to write to" << m_file.fileName() << ":" << m_errorString;
+            return false;
+        }
+
+        return true;
+    }
+}
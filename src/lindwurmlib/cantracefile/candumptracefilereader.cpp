@@ -0,0 +1,198 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/candumptracefilereader.h"
+
+namespace
+{
+    // flags of the frame ID as used by SocketCAN
+    const quint32 CAN_ERR_FLAG  = 0x20000000U;
+    const quint32 CAN_EFF_MASK  = 0x1FFFFFFFU;
+
+    // flags of CAN FD frames
+    const int CANFD_BRS         = 0x01;
+    const int CANFD_ESI         = 0x02;
+
+    const int STANDARD_ID_DIGITS = 3;
+    const int EXTENDED_ID_DIGITS = 8;
+}
+
+namespace Lindwurm::Lib
+{
+    CandumpTraceFileReader::CandumpTraceFileReader()
+    {
+
+    }
+
+    void CandumpTraceFileReader::decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const
+    {
+        Q_UNUSED(context)
+
+        QByteArray  interfaceName;
+        QByteArray  lastInterfaceName;
+        QString     channelName;
+        int         lineStart = 0;
+
+        while ( lineStart < data.size() )
+        {
+            int lineEnd = data.indexOf('\n', lineStart);
+
+            if ( lineEnd < 0 )
+            {
+                lineEnd = data.size();
+            }
+
+            const QByteArray line = data.mid(lineStart, lineEnd - lineStart).trimmed();
+            lineStart = lineEnd + 1;
+
+            if ( line.isEmpty() )
+            {
+                continue;
+            }
+
+            QCanBusFrame frame;
+
+            if ( ! parseLine(line, frame, interfaceName) )
+            {
+                skipRecord();
+                continue;
+            }
+
+            // consecutive frames usually share their interface, whose name is converted only once
+            if ( interfaceName != lastInterfaceName )
+            {
+                lastInterfaceName   = interfaceName;
+                channelName         = QString::fromUtf8(interfaceName);
+            }
+
+            block.appendFrame(frame, channelName);
+        }
+    }
+
+    bool CandumpTraceFileReader::parseLine(const QByteArray &line, QCanBusFrame &frame, QByteArray &interfaceName)
+    {
+        // (<seconds>.<microseconds>) <interface> <frame> [T|R]
+        const QList<QByteArray> fields = line.simplified().split(' ');
+
+        if ( fields.size() < 3 || ! fields.at(0).startsWith('(') || ! fields.at(0).endsWith(')') )
+        {
+            return false;
+        }
+
+        const QByteArray        timestamp       = fields.at(0).mid(1, fields.at(0).size() - 2);
+        const int               separator       = timestamp.indexOf('.');
+        bool                    secondsValid    = false;
+        bool                    fractionValid   = false;
+
+        if ( separator < 0 )
+        {
+            return false;
+        }
+
+        const qint64 seconds        = timestamp.left(separator).toLongLong(&secondsValid);
+        const qint64 microSeconds   = timestamp.mid(separator + 1).leftJustified(6, '0', true).toLongLong(&fractionValid);
+
+        if ( ! secondsValid || ! fractionValid )
+        {
+            return false;
+        }
+
+        const QByteArray    &frameField = fields.at(2);
+        const int           idEnd       = frameField.indexOf('#');
+
+        if ( idEnd != STANDARD_ID_DIGITS && idEnd != EXTENDED_ID_DIGITS )
+        {
+            return false;
+        }
+
+        bool            idValid = false;
+        const quint32   rawId   = frameField.left(idEnd).toUInt(&idValid, 16);
+
+        if ( ! idValid )
+        {
+            return false;
+        }
+
+        QByteArray  data        = frameField.mid(idEnd + 1);
+        bool        fdFrame     = false;
+        int         fdFlags     = 0;
+
+        if ( data.startsWith('#') )
+        {
+            // CAN FD frame: ##<flags><data>
+            if ( data.size() < 2 )
+            {
+                return false;
+            }
+
+            bool flagsValid = false;
+            fdFlags = data.mid(1, 1).toInt(&flagsValid, 16);
+            fdFrame = true;
+            data    = data.mid(2);
+
+            if ( ! flagsValid )
+            {
+                return false;
+            }
+        }
+
+        frame = QCanBusFrame();
+        frame.setExtendedFrameFormat( idEnd == EXTENDED_ID_DIGITS );
+        frame.setFrameId( rawId & CAN_EFF_MASK );
+
+        if ( ( rawId & CAN_ERR_FLAG ) && idEnd == EXTENDED_ID_DIGITS )
+        {
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+            frame.setExtendedFrameFormat(false);
+            frame.setError( QCanBusFrame::FrameErrors( int(rawId & CAN_EFF_MASK) ) );
+        }
+        else if ( ! fdFrame && data.startsWith('R') )
+        {
+            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        }
+
+        if ( frame.frameType() != QCanBusFrame::RemoteRequestFrame )
+        {
+            data.replace(".", "");
+
+            if ( data.size() % 2 != 0 )
+            {
+                return false;
+            }
+
+            frame.setPayload( QByteArray::fromHex(data) );
+        }
+
+        if ( fdFrame )
+        {
+            frame.setFlexibleDataRateFormat(true);
+            frame.setBitrateSwitch( fdFlags & CANFD_BRS );
+            frame.setErrorStateIndicator( fdFlags & CANFD_ESI );
+        }
+
+        if ( fields.size() > 3 && fields.at(3) == "T" )
+        {
+            frame.setLocalEcho(true);
+        }
+
+        frame.setTimeStamp( QCanBusFrame::TimeStamp(seconds, microSeconds) );
+
+        interfaceName = fields.at(1);
+
+        return frame.isValid();
+    }
+}
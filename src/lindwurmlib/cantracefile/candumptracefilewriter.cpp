@@ -0,0 +1,164 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/candumptracefilewriter.h"
+
+#include <QLoggingCategory>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    // flags of the frame ID as used by SocketCAN
+    const quint32 CAN_ERR_FLAG  = 0x20000000U;
+    const quint32 CAN_EFF_MASK  = 0x1FFFFFFFU;
+
+    // flags of CAN FD frames
+    const int CANFD_BRS         = 0x01;
+    const int CANFD_ESI         = 0x02;
+
+    const int STANDARD_ID_DIGITS = 3;
+    const int EXTENDED_ID_DIGITS = 8;
+}
+
+namespace Lindwurm::Lib
+{
+    CandumpTraceFileWriter::CandumpTraceFileWriter()
+    {
+
+    }
+
+    CandumpTraceFileWriter::~CandumpTraceFileWriter()
+    {
+        close();
+    }
+
+    bool CandumpTraceFileWriter::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_errorString.clear();
+
+        return true;
+    }
+
+    void CandumpTraceFileWriter::close()
+    {
+        if ( m_file.isOpen() )
+        {
+            m_file.close();
+        }
+    }
+
+    bool CandumpTraceFileWriter::writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            m_errorString = QStringLiteral("Trace file is not open");
+            return false;
+        }
+
+        // the fields of a line are separated by spaces, so they must not appear in the interface name
+        const QString       simplifiedName  = interfaceName.simplified().replace(' ', '_');
+        const QByteArray    name            = simplifiedName.isEmpty() ? QByteArray("can") : simplifiedName.toUtf8();
+        QByteArray          buffer;
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            buffer.append( formatLine(frame, name) );
+            buffer.append('\n');
+        }
+
+        if ( m_file.write(buffer) != buffer.size() )
+        {
+            m_errorString = m_file.errorString();
+            qWarning(LOG_TAG) << "Failed to write to" << m_file.fileName() << ":" << m_errorString;
+            return false;
+        }
+
+        return true;
+    }
+
+    QString CandumpTraceFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    QByteArray CandumpTraceFileWriter::formatLine(const QCanBusFrame &frame, const QByteArray &interfaceName)
+    {
+        const QCanBusFrame::TimeStamp timeStamp = frame.timeStamp();
+
+        QByteArray line = "(" + QByteArray::number(timeStamp.seconds()) + "."
+                        + QByteArray::number(timeStamp.microSeconds()).rightJustified(6, '0') + ") "
+                        + interfaceName + " ";
+
+        if ( frame.frameType() == QCanBusFrame::ErrorFrame )
+        {
+            const quint32 rawId = CAN_ERR_FLAG | ( quint32(frame.error()) & CAN_EFF_MASK );
+            line += QByteArray::number(rawId, 16).toUpper().rightJustified(EXTENDED_ID_DIGITS, '0');
+        }
+        else
+        {
+            const int digits = frame.hasExtendedFrameFormat() ? EXTENDED_ID_DIGITS : STANDARD_ID_DIGITS;
+            line += QByteArray::number(frame.frameId(), 16).toUpper().rightJustified(digits, '0');
+        }
+
+        line += '#';
+
+        if ( frame.frameType() == QCanBusFrame::RemoteRequestFrame )
+        {
+            line += 'R';
+        }
+        else
+        {
+            if ( frame.hasFlexibleDataRateFormat() )
+            {
+                int flags = 0;
+
+                if ( frame.hasBitrateSwitch() )
+                {
+                    flags |= CANFD_BRS;
+                }
+
+                if ( frame.hasErrorStateIndicator() )
+                {
+                    flags |= CANFD_ESI;
+                }
+
+                line += '#';
+                line += QByteArray::number(flags, 16).toUpper();
+            }
+
+            line += frame.payload().toHex().toUpper();
+        }
+
+        if ( frame.hasLocalEcho() )
+        {
+            line += " T";
+        }
+
+        return line;
+    }
+}
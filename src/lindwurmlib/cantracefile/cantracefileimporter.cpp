@@ -0,0 +1,301 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/cantracefileimporter.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QRunnable>
+#include <QThread>
+
+#include <deque>
+#include <future>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    // the import thread checks for a cancel request at least this often while the queue is full
+    const int CANCEL_CHECK_INTERVAL_MSECS = 50;
+
+    /**
+     * @brief The DecodeTask class decodes a single block in a thread of the decoder pool.
+     */
+    class DecodeTask : public QRunnable
+    {
+        public:
+
+            DecodeTask(Lindwurm::Lib::ICanTraceFileReader &reader, Lindwurm::Lib::CanTraceFileBlock &&block)
+                : m_reader(reader)
+                , m_block( std::move(block) )
+            {
+
+            }
+
+            std::future<Lindwurm::Lib::CanTraceFileBlock> result()
+            {
+                return m_result.get_future();
+            }
+
+            virtual void run() override
+            {
+                m_reader.decodeBlock(m_block);
+                m_result.set_value( std::move(m_block) );
+            }
+
+        private:
+
+            Lindwurm::Lib::ICanTraceFileReader&             m_reader;
+            Lindwurm::Lib::CanTraceFileBlock                m_block;
+            std::promise<Lindwurm::Lib::CanTraceFileBlock>  m_result;
+    };
+}
+
+namespace Lindwurm::Lib
+{
+    CanTraceFileImporter::CanTraceFileImporter(QObject *parent)
+        : QObject(parent)
+        , m_blocks(QueueCapacity)
+        , m_freeSlots(QueueCapacity)
+    {
+        // the decoder threads are kept between the blocks and imports instead of being started for each block
+        m_decoderPool.setMaxThreadCount( qMax(QThread::idealThreadCount(), 1) );
+    }
+
+    CanTraceFileImporter::~CanTraceFileImporter()
+    {
+        m_cancelRequested = true;
+        stopImportThread();
+    }
+
+    bool CanTraceFileImporter::start(const QString &fileName)
+    {
+        if ( m_importThread != nullptr )
+        {
+            m_errorString = QStringLiteral("An import is already running");
+            return false;
+        }
+
+        ICanTraceFileReaderPtr reader = ICanTraceFileReader::createReader(fileName);
+
+        if ( ! reader )
+        {
+            m_errorString = QStringLiteral("Unsupported trace file format");
+            return false;
+        }
+
+        if ( ! reader->open(fileName) )
+        {
+            m_errorString = reader->errorString();
+            return false;
+        }
+
+        std::shared_ptr<ICanTraceFileReader> sharedReader( reader.release() );
+
+        m_errorString.clear();
+        m_cancelRequested   = false;
+        m_importThread      = QThread::create([this, sharedReader]()
+        {
+            importLoop(*sharedReader);
+        });
+
+        m_importThread->setObjectName( QStringLiteral("CAN trace import") );
+        m_importThread->start();
+
+        return true;
+    }
+
+    void CanTraceFileImporter::cancel()
+    {
+        if ( m_importThread == nullptr )
+        {
+            return;
+        }
+
+        m_cancelRequested = true;
+        stopImportThread();
+
+        // the blocks not yet taken are discarded
+        QVector<CanTraceFileBlock> discardedBlocks;
+        m_freeSlots.release( m_blocks.popAll(discardedBlocks) );
+
+        m_errorString = QStringLiteral("The import has been cancelled");
+
+        emit finished(false);
+    }
+
+    bool CanTraceFileImporter::isRunning() const
+    {
+        return m_importThread != nullptr;
+    }
+
+    QVector<CanTraceFileBlock> CanTraceFileImporter::takeBlocks()
+    {
+        // reset the flag before draining, so blocks pushed while draining trigger a new notification
+        m_notificationPending.store(false, std::memory_order_release);
+
+        QVector<CanTraceFileBlock> blocks;
+        m_freeSlots.release( m_blocks.popAll(blocks) );
+
+        return blocks;
+    }
+
+    QString CanTraceFileImporter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    void CanTraceFileImporter::importLoop(ICanTraceFileReader &reader)
+    {
+        const size_t                                decoderCount    = size_t( m_decoderPool.maxThreadCount() );
+        std::deque<std::future<CanTraceFileBlock>>  decodingBlocks;
+        bool                                        endOfFile       = false;
+        bool                                        published       = true;
+
+        while ( ! m_cancelRequested && published )
+        {
+            // keep the decoders busy with the following blocks while the oldest one is completed
+            while ( ! endOfFile && decodingBlocks.size() < decoderCount )
+            {
+                CanTraceFileBlock block;
+
+                if ( ! reader.readBlock(block) )
+                {
+                    endOfFile = true;
+                    break;
+                }
+
+                DecodeTask *task = new DecodeTask( reader, std::move(block) );
+
+                decodingBlocks.push_back( task->result() );
+                m_decoderPool.start(task);
+            }
+
+            if ( decodingBlocks.empty() )
+            {
+                break;
+            }
+
+            CanTraceFileBlock block = decodingBlocks.front().get();
+            decodingBlocks.pop_front();
+
+            reader.completeBlock(block);
+            published = publishBlock(block);
+
+            const qint64 bytesRead  = reader.position();
+            const qint64 totalBytes = reader.size();
+
+            QMetaObject::invokeMethod(this, [this, bytesRead, totalBytes]()
+            {
+                emit progress(bytesRead, totalBytes);
+            }, Qt::QueuedConnection);
+        }
+
+        // the decoders refer to the reader, so they have to finish before it is closed
+        for (const std::future<CanTraceFileBlock> &decodingBlock : decodingBlocks)
+        {
+            decodingBlock.wait();
+        }
+
+        decodingBlocks.clear();
+
+        if ( ! m_cancelRequested )
+        {
+            CanTraceFileBlock lastBlock;
+            reader.finishBlocks(lastBlock);
+            publishBlock(lastBlock);
+        }
+
+        const QString   errorString = reader.errorString();
+        const bool      success     = ! m_cancelRequested && errorString.isEmpty();
+
+        reader.close();
+
+        if ( m_cancelRequested )
+        {
+            // cancel() joins this thread and reports the end of the import itself
+            return;
+        }
+
+        if ( ! success )
+        {
+            qWarning(LOG_TAG) << "Failed to import trace file:" << errorString;
+        }
+
+        QThread *importThread = QThread::currentThread();
+
+        QMetaObject::invokeMethod(this, [this, importThread, success, errorString]()
+        {
+            // unless the import was cancelled meanwhile
+            if ( m_importThread != importThread )
+            {
+                return;
+            }
+
+            stopImportThread();
+
+            m_errorString = errorString;
+
+            if ( m_blocks.size() > 0 )
+            {
+                emit blocksAvailable();
+            }
+
+            emit finished(success);
+        }, Qt::QueuedConnection);
+    }
+
+    bool CanTraceFileImporter::publishBlock(const CanTraceFileBlock &block)
+    {
+        if ( block.frames.isEmpty() )
+        {
+            return true;
+        }
+
+        // wait for the consumer while the queue is full
+        while ( ! m_freeSlots.tryAcquire(1, CANCEL_CHECK_INTERVAL_MSECS) )
+        {
+            if ( m_cancelRequested )
+            {
+                return false;
+            }
+        }
+
+        m_blocks.push(block);
+
+        if ( ! m_notificationPending.exchange(true, std::memory_order_acq_rel) )
+        {
+            QMetaObject::invokeMethod(this, [this]()
+            {
+                emit blocksAvailable();
+            }, Qt::QueuedConnection);
+        }
+
+        return true;
+    }
+
+    void CanTraceFileImporter::stopImportThread()
+    {
+        if ( m_importThread != nullptr )
+        {
+            m_importThread->wait();
+
+            delete m_importThread;
+            m_importThread = nullptr;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/icantracefilewriter.h"
+#include "cantracefile/asctracefilewriter.h"
+#include "cantracefile/blftracefilewriter.h"
+#include "cantracefile/candumptracefilewriter.h"
+#include "cantracefile/pcapngtracefilewriter.h"
+
+#include <QFileInfo>
+
+namespace Lindwurm::Lib
+{
+    ICanTraceFileWriterPtr ICanTraceFileWriter::createWriter(const QString &fileName)
+    {
+        const QString suffix = QFileInfo(fileName).suffix().toLower();
+
+        if ( suffix == "log" )
+        {
+            return std::make_unique<CandumpTraceFileWriter>();
+        }
+
+        if ( suffix == "asc" )
+        {
+            return std::make_unique<AscTraceFileWriter>();
+        }
+
+        if ( suffix == "blf" )
+        {
+            return std::make_unique<BlfTraceFileWriter>();
+        }
+
+        if ( suffix == "pcapng" )
+        {
+            return std::make_unique<PcapngTraceFileWriter>();
+        }
+
+        return ICanTraceFileWriterPtr();
+    }
+}
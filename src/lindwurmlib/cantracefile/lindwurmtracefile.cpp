@@ -0,0 +1,478 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cantracefile/lindwurmtracefile.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+}
+
+namespace Lindwurm::Lib
+{
+    using namespace LindwurmTraceFormat;
+
+    namespace
+    {
+        const qint64 RECORD_SIZE = qint64( sizeof(CanFrameTracerRecord) );
+
+        // replaces the payloads of a corrupted trace file, so they are never read from outside of the mapping
+        const quint8 ZERO_PAYLOAD[MaxPayloadLength] = {};
+
+        CanFrameAggregator fromAggregatorEntry(const AggregatorEntry &entry)
+        {
+            const QCanBusFrame::FrameType frameType = QCanBusFrame::FrameType(entry.frameType);
+
+            QCanBusFrame frame(frameType);
+
+            if ( frameType == QCanBusFrame::ErrorFrame )
+            {
+                frame.setError( QCanBusFrame::FrameErrors( int(entry.latestFrameId) ) );
+            }
+            else
+            {
+                frame.setFrameId(entry.latestFrameId);
+                frame.setExtendedFrameFormat( entry.flags & ExtendedFrameFormat );
+            }
+
+            frame.setFlexibleDataRateFormat( entry.flags & FlexibleDataRate );
+            frame.setBitrateSwitch( entry.flags & BitrateSwitch );
+            frame.setErrorStateIndicator( entry.flags & ErrorStateIndicator );
+            frame.setLocalEcho( entry.flags & LocalEcho );
+            frame.setPayload( QByteArray( reinterpret_cast<const char*>(entry.payload), int( qMin( entry.payloadLength, quint32(MaxPayloadLength) ) ) ) );
+            frame.setTimeStamp( QCanBusFrame::TimeStamp::fromMicroSeconds(entry.latestTimestampUSecs) );
+
+            CanFrameIntervalStatistics intervalStatistics;
+            intervalStatistics.intervalCount            = entry.intervalCount;
+            intervalStatistics.meanUSecs                = entry.averageTimeIntervalUSecs;
+            intervalStatistics.sumOfSquaredDeviations   = entry.intervalSumOfSquaredDeviations;
+            intervalStatistics.minUSecs                 = entry.minTimeIntervalUSecs;
+            intervalStatistics.maxUSecs                 = entry.maxTimeIntervalUSecs;
+            std::copy( std::begin(entry.jitterBuckets), std::end(entry.jitterBuckets), intervalStatistics.jitterBuckets.begin() );
+
+            return CanFrameAggregator( entry.frameId, entry.frameRecordCount, frame, entry.latestTimestampUSecs,
+                                       entry.latestTimeDifferenceUSecs, entry.latestSourceInterface, intervalStatistics );
+        }
+    }
+
+    LindwurmTraceFile::LindwurmTraceFile()
+    {
+
+    }
+
+    LindwurmTraceFile::~LindwurmTraceFile()
+    {
+        close();
+    }
+
+    bool LindwurmTraceFile::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::ReadOnly) )
+        {
+            return fail( m_file.errorString() );
+        }
+
+        m_size = m_file.size();
+
+        if ( m_size < qint64( sizeof(FileHeader) ) )
+        {
+            return fail("The file is not a Lindwurm trace file");
+        }
+
+        // copy-on-write, records are relocated to their payloads without writing to the file
+        m_map = m_file.map(0, m_size, QFileDevice::MapPrivateOption);
+
+        if ( m_map == nullptr )
+        {
+            return fail( m_file.errorString() );
+        }
+
+        FileHeader header;
+        std::memcpy( &header, m_map, sizeof(header) );
+
+        if ( std::memcmp( header.magic, Magic, sizeof(header.magic) ) != 0 )
+        {
+            return fail("The file is not a Lindwurm trace file");
+        }
+
+        if ( header.version < MinimumVersion || header.version > Version || header.byteOrderMark != ByteOrderMark
+             || header.recordSize != quint32(RECORD_SIZE) || header.chunkRecordCount != quint32(ChunkRecordCount) )
+        {
+            return fail("The trace file was written by an incompatible version or platform");
+        }
+
+        if ( ! ( header.indexOffset != 0 ? readIndex(header.indexOffset, header.version) : recoverIndex() ) )
+        {
+            return false;
+        }
+
+        // the records are checked and their payloads relocated when a chunk is accessed the first time,
+        // opening does not touch the chunks
+        m_relocatedChunks.reset( new std::atomic<bool>[ size_t( m_chunkEntries.size() ) ] );
+
+        for (int chunk = 0; chunk < m_chunkEntries.size(); chunk++)
+        {
+            m_relocatedChunks[chunk].store(false, std::memory_order_relaxed);
+        }
+
+        m_recordCount = m_chunkEntries.isEmpty() ? 0 : m_chunkEntries.last().firstRecord + m_chunkEntries.last().recordCount;
+        m_startTime   = header.startTimeUSecs;
+
+        // an unfinished file has no start time, the trace starts with its first frame
+        if ( m_startTime == 0 && ! m_chunkEntries.isEmpty() )
+        {
+            m_startTime = m_chunkEntries.first().minTimestampUSecs;
+        }
+
+        m_errorString.clear();
+
+        return true;
+    }
+
+    void LindwurmTraceFile::close()
+    {
+        if ( m_map != nullptr )
+        {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+        }
+
+        m_file.close();
+
+        m_size              = 0;
+        m_startTime         = 0;
+        m_recordCount       = 0;
+        m_hasAggregators    = false;
+
+        m_chunkEntries.clear();
+        m_relocatedChunks.reset();
+        m_aggregators.clear();
+        m_interfaceNames.clear();
+    }
+
+    bool LindwurmTraceFile::isOpen() const
+    {
+        return m_map != nullptr;
+    }
+
+    QString LindwurmTraceFile::fileName() const
+    {
+        return m_file.fileName();
+    }
+
+    qint64 LindwurmTraceFile::startTime() const
+    {
+        return m_startTime;
+    }
+
+    qint64 LindwurmTraceFile::recordCount() const
+    {
+        return m_recordCount;
+    }
+
+    int LindwurmTraceFile::chunkCount() const
+    {
+        return m_chunkEntries.size();
+    }
+
+    CanFrameTracerRecord *LindwurmTraceFile::chunkRecords(int chunk) const
+    {
+        return reinterpret_cast<CanFrameTracerRecord*>( m_map + m_chunkEntries.at(chunk).fileOffset + qint64( sizeof(ChunkHeader) ) );
+    }
+
+    int LindwurmTraceFile::chunkRecordCount(int chunk) const
+    {
+        return int( m_chunkEntries.at(chunk).recordCount );
+    }
+
+    qint64 LindwurmTraceFile::recordIndexAtTime(qint64 timestampUSecs) const
+    {
+        for (int chunk = 0; chunk < m_chunkEntries.size(); chunk++)
+        {
+            const ChunkEntry &entry = m_chunkEntries.at(chunk);
+
+            // only the chunk which may hold the record is paged in
+            if ( entry.maxTimestampUSecs < timestampUSecs )
+            {
+                continue;
+            }
+
+            const CanFrameTracerRecord *records = chunkRecords(chunk);
+
+            for (quint32 index = 0; index < entry.recordCount; index++)
+            {
+                if ( records[index].timestampUSecs() >= timestampUSecs )
+                {
+                    return entry.firstRecord + index;
+                }
+            }
+        }
+
+        return m_recordCount;
+    }
+
+    bool LindwurmTraceFile::hasAggregators() const
+    {
+        return m_hasAggregators;
+    }
+
+    QVector<CanFrameAggregator> LindwurmTraceFile::aggregators() const
+    {
+        return m_aggregators;
+    }
+
+    QMap<CanInterfaceIndex, QString> LindwurmTraceFile::interfaceNames() const
+    {
+        return m_interfaceNames;
+    }
+
+    QString LindwurmTraceFile::errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool LindwurmTraceFile::readIndex(qint64 indexOffset, quint32 version)
+    {
+        IndexHeader header;
+
+        if ( indexOffset < qint64( sizeof(FileHeader) ) || indexOffset > m_size - qint64( sizeof(header) ) )
+        {
+            return fail("The index of the trace file is corrupted");
+        }
+
+        std::memcpy( &header, m_map + indexOffset, sizeof(header) );
+
+        qint64 offset = indexOffset + qint64( sizeof(header) );
+
+        // the aggregate records of older versions lack the interval statistics and are rebuilt instead
+        const bool      readAggregators     = version == Version;
+        const qint64    aggregatorEntrySize = readAggregators ? qint64( sizeof(AggregatorEntry) ) : AggregatorEntryV1Size;
+        const qint64    fixedBytes          = qint64(header.chunkCount) * qint64( sizeof(ChunkEntry) ) + qint64(header.aggregatorCount) * aggregatorEntrySize;
+
+        if ( fixedBytes > m_size - offset )
+        {
+            return fail("The index of the trace file is corrupted");
+        }
+
+        m_chunkEntries.resize( int(header.chunkCount) );
+        std::memcpy( m_chunkEntries.data(), m_map + offset, size_t(header.chunkCount) * sizeof(ChunkEntry) );
+        offset += qint64(header.chunkCount) * qint64( sizeof(ChunkEntry) );
+
+        // the chunks are served from the mapping, so every entry has to lie within the chunk area before the index
+        if ( ! validateChunkEntries(indexOffset) )
+        {
+            return fail("The index of the trace file is corrupted");
+        }
+
+        if ( readAggregators )
+        {
+            m_aggregators.reserve( int(header.aggregatorCount) );
+
+            for (quint32 index = 0; index < header.aggregatorCount; index++)
+            {
+                AggregatorEntry entry;
+                std::memcpy( &entry, m_map + offset, sizeof(entry) );
+                offset += qint64( sizeof(entry) );
+
+                m_aggregators.append( fromAggregatorEntry(entry) );
+            }
+        }
+        else
+        {
+            offset += qint64(header.aggregatorCount) * aggregatorEntrySize;
+        }
+
+        // aggregate records of an empty trace are never missing
+        m_hasAggregators = ( readAggregators && header.aggregatorCount > 0 ) || header.chunkCount == 0;
+
+        for (quint32 index = 0; index < header.interfaceCount; index++)
+        {
+            InterfaceEntry entry;
+
+            if ( qint64( sizeof(entry) ) > m_size - offset )
+            {
+                return fail("The index of the trace file is corrupted");
+            }
+
+            std::memcpy( &entry, m_map + offset, sizeof(entry) );
+            offset += qint64( sizeof(entry) );
+
+            if ( entry.nameLength > m_size - offset )
+            {
+                return fail("The index of the trace file is corrupted");
+            }
+
+            m_interfaceNames.insert( entry.interfaceIndex, QString::fromUtf8( reinterpret_cast<const char*>(m_map + offset), entry.nameLength ) );
+            offset += entry.nameLength;
+        }
+
+        return true;
+    }
+
+    bool LindwurmTraceFile::validateChunkEntries(qint64 chunkAreaEnd) const
+    {
+        qint64 firstRecord = 0;
+
+        for (int chunk = 0; chunk < m_chunkEntries.size(); chunk++)
+        {
+            const ChunkEntry &entry = m_chunkEntries.at(chunk);
+
+            // every chunk but the last one is completely filled, so the chunks can be served to the tracer's store
+            const bool  lastChunk   = chunk == m_chunkEntries.size() - 1;
+            const bool  validCount  = entry.recordCount > 0 && ( lastChunk ? entry.recordCount <= quint32(ChunkRecordCount) : entry.recordCount == quint32(ChunkRecordCount) );
+            const qint64 chunkBytes = qint64( sizeof(ChunkHeader) ) + qint64(entry.recordCount) * RECORD_SIZE + qint64(entry.payloadBytes);
+
+            if ( ! validCount || entry.firstRecord != firstRecord || entry.fileOffset < qint64( sizeof(FileHeader) )
+                 || entry.fileOffset % Alignment != 0 || chunkAreaEnd > m_size || entry.fileOffset > chunkAreaEnd - chunkBytes )
+            {
+                return false;
+            }
+
+            // the entry has to describe the chunk it points to
+            ChunkHeader header;
+            std::memcpy( &header, m_map + entry.fileOffset, sizeof(header) );
+
+            if ( header.magic != ChunkMagic || header.recordCount != entry.recordCount || header.payloadBytes != entry.payloadBytes )
+            {
+                return false;
+            }
+
+            firstRecord += entry.recordCount;
+        }
+
+        return true;
+    }
+
+    bool LindwurmTraceFile::recoverIndex()
+    {
+        qint64 offset       = qint64( sizeof(FileHeader) );
+        qint64 firstRecord  = 0;
+
+        while ( offset <= m_size - qint64( sizeof(ChunkHeader) ) )
+        {
+            ChunkHeader header;
+            std::memcpy( &header, m_map + offset, sizeof(header) );
+
+            const qint64 chunkBytes = qint64( sizeof(header) ) + qint64(header.recordCount) * RECORD_SIZE + qint64(header.payloadBytes);
+
+            // the last chunk may have been written partially
+            if ( header.magic != ChunkMagic || header.recordCount == 0 || header.recordCount > quint32(ChunkRecordCount) || chunkBytes > m_size - offset )
+            {
+                break;
+            }
+
+            ChunkEntry entry;
+            entry.fileOffset    = offset;
+            entry.firstRecord   = firstRecord;
+            entry.recordCount   = header.recordCount;
+            entry.payloadBytes  = header.payloadBytes;
+
+            const CanFrameTracerRecord *records = reinterpret_cast<const CanFrameTracerRecord*>( m_map + offset + qint64( sizeof(header) ) );
+
+            entry.minTimestampUSecs = records[0].timestampUSecs();
+            entry.maxTimestampUSecs = records[0].timestampUSecs();
+
+            for (quint32 index = 1; index < header.recordCount; index++)
+            {
+                entry.minTimestampUSecs = qMin( entry.minTimestampUSecs, records[index].timestampUSecs() );
+                entry.maxTimestampUSecs = qMax( entry.maxTimestampUSecs, records[index].timestampUSecs() );
+            }
+
+            m_chunkEntries.append(entry);
+
+            firstRecord += header.recordCount;
+            offset      = aligned(offset + chunkBytes);
+
+            // only the last chunk is partially filled
+            if ( header.recordCount < quint32(ChunkRecordCount) )
+            {
+                break;
+            }
+        }
+
+        m_hasAggregators = m_chunkEntries.isEmpty();
+
+        return true;
+    }
+
+    void LindwurmTraceFile::relocatePayloads(int chunk) const
+    {
+        QMutexLocker locker(&m_relocationMutex);
+
+        if ( m_relocatedChunks[chunk].load(std::memory_order_relaxed) )
+        {
+            return;
+        }
+
+        const ChunkEntry        &entry      = m_chunkEntries.at(chunk);
+        CanFrameTracerRecord    *records    = chunkRecords(chunk);
+        const quint8            *payload    = reinterpret_cast<const quint8*>(records + entry.recordCount);
+
+        int corruptedRecordCount = 0;
+
+        // only records with CAN FD payloads and corrupted records are written to, their pages are copied on write
+        for (quint32 index = 0; index < entry.recordCount; index++)
+        {
+            CanFrameTracerRecord &record = records[index];
+
+            const bool corrupted = record.repair();
+
+            if ( record.payloadLength() <= CanFrameTracerRecord::InlinePayloadSize )
+            {
+                corruptedRecordCount += corrupted ? 1 : 0;
+                continue;
+            }
+
+            const quint64 offset = record.arenaPayloadOffset();
+
+            if ( corrupted || offset > entry.payloadBytes || quint64( record.payloadLength() ) > entry.payloadBytes - offset )
+            {
+                // the repaired payload length never exceeds the zeros
+                record.relocateArenaPayload(ZERO_PAYLOAD);
+                corruptedRecordCount++;
+                continue;
+            }
+
+            record.relocateArenaPayload(payload + offset);
+        }
+
+        if ( corruptedRecordCount > 0 )
+        {
+            qWarning(LOG_TAG) << "Trace file" << m_file.fileName() << "has" << corruptedRecordCount << "corrupted records in chunk" << chunk;
+        }
+
+        m_relocatedChunks[chunk].store(true, std::memory_order_release);
+    }
+
+    bool LindwurmTraceFile::fail(const QString &errorString)
+    {
+        close();
+
+        m_errorString = errorString;
+
+        return false;
+    }
+}
@@ -0,0 +1,329 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cantracefile/lindwurmtracefilewriter.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+}
+
+namespace Lindwurm::Lib
+{
+    using namespace LindwurmTraceFormat;
+
+    static_assert( JitterBucketCount == CanFrameIntervalStatistics::JitterBucketCount, "the jitter histogram is stored as is" );
+
+    namespace
+    {
+        AggregatorEntry toAggregatorEntry(const CanFrameAggregator &aggregator)
+        {
+            const QCanBusFrame  &frame  = aggregator.latestFrame();
+            const QByteArray    payload = frame.payload().left(MaxPayloadLength);
+            const CanFrameIntervalStatistics &intervals = aggregator.intervalStatistics();
+
+            AggregatorEntry entry;
+            std::memset( &entry, 0, sizeof(entry) );
+
+            entry.frameId                   = aggregator.frameId();
+            entry.latestFrameId             = frame.frameType() == QCanBusFrame::ErrorFrame ? quint32( frame.error() ) : frame.frameId();
+            entry.latestSourceInterface     = aggregator.latestSourceInterface();
+            entry.frameType                 = quint8( frame.frameType() );
+            entry.frameRecordCount          = aggregator.frameRecordCount();
+            entry.latestTimestampUSecs      = aggregator.latestTimestampUSecs();
+            entry.latestTimeDifferenceUSecs = aggregator.latestTimeDifferenceUSecs();
+            entry.intervalCount             = intervals.intervalCount;
+            entry.averageTimeIntervalUSecs  = intervals.meanUSecs;
+            entry.intervalSumOfSquaredDeviations = intervals.sumOfSquaredDeviations;
+            entry.minTimeIntervalUSecs      = intervals.minUSecs;
+            entry.maxTimeIntervalUSecs      = intervals.maxUSecs;
+            entry.payloadLength             = quint32( payload.size() );
+
+            std::copy( intervals.jitterBuckets.cbegin(), intervals.jitterBuckets.cend(), entry.jitterBuckets );
+
+            entry.flags = ( frame.hasExtendedFrameFormat()      ? ExtendedFrameFormat   : 0 )
+                        | ( frame.hasFlexibleDataRateFormat()   ? FlexibleDataRate      : 0 )
+                        | ( frame.hasBitrateSwitch()            ? BitrateSwitch         : 0 )
+                        | ( frame.hasErrorStateIndicator()      ? ErrorStateIndicator   : 0 )
+                        | ( frame.hasLocalEcho()                ? LocalEcho             : 0 );
+
+            std::memcpy( entry.payload, payload.constData(), size_t( payload.size() ) );
+
+            return entry;
+        }
+    }
+
+    LindwurmTraceFileWriter::LindwurmTraceFileWriter()
+    {
+
+    }
+
+    LindwurmTraceFileWriter::~LindwurmTraceFileWriter()
+    {
+        if ( isOpen() )
+        {
+            // without the aggregate records, they are rebuilt when the file is opened
+            close(0, {}, {});
+        }
+    }
+
+    bool LindwurmTraceFileWriter::open(const QString &fileName)
+    {
+        if ( isOpen() )
+        {
+            m_file.close();
+        }
+
+        m_chunkRecords.clear();
+        m_chunkPayload.clear();
+        m_chunkEntries.clear();
+        m_sourceInterfaces.clear();
+        m_chunkRecordCount  = 0;
+        m_recordCount       = 0;
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_chunkRecords.reserve( ChunkRecordCount * int( sizeof(CanFrameTracerRecord) ) );
+
+        // the header is completed by close(), an index offset of 0 marks an unfinished file
+        FileHeader header;
+        std::memset( &header, 0, sizeof(header) );
+        std::memcpy( header.magic, Magic, sizeof(header.magic) );
+
+        header.version          = Version;
+        header.byteOrderMark    = ByteOrderMark;
+        header.recordSize       = quint32( sizeof(CanFrameTracerRecord) );
+        header.chunkRecordCount = quint32(ChunkRecordCount);
+
+        m_errorString.clear();
+
+        return write( &header, sizeof(header) );
+    }
+
+    bool LindwurmTraceFileWriter::isOpen() const
+    {
+        return m_file.isOpen();
+    }
+
+    bool LindwurmTraceFileWriter::appendRecord(const CanFrameTracerRecord &record)
+    {
+        if ( ! isOpen() )
+        {
+            m_errorString = "The trace file is not open";
+            return false;
+        }
+
+        CanFrameTracerRecord storedRecord = record;
+
+        const quint8 *arenaPayload = record.arenaPayload();
+
+        if ( arenaPayload != nullptr )
+        {
+            storedRecord.setArenaPayloadOffset( quint64( m_chunkPayload.size() ) );
+            m_chunkPayload.append( reinterpret_cast<const char*>(arenaPayload), record.payloadLength() );
+        }
+
+        m_chunkRecords.append( reinterpret_cast<const char*>(&storedRecord), int( sizeof(storedRecord) ) );
+
+        const qint64 timestampUSecs = record.timestampUSecs();
+
+        if ( m_chunkRecordCount == 0 )
+        {
+            m_chunkMinTimestampUSecs = timestampUSecs;
+            m_chunkMaxTimestampUSecs = timestampUSecs;
+        }
+        else
+        {
+            // frames of different interfaces may arrive slightly out of order
+            m_chunkMinTimestampUSecs = qMin(m_chunkMinTimestampUSecs, timestampUSecs);
+            m_chunkMaxTimestampUSecs = qMax(m_chunkMaxTimestampUSecs, timestampUSecs);
+        }
+
+        m_sourceInterfaces.insert( record.sourceInterface() );
+        m_chunkRecordCount++;
+        m_recordCount++;
+
+        if ( m_chunkRecordCount == ChunkRecordCount )
+        {
+            return writeChunk();
+        }
+
+        return true;
+    }
+
+    qint64 LindwurmTraceFileWriter::recordCount() const
+    {
+        return m_recordCount;
+    }
+
+    QList<CanInterfaceIndex> LindwurmTraceFileWriter::sourceInterfaces() const
+    {
+        return m_sourceInterfaces.values();
+    }
+
+    bool LindwurmTraceFileWriter::close(qint64 startTimeUSecs, const QVector<CanFrameAggregator> &aggregators, const QMap<CanInterfaceIndex, QString> &interfaceNames)
+    {
+        if ( ! isOpen() )
+        {
+            return false;
+        }
+
+        bool success = writeChunk();
+
+        // the index directly follows the padded last chunk
+        const qint64 indexOffset = m_file.pos();
+
+        success = success && writeIndex(aggregators, interfaceNames);
+
+        if ( success )
+        {
+            FileHeader header;
+            std::memset( &header, 0, sizeof(header) );
+            std::memcpy( header.magic, Magic, sizeof(header.magic) );
+
+            header.version          = Version;
+            header.byteOrderMark    = ByteOrderMark;
+            header.recordSize       = quint32( sizeof(CanFrameTracerRecord) );
+            header.chunkRecordCount = quint32(ChunkRecordCount);
+            header.startTimeUSecs   = startTimeUSecs;
+            header.recordCount      = m_recordCount;
+            header.indexOffset      = indexOffset;
+
+            success = m_file.seek(0) && write( &header, sizeof(header) );
+        }
+
+        if ( ! success )
+        {
+            qWarning(LOG_TAG) << "Failed to finish trace file" << m_file.fileName() << ":" << m_errorString;
+        }
+
+        m_file.close();
+
+        m_chunkRecords.clear();
+        m_chunkPayload.clear();
+        m_chunkEntries.clear();
+
+        return success;
+    }
+
+    QString LindwurmTraceFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool LindwurmTraceFileWriter::writeChunk()
+    {
+        if ( m_chunkRecordCount == 0 )
+        {
+            return true;
+        }
+
+        ChunkEntry entry;
+        entry.fileOffset        = m_file.pos();
+        entry.firstRecord       = m_recordCount - m_chunkRecordCount;
+        entry.minTimestampUSecs = m_chunkMinTimestampUSecs;
+        entry.maxTimestampUSecs = m_chunkMaxTimestampUSecs;
+        entry.recordCount       = quint32(m_chunkRecordCount);
+        entry.payloadBytes      = quint32( m_chunkPayload.size() );
+
+        ChunkHeader header;
+        header.magic            = ChunkMagic;
+        header.recordCount      = entry.recordCount;
+        header.payloadBytes     = entry.payloadBytes;
+        header.reserved         = 0;
+
+        const qint64    chunkBytes  = qint64( sizeof(header) ) + m_chunkRecords.size() + m_chunkPayload.size();
+        const QByteArray padding( int( aligned(chunkBytes) - chunkBytes ), '\0' );
+
+        if ( ! write( &header, sizeof(header) ) || ! write( m_chunkRecords.constData(), m_chunkRecords.size() )
+             || ! write( m_chunkPayload.constData(), m_chunkPayload.size() ) || ! write( padding.constData(), padding.size() ) )
+        {
+            return false;
+        }
+
+        m_chunkEntries.append(entry);
+
+        m_chunkRecords.clear();
+        m_chunkPayload.clear();
+        m_chunkRecordCount = 0;
+
+        return true;
+    }
+
+    bool LindwurmTraceFileWriter::writeIndex(const QVector<CanFrameAggregator> &aggregators, const QMap<CanInterfaceIndex, QString> &interfaceNames)
+    {
+        IndexHeader header;
+        header.chunkCount       = quint32( m_chunkEntries.size() );
+        header.aggregatorCount  = quint32( aggregators.size() );
+        header.interfaceCount   = quint32( interfaceNames.size() );
+        header.reserved         = 0;
+
+        if ( ! write( &header, sizeof(header) ) || ! write( m_chunkEntries.constData(), qint64( m_chunkEntries.size() ) * qint64( sizeof(ChunkEntry) ) ) )
+        {
+            return false;
+        }
+
+        for (const CanFrameAggregator &aggregator : aggregators)
+        {
+            const AggregatorEntry entry = toAggregatorEntry(aggregator);
+
+            if ( ! write( &entry, sizeof(entry) ) )
+            {
+                return false;
+            }
+        }
+
+        for (const CanInterfaceIndex interfaceIndex : interfaceNames.keys())
+        {
+            const QByteArray name = interfaceNames.value(interfaceIndex).toUtf8().left( std::numeric_limits<quint16>::max() );
+
+            InterfaceEntry entry;
+            entry.interfaceIndex    = interfaceIndex;
+            entry.nameLength        = quint16( name.size() );
+
+            if ( ! write( &entry, sizeof(entry) ) || ! write( name.constData(), name.size() ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool LindwurmTraceFileWriter::write(const void *data, qint64 size)
+    {
+        if ( size > 0 && m_file.write( static_cast<const char*>(data), size ) != size )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        return true;
+    }
+}
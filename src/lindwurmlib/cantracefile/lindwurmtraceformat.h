@@ -0,0 +1,132 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LINDWURMTRACEFORMAT_H
+#define LINDWURMTRACEFORMAT_H
+
+#include <QtGlobal>
+
+namespace Lindwurm::Lib::LindwurmTraceFormat
+{
+    /*
+     * Layout of a Lindwurm trace file (*.lwtrace), all values in host byte order:
+     *
+     *   FileHeader
+     *   chunk 0:   ChunkHeader, CanFrameTracerRecord[recordCount], payload bytes, padding to Alignment
+     *   chunk 1:   ...
+     *   index:     IndexHeader, ChunkEntry[chunkCount], AggregatorEntry[aggregatorCount],
+     *              InterfaceEntry + UTF-8 name for each interface
+     *
+     * The records are the tracer's packed records. Payloads longer than CanFrameTracerRecord::InlinePayloadSize follow
+     * the records of their chunk and are referenced by their offset from the first payload byte of the chunk. Every
+     * chunk except the last one holds ChunkRecordCount records, so the chunks are served to a SegmentedAppendStore
+     * as they are mapped. The index is written when the file is closed, FileHeader::indexOffset is 0 until then.
+     *
+     * Files of version 1 differ only in their shorter AggregatorEntry without interval statistics. Their aggregate
+     * records are skipped and rebuilt from the frame records.
+     */
+
+    const char      Magic[8]            = { 'L', 'W', 'T', 'R', 'A', 'C', 'E', '\0' };
+    const quint32   Version             = 2;
+    const quint32   MinimumVersion      = 1;
+    const quint32   ByteOrderMark       = 0x01020304U;
+    const quint32   ChunkMagic          = 0x4B484357U;      // "WCHK"
+    const int       ChunkRecordCount    = 16384;
+    const qint64    Alignment           = 8;
+    const int       MaxPayloadLength    = 64;
+    const int       JitterBucketCount   = 16;
+    const qint64    AggregatorEntryV1Size = 112;
+
+    struct FileHeader
+    {
+        char        magic[8];
+        quint32     version;
+        quint32     byteOrderMark;
+        quint32     recordSize;
+        quint32     chunkRecordCount;
+        qint64      startTimeUSecs;
+        qint64      recordCount;
+        qint64      indexOffset;
+    };
+
+    struct ChunkHeader
+    {
+        quint32     magic;
+        quint32     recordCount;
+        quint32     payloadBytes;
+        quint32     reserved;
+    };
+
+    struct IndexHeader
+    {
+        quint32     chunkCount;
+        quint32     aggregatorCount;
+        quint32     interfaceCount;
+        quint32     reserved;
+    };
+
+    struct ChunkEntry
+    {
+        qint64      fileOffset;             // offset of the ChunkHeader
+        qint64      firstRecord;
+        qint64      minTimestampUSecs;
+        qint64      maxTimestampUSecs;
+        quint32     recordCount;
+        quint32     payloadBytes;
+    };
+
+    enum AggregatorFlag : quint8
+    {
+        ExtendedFrameFormat     = 0x01,
+        FlexibleDataRate        = 0x02,
+        BitrateSwitch           = 0x04,
+        ErrorStateIndicator     = 0x08,
+        LocalEcho               = 0x10
+    };
+
+    struct AggregatorEntry
+    {
+        quint32     frameId;
+        quint16     latestSourceInterface;
+        quint8      frameType;
+        quint8      flags;
+        qint64      frameRecordCount;
+        qint64      latestTimestampUSecs;
+        qint64      latestTimeDifferenceUSecs;
+        qint64      intervalCount;
+        double      averageTimeIntervalUSecs;
+        double      intervalSumOfSquaredDeviations;
+        qint64      minTimeIntervalUSecs;
+        qint64      maxTimeIntervalUSecs;
+        quint32     jitterBuckets[JitterBucketCount];
+        quint32     payloadLength;
+        quint32     latestFrameId;          // the error flags for error frames
+        quint8      payload[MaxPayloadLength];
+    };
+
+    struct InterfaceEntry
+    {
+        quint16     interfaceIndex;
+        quint16     nameLength;
+    };
+
+    inline qint64 aligned(qint64 offset)
+    {
+        return ( offset + Alignment - 1 ) & ~(Alignment - 1);
+    }
+}
+
+#endif // LINDWURMTRACEFORMAT_H
@@ -0,0 +1,80 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCAPNGFORMAT_H
+#define PCAPNGFORMAT_H
+
+#include <QtGlobal>
+
+namespace Lindwurm::Lib::PcapngFormat
+{
+    /*
+     * Layout of a PCAP-NG capture (*.pcapng), all values in the byte order of the section:
+     *
+     *   block:     type, total length, body padded to 4 bytes, total length
+     *   section:   SectionHeaderBlock, InterfaceDescriptionBlock..., EnhancedPacketBlock...
+     *
+     * The byte order mark of the section header tells the byte order of the section. Interfaces are numbered by the
+     * order of their descriptions within the section. Options are a list of code, length and value padded to
+     * 4 bytes, terminated by OptionEnd.
+     *
+     * Packets of the SocketCAN link type start with the frame ID and its flags in network byte order, followed by
+     * the payload length, the CAN FD flags, two reserved bytes and the payload.
+     */
+
+    const quint32   SectionHeaderBlock          = 0x0A0D0D0AU;
+    const quint32   InterfaceDescriptionBlock   = 0x00000001U;
+    const quint32   EnhancedPacketBlock         = 0x00000006U;
+    const quint32   ByteOrderMagic              = 0x1A2B3C4DU;
+
+    const int       BlockHeaderSize             = 8;
+    const int       BlockTrailerSize            = 4;
+    const int       SectionHeaderSize           = 28;
+    const int       InterfaceDescriptionSize    = 20;
+    const int       EnhancedPacketSize          = 32;
+
+    // options
+    const quint16   OptionEnd                   = 0;
+    const quint16   InterfaceName               = 2;
+    const quint16   InterfaceTimestampResolution = 9;
+    const quint16   InterfaceTimestampOffset    = 14;
+    const quint16   PacketFlags                 = 2;
+
+    const quint32   PacketDirectionMask         = 0x3U;
+    const quint32   PacketInbound               = 0x1U;
+    const quint32   PacketOutbound              = 0x2U;
+
+    const quint16   LinkTypeSocketCan           = 227;
+    const quint8    MicroSecondResolution       = 6;
+
+    // SocketCAN frame ID flags and CAN FD flags
+    const quint32   CanEffFlag                  = 0x80000000U;
+    const quint32   CanRtrFlag                  = 0x40000000U;
+    const quint32   CanErrFlag                  = 0x20000000U;
+    const quint32   CanEffMask                  = 0x1FFFFFFFU;
+    const quint32   CanSffMask                  = 0x000007FFU;
+
+    const quint8    CanFdBrs                    = 0x01;
+    const quint8    CanFdEsi                    = 0x02;
+    const quint8    CanFdFdf                    = 0x04;
+
+    const int       CanHeaderSize               = 8;
+    const int       CanMtu                      = 16;
+    const int       CanFdMtu                    = 72;
+}
+
+#endif // PCAPNGFORMAT_H
@@ -0,0 +1,454 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/pcapngtracefilereader.h"
+#include "cantracefile/pcapngformat.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QtEndian>
+
+#include <limits>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    struct InterfaceDescription
+    {
+        quint16     linkType = {0};
+        quint8      timestampResolution = { Lindwurm::Lib::PcapngFormat::MicroSecondResolution };
+        qint64      timestampOffset = {0};          // in seconds
+        QString     name = {};
+    };
+
+    QByteArray serializeInterfaces(bool bigEndian, const QVector<InterfaceDescription> &interfaces)
+    {
+        QByteArray  context;
+        QDataStream stream(&context, QIODevice::WriteOnly);
+
+        stream << bigEndian << quint32( interfaces.size() );
+
+        for (const InterfaceDescription &interface : interfaces)
+        {
+            stream << interface.linkType << interface.timestampResolution << interface.timestampOffset << interface.name;
+        }
+
+        return context;
+    }
+
+    QVector<InterfaceDescription> deserializeInterfaces(const QByteArray &context, bool &bigEndian)
+    {
+        QVector<InterfaceDescription>   interfaces;
+        QDataStream                     stream(context);
+        quint32                         count = 0;
+
+        stream >> bigEndian >> count;
+
+        for (quint32 index = 0; index < count; index++)
+        {
+            InterfaceDescription interface;
+
+            stream >> interface.linkType >> interface.timestampResolution >> interface.timestampOffset >> interface.name;
+            interfaces.append(interface);
+        }
+
+        return interfaces;
+    }
+
+    template <typename T>
+    T readValue(const char *data, bool bigEndian)
+    {
+        return bigEndian ? qFromBigEndian<T>(data) : qFromLittleEndian<T>(data);
+    }
+
+    quint64 powerOfTen(int exponent)
+    {
+        quint64 power = 1;
+
+        for (int index = 0; index < exponent; index++)
+        {
+            power *= 10;
+        }
+
+        return power;
+    }
+
+    qint64 timestampUSecsOf(quint64 ticks, const InterfaceDescription &interface)
+    {
+        const int   exponent    = qMin(interface.timestampResolution & 0x7F, 63);
+        qint64      uSecs       = 0;
+
+        if ( interface.timestampResolution & 0x80 )
+        {
+            // ticks of 2^-exponent seconds
+            const quint64 seconds   = ticks >> exponent;
+            const quint64 fraction  = ticks - ( seconds << exponent );
+
+            uSecs = qint64(seconds) * 1000000 + qint64( (long double)(fraction) * 1000000 / (long double)( quint64(1) << exponent ) );
+        }
+        else if ( exponent >= 6 )
+        {
+            // ticks of 10^-exponent seconds
+            uSecs = qint64( ticks / powerOfTen( qMin(exponent - 6, 19) ) );
+        }
+        else
+        {
+            uSecs = qint64( ticks * powerOfTen(6 - exponent) );
+        }
+
+        return uSecs + interface.timestampOffset * 1000000;
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    using namespace PcapngFormat;
+
+    PcapngTraceFileReader::PcapngTraceFileReader()
+    {
+
+    }
+
+    bool PcapngTraceFileReader::readBlock(CanTraceFileBlock &block)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            return false;
+        }
+
+        // the section headers and interface descriptions in front of the packets change the context of the block
+        forever
+        {
+            if ( ! fillBuffer(BlockHeaderSize) )
+            {
+                if ( ! m_buffer.isEmpty() )
+                {
+                    qWarning(LOG_TAG) << "Truncated block at the end of" << m_file.fileName();
+                    m_buffer.clear();
+                }
+
+                return false;
+            }
+
+            const quint32 blockType = readValue<quint32>(m_buffer.constData(), m_bigEndian);
+
+            if ( blockType == SectionHeaderBlock )
+            {
+                // the byte order of the new section has to be known to read the length of its header
+                if ( ! fillBuffer(BlockHeaderSize + 4) || ! readSectionHeader( m_buffer.constData() ) )
+                {
+                    return false;
+                }
+            }
+
+            const quint32 blockLength = readValue<quint32>(m_buffer.constData() + 4, m_bigEndian);
+
+            if ( blockLength < quint32(BlockHeaderSize + BlockTrailerSize) || blockLength % 4 != 0 || blockLength > quint32( std::numeric_limits<int>::max() ) )
+            {
+                m_errorString = QString("Invalid block length at offset %1").arg( m_file.pos() - m_buffer.size() );
+                return false;
+            }
+
+            if ( ! fillBuffer( int(blockLength) ) )
+            {
+                qWarning(LOG_TAG) << "Truncated block at the end of" << m_file.fileName();
+                m_buffer.clear();
+                return false;
+            }
+
+            if ( blockType == SectionHeaderBlock )
+            {
+                m_context = serializeInterfaces( m_bigEndian, QVector<InterfaceDescription>() );
+            }
+            else if ( blockType == InterfaceDescriptionBlock )
+            {
+                if ( ! readInterfaceDescription( m_buffer.constData(), int(blockLength) ) )
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                break;
+            }
+
+            m_buffer.remove( 0, int(blockLength) );
+        }
+
+        block.context = m_context;
+
+        fillBuffer(BlockSize);
+
+        // the block ends in front of the next section header or interface description
+        int position = 0;
+
+        while ( position + BlockHeaderSize <= m_buffer.size() )
+        {
+            const quint32 blockType     = readValue<quint32>(m_buffer.constData() + position, m_bigEndian);
+            const quint32 blockLength   = readValue<quint32>(m_buffer.constData() + position + 4, m_bigEndian);
+
+            if ( blockType == SectionHeaderBlock || blockType == InterfaceDescriptionBlock
+                 || blockLength < quint32(BlockHeaderSize + BlockTrailerSize) || blockLength % 4 != 0
+                 || blockLength > quint32(m_buffer.size() - position) )
+            {
+                break;
+            }
+
+            position += int(blockLength);
+        }
+
+        block.data = m_buffer.left(position);
+        m_buffer.remove(0, position);
+
+        return true;
+    }
+
+    void PcapngTraceFileReader::decodeBlock(CanTraceFileBlock &block) const
+    {
+        // blocks hold complete PCAP-NG blocks only
+        block.hasBoundary = true;
+
+        decodeRecords(block.data, block.context, block);
+
+        block.data.clear();
+    }
+
+    bool PcapngTraceFileReader::readHeader()
+    {
+        const QByteArray header = m_file.read(BlockHeaderSize + 4);
+
+        if ( header.size() < BlockHeaderSize + 4 || qFromLittleEndian<quint32>( header.constData() ) != SectionHeaderBlock )
+        {
+            m_errorString = QStringLiteral("Not a PCAP-NG file");
+            return false;
+        }
+
+        m_buffer.clear();
+        m_context.clear();
+
+        // the section header is read with the first block
+        return m_file.seek(0);
+    }
+
+    void PcapngTraceFileReader::decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const
+    {
+        bool                                bigEndian   = false;
+        const QVector<InterfaceDescription> interfaces  = deserializeInterfaces(context, bigEndian);
+        QStringList                         channelNames;
+
+        for (int index = 0; index < interfaces.size(); index++)
+        {
+            channelNames.append( interfaces.at(index).name.isEmpty() ? QString("interface %1").arg(index) : interfaces.at(index).name );
+        }
+
+        int position = 0;
+
+        while ( position + BlockHeaderSize <= data.size() )
+        {
+            const char      *pcapngBlock    = data.constData() + position;
+            const quint32   blockType       = readValue<quint32>(pcapngBlock, bigEndian);
+            const int       blockLength     = int( readValue<quint32>(pcapngBlock + 4, bigEndian) );
+
+            position += blockLength;
+
+            if ( blockType != EnhancedPacketBlock )
+            {
+                continue;
+            }
+
+            // interface id, timestamp high, timestamp low, captured length, original length, packet, options
+            const quint32   interfaceId     = readValue<quint32>(pcapngBlock + 8, bigEndian);
+            const quint64   ticks           = ( quint64( readValue<quint32>(pcapngBlock + 12, bigEndian) ) << 32 ) | readValue<quint32>(pcapngBlock + 16, bigEndian);
+            const int       capturedLength  = int( readValue<quint32>(pcapngBlock + 20, bigEndian) );
+            const char      *packet         = pcapngBlock + 28;
+            const int       paddedLength    = ( capturedLength + 3 ) & ~3;
+
+            if ( blockLength < EnhancedPacketSize || capturedLength < 0 || paddedLength > blockLength - EnhancedPacketSize || interfaceId >= quint32( interfaces.size() ) )
+            {
+                skipRecord();
+                continue;
+            }
+
+            const InterfaceDescription &interface = interfaces.at( int(interfaceId) );
+
+            if ( interface.linkType != LinkTypeSocketCan )
+            {
+                continue;
+            }
+
+            if ( capturedLength < CanHeaderSize )
+            {
+                skipRecord();
+                continue;
+            }
+
+            // the SocketCAN header is in network byte order regardless of the section
+            const quint32   canId       = qFromBigEndian<quint32>(packet);
+            const quint8    fdFlags     = quint8( packet[5] );
+            const bool      fdFrame     = ( fdFlags & CanFdFdf ) || capturedLength > CanMtu;
+            const int       length      = qMin( int( quint8( packet[4] ) ), qMin( capturedLength - CanHeaderSize, fdFrame ? 64 : 8 ) );
+
+            QCanBusFrame frame;
+
+            if ( canId & CanErrFlag )
+            {
+                frame.setFrameType(QCanBusFrame::ErrorFrame);
+                frame.setError( QCanBusFrame::FrameErrors( int(canId & CanEffMask) ) );
+            }
+            else
+            {
+                frame.setExtendedFrameFormat( canId & CanEffFlag );
+                frame.setFrameId( canId & ( ( canId & CanEffFlag ) ? CanEffMask : CanSffMask ) );
+
+                if ( ( canId & CanRtrFlag ) && ! fdFrame )
+                {
+                    frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+                }
+                else
+                {
+                    frame.setPayload( QByteArray(packet + CanHeaderSize, length) );
+                }
+
+                if ( fdFrame )
+                {
+                    frame.setFlexibleDataRateFormat(true);
+                    frame.setBitrateSwitch( fdFlags & CanFdBrs );
+                    frame.setErrorStateIndicator( fdFlags & CanFdEsi );
+                }
+            }
+
+            // the direction is given by the packet flags option
+            const char *option      = packet + paddedLength;
+            const char *optionsEnd  = pcapngBlock + blockLength - BlockTrailerSize;
+
+            while ( option + 4 <= optionsEnd )
+            {
+                const quint16   optionCode      = readValue<quint16>(option, bigEndian);
+                const int       optionLength    = readValue<quint16>(option + 2, bigEndian);
+
+                if ( optionCode == OptionEnd || option + 4 + optionLength > optionsEnd )
+                {
+                    break;
+                }
+
+                if ( optionCode == PacketFlags && optionLength == 4 )
+                {
+                    frame.setLocalEcho( ( readValue<quint32>(option + 4, bigEndian) & PacketDirectionMask ) == PacketOutbound );
+                }
+
+                option += 4 + ( ( optionLength + 3 ) & ~3 );
+            }
+
+            const qint64 timestampUSecs = timestampUSecsOf(ticks, interface);
+
+            frame.setTimeStamp( QCanBusFrame::TimeStamp(timestampUSecs / 1000000, timestampUSecs % 1000000) );
+
+            if ( ! frame.isValid() )
+            {
+                skipRecord();
+                continue;
+            }
+
+            block.appendFrame( frame, channelNames.at( int(interfaceId) ) );
+        }
+    }
+
+    bool PcapngTraceFileReader::fillBuffer(int size)
+    {
+        if ( m_buffer.size() < size )
+        {
+            m_buffer.append( m_file.read( size - m_buffer.size() ) );
+        }
+
+        return m_buffer.size() >= size;
+    }
+
+    bool PcapngTraceFileReader::readSectionHeader(const char *data)
+    {
+        // the byte order mark follows the block type and length
+        const quint32 byteOrderMagic = qFromLittleEndian<quint32>(data + BlockHeaderSize);
+
+        if ( byteOrderMagic == ByteOrderMagic )
+        {
+            m_bigEndian = false;
+        }
+        else if ( qFromBigEndian<quint32>(data + BlockHeaderSize) == ByteOrderMagic )
+        {
+            m_bigEndian = true;
+        }
+        else
+        {
+            m_errorString = QStringLiteral("Invalid byte order mark of section");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PcapngTraceFileReader::readInterfaceDescription(const char *data, int length)
+    {
+        if ( length < InterfaceDescriptionSize )
+        {
+            m_errorString = QStringLiteral("Invalid interface description");
+            return false;
+        }
+
+        bool                            bigEndian   = m_bigEndian;
+        QVector<InterfaceDescription>   interfaces  = deserializeInterfaces(m_context, bigEndian);
+        InterfaceDescription            interface;
+
+        // link type, reserved, snap length, options
+        interface.linkType = readValue<quint16>(data + BlockHeaderSize, m_bigEndian);
+
+        const char *option      = data + 16;
+        const char *optionsEnd  = data + length - BlockTrailerSize;
+
+        while ( option + 4 <= optionsEnd )
+        {
+            const quint16   optionCode      = readValue<quint16>(option, m_bigEndian);
+            const int       optionLength    = readValue<quint16>(option + 2, m_bigEndian);
+            const char      *value          = option + 4;
+
+            if ( optionCode == OptionEnd || value + optionLength > optionsEnd )
+            {
+                break;
+            }
+
+            if ( optionCode == InterfaceName )
+            {
+                interface.name = QString::fromUtf8(value, optionLength);
+            }
+            else if ( optionCode == InterfaceTimestampResolution && optionLength == 1 )
+            {
+                interface.timestampResolution = quint8( value[0] );
+            }
+            else if ( optionCode == InterfaceTimestampOffset && optionLength == 8 )
+            {
+                interface.timestampOffset = readValue<qint64>(value, m_bigEndian);
+            }
+
+            option = value + ( ( optionLength + 3 ) & ~3 );
+        }
+
+        interfaces.append(interface);
+        m_context = serializeInterfaces(m_bigEndian, interfaces);
+
+        return true;
+    }
+}
@@ -0,0 +1,226 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracefile/pcapngtracefilewriter.h"
+#include "cantracefile/pcapngformat.h"
+
+#include <QDataStream>
+#include <QLoggingCategory>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracefile")
+
+    using namespace Lindwurm::Lib::PcapngFormat;
+
+    QDataStream& prepareStream(QDataStream &stream)
+    {
+        // the section is written in little endian, as declared by its byte order mark
+        stream.setByteOrder(QDataStream::LittleEndian);
+        return stream;
+    }
+
+    void writeOption(QDataStream &stream, quint16 code, const QByteArray &value)
+    {
+        stream << code << quint16( value.size() );
+        stream.writeRawData( value.constData(), value.size() );
+        stream.writeRawData( "\0\0\0", ( 4 - value.size() % 4 ) % 4 );
+    }
+
+    QByteArray formatBlock(quint32 blockType, const QByteArray &body)
+    {
+        const quint32   blockLength = quint32(BlockHeaderSize + body.size() + BlockTrailerSize);
+        QByteArray      block;
+        QDataStream     stream(&block, QIODevice::WriteOnly);
+
+        prepareStream(stream) << blockType << blockLength;
+        stream.writeRawData( body.constData(), body.size() );
+        stream << blockLength;
+
+        return block;
+    }
+
+    QByteArray formatSocketCanPacket(const QCanBusFrame &frame)
+    {
+        const QByteArray    payload = frame.payload();
+        quint32             canId   = frame.frameId() & ( frame.hasExtendedFrameFormat() ? CanEffMask : CanSffMask );
+        quint8              fdFlags = 0;
+
+        if ( frame.hasExtendedFrameFormat() )
+        {
+            canId |= CanEffFlag;
+        }
+
+        if ( frame.frameType() == QCanBusFrame::ErrorFrame )
+        {
+            canId = CanErrFlag | ( quint32( frame.error() ) & CanEffMask );
+        }
+        else if ( frame.frameType() == QCanBusFrame::RemoteRequestFrame )
+        {
+            canId |= CanRtrFlag;
+        }
+
+        if ( frame.hasFlexibleDataRateFormat() )
+        {
+            fdFlags = CanFdFdf;
+
+            if ( frame.hasBitrateSwitch() )
+            {
+                fdFlags |= CanFdBrs;
+            }
+
+            if ( frame.hasErrorStateIndicator() )
+            {
+                fdFlags |= CanFdEsi;
+            }
+        }
+
+        // frames are captured with the size of the SocketCAN structures, error frames carry 8 data bytes
+        const int   length  = frame.frameType() == QCanBusFrame::ErrorFrame ? 8 : payload.size();
+        QByteArray  packet( frame.hasFlexibleDataRateFormat() ? CanFdMtu : CanMtu, '\0' );
+
+        qToBigEndian<quint32>( canId, packet.data() );
+        packet[4] = char(length);
+        packet[5] = char(fdFlags);
+
+        if ( frame.frameType() != QCanBusFrame::ErrorFrame )
+        {
+            std::memcpy( packet.data() + CanHeaderSize, payload.constData(), size_t( qMin( payload.size(), packet.size() - CanHeaderSize ) ) );
+        }
+
+        return packet;
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    PcapngTraceFileWriter::PcapngTraceFileWriter()
+    {
+
+    }
+
+    PcapngTraceFileWriter::~PcapngTraceFileWriter()
+    {
+        close();
+    }
+
+    bool PcapngTraceFileWriter::open(const QString &fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+
+        m_errorString.clear();
+        m_interfaceNames.clear();
+
+        // byte order mark, version 1.0, unknown section length
+        QByteArray  body;
+        QDataStream stream(&body, QIODevice::WriteOnly);
+
+        prepareStream(stream) << ByteOrderMagic << quint16(1) << quint16(0) << qint64(-1);
+
+        return write( formatBlock(SectionHeaderBlock, body) );
+    }
+
+    void PcapngTraceFileWriter::close()
+    {
+        if ( m_file.isOpen() )
+        {
+            m_file.close();
+        }
+    }
+
+    bool PcapngTraceFileWriter::writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName)
+    {
+        if ( ! m_file.isOpen() )
+        {
+            m_errorString = QStringLiteral("Trace file is not open");
+            return false;
+        }
+
+        QByteArray  buffer;
+        int         interfaceId = m_interfaceNames.indexOf(interfaceName);
+
+        if ( interfaceId < 0 )
+        {
+            // link type, reserved, unlimited snap length, name and microsecond resolution
+            QByteArray  body;
+            QDataStream stream(&body, QIODevice::WriteOnly);
+
+            prepareStream(stream) << LinkTypeSocketCan << quint16(0) << quint32(0);
+
+            writeOption( stream, InterfaceName, interfaceName.toUtf8() );
+            writeOption( stream, InterfaceTimestampResolution, QByteArray(1, char(MicroSecondResolution)) );
+            stream << OptionEnd << quint16(0);
+
+            buffer.append( formatBlock(InterfaceDescriptionBlock, body) );
+
+            interfaceId = m_interfaceNames.size();
+            m_interfaceNames.append(interfaceName);
+        }
+
+        for (const QCanBusFrame &frame : frames)
+        {
+            const quint64       timestampUSecs  = quint64( frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds() );
+            const QByteArray    packet          = formatSocketCanPacket(frame);
+            QByteArray          body;
+            QDataStream         stream(&body, QIODevice::WriteOnly);
+
+            // interface, timestamp, captured and original length, packet, direction
+            prepareStream(stream) << quint32(interfaceId) << quint32(timestampUSecs >> 32) << quint32(timestampUSecs)
+                                  << quint32( packet.size() ) << quint32( packet.size() );
+
+            stream.writeRawData( packet.constData(), packet.size() );
+
+            QByteArray flags(4, '\0');
+            qToLittleEndian<quint32>( frame.hasLocalEcho() ? PacketOutbound : PacketInbound, flags.data() );
+
+            writeOption(stream, PacketFlags, flags);
+            stream << OptionEnd << quint16(0);
+
+            buffer.append( formatBlock(EnhancedPacketBlock, body) );
+        }
+
+        return write(buffer);
+    }
+
+    QString PcapngTraceFileWriter::errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool PcapngTraceFileWriter::write(const QByteArray &data)
+    {
+        if ( m_file.write(data) != data.size() )
+        {
+            m_errorString = m_file.errorString();
+            qWarning(LOG_TAG) << "Failed to write to" << m_file.fileName() << ":" << m_errorString;
+            return false;
+        }
+
+        return true;
+    }
+}
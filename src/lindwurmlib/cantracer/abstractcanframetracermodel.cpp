@@ -18,6 +18,8 @@
 #include "cantracer/abstractcanframetracermodel.h"
 #include "cantracer/canframetracer.h"
 
+#include <cstring>
+
 namespace
 {
     const int BASE_10 = 10;
@@ -82,4 +84,62 @@ namespace Lindwurm::Lib
 
         return asciiString;
     }
+
+    QString AbstractCanFrameTracerModel::timestampSourceDescription(CanTimestampSource source) const
+    {
+        switch (source)
+        {
+            case CanTimestampSource::Driver:    return "Timestamp provided by the CAN driver";
+            case CanTimestampSource::Kernel:    return "Kernel receive timestamp";
+            case CanTimestampSource::Hardware:  return "Hardware timestamp of the CAN controller";
+            case CanTimestampSource::Simulated: return "End of frame time on the virtual CAN bus";
+            default:                            return "Timestamp of unknown origin";
+        }
+    }
+
+    QString AbstractCanFrameTracerModel::interfaceName(CanInterfaceIndex interfaceIndex) const
+    {
+        // records only store the interface index, the name is resolved when displayed
+        return m_tracer->interfaceNameOf(interfaceIndex);
+    }
+
+    QString AbstractCanFrameTracerModel::getFrameLength(const QCanBusFrame &frame) const
+    {
+        const QString length = QString::number( frame.payload().size() );
+
+        if ( ! frame.hasFlexibleDataRateFormat() )
+        {
+            return length;
+        }
+
+        return length + ( frame.hasBitrateSwitch() ? " FD BRS" : " FD" );
+    }
+
+    QString AbstractCanFrameTracerModel::getCopyText(const QCanBusFrame &frame) const
+    {
+        QString frameId = QString("%1").arg( frame.frameId(), 3, 16, QLatin1Char(' ') ).toUpper();
+
+        if ( frame.hasFlexibleDataRateFormat() )
+        {
+            // CAN FD frames are marked like in candump logs, which is also understood by the frame composer
+            const int flags = (frame.hasBitrateSwitch() ? 0x01 : 0) | (frame.hasErrorStateIndicator() ? 0x02 : 0);
+
+            frameId += QString("##%1").arg(flags);
+        }
+
+        return frameId + "\t" + frame.payload().toHex(' ').toUpper() + "\t\t# " + toASCIIString( frame.payload() );
+    }
+
+    QVariant AbstractCanFrameTracerModel::renderRecord(CanFrameRenderRecord::Field field, qint64 timestampUSecs, quint32 frameId, const quint8 *payload, int payloadLength) const
+    {
+        payloadLength = qBound(0, payloadLength, int(CanFrameRenderRecord::MaxPayloadLength) );
+
+        m_renderRecord.field            = field;
+        m_renderRecord.traceTimeUSecs   = timestampUSecs - m_tracer->startTime();
+        m_renderRecord.frameId          = frameId;
+        m_renderRecord.payloadLength    = payloadLength;
+        std::memcpy( m_renderRecord.payload, payload, size_t(payloadLength) );
+
+        return QVariant::fromValue( static_cast<const CanFrameRenderRecord*>(&m_renderRecord) );
+    }
 }
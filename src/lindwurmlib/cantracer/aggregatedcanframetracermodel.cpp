@@ -21,6 +21,8 @@
 
 #include <QSize>
 
+#include <algorithm>
+
 namespace
 {
     const int ViewUpdateInterval = 100;
@@ -37,8 +39,8 @@ namespace Lindwurm::Lib
         m_updateTimer.setSingleShot(true);
         connect(&m_updateTimer, &QTimer::timeout, this, &AggregatedCanFrameTracerModel::updateModel);
 
-        connect(m_tracer, &CanFrameTracer::aggregateRecordInserted, this, &AggregatedCanFrameTracerModel::aggregateRecordInserted);
-        connect(m_tracer, &CanFrameTracer::aggregateRecordUpdated,  this, &AggregatedCanFrameTracerModel::aggregateRecordUpdated);
+        connect(m_tracer, &CanFrameTracer::aggregateRecordsInserted, this, &AggregatedCanFrameTracerModel::aggregateRecordsInserted);
+        connect(m_tracer, &CanFrameTracer::aggregateRecordsUpdated,  this, &AggregatedCanFrameTracerModel::aggregateRecordsUpdated);
     }
 
     int AggregatedCanFrameTracerModel::rowCount(const QModelIndex &parent) const
@@ -55,7 +57,7 @@ namespace Lindwurm::Lib
     {
         if ( ! parent.isValid() )
         {
-            return 11;
+            return 14;
         }
 
         return 0;
@@ -66,31 +68,56 @@ namespace Lindwurm::Lib
         if (index.isValid() && role == Qt::DisplayRole)
         {
             CanFrameAggregator aggregate = m_tracer->aggregateRecordAt( index.row() );
-            CanFrameTracerRecord record = m_tracer->frameRecordAt( aggregate.latestFrameRecordIndex() );
+            const QCanBusFrame &frame = aggregate.latestFrame();
+            const CanFrameIntervalStatistics &intervals = aggregate.intervalStatistics();
 
             switch ( index.column() )
             {
                 case 0:     return index.row() + 1;
-                case 1:     return getFrameTime( record.canFrame().timeStamp() );
-                case 2:     return QString("%1").arg( record.canFrame().frameId(), 3, 16, QLatin1Char(' ') ).toUpper();
-                case 3:     return getFrameTimeDiff( record.timeDifferenceUSecs() );
+                case 1:     return getFrameTime( frame.timeStamp() );
+                case 2:     return QString("%1").arg( frame.frameId(), 3, 16, QLatin1Char(' ') ).toUpper();
+                case 3:     return getFrameTimeDiff( aggregate.latestTimeDifferenceUSecs() );
                 case 4:     return getFrameTimeDiff( qint64( aggregate.averageTimeIntervalUSecs() ) );
-                case 5:     return aggregate.frameRecordCount();
-                case 6:     return record.canFrame().hasLocalEcho() ? "TX" : "RX";
-                case 7:     return record.sourceInterface();
-                case 8:     return record.canFrame().payload().size();
-                case 9:     return record.canFrame().payload().toHex(' ').toUpper();
-                case 10:    return toASCIIString( record.canFrame().payload() );
+                case 5:     return getFrameTimeDiff( intervals.minUSecs );
+                case 6:     return getFrameTimeDiff( intervals.maxUSecs );
+                case 7:     return getFrameTimeDiff( qint64( intervals.standardDeviationUSecs() ) );
+                case 8:     return aggregate.frameRecordCount();
+                case 9:     return frame.hasLocalEcho() ? "TX" : "RX";
+                case 10:    return interfaceName( aggregate.latestSourceInterface() );
+                case 11:    return getFrameLength(frame);
+                case 12:    return frame.payload().toHex(' ').toUpper();
+                case 13:    return toASCIIString( frame.payload() );
                 default:    return QVariant();
             }
         }
 
+        if ( index.isValid() && role == RenderRecordRole )
+        {
+            CanFrameRenderRecord::Field field;
+
+            switch ( index.column() )
+            {
+                case 1:     field = CanFrameRenderRecord::Time;            break;
+                case 2:     field = CanFrameRenderRecord::FrameId;         break;
+                case 12:    field = CanFrameRenderRecord::HexPayload;      break;
+                case 13:    field = CanFrameRenderRecord::AsciiPayload;    break;
+                default:    return QVariant();
+            }
+
+            // the aggregate shares the payload of the latest frame, so copying it does not allocate
+            const CanFrameAggregator    aggregate   = m_tracer->aggregateRecordAt( index.row() );
+            const QCanBusFrame          &frame      = aggregate.latestFrame();
+            const QByteArray            payload     = frame.payload();
+            const qint64                timestampUSecs = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+            return renderRecord( field, timestampUSecs, frame.frameId(), reinterpret_cast<const quint8*>( payload.constData() ), payload.size() );
+        }
+
         if ( index.isValid() && role == CopyTextRole )
         {
             CanFrameAggregator aggregate = m_tracer->aggregateRecordAt( index.row() );
-            CanFrameTracerRecord record = m_tracer->frameRecordAt( aggregate.latestFrameRecordIndex() );
 
-            return QString("%1").arg( record.canFrame().frameId(), 3, 16, QLatin1Char(' ') ).toUpper() + "\t" + record.canFrame().payload().toHex(' ').toUpper() + "\t\t# " + toASCIIString( record.canFrame().payload() );
+            return getCopyText( aggregate.latestFrame() );
         }
 
         return QVariant();
@@ -107,12 +134,15 @@ namespace Lindwurm::Lib
                 case 2:     return "ID";
                 case 3:     return "Time Diff";
                 case 4:     return "Interval (avg)";
-                case 5:     return "Count";
-                case 6:     return "Dir";
-                case 7:     return "Interface";
-                case 8:     return "Length";
-                case 9:     return "Data";
-                case 10:     return "ASCII";
+                case 5:     return "Interval (min)";
+                case 6:     return "Interval (max)";
+                case 7:     return "Jitter (std dev)";
+                case 8:     return "Count";
+                case 9:     return "Dir";
+                case 10:    return "Interface";
+                case 11:    return "Length";
+                case 12:    return "Data";
+                case 13:    return "ASCII";
                 default:    return QVariant();
             }
         }
@@ -126,11 +156,14 @@ namespace Lindwurm::Lib
                 case 2:     return QSize(50, 24);
                 case 3:     return QSize(160, 24);
                 case 4:     return QSize(180, 24);
-                case 5:     return QSize(90, 24);
-                case 6:     return QSize(50, 24);
-                case 7:     return QSize(90, 24);
-                case 8:     return QSize(70, 24);
-                case 9:     return QSize(230, 24);
+                case 5:     return QSize(180, 24);
+                case 6:     return QSize(180, 24);
+                case 7:     return QSize(180, 24);
+                case 8:     return QSize(90, 24);
+                case 9:     return QSize(50, 24);
+                case 10:    return QSize(90, 24);
+                case 11:    return QSize(70, 24);
+                case 12:    return QSize(230, 24);
                 default:    return QVariant();
             }
         }
@@ -138,22 +171,35 @@ namespace Lindwurm::Lib
         return QVariant();
     }
 
-    void AggregatedCanFrameTracerModel::aggregateRecordInserted()
+    QModelIndex AggregatedCanFrameTracerModel::indexOfFrameId(quint32 frameId, int column) const
+    {
+        const int row = m_tracer->aggregateRecordIndexOf(frameId);
+
+        // rows of aggregate records which have not been announced yet are not part of the model
+        if ( row < 0 || row >= m_rowCount )
+        {
+            return QModelIndex();
+        }
+
+        return index(row, column);
+    }
+
+    void AggregatedCanFrameTracerModel::aggregateRecordsInserted(int count)
     {
         // existing rows are numbered from 0 (!) to _rowCount-1
         // first and last are the row numbers that the new rows will have after they have been inserted.
         // e.g. if 2 rows are inserted they will have the numbers _rowCount and _rowCount + 1 // 2-1
         // if only 1 row is inserted it will have the number _rowCount, hence first/last are equal
-        beginInsertRows( QModelIndex(), m_rowCount, m_rowCount);
+        beginInsertRows( QModelIndex(), m_rowCount, m_rowCount + (count-1) );
 
-        m_rowCount += 1;
+        m_rowCount += count;
 
         endInsertRows();
     }
 
-    void AggregatedCanFrameTracerModel::aggregateRecordUpdated(int aggregateRecordIndex)
+    void AggregatedCanFrameTracerModel::aggregateRecordsUpdated(const QVector<int> &aggregateRecordIndices)
     {
-        m_updatedAggregateIndices.append(aggregateRecordIndex);
+        m_updatedAggregateIndices.append(aggregateRecordIndices);
 
         if ( ! m_updateTimer.isActive() )
         {
@@ -163,9 +209,13 @@ namespace Lindwurm::Lib
 
     void AggregatedCanFrameTracerModel::updateModel()
     {
+        // an aggregate record may have been updated by several batches since the last view update
+        std::sort( m_updatedAggregateIndices.begin(), m_updatedAggregateIndices.end() );
+        m_updatedAggregateIndices.erase( std::unique( m_updatedAggregateIndices.begin(), m_updatedAggregateIndices.end() ), m_updatedAggregateIndices.end() );
+
         for (const int index : qAsConst(m_updatedAggregateIndices))
         {
-            emit dataChanged( createIndex(index, 0),  createIndex(index, 8) );
+            emit dataChanged( createIndex(index, 0),  createIndex(index, columnCount() - 1) );
         }
 
         m_updatedAggregateIndices.clear();
@@ -17,13 +17,81 @@
 
 #include "canframeaggregator.h"
 
+#include <cmath>
+
 namespace Lindwurm::Lib
 {
+    int CanFrameIntervalStatistics::jitterBucketIndex(qint64 jitterUSecs)
+    {
+        int index = 0;
+
+        while ( jitterUSecs > 0 && index < JitterBucketCount - 1 )
+        {
+            jitterUSecs >>= 1;
+            index++;
+        }
+
+        return index;
+    }
+
+    void CanFrameIntervalStatistics::appendInterval(qint64 intervalUSecs)
+    {
+        if ( intervalCount == 0 )
+        {
+            minUSecs = intervalUSecs;
+            maxUSecs = intervalUSecs;
+        }
+        else
+        {
+            // the jitter is measured against the mean of the preceding intervals, the first interval has none
+            const qint64 jitterUSecs = qint64( std::llround( std::abs( double(intervalUSecs) - meanUSecs ) ) );
+
+            jitterBuckets[ jitterBucketIndex(jitterUSecs) ]++;
+
+            minUSecs = qMin(minUSecs, intervalUSecs);
+            maxUSecs = qMax(maxUSecs, intervalUSecs);
+        }
+
+        intervalCount++;
+
+        // Welford's online update of mean and sum of squared deviations
+        const double delta = double(intervalUSecs) - meanUSecs;
+
+        meanUSecs               += delta / double(intervalCount);
+        sumOfSquaredDeviations  += delta * ( double(intervalUSecs) - meanUSecs );
+    }
+
+    double CanFrameIntervalStatistics::standardDeviationUSecs() const
+    {
+        if ( intervalCount < 2 )
+        {
+            return 0;
+        }
+
+        return std::sqrt( sumOfSquaredDeviations / double(intervalCount - 1) );
+    }
+
     CanFrameAggregator::CanFrameAggregator(quint32 frameId)
         : m_frameId(frameId)
-        , m_frameRecordIndices()
+        , m_frameRecordCount(0)
+        , m_latestFrame()
+        , m_latestTimeDifferenceUSecs(0)
+        , m_latestSourceInterface(InvalidCanInterfaceIndex)
         , m_latestFrameTimestampUSecs(0)
-        , m_averageTimeIntervalUSecs(0)
+        , m_intervalStatistics()
+    {
+
+    }
+
+    CanFrameAggregator::CanFrameAggregator(quint32 frameId, qint64 frameRecordCount, const QCanBusFrame &latestFrame, qint64 latestTimestampUSecs,
+                                           qint64 latestTimeDifferenceUSecs, CanInterfaceIndex latestSourceInterface, const CanFrameIntervalStatistics &intervalStatistics)
+        : m_frameId(frameId)
+        , m_frameRecordCount(frameRecordCount)
+        , m_latestFrame(latestFrame)
+        , m_latestTimeDifferenceUSecs(latestTimeDifferenceUSecs)
+        , m_latestSourceInterface(latestSourceInterface)
+        , m_latestFrameTimestampUSecs(latestTimestampUSecs)
+        , m_intervalStatistics(intervalStatistics)
     {
 
     }
@@ -37,23 +105,39 @@ namespace Lindwurm::Lib
         return m_frameId;
     }
 
-    void CanFrameAggregator::appendFrameRecord(int frameRecordIndex, qint64 timestampUSecs, qint64 timeDifferenceUSecs)
+    void CanFrameAggregator::appendFrameRecord(const QCanBusFrame &frame, qint64 timestampUSecs, qint64 timeDifferenceUSecs, CanInterfaceIndex sourceInterface)
+    {
+        m_frameRecordCount++;
+        m_latestFrame                   = frame;
+        m_latestTimeDifferenceUSecs     = timeDifferenceUSecs;
+        m_latestSourceInterface         = sourceInterface;
+        m_latestFrameTimestampUSecs     = timestampUSecs;
+
+        // the first frame has no predecessor and therefore does not define an interval
+        if ( m_frameRecordCount > 1 )
+        {
+            m_intervalStatistics.appendInterval(timeDifferenceUSecs);
+        }
+    }
+
+    qint64 CanFrameAggregator::frameRecordCount() const
     {
-        m_frameRecordIndices.append(frameRecordIndex);
-        m_latestFrameTimestampUSecs = timestampUSecs;
+        return m_frameRecordCount;
+    }
 
-        // update the average difference with the new frame
-        m_averageTimeIntervalUSecs = m_averageTimeIntervalUSecs + ( ( float(timeDifferenceUSecs) - m_averageTimeIntervalUSecs) / m_frameRecordIndices.size() );
+    const QCanBusFrame &CanFrameAggregator::latestFrame() const
+    {
+        return m_latestFrame;
     }
 
-    int CanFrameAggregator::frameRecordCount() const
+    qint64 CanFrameAggregator::latestTimeDifferenceUSecs() const
     {
-        return m_frameRecordIndices.size();
+        return m_latestTimeDifferenceUSecs;
     }
 
-    int CanFrameAggregator::latestFrameRecordIndex() const
+    CanInterfaceIndex CanFrameAggregator::latestSourceInterface() const
     {
-        return m_frameRecordIndices.last();
+        return m_latestSourceInterface;
     }
 
     qint64 CanFrameAggregator::latestTimestampUSecs() const
@@ -63,6 +147,11 @@ namespace Lindwurm::Lib
 
     double CanFrameAggregator::averageTimeIntervalUSecs() const
     {
-        return m_averageTimeIntervalUSecs;
+        return m_intervalStatistics.meanUSecs;
+    }
+
+    const CanFrameIntervalStatistics &CanFrameAggregator::intervalStatistics() const
+    {
+        return m_intervalStatistics;
     }
 }
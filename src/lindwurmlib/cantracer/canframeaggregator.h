@@ -19,33 +19,95 @@
 #define CANFRAMEAGGREGATOR_H
 
 #include <qglobal.h>
-#include <QVector>
 #include <QCanBusFrame>
 
+#include "caninterface/caninterfaceindex.h"
+
+#include <array>
+
 namespace Lindwurm::Lib
 {
+    /**
+     * @brief The CanFrameIntervalStatistics struct holds online statistics of the time intervals between frames.
+     *
+     * Mean and variance are updated with Welford's algorithm, so the statistics take constant memory regardless of
+     * the number of frames. The jitter of an interval is its deviation from the mean of all preceding intervals and
+     * is counted in logarithmic buckets: bucket 0 counts jitters below 1 µs, bucket `n` counts jitters from
+     * 2^(n-1) µs up to (but excluding) 2^n µs. The last bucket also counts all larger jitters.
+     */
+    struct CanFrameIntervalStatistics
+    {
+        static const int JitterBucketCount = 16;
+
+        /**
+         * @brief Returns the bucket index for a specific jitter.
+         * @param jitterUSecs the absolute jitter in microseconds.
+         * @return the index of the bucket counting this jitter.
+         */
+        static int      jitterBucketIndex(qint64 jitterUSecs);
+
+        /**
+         * @brief Adds an interval to the statistics.
+         * @param intervalUSecs the time since the previous frame in microseconds.
+         */
+        void            appendInterval(qint64 intervalUSecs);
+
+        /**
+         * @brief Returns the standard deviation of the intervals.
+         * @return the sample standard deviation in microseconds or 0 if less than two intervals were counted.
+         */
+        double          standardDeviationUSecs() const;
+
+        qint64                                  intervalCount = {0};
+        double                                  meanUSecs = {0};
+        double                                  sumOfSquaredDeviations = {0};
+        qint64                                  minUSecs = {0};
+        qint64                                  maxUSecs = {0};
+        std::array<quint32, JitterBucketCount>  jitterBuckets = {};
+    };
+
+    /**
+     * @brief The CanFrameAggregator class aggregates all frames of a single frame ID over the whole trace.
+     *
+     * It keeps a copy of the latest frame and the statistics of the frame intervals, so it takes constant memory and
+     * does not depend on frame records which may have been evicted from a bounded trace. The retained frame records
+     * of an aggregate record are looked up with CanFrameTracer::frameRecordIndicesOf().
+     */
     class CanFrameAggregator
     {
         public:
 
             CanFrameAggregator(quint32 frameId);
+
+            /**
+             * @brief Restores an aggregator with the statistics of a previous trace, e.g. from a trace file.
+             */
+            CanFrameAggregator(quint32 frameId, qint64 frameRecordCount, const QCanBusFrame &latestFrame, qint64 latestTimestampUSecs,
+                               qint64 latestTimeDifferenceUSecs, CanInterfaceIndex latestSourceInterface, const CanFrameIntervalStatistics &intervalStatistics);
             ~CanFrameAggregator();
 
             quint32     frameId(void) const;
 
-            void        appendFrameRecord(int frameRecordIndex, qint64 timestampUSecs, qint64 timeDifferenceUSecs);
-            int         frameRecordCount(void) const;
-            int         latestFrameRecordIndex(void) const;
+            void        appendFrameRecord(const QCanBusFrame &frame, qint64 timestampUSecs, qint64 timeDifferenceUSecs, CanInterfaceIndex sourceInterface);
+            qint64      frameRecordCount(void) const;
+
+            const QCanBusFrame& latestFrame(void) const;
+            qint64      latestTimeDifferenceUSecs(void) const;
+            CanInterfaceIndex latestSourceInterface(void) const;
 
             qint64      latestTimestampUSecs(void) const;
             double      averageTimeIntervalUSecs(void) const;
+            const CanFrameIntervalStatistics& intervalStatistics(void) const;
 
         private:
 
-            quint32         m_frameId;
-            QVector<int>    m_frameRecordIndices;
-            qint64          m_latestFrameTimestampUSecs;
-            double          m_averageTimeIntervalUSecs;
+            quint32             m_frameId;
+            qint64              m_frameRecordCount;
+            QCanBusFrame        m_latestFrame;
+            qint64              m_latestTimeDifferenceUSecs;
+            CanInterfaceIndex   m_latestSourceInterface;
+            qint64              m_latestFrameTimestampUSecs;
+            CanFrameIntervalStatistics m_intervalStatistics;
     };
 }
 
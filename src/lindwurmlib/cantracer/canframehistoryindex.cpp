@@ -0,0 +1,77 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "canframehistoryindex.h"
+
+namespace Lindwurm::Lib
+{
+    bool CanFrameHistoryIndex::contains(int aggregateIndex) const
+    {
+        return aggregateIndex >= 0 && aggregateIndex < m_historySlots.size() && m_historySlots.at(aggregateIndex) != NoHistory;
+    }
+
+    void CanFrameHistoryIndex::insert(int aggregateIndex, const QVector<quint64> &positions)
+    {
+        while ( m_historySlots.size() <= aggregateIndex )
+        {
+            m_historySlots.append(NoHistory);
+        }
+
+        if ( m_historySlots.at(aggregateIndex) == NoHistory )
+        {
+            m_historySlots[aggregateIndex] = m_histories.size();
+            m_histories.append( History() );
+        }
+
+        History &history = m_histories[ m_historySlots.at(aggregateIndex) ];
+
+        history.positions   = positions;
+        history.head        = 0;
+    }
+
+    void CanFrameHistoryIndex::removeBefore(quint64 head)
+    {
+        for (History &history : m_histories)
+        {
+            while ( history.head < history.positions.size() && history.positions.at(history.head) < head )
+            {
+                history.head++;
+            }
+
+            // the evicted positions are only dropped once they make up half of the history, so trimming takes
+            // amortized constant time per position
+            if ( history.head > 0 && history.head * 2 >= history.positions.size() )
+            {
+                history.positions.remove(0, history.head);
+                history.head = 0;
+            }
+        }
+    }
+
+    QVector<quint64> CanFrameHistoryIndex::positions(int aggregateIndex) const
+    {
+        const History &history = m_histories.at( m_historySlots.at(aggregateIndex) );
+
+        return history.positions.mid(history.head);
+    }
+
+    void CanFrameHistoryIndex::clear()
+    {
+        m_historySlots.clear();
+        m_histories.clear();
+    }
+}
@@ -0,0 +1,100 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANFRAMEHISTORYINDEX_H
+#define CANFRAMEHISTORYINDEX_H
+
+#include <qglobal.h>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameHistoryIndex class maps aggregate records to the positions of their frame records in a trace.
+     *
+     * Only the histories which have been requested are indexed, so capturing does not pay for histories nobody looks
+     * at. The positions count all records ever appended to the trace, so they stay valid when the oldest records are
+     * evicted; removeBefore() trims the evicted positions.
+     */
+    class CanFrameHistoryIndex
+    {
+        public:
+
+            /**
+             * @brief Returns whether the history of an aggregate record is indexed.
+             * @param aggregateIndex the index of the aggregate record.
+             * @return `true` if the history is indexed.
+             */
+            bool            contains(int aggregateIndex) const;
+
+            /**
+             * @brief Starts indexing the history of an aggregate record.
+             * @param aggregateIndex    the index of the aggregate record.
+             * @param positions         the positions of its retained frame records in ascending order.
+             */
+            void            insert(int aggregateIndex, const QVector<quint64> &positions);
+
+            /**
+             * @brief Appends the position of a new frame record, if the history of its aggregate record is indexed.
+             * @param aggregateIndex    the index of the aggregate record.
+             * @param position          the position of the frame record, which is greater than all before.
+             */
+            inline void     append(int aggregateIndex, quint64 position)
+            {
+                if ( aggregateIndex < m_historySlots.size() && m_historySlots.at(aggregateIndex) != NoHistory )
+                {
+                    m_histories[ m_historySlots.at(aggregateIndex) ].positions.append(position);
+                }
+            }
+
+            /**
+             * @brief Removes the positions of evicted frame records from all indexed histories.
+             * @param head the position of the oldest retained frame record.
+             */
+            void            removeBefore(quint64 head);
+
+            /**
+             * @brief Returns the indexed history of an aggregate record.
+             * @param aggregateIndex the index of the aggregate record, whose history must be indexed.
+             * @return the positions of the retained frame records in ascending order.
+             */
+            QVector<quint64> positions(int aggregateIndex) const;
+
+            /**
+             * @brief Removes all histories, e.g. when the aggregate records are rebuilt.
+             */
+            void            clear();
+
+        private:
+
+            static const int NoHistory = -1;
+
+            /**
+             * @brief The History struct holds the positions of one aggregate record, the evicted ones precede the head.
+             */
+            struct History
+            {
+                QVector<quint64>    positions = {};
+                int                 head = {0};
+            };
+
+            QVector<int>        m_historySlots = {};    // history of each aggregate record or NoHistory
+            QVector<History>    m_histories = {};
+    };
+}
+
+#endif // CANFRAMEHISTORYINDEX_H
@@ -0,0 +1,91 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "canframeidindex.h"
+
+namespace Lindwurm::Lib
+{
+    CanFrameIdIndex::CanFrameIdIndex()
+    {
+        m_standardIndices.fill(NoIndex);
+    }
+
+    void CanFrameIdIndex::insert(quint32 frameId, int index)
+    {
+        if ( frameId < StandardFrameIdCount )
+        {
+            m_standardIndices[frameId] = index;
+            return;
+        }
+
+        // keep the load factor at or below one half, so probe sequences stay short
+        if ( ( m_extendedCount + 1 ) * 2 > m_extendedSlots.size() )
+        {
+            rehash( qMax( MinExtendedCapacity, m_extendedSlots.size() * 2 ) );
+        }
+
+        const quint32 mask = quint32( m_extendedSlots.size() ) - 1;
+
+        for (quint32 slot = slotOf(frameId); ; slot = (slot + 1) & mask)
+        {
+            Slot &entry = m_extendedSlots[ int(slot) ];
+
+            if ( entry.frameId == EmptyFrameId )
+            {
+                entry.frameId = frameId;
+                m_extendedCount++;
+            }
+
+            if ( entry.frameId == frameId )
+            {
+                entry.index = index;
+                return;
+            }
+        }
+    }
+
+    void CanFrameIdIndex::clear()
+    {
+        m_standardIndices.fill(NoIndex);
+        m_extendedSlots.clear();
+        m_extendedCount = 0;
+        m_extendedShift = 32;
+    }
+
+    void CanFrameIdIndex::rehash(int capacity)
+    {
+        const QVector<Slot> previousSlots = m_extendedSlots;
+
+        int bits = 0;
+
+        while ( ( 1 << bits ) < capacity )
+        {
+            bits++;
+        }
+
+        m_extendedSlots = QVector<Slot>( 1 << bits );
+        m_extendedCount = 0;
+        m_extendedShift = 32 - bits;
+
+        for (const Slot &entry : previousSlots)
+        {
+            if ( entry.frameId != EmptyFrameId )
+            {
+                insert(entry.frameId, entry.index);
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CANFRAMEIDINDEX_H
+#define CANFRAMEIDINDEX_H
+
+#include <qglobal.h>
+#include <QVector>
+
+#include <array>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameIdIndex class maps frame IDs to indices, e.g. of the aggregate records of a trace.
+     *
+     * Standard frame IDs are looked up in a flat array, extended frame IDs in an open-addressing hash table with
+     * linear probing. Either way a lookup usually touches a single cache line.
+     */
+    class CanFrameIdIndex
+    {
+        public:
+
+            static const int NoIndex = -1;
+
+            CanFrameIdIndex();
+
+            /**
+             * @brief Returns the index of a frame ID.
+             * @param frameId the frame ID.
+             * @return the index or NoIndex if the frame ID has not been inserted.
+             */
+            inline int      value(quint32 frameId) const
+            {
+                if ( frameId < StandardFrameIdCount )
+                {
+                    return m_standardIndices[frameId];
+                }
+
+                if ( m_extendedSlots.isEmpty() )
+                {
+                    return NoIndex;
+                }
+
+                const quint32 mask = quint32( m_extendedSlots.size() ) - 1;
+
+                for (quint32 slot = slotOf(frameId); ; slot = (slot + 1) & mask)
+                {
+                    const Slot &entry = m_extendedSlots.at( int(slot) );
+
+                    if ( entry.frameId == frameId )
+                    {
+                        return entry.index;
+                    }
+
+                    if ( entry.frameId == EmptyFrameId )
+                    {
+                        return NoIndex;
+                    }
+                }
+            }
+
+            /**
+             * @brief Inserts a frame ID or replaces its index.
+             * @param frameId   the frame ID.
+             * @param index     the index of the frame ID, which must not be negative.
+             */
+            void            insert(quint32 frameId, int index);
+
+            /**
+             * @brief Removes all frame IDs.
+             */
+            void            clear();
+
+        private:
+
+            static const quint32 StandardFrameIdCount   = 2048;
+            static const quint32 EmptyFrameId           = 0xFFFFFFFFU;     // not a valid CAN frame ID
+            static const int     MinExtendedCapacity    = 64;
+
+            struct Slot
+            {
+                quint32     frameId = { EmptyFrameId };
+                int         index = { NoIndex };
+            };
+
+            /**
+             * @brief Returns the home slot of an extended frame ID (Fibonacci hashing).
+             */
+            inline quint32  slotOf(quint32 frameId) const
+            {
+                return ( frameId * 0x9E3779B1U ) >> m_extendedShift;
+            }
+
+            void            rehash(int capacity);
+
+            std::array<int, StandardFrameIdCount>   m_standardIndices = {};
+            QVector<Slot>                           m_extendedSlots = {};
+            int                                     m_extendedCount = {0};
+            int                                     m_extendedShift = {32};
+    };
+}
+
+#endif // CANFRAMEIDINDEX_H
@@ -0,0 +1,182 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracer/canframerecordspill.h"
+
+#include <QDir>
+
+#include <cstring>
+
+namespace
+{
+    // segment offsets are kept aligned to the records
+    const qint64 RECORD_ALIGNMENT = 8;
+}
+
+namespace Lindwurm::Lib
+{
+    CanFrameRecordSpill::CanFrameRecordSpill()
+    {
+
+    }
+
+    CanFrameRecordSpill::~CanFrameRecordSpill()
+    {
+        close();
+    }
+
+    bool CanFrameRecordSpill::open(const QString &directory)
+    {
+        close();
+
+        m_directory = std::make_unique<QTemporaryDir>( QDir(directory).filePath("lindwurm-trace-XXXXXX") );
+
+        if ( ! m_directory->isValid() )
+        {
+            m_errorString = QString("Failed to create a scratch directory in %1").arg(directory);
+            m_directory.reset();
+            return false;
+        }
+
+        m_errorString.clear();
+
+        return true;
+    }
+
+    void CanFrameRecordSpill::close()
+    {
+        for (Segment &segment : m_segments)
+        {
+            removeSegment(segment);
+        }
+
+        m_segments.clear();
+        m_directory.reset();
+        m_diskUsage = 0;
+    }
+
+    bool CanFrameRecordSpill::isOpen() const
+    {
+        return m_directory != nullptr;
+    }
+
+    CanFrameTracerRecord *CanFrameRecordSpill::seal(quint64 chunkIndex, const CanFrameTracerRecord *records, int recordCount, int firstRecord)
+    {
+        if ( ! isOpen() )
+        {
+            m_errorString = "The spill is not open";
+            return nullptr;
+        }
+
+        if ( m_segments.empty() || chunkIndex >= m_segments.back().firstChunkIndex + SegmentChunkCount )
+        {
+            Segment segment;
+            segment.firstChunkIndex = chunkIndex;
+            segment.file            = std::make_unique<QFile>( m_directory->filePath( QString("segment-%1.bin").arg(chunkIndex) ) );
+
+            if ( ! segment.file->open(QIODevice::ReadWrite | QIODevice::Truncate) )
+            {
+                m_errorString = segment.file->errorString();
+                return nullptr;
+            }
+
+            m_segments.push_back( std::move(segment) );
+        }
+
+        QFile *file = m_segments.back().file.get();
+
+        qint64 payloadBytes = 0;
+
+        for (int index = firstRecord; index < recordCount; index++)
+        {
+            if ( records[index].arenaPayload() != nullptr )
+            {
+                payloadBytes += records[index].payloadLength();
+            }
+        }
+
+        const qint64 recordBytes    = qint64(recordCount) * qint64( sizeof(CanFrameTracerRecord) );
+        const qint64 chunkBytes     = ( recordBytes + payloadBytes + RECORD_ALIGNMENT - 1 ) & ~(RECORD_ALIGNMENT - 1);
+        const qint64 offset         = file->size();
+
+        if ( ! file->resize(offset + chunkBytes) )
+        {
+            m_errorString = file->errorString();
+            return nullptr;
+        }
+
+        uchar *map = file->map(offset, chunkBytes);
+
+        if ( map == nullptr )
+        {
+            m_errorString = file->errorString();
+            file->resize(offset);
+            return nullptr;
+        }
+
+        CanFrameTracerRecord    *sealedRecords  = reinterpret_cast<CanFrameTracerRecord*>(map);
+        quint8                  *payload        = map + recordBytes;
+
+        std::memcpy( sealedRecords + firstRecord, records + firstRecord, size_t(recordCount - firstRecord) * sizeof(CanFrameTracerRecord) );
+
+        for (int index = firstRecord; index < recordCount; index++)
+        {
+            const quint8 *arenaPayload = records[index].arenaPayload();
+
+            if ( arenaPayload != nullptr )
+            {
+                std::memcpy( payload, arenaPayload, size_t( records[index].payloadLength() ) );
+                sealedRecords[index].relocateArenaPayload(payload);
+
+                payload += records[index].payloadLength();
+            }
+        }
+
+        m_diskUsage += chunkBytes;
+
+        return sealedRecords;
+    }
+
+    void CanFrameRecordSpill::releaseBefore(quint64 chunkIndex)
+    {
+        // the segment currently filled is kept, it receives the next sealed chunks
+        while ( m_segments.size() > 1 && m_segments.front().firstChunkIndex + SegmentChunkCount <= chunkIndex )
+        {
+            removeSegment( m_segments.front() );
+            m_segments.pop_front();
+        }
+    }
+
+    qint64 CanFrameRecordSpill::diskUsage() const
+    {
+        return m_diskUsage;
+    }
+
+    QString CanFrameRecordSpill::errorString() const
+    {
+        return m_errorString;
+    }
+
+    void CanFrameRecordSpill::removeSegment(Segment &segment)
+    {
+        m_diskUsage -= segment.file->size();
+
+        // closing the file unmaps all of its chunks
+        segment.file->close();
+        segment.file->remove();
+    }
+}
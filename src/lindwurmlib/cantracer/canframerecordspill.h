@@ -0,0 +1,121 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANFRAMERECORDSPILL_H
+#define CANFRAMERECORDSPILL_H
+
+#include "lindwurmlib_global.h"
+#include "cantracer/canframetracerrecord.h"
+
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <deque>
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameRecordSpill class moves sealed chunks of frame records into memory-mapped segment files.
+     *
+     * The records of a chunk and their CAN FD payloads are copied into a segment file within a temporary scratch
+     * directory, which is mapped into memory. The records are patched to refer to the mapped payloads, so the
+     * mapped chunk replaces the chunk in RAM one to one. The kernel writes the mapped pages back to disk and
+     * reloads them on demand, so the size of a trace is limited by the disk instead of the RAM.
+     *
+     * Each segment file holds up to SegmentChunkCount consecutive chunks and is deleted as soon as all of its
+     * chunks have been released. The scratch directory is removed when the spill is closed.
+     */
+    class LINDWURMLIB_EXPORT CanFrameRecordSpill
+    {
+        public:
+
+            static const int SegmentChunkCount = 64;
+
+            CanFrameRecordSpill();
+            ~CanFrameRecordSpill();
+
+            CanFrameRecordSpill(const CanFrameRecordSpill&) = delete;
+            CanFrameRecordSpill& operator=(const CanFrameRecordSpill&) = delete;
+
+            /**
+             * @brief Creates the scratch directory for the segment files
+             * @param directory the directory in which the scratch directory is created.
+             * @return `true` on success; otherwise see errorString().
+             */
+            bool            open(const QString &directory);
+
+            /**
+             * @brief Unmaps and deletes all segment files and the scratch directory
+             *
+             * All chunks returned by seal() become invalid.
+             */
+            void            close();
+
+            /**
+             * @brief Returns whether the scratch directory has been created
+             * @return `true` if chunks can be sealed.
+             */
+            bool            isOpen() const;
+
+            /**
+             * @brief Copies a chunk of records to the current segment file and maps it into memory
+             * @param chunkIndex    the index of the chunk, chunks must be sealed in ascending order.
+             * @param records       the records of the chunk.
+             * @param recordCount   the number of records of the chunk.
+             * @param firstRecord   the first valid record, all records before it have been evicted.
+             * @return the mapped copy of the chunk or `nullptr` on failure (see errorString()).
+             */
+            CanFrameTracerRecord* seal(quint64 chunkIndex, const CanFrameTracerRecord *records, int recordCount, int firstRecord);
+
+            /**
+             * @brief Deletes all segment files which only hold chunks before the given chunk
+             * @param chunkIndex the index of the first chunk still in use.
+             */
+            void            releaseBefore(quint64 chunkIndex);
+
+            /**
+             * @brief Returns the size of all segment files
+             * @return the size in bytes.
+             */
+            qint64          diskUsage() const;
+
+            /**
+             * @brief Returns a description of the last error
+             * @return the description of the last error.
+             */
+            QString         errorString() const;
+
+        private:
+
+            struct Segment
+            {
+                quint64                 firstChunkIndex;
+                std::unique_ptr<QFile>  file;
+            };
+
+            void            removeSegment(Segment &segment);
+
+            std::unique_ptr<QTemporaryDir>  m_directory = {};
+            std::deque<Segment>             m_segments = {};
+            qint64                          m_diskUsage = {0};
+            QString                         m_errorString = {};
+    };
+}
+
+#endif // CANFRAMERECORDSPILL_H
@@ -0,0 +1,116 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cantracer/canframerenderrecord.h"
+
+namespace
+{
+    const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    /**
+     * @brief Writes a number right-aligned into a field of the given width, like QString::arg() does.
+     */
+    int formatNumber(QChar *text, quint64 value, int base, int fieldWidth, char fillChar, bool negative = false)
+    {
+        char digits[24];
+        int digitCount = 0;
+
+        do
+        {
+            digits[digitCount++] = HEX_DIGITS[value % quint64(base)];
+            value /= quint64(base);
+        }
+        while ( value > 0 );
+
+        if ( negative )
+        {
+            digits[digitCount++] = '-';
+        }
+
+        int length = 0;
+
+        for (int i = digitCount; i < fieldWidth; i++)
+        {
+            text[length++] = QLatin1Char(fillChar);
+        }
+
+        while ( digitCount > 0 )
+        {
+            text[length++] = QLatin1Char( digits[--digitCount] );
+        }
+
+        return length;
+    }
+}
+
+namespace Lindwurm::Lib
+{
+    int CanFrameRenderRecord::format(QChar *text) const
+    {
+        int length = 0;
+
+        switch (field)
+        {
+            case Time:
+            {
+                // same layout as AbstractCanFrameTracerModel::getFrameTime(), the sign is kept on the seconds only
+                const qint64 seconds        = traceTimeUSecs / 1000000;
+                const qint64 microSeconds   = qAbs(traceTimeUSecs % 1000000);
+
+                length += formatNumber( text + length, quint64( qAbs(seconds) ), 10, 4, ' ', seconds < 0 );
+                text[length++] = QLatin1Char('.');
+                length += formatNumber( text + length, quint64(microSeconds), 10, 6, '0' );
+                text[length++] = QLatin1Char(' ');
+                text[length++] = QLatin1Char('s');
+                break;
+            }
+
+            case FrameId:
+            {
+                length += formatNumber( text + length, frameId, 16, 3, ' ' );
+                break;
+            }
+
+            case HexPayload:
+            {
+                for (int i = 0; i < payloadLength; i++)
+                {
+                    if ( i > 0 )
+                    {
+                        text[length++] = QLatin1Char(' ');
+                    }
+
+                    text[length++] = QLatin1Char( HEX_DIGITS[ payload[i] >> 4 ] );
+                    text[length++] = QLatin1Char( HEX_DIGITS[ payload[i] & 0x0F ] );
+                }
+                break;
+            }
+
+            case AsciiPayload:
+            {
+                for (int i = 0; i < payloadLength; i++)
+                {
+                    const QChar dataChar = QLatin1Char( char( payload[i] ) );
+
+                    text[length++] = dataChar.isPrint() ? dataChar : QLatin1Char('.');
+                }
+                break;
+            }
+        }
+
+        return length;
+    }
+}
@@ -17,10 +17,28 @@
 
 #include "cantracer/canframetracer.h"
 #include "caninterface/icaninterfacehandle.h"
+#include "caninterface/icaninterfacemanager.h"
+#include "cantracefile/icantracefilewriter.h"
 
-#include <QDateTime>
+#include <QFileInfo>
+#include <QLoggingCategory>
 #include <QMutexLocker>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.lib.tracer")
+
+    // the number of most recent chunks of frame records which are never spilled to disk
+    const quint64 RESIDENT_CHUNK_COUNT = 4;
+
+    // the number of frames passed to a trace file writer at once
+    const int EXPORT_BATCH_SIZE = 4096;
+}
+
 namespace Lindwurm::Lib
 {
     CanFrameTracer::CanFrameTracer(QObject *parent) : QObject(parent)
@@ -48,16 +66,22 @@ namespace Lindwurm::Lib
 
     void CanFrameTracer::start()
     {
+        // the interfaces of a trace read from a file do not exist in this session
+        if ( m_traceFile.isOpen() || m_importer != nullptr || ! m_interfaceNames.isEmpty() )
+        {
+            qWarning(LOG_TAG) << "A trace read from a file cannot be continued";
+            return;
+        }
+
         if ( (m_canInterface) && (m_isRunning == false) )
         {
             m_isRunning = true;
-            m_traceStartTimeMicroSeconds = QDateTime::currentMSecsSinceEpoch() * 1000;
 
-            // adding a time buffer from 1 ms to compensate a deviation (first received frames may have a timestamp little earlier than current timestamp)
-            // which could result in negative frame times
-            m_traceStartTimeMicroSeconds = m_traceStartTimeMicroSeconds - 1000;
+            // frame timestamps are in µs since epoch, so take the start time with the same resolution
+            // frames received before the first record was inserted may still be earlier, this is corrected in canFramesReceived()
+            m_traceStartTimeMicroSeconds = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
 
-            connect(m_canInterface.get(), &ICanInterfaceHandle::frameReceived, this, &CanFrameTracer::canFrameReceived);
+            connect(m_canInterface.get(), &ICanInterfaceHandle::framesReceived, this, &CanFrameTracer::canFramesReceived);
         }
     }
 
@@ -65,7 +89,14 @@ namespace Lindwurm::Lib
     {
         if ( (m_canInterface) && (m_isRunning == true) )
         {
-            disconnect(m_canInterface.get(), &ICanInterfaceHandle::frameReceived, this, &CanFrameTracer::canFrameReceived);
+            disconnect(m_canInterface.get(), &ICanInterfaceHandle::framesReceived, this, &CanFrameTracer::canFramesReceived);
+        }
+
+        // the recording file is completed once the capture has ended, not when an interface is mounted before it starts
+        if ( m_isRunning && m_recordingWriter )
+        {
+            finishTraceFile(*m_recordingWriter);
+            m_recordingWriter.reset();
         }
 
         m_isRunning = false;
@@ -76,18 +107,295 @@ namespace Lindwurm::Lib
         return m_traceStartTimeMicroSeconds;
     }
 
-    int CanFrameTracer::frameRecordCount() const
+    void CanFrameTracer::setCaptureLimits(int maxFrameRecords, qint64 maxMemoryBytes)
     {
-        QMutexLocker locker( &m_frameRecordsMutex );
+        // keep a chunk of headroom, so a bounded trace never runs full
+        m_maxFrameRecords   = qBound(0, maxFrameRecords, RecordStore::Capacity - RecordStore::ChunkSize);
+        m_maxMemoryBytes    = qMax(qint64(0), maxMemoryBytes);
 
-        return m_frameRecords.size();
+        const int evictedCount = evictFrameRecords();
+
+        if ( evictedCount > 0 )
+        {
+            emit frameRecordsRemoved(evictedCount);
+        }
+    }
+
+    int CanFrameTracer::maxFrameRecords() const
+    {
+        return m_maxFrameRecords;
+    }
+
+    qint64 CanFrameTracer::maxMemoryBytes() const
+    {
+        return m_maxMemoryBytes;
+    }
+
+    qint64 CanFrameTracer::memoryUsage() const
+    {
+        return m_frameRecords.allocatedBytes() + m_payloadArena.allocatedBytes();
+    }
+
+    bool CanFrameTracer::setSpillDirectory(const QString &directory)
+    {
+        if ( m_frameRecords.appendedCount() > 0 )
+        {
+            qWarning(LOG_TAG) << "The spill directory must be set before frames are recorded";
+            return false;
+        }
+
+        if ( directory.isEmpty() )
+        {
+            m_recordSpill.close();
+            return true;
+        }
+
+        if ( ! m_recordSpill.open(directory) )
+        {
+            qWarning(LOG_TAG) << m_recordSpill.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    qint64 CanFrameTracer::spilledBytes() const
+    {
+        return m_recordSpill.diskUsage();
+    }
+
+    bool CanFrameTracer::setRecordingFile(const QString &fileName)
+    {
+        if ( m_frameRecords.appendedCount() > 0 || m_traceFile.isOpen() )
+        {
+            qWarning(LOG_TAG) << "The recording file must be set before frames are recorded";
+            return false;
+        }
+
+        if ( fileName.isEmpty() )
+        {
+            m_recordingWriter.reset();
+            return true;
+        }
+
+        std::unique_ptr<LindwurmTraceFileWriter> writer = std::make_unique<LindwurmTraceFileWriter>();
+
+        if ( ! writer->open(fileName) )
+        {
+            qWarning(LOG_TAG) << "Failed to create recording file" << fileName << ":" << writer->errorString();
+            return false;
+        }
+
+        m_recordingWriter = std::move(writer);
+
+        return true;
+    }
+
+    bool CanFrameTracer::saveTraceFile(const QString &fileName)
+    {
+        // truncating the mapped file would invalidate the records served from it
+        if ( m_traceFile.isOpen() && QFileInfo(fileName) == QFileInfo( m_traceFile.fileName() ) )
+        {
+            qWarning(LOG_TAG) << "A trace cannot be saved to the file it was opened from";
+            return false;
+        }
+
+        LindwurmTraceFileWriter writer;
+
+        if ( ! writer.open(fileName) )
+        {
+            qWarning(LOG_TAG) << "Failed to create trace file" << fileName << ":" << writer.errorString();
+            return false;
+        }
+
+        for (int index = 0; index < m_frameRecords.size(); index++)
+        {
+            if ( ! writer.appendRecord( recordAt(index) ) )
+            {
+                qWarning(LOG_TAG) << "Failed to write trace file" << fileName << ":" << writer.errorString();
+                return false;
+            }
+        }
+
+        return finishTraceFile(writer);
+    }
+
+    bool CanFrameTracer::openTraceFile(const QString &fileName)
+    {
+        if ( m_isRunning || m_frameRecords.appendedCount() > 0 || m_traceFile.isOpen() )
+        {
+            qWarning(LOG_TAG) << "Only an empty tracer can open a trace file";
+            return false;
+        }
+
+        if ( ! m_traceFile.open(fileName) )
+        {
+            qWarning(LOG_TAG) << "Failed to open trace file" << fileName << ":" << m_traceFile.errorString();
+            return false;
+        }
+
+        // the mapped chunks are served to the models as they are, only the index of the file has been read
+        for (int chunk = 0; chunk < m_traceFile.chunkCount(); chunk++)
+        {
+            if ( ! m_frameRecords.appendChunk( m_traceFile.chunkRecords(chunk), m_traceFile.chunkRecordCount(chunk) ) )
+            {
+                qWarning(LOG_TAG) << "The trace file exceeds the capacity of the tracer, only" << m_frameRecords.size() << "frames are shown";
+                break;
+            }
+        }
+
+        m_traceStartTimeMicroSeconds    = m_traceFile.startTime();
+        m_interfaceNames                = m_traceFile.interfaceNames();
+
+        if ( m_traceFile.hasAggregators() )
+        {
+            QMutexLocker locker( &m_aggregatorsMutex );
+
+            m_aggregators = m_traceFile.aggregators();
+
+            for (int index = 0; index < m_aggregators.size(); index++)
+            {
+                m_frameIdToAggregatorIndex.insert( m_aggregators.at(index).frameId(), index );
+            }
+        }
+        else
+        {
+            qInfo(LOG_TAG) << "Trace file" << fileName << "was not closed properly, rebuilding the aggregate records";
+            rebuildAggregators();
+        }
+
+        if ( aggregateRecordCount() > 0 )
+        {
+            emit aggregateRecordsInserted( aggregateRecordCount() );
+        }
+
+        if ( ! m_frameRecords.isEmpty() )
+        {
+            emit frameRecordsInserted( m_frameRecords.size() );
+        }
+
+        return true;
+    }
+
+    bool CanFrameTracer::importTraceFile(const QString &fileName)
+    {
+        if ( m_isRunning || m_frameRecords.appendedCount() > 0 || m_traceFile.isOpen() || m_importer != nullptr )
+        {
+            qWarning(LOG_TAG) << "Only an empty tracer can import a trace file";
+            return false;
+        }
+
+        CanTraceFileImporter *importer = new CanTraceFileImporter(this);
+
+        connect(importer, &CanTraceFileImporter::blocksAvailable, this, &CanFrameTracer::importedBlocksAvailable);
+        connect(importer, &CanTraceFileImporter::progress, this, &CanFrameTracer::importProgress);
+        connect(importer, &CanTraceFileImporter::finished, this, &CanFrameTracer::importEnded);
+
+        if ( ! importer->start(fileName) )
+        {
+            qWarning(LOG_TAG) << "Failed to import trace file" << fileName << ":" << importer->errorString();
+            delete importer;
+            return false;
+        }
+
+        // the start time is moved back to the earliest imported frame
+        m_traceStartTimeMicroSeconds    = std::numeric_limits<qint64>::max();
+        m_importer                      = importer;
+
+        return true;
+    }
+
+    void CanFrameTracer::cancelImport()
+    {
+        if ( m_importer != nullptr )
+        {
+            m_importer->cancel();
+        }
+    }
+
+    bool CanFrameTracer::isImporting() const
+    {
+        return m_importer != nullptr;
+    }
+
+    bool CanFrameTracer::exportTraceFile(const QString &fileName)
+    {
+        ICanTraceFileWriterPtr writer = ICanTraceFileWriter::createWriter(fileName);
+
+        if ( ! writer )
+        {
+            qWarning(LOG_TAG) << "Unsupported trace file format:" << fileName;
+            return false;
+        }
+
+        if ( ! writer->open(fileName) )
+        {
+            qWarning(LOG_TAG) << "Failed to create trace file" << fileName << ":" << writer->errorString();
+            return false;
+        }
+
+        // consecutive frames of the same interface are written together
+        QVector<QCanBusFrame>   frames;
+        CanInterfaceIndex       framesInterface = 0;
+
+        for (int index = 0; index <= m_frameRecords.size(); index++)
+        {
+            const bool lastRecord = index == m_frameRecords.size();
+
+            if ( ! frames.isEmpty() && ( lastRecord || frames.size() >= EXPORT_BATCH_SIZE || recordAt(index).sourceInterface() != framesInterface ) )
+            {
+                if ( ! writer->writeFrames( frames, interfaceNameOf(framesInterface) ) )
+                {
+                    qWarning(LOG_TAG) << "Failed to write trace file" << fileName << ":" << writer->errorString();
+                    return false;
+                }
+
+                frames.clear();
+            }
+
+            if ( ! lastRecord )
+            {
+                framesInterface = recordAt(index).sourceInterface();
+                frames.append( recordAt(index).canFrame() );
+            }
+        }
+
+        writer->close();
+
+        return true;
+    }
+
+    QString CanFrameTracer::interfaceNameOf(CanInterfaceIndex interfaceIndex) const
+    {
+        // the interfaces of an opened trace file do not exist in this session
+        if ( m_interfaceNames.contains(interfaceIndex) )
+        {
+            return m_interfaceNames.value(interfaceIndex);
+        }
+
+        ICanInterfaceManager* interfaceManager = ICanInterfaceManager::instance();
+
+        if ( interfaceManager == nullptr )
+        {
+            return QString();
+        }
+
+        return interfaceManager->interfaceNameOf(interfaceIndex);
+    }
+
+    qint64 CanFrameTracer::evictedFrameRecordCount() const
+    {
+        return qint64( m_frameRecords.removedCount() );
     }
 
-    CanFrameTracerRecord CanFrameTracer::frameRecordAt(int index) const
+    int CanFrameTracer::frameRecordCount() const
     {
-        QMutexLocker locker( &m_frameRecordsMutex );
+        return m_frameRecords.size();
+    }
 
-        return m_frameRecords.at(index);
+    const CanFrameTracerRecord& CanFrameTracer::frameRecordAt(int index) const
+    {
+        return recordAt(index);
     }
 
     int CanFrameTracer::aggregateRecordCount() const
@@ -104,74 +412,395 @@ namespace Lindwurm::Lib
         return m_aggregators.at(index);
     }
 
-    void CanFrameTracer::canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface)
+    int CanFrameTracer::aggregateRecordIndexOf(quint32 frameId) const
+    {
+        QMutexLocker locker( &m_aggregatorsMutex );
+
+        const int index = m_frameIdToAggregatorIndex.value(frameId);
+
+        return index != CanFrameIdIndex::NoIndex ? index : -1;
+    }
+
+    QVector<int> CanFrameTracer::frameRecordIndicesOf(int aggregateRecordIndex) const
+    {
+        QMutexLocker locker( &m_aggregatorsMutex );
+
+        if ( aggregateRecordIndex < 0 || aggregateRecordIndex >= m_aggregators.size() )
+        {
+            return QVector<int>();
+        }
+
+        const quint64 head = m_frameRecords.removedCount();
+
+        if ( ! m_historyIndex.contains(aggregateRecordIndex) )
+        {
+            const quint32       frameId     = m_aggregators.at(aggregateRecordIndex).frameId();
+            const int           recordCount = m_frameRecords.size();
+            QVector<quint64>    positions;
+
+            // only the IDs of the records are read, so the chunks of an opened trace file need not be relocated
+            for (int index = 0; index < recordCount; index++)
+            {
+                if ( m_frameRecords.at(index).aggregateFrameId() == frameId )
+                {
+                    positions.append( head + quint64(index) );
+                }
+            }
+
+            m_historyIndex.insert(aggregateRecordIndex, positions);
+        }
+
+        const QVector<quint64> positions = m_historyIndex.positions(aggregateRecordIndex);
+
+        QVector<int> indices;
+        indices.reserve( positions.size() );
+
+        for (const quint64 position : positions)
+        {
+            indices.append( int(position - head) );
+        }
+
+        return indices;
+    }
+
+    void CanFrameTracer::canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
+    {
+        const CanTimestampSource timestampSource = m_canInterface ? m_canInterface->timestampSource() : CanTimestampSource::Unknown;
+
+        appendFrames( frames, QVector<CanInterfaceIndex>(frames.size(), sourceInterface), timestampSource );
+    }
+
+    void CanFrameTracer::importedBlocksAvailable()
+    {
+        if ( m_importer == nullptr )
+        {
+            return;
+        }
+
+        for (const CanTraceFileBlock &block : m_importer->takeBlocks())
+        {
+            // each channel of the file gets an interface index of its own
+            QVector<CanInterfaceIndex> channelInterfaces;
+
+            for (const QString &channelName : block.channelNames)
+            {
+                CanInterfaceIndex interfaceIndex = m_interfaceNames.key( channelName, CanInterfaceIndex( m_interfaceNames.size() ) );
+
+                m_interfaceNames.insert(interfaceIndex, channelName);
+                channelInterfaces.append(interfaceIndex);
+            }
+
+            QVector<CanInterfaceIndex> sourceInterfaces;
+            sourceInterfaces.reserve( block.channels.size() );
+
+            for (const quint16 channel : block.channels)
+            {
+                sourceInterfaces.append( channelInterfaces.at(channel) );
+            }
+
+            appendFrames(block.frames, sourceInterfaces, CanTimestampSource::Unknown);
+        }
+
+        if ( m_frameRecords.isFull() )
+        {
+            qWarning(LOG_TAG) << "The trace file exceeds the capacity of the tracer, stopping the import";
+            cancelImport();
+        }
+    }
+
+    void CanFrameTracer::importEnded(bool success)
     {
-        // TODO: BugFix (negative trace times)
-        // Check if received frame timestamp is earlier than _traceStartTimeMicroSeconds
-        // and correct _traceStartTimeMicroSeconds accordingly
+        if ( m_importer == nullptr )
+        {
+            return;
+        }
+
+        if ( ! success )
+        {
+            qWarning(LOG_TAG) << "Import of trace file ended:" << m_importer->errorString();
+        }
+
+        if ( m_frameRecords.isEmpty() )
+        {
+            m_traceStartTimeMicroSeconds = 0;
+        }
+
+        // the importer is emitting this signal
+        m_importer->deleteLater();
+        m_importer = nullptr;
+
+        emit importFinished(success);
+    }
+
+    void CanFrameTracer::appendFrames(const QVector<QCanBusFrame> &frames, const QVector<CanInterfaceIndex> &sourceInterfaces, CanTimestampSource timestampSource)
+    {
+        QVector<int> updatedAggregatorIndices;
+
+        int insertedFrameCount = 0;
 
         QMutexLocker aggregatorsLocker( &m_aggregatorsMutex );
-        QMutexLocker frameLocker( &m_frameRecordsMutex );
 
-            bool newAggregateInserted = false;
+            // aggregators appended by this batch are announced as inserted, all others as updated
+            const int aggregatorCountBeforeBatch = m_aggregators.size();
+
+            // frames which were already queued when the trace was started may have a timestamp earlier than the start time
+            // as long as no record was inserted, we move the start time back to avoid negative trace times
+            const bool adjustStartTime = m_frameRecords.isEmpty();
 
-            if ( ! m_frameIdToAggregatorIndex.contains( frame.frameId() ) )
+            for (int frameIndex = 0; frameIndex < frames.size(); frameIndex++)
             {
-                // we have identified a new distinct frame id and create an aggregator for it
+                const QCanBusFrame      &frame          = frames.at(frameIndex);
+                const CanInterfaceIndex sourceInterface = sourceInterfaces.at(frameIndex);
+
+                if ( m_frameRecords.isFull() )
+                {
+                    qWarning(LOG_TAG) << "Trace is full, dropping" << (frames.size() - insertedFrameCount) << "frames";
+                    break;
+                }
+
+                int aggregatorIndex = m_frameIdToAggregatorIndex.value( frame.frameId() );
+
+                if ( aggregatorIndex == CanFrameIdIndex::NoIndex )
+                {
+                    // we have identified a new distinct frame id and create an aggregator for it
+
+                    m_aggregators.append( CanFrameAggregator( frame.frameId() ) );
+
+                    // map the frame id to the aggregate record's index
+                    aggregatorIndex = m_aggregators.size() - 1;
+                    m_frameIdToAggregatorIndex.insert( frame.frameId(), aggregatorIndex );
+                }
+                else if ( aggregatorIndex < aggregatorCountBeforeBatch )
+                {
+                    updatedAggregatorIndices.append(aggregatorIndex);
+                }
+
+                qint64 timeDiffToLastCorrespondingFrameUSecs = 0;
+
+                qint64 timeOfLastCorrespondingFrameUSecs = m_aggregators.at(aggregatorIndex).latestTimestampUSecs();
+                qint64 timestampOfCurrentFrameUSecs = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+                if ( adjustStartTime && timestampOfCurrentFrameUSecs < m_traceStartTimeMicroSeconds )
+                {
+                    m_traceStartTimeMicroSeconds = timestampOfCurrentFrameUSecs;
+                }
+
+                if ( timeOfLastCorrespondingFrameUSecs != 0 )
+                {
+                    timeDiffToLastCorrespondingFrameUSecs = timestampOfCurrentFrameUSecs - timeOfLastCorrespondingFrameUSecs;
+                }
+
+                // insert current frame to frame records, this publishes the record before the aggregate refers to it
+                m_frameRecords.emplaceBack(frame, timeDiffToLastCorrespondingFrameUSecs, 0, sourceInterface, timestampSource, &m_payloadArena);
+                m_historyIndex.append( aggregatorIndex, m_frameRecords.appendedCount() - 1 );
+                insertedFrameCount++;
+
+                // append current frame to aggregate record
+                m_aggregators[aggregatorIndex].appendFrameRecord( frame, timestampOfCurrentFrameUSecs, timeDiffToLastCorrespondingFrameUSecs, sourceInterface );
+            }
 
-                CanFrameAggregator aggregator( frame.frameId() );
+            const int insertedAggregatorCount = m_aggregators.size() - aggregatorCountBeforeBatch;
 
-                m_aggregators.append(aggregator);
+        aggregatorsLocker.unlock();
 
-                // map the frame id to the aggregate record's index
-                m_frameIdToAggregatorIndex.insert( frame.frameId(), m_aggregators.size() - 1 );
+        // each updated aggregator is announced once per batch
+        std::sort( updatedAggregatorIndices.begin(), updatedAggregatorIndices.end() );
+        updatedAggregatorIndices.erase( std::unique( updatedAggregatorIndices.begin(), updatedAggregatorIndices.end() ), updatedAggregatorIndices.end() );
 
-                // remind to emit aggregateInserted signal after all data is updated
-                newAggregateInserted = true;
+        // the records are recorded before they may be evicted
+        if ( m_recordingWriter )
+        {
+            for (int index = m_frameRecords.size() - insertedFrameCount; index < m_frameRecords.size(); index++)
+            {
+                if ( ! m_recordingWriter->appendRecord( m_frameRecords.at(index) ) )
+                {
+                    qWarning(LOG_TAG) << "Stopped recording to trace file:" << m_recordingWriter->errorString();
+                    m_recordingWriter.reset();
+                    break;
+                }
             }
+        }
 
-            int aggregatorIndex = m_frameIdToAggregatorIndex.value(frame.frameId(), -1);
+        const int evictedFrameCount = evictFrameRecords();
 
-            Q_ASSERT(aggregatorIndex != -1);
+        spillFrameRecords();
 
-            qint64 timeDiffToLastCorrespondingFrameUSecs = 0;
+        if ( insertedAggregatorCount > 0 )
+        {
+            emit aggregateRecordsInserted(insertedAggregatorCount);
+        }
 
-            qint64 timeOfLastCorrespondingFrameUSecs = m_aggregators.at(aggregatorIndex).latestTimestampUSecs();
-            qint64 timestampOfCurrentFrameUSecs = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+        if ( ! updatedAggregatorIndices.isEmpty() )
+        {
+            emit aggregateRecordsUpdated(updatedAggregatorIndices);
+        }
+
+        if ( insertedFrameCount > 0 )
+        {
+            emit frameRecordsInserted(insertedFrameCount);
+        }
+
+        if ( evictedFrameCount > 0 )
+        {
+            emit frameRecordsRemoved(evictedFrameCount);
+        }
+    }
+
+    int CanFrameTracer::evictFrameRecords()
+    {
+        const int       size        = m_frameRecords.size();
+        const quint64   head        = m_frameRecords.removedCount();
+        quint64         newHead     = head;
+
+        if ( m_maxFrameRecords > 0 && size > m_maxFrameRecords )
+        {
+            newHead = head + quint64(size - m_maxFrameRecords);
+        }
+
+        const qint64 excessBytes = m_maxMemoryBytes > 0 ? memoryUsage() - m_maxMemoryBytes : 0;
+
+        if ( excessBytes > 0 )
+        {
+            // memory is only released in whole chunks, so the new head is moved to the start of a chunk
+            const qint64    recordSize      = qint64( sizeof(CanFrameTracerRecord) );
+            const quint64   chunkMask       = quint64(RecordStore::ChunkSize - 1);
+            const quint64   budgetHead      = ( head + quint64( (excessBytes + recordSize - 1) / recordSize ) + chunkMask ) & ~chunkMask;
+
+            newHead = qMax(newHead, budgetHead);
+        }
+
+        const int evictCount = int( qMin( newHead - head, quint64(size) ) );
 
-            if ( timeOfLastCorrespondingFrameUSecs != 0 )
+        if ( evictCount == 0 )
+        {
+            return 0;
+        }
+
+        // the payloads of the records are stored in order, so the arena keeps everything from the latest evicted one on
+        for (int index = evictCount - 1; index >= 0; index--)
+        {
+            const quint8 *arenaPayload = m_frameRecords.at(index).arenaPayload();
+
+            if ( arenaPayload != nullptr )
             {
-                timeDiffToLastCorrespondingFrameUSecs = timestampOfCurrentFrameUSecs - timeOfLastCorrespondingFrameUSecs;
+                m_payloadArena.releaseBefore(arenaPayload);
+                break;
             }
+        }
 
-            // insert current frame to frame records
-            m_frameRecords.append( CanFrameTracerRecord(frame, timeDiffToLastCorrespondingFrameUSecs, 0, sourceInterface) );
+        m_frameRecords.removeFront(evictCount);
+        m_recordSpill.releaseBefore( m_frameRecords.removedCount() / RecordStore::ChunkSize );
 
-            // append current frame to aggregate record
-            m_aggregators[aggregatorIndex].appendFrameRecord( m_frameRecords.size() - 1, timestampOfCurrentFrameUSecs, timeDiffToLastCorrespondingFrameUSecs );
+        {
+            QMutexLocker locker( &m_aggregatorsMutex );
+            m_historyIndex.removeBefore( m_frameRecords.removedCount() );
+        }
 
-        frameLocker.unlock();
-        aggregatorsLocker.unlock();
+        return evictCount;
+    }
 
-        if ( newAggregateInserted )
+    void CanFrameTracer::spillFrameRecords()
+    {
+        if ( ! m_recordSpill.isOpen() )
         {
-            emit aggregateRecordInserted();
+            return;
         }
-        else
+
+        const quint64 removedCount      = m_frameRecords.removedCount();
+        const quint64 filledChunkEnd    = m_frameRecords.appendedCount() / RecordStore::ChunkSize;
+
+        // chunks which have been evicted completely are not spilled
+        m_sealedChunkEnd = qMax( m_sealedChunkEnd, removedCount / RecordStore::ChunkSize );
+
+        if ( m_sealedChunkEnd + RESIDENT_CHUNK_COUNT >= filledChunkEnd )
         {
-            emit aggregateRecordUpdated(aggregatorIndex);
+            return;
         }
 
-        emit frameRecordInserted();
+        while ( m_sealedChunkEnd + RESIDENT_CHUNK_COUNT < filledChunkEnd )
+        {
+            const quint64   chunkStart  = m_sealedChunkEnd * RecordStore::ChunkSize;
+            const int       firstRecord = int( qMax(chunkStart, removedCount) - chunkStart );
+
+            CanFrameTracerRecord *sealedChunk = m_recordSpill.seal( m_sealedChunkEnd, m_frameRecords.chunkData(m_sealedChunkEnd), RecordStore::ChunkSize, firstRecord );
+
+            if ( sealedChunk == nullptr )
+            {
+                qWarning(LOG_TAG) << "Failed to spill frame records, keeping them in memory:" << m_recordSpill.errorString();
+                break;
+            }
+
+            m_frameRecords.replaceChunk(m_sealedChunkEnd, sealedChunk);
+            m_sealedChunkEnd++;
+        }
+
+        // the payloads of the sealed records have been copied, the arena only has to keep those of resident records
+        const int firstResidentRecord = int( qMax(m_sealedChunkEnd * RecordStore::ChunkSize, removedCount) - removedCount );
+
+        for (int index = firstResidentRecord; index < m_frameRecords.size(); index++)
+        {
+            const quint8 *arenaPayload = m_frameRecords.at(index).arenaPayload();
+
+            if ( arenaPayload != nullptr )
+            {
+                m_payloadArena.releaseBefore(arenaPayload);
+                return;
+            }
+        }
+
+        m_payloadArena.releaseFilledBlocks();
     }
 
-    void CanFrameTracer::initializeStartTimeFromFirstFrame()
+    bool CanFrameTracer::finishTraceFile(LindwurmTraceFileWriter &writer)
+    {
+        QMap<CanInterfaceIndex, QString> interfaceNames;
+
+        for (const CanInterfaceIndex interfaceIndex : writer.sourceInterfaces())
+        {
+            interfaceNames.insert( interfaceIndex, interfaceNameOf(interfaceIndex) );
+        }
+
+        QMutexLocker aggregatorsLocker( &m_aggregatorsMutex );
+
+            const QVector<CanFrameAggregator> aggregators = m_aggregators;
+
+        aggregatorsLocker.unlock();
+
+        return writer.close(m_traceStartTimeMicroSeconds, aggregators, interfaceNames);
+    }
+
+    void CanFrameTracer::rebuildAggregators()
     {
-        if ( m_frameRecords.size() > 0 )
+        QMutexLocker locker( &m_aggregatorsMutex );
+
+        m_aggregators.clear();
+        m_frameIdToAggregatorIndex.clear();
+        m_historyIndex.clear();
+
+        for (int index = 0; index < m_frameRecords.size(); index++)
         {
-            CanFrameTracerRecord record = m_frameRecords.at(0);
+            const CanFrameTracerRecord  &record = recordAt(index);
+            const QCanBusFrame          frame   = record.canFrame();
 
-            m_traceStartTimeMicroSeconds = (record.canFrame().timeStamp().seconds() * 1000000) + record.canFrame().timeStamp().microSeconds();
+            int aggregatorIndex = m_frameIdToAggregatorIndex.value( frame.frameId() );
+
+            if ( aggregatorIndex == CanFrameIdIndex::NoIndex )
+            {
+                m_aggregators.append( CanFrameAggregator( frame.frameId() ) );
+
+                aggregatorIndex = m_aggregators.size() - 1;
+                m_frameIdToAggregatorIndex.insert( frame.frameId(), aggregatorIndex );
+            }
+
+            m_aggregators[aggregatorIndex].appendFrameRecord( frame, record.timestampUSecs(), record.timeDifferenceUSecs(), record.sourceInterface() );
+        }
+    }
+
+    void CanFrameTracer::initializeStartTimeFromFirstFrame()
+    {
+        if ( ! m_frameRecords.isEmpty() )
+        {
+            m_traceStartTimeMicroSeconds = m_frameRecords.at(0).timestampUSecs();
         }
     }
 }
@@ -16,21 +16,166 @@
  */
 
 #include "cantracer/canframetracerrecord.h"
+#include "cantracer/canpayloadarena.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    // the maximum payload length of a CAN FD frame
+    const int MAX_PAYLOAD_LENGTH = 64;
+}
 
 namespace Lindwurm::Lib
 {
-    CanFrameTracerRecord::CanFrameTracerRecord(const QCanBusFrame &frame, qint64 timeDifferenceUSecs, int hammingDistance, const QString &sourceInterface)
-        : m_frame(frame)
+    static_assert( std::is_trivially_copyable<CanFrameTracerRecord>::value, "CanFrameTracerRecord must stay trivially copyable" );
+    static_assert( sizeof(CanFrameTracerRecord) <= 40, "CanFrameTracerRecord must stay packed" );
+
+    CanFrameTracerRecord::CanFrameTracerRecord(const QCanBusFrame &frame, qint64 timeDifferenceUSecs, int hammingDistance, CanInterfaceIndex sourceInterface,
+                                               CanTimestampSource timestampSource, CanPayloadArena *payloadArena)
+        : m_timestampUSecs( frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds() )
         , m_timeDifferenceUSecs(timeDifferenceUSecs)
-        , m_hammingDistance(hammingDistance)
+        , m_payload()
+        , m_frameId( frame.frameType() == QCanBusFrame::ErrorFrame ? quint32( frame.error() ) : frame.frameId() )
         , m_sourceInterface(sourceInterface)
+        , m_hammingDistance( quint16(hammingDistance) )
+        , m_frameType( quint8( frame.frameType() ) )
+        , m_flags(0)
+        , m_payloadLength(0)
+        , m_timestampSource( quint8(timestampSource) )
+    {
+        if ( frame.hasExtendedFrameFormat() )       m_flags |= ExtendedFrameFormat;
+        if ( frame.hasFlexibleDataRateFormat() )    m_flags |= FlexibleDataRate;
+        if ( frame.hasBitrateSwitch() )             m_flags |= BitrateSwitch;
+        if ( frame.hasErrorStateIndicator() )       m_flags |= ErrorStateIndicator;
+        if ( frame.hasLocalEcho() )                 m_flags |= LocalEcho;
+
+        const QByteArray    payload = frame.payload();
+        const int           length  = qMin( payload.size(), MAX_PAYLOAD_LENGTH );
+
+        if ( length <= InlinePayloadSize )
+        {
+            std::memcpy(m_payload.inlineData, payload.constData(), size_t(length));
+            m_payloadLength = quint8(length);
+        }
+        else if ( payloadArena )
+        {
+            m_payload.arenaData = payloadArena->store(payload.constData(), length);
+            m_payloadLength     = quint8(length);
+        }
+        else
+        {
+            // without an arena only the inline bytes can be kept
+            Q_ASSERT( payloadArena != nullptr );
+
+            std::memcpy(m_payload.inlineData, payload.constData(), size_t(InlinePayloadSize));
+            m_payloadLength = quint8(InlinePayloadSize);
+        }
+    }
+
+    QCanBusFrame CanFrameTracerRecord::canFrame() const
+    {
+        const QCanBusFrame::FrameType frameType = QCanBusFrame::FrameType(m_frameType);
+
+        QCanBusFrame frame(frameType);
+
+        if ( frameType == QCanBusFrame::ErrorFrame )
+        {
+            frame.setError( QCanBusFrame::FrameErrors( int(m_frameId) ) );
+        }
+        else
+        {
+            frame.setFrameId(m_frameId);
+            frame.setExtendedFrameFormat( m_flags & ExtendedFrameFormat );
+        }
+
+        frame.setFlexibleDataRateFormat( m_flags & FlexibleDataRate );
+        frame.setBitrateSwitch( m_flags & BitrateSwitch );
+        frame.setErrorStateIndicator( m_flags & ErrorStateIndicator );
+        frame.setLocalEcho( m_flags & LocalEcho );
+        frame.setPayload( payload() );
+        frame.setTimeStamp( QCanBusFrame::TimeStamp::fromMicroSeconds(m_timestampUSecs) );
+
+        return frame;
+    }
+
+    quint32 CanFrameTracerRecord::frameId() const
+    {
+        return m_frameId;
+    }
+
+    quint32 CanFrameTracerRecord::aggregateFrameId() const
     {
+        return m_frameType == quint8(QCanBusFrame::ErrorFrame) ? 0 : m_frameId;
+    }
 
+    QByteArray CanFrameTracerRecord::payload() const
+    {
+        return QByteArray( reinterpret_cast<const char*>( payloadData() ), m_payloadLength );
     }
 
-    const QCanBusFrame &CanFrameTracerRecord::canFrame() const
+    int CanFrameTracerRecord::payloadLength() const
     {
-        return m_frame;
+        return m_payloadLength;
+    }
+
+    const quint8 *CanFrameTracerRecord::arenaPayload() const
+    {
+        return m_payloadLength > InlinePayloadSize ? m_payload.arenaData : nullptr;
+    }
+
+    void CanFrameTracerRecord::relocateArenaPayload(const quint8 *data)
+    {
+        Q_ASSERT( m_payloadLength > InlinePayloadSize );
+
+        m_payload.arenaData = data;
+    }
+
+    bool CanFrameTracerRecord::repair()
+    {
+        bool corrupted = false;
+
+        if ( m_frameType > quint8(QCanBusFrame::InvalidFrame) )
+        {
+            m_frameType = quint8(QCanBusFrame::InvalidFrame);
+            corrupted   = true;
+        }
+
+        if ( m_payloadLength > MAX_PAYLOAD_LENGTH )
+        {
+            m_payloadLength = MAX_PAYLOAD_LENGTH;
+            corrupted       = true;
+        }
+
+        return corrupted;
+    }
+
+    void CanFrameTracerRecord::setArenaPayloadOffset(quint64 offset)
+    {
+        Q_ASSERT( m_payloadLength > InlinePayloadSize );
+
+        m_payload.arenaOffset = offset;
+    }
+
+    quint64 CanFrameTracerRecord::arenaPayloadOffset() const
+    {
+        return m_payload.arenaOffset;
+    }
+
+    bool CanFrameTracerRecord::hasLocalEcho() const
+    {
+        return m_flags & LocalEcho;
+    }
+
+    qint64 CanFrameTracerRecord::timestampUSecs() const
+    {
+        return m_timestampUSecs;
+    }
+
+    CanTimestampSource CanFrameTracerRecord::timestampSource() const
+    {
+        return CanTimestampSource(m_timestampSource);
     }
 
     qint64 CanFrameTracerRecord::timeDifferenceUSecs() const
@@ -43,8 +188,13 @@ namespace Lindwurm::Lib
         return m_hammingDistance;
     }
 
-    QString CanFrameTracerRecord::sourceInterface() const
+    CanInterfaceIndex CanFrameTracerRecord::sourceInterface() const
     {
         return m_sourceInterface;
     }
+
+    const quint8 *CanFrameTracerRecord::payloadData() const
+    {
+        return m_payloadLength > InlinePayloadSize ? m_payload.arenaData : m_payload.inlineData;
+    }
 }
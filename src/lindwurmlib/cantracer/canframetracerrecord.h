@@ -21,33 +21,136 @@
 #include "lindwurmlib_global.h"
 #include <QCanBusFrame>
 
+#include "caninterface/cantimestampsource.h"
+#include "caninterface/caninterfaceindex.h"
+
 namespace Lindwurm::Lib
 {
+    class CanPayloadArena;
+
     /**
      * @brief The CanFrameTracerRecord class represents a record for a single CAN frame in a trace log.
      *
      * It stores additional information about the captured CAN frame in the trace log, for example
      * the time difference to the last CAN frame with this ID or the source interface of the frame.
      *
+     * The record is a packed, trivially copyable layout of 40 bytes which is filled on ingest. Payloads of up
+     * to eight bytes are stored inline, longer CAN FD payloads in a CanPayloadArena owned by the tracer. The
+     * QCanBusFrame is only rebuilt on demand by canFrame().
+     *
      * WIP: The hamming distance shows the payload changes over time.
      */
     class LINDWURMLIB_EXPORT CanFrameTracerRecord
     {
         public:
 
+            /**
+             * @brief The maximum payload length which is stored inline within the record.
+             */
+            static const int InlinePayloadSize = 8;
+
             /**
              * @brief Constructs a CanFrameTracerRecord with the provided data.
              * @param frame                 the traced frame.
              * @param timeDifferenceUSecs   the time difference since last corresponding frame in µs.
              * @param hammingDistance       the hamming distance of the payload bytes.
+             * @param sourceInterface       the index of the interface from which the frame was captured.
+             * @param timestampSource       the source of the frame's timestamp.
+             * @param payloadArena          the arena for payloads longer than InlinePayloadSize; it must outlive the record.
              */
-            CanFrameTracerRecord(const QCanBusFrame &frame, qint64 timeDifferenceUSecs, int hammingDistance, const QString &sourceInterface);
+            CanFrameTracerRecord(const QCanBusFrame &frame, qint64 timeDifferenceUSecs, int hammingDistance, CanInterfaceIndex sourceInterface,
+                                 CanTimestampSource timestampSource = CanTimestampSource::Unknown, CanPayloadArena *payloadArena = nullptr);
 
             /**
              * @brief Returns the captured CAN frame.
-             * @return the captured CAN frame.
+             * @return the captured CAN frame, rebuilt from the packed record.
+             */
+            QCanBusFrame            canFrame() const;
+
+            /**
+             * @brief Returns the ID of the captured CAN frame.
+             * @return the frame ID; the error flags for error frames.
+             */
+            quint32                 frameId() const;
+
+            /**
+             * @brief Returns the frame ID the aggregate record of the captured CAN frame is keyed by.
+             * @return the frame ID; 0 for error frames, whose frameId() holds the error flags.
+             */
+            quint32                 aggregateFrameId() const;
+
+            /**
+             * @brief Returns the payload of the captured CAN frame.
+             * @return a copy of the payload.
+             */
+            QByteArray              payload() const;
+
+            /**
+             * @brief Returns the payload length of the captured CAN frame.
+             * @return the payload length in bytes.
+             */
+            int                     payloadLength() const;
+
+            /**
+             * @brief Returns the payload bytes of the captured CAN frame without copying them.
+             * @return a pointer to payloadLength() bytes, which stays valid as long as the record.
+             */
+            const quint8*           payloadData() const;
+
+            /**
+             * @brief Returns the payload stored in the CanPayloadArena.
+             * @return the arena payload; `nullptr` if the payload is stored inline.
              */
-            const QCanBusFrame&     canFrame() const;
+            const quint8*           arenaPayload() const;
+
+            /**
+             * @brief Points the record to a copy of its arena payload, e.g. in a sealed trace segment.
+             * @param data the copy of the payload, which must outlive the record.
+             */
+            void                    relocateArenaPayload(const quint8 *data);
+
+            /**
+             * @brief Repairs a record which was read from an untrusted source, e.g. a corrupted trace file.
+             *
+             * An undefined frame type is replaced by QCanBusFrame::InvalidFrame and the payload length is limited to
+             * the longest CAN FD payload. The arena payload of a repaired record has to be relocated afterwards.
+             *
+             * @return `true` if the record was corrupted.
+             */
+            bool                    repair();
+
+            /**
+             * @brief Replaces the address of the arena payload by a file offset, e.g. when the record is written to a trace file.
+             *
+             * The payload of the record is invalid until it is relocated again with relocateArenaPayload().
+             *
+             * @param offset the offset of the payload.
+             */
+            void                    setArenaPayloadOffset(quint64 offset);
+
+            /**
+             * @brief Returns the offset of the arena payload as set by setArenaPayloadOffset().
+             * @return the offset of the payload.
+             */
+            quint64                 arenaPayloadOffset() const;
+
+            /**
+             * @brief Returns whether the frame was sent by the recording interface.
+             * @return `true` if the frame was received by local echo.
+             */
+            bool                    hasLocalEcho() const;
+
+            /**
+             * @brief Returns the timestamp of the captured CAN frame.
+             * @return the timestamp in µs.
+             */
+            qint64                  timestampUSecs() const;
+
+            /**
+             * @brief Returns the source of the frame's timestamp.
+             * @return the source of the frame's timestamp.
+             */
+            CanTimestampSource      timestampSource() const;
 
             /**
              * @brief Returns the time difference to the last frame with this frame ID.
@@ -62,18 +165,43 @@ namespace Lindwurm::Lib
             int                     hammingDistance() const;
 
             /**
-             * @brief Returns the name of the interface from which the frame was captured.
-             * @return the name of the interface from which the frame was captured.
+             * @brief Returns the index of the interface from which the frame was captured.
+             *
+             * The name of the interface is resolved with CanFrameTracer::interfaceNameOf().
+             *
+             * @return the index of the interface from which the frame was captured.
              */
-            QString                 sourceInterface() const;
+            CanInterfaceIndex       sourceInterface() const;
 
 
         private:
 
-            QCanBusFrame    m_frame;
-            qint64          m_timeDifferenceUSecs;
-            int             m_hammingDistance;
-            QString         m_sourceInterface;
+            enum Flag : quint8
+            {
+                ExtendedFrameFormat     = 0x01,
+                FlexibleDataRate        = 0x02,
+                BitrateSwitch           = 0x04,
+                ErrorStateIndicator     = 0x08,
+                LocalEcho               = 0x10
+            };
+
+            qint64              m_timestampUSecs;
+            qint64              m_timeDifferenceUSecs;
+
+            union
+            {
+                quint8          inlineData[InlinePayloadSize];
+                const quint8*   arenaData;
+                quint64         arenaOffset;
+            }                   m_payload;
+
+            quint32             m_frameId;
+            CanInterfaceIndex   m_sourceInterface;
+            quint16             m_hammingDistance;
+            quint8              m_frameType;
+            quint8              m_flags;
+            quint8              m_payloadLength;
+            quint8              m_timestampSource;
     };
 }
 
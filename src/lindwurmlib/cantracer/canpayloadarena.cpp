@@ -0,0 +1,77 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cantracer/canpayloadarena.h"
+
+#include <cstring>
+#include <functional>
+
+namespace Lindwurm::Lib
+{
+    CanPayloadArena::CanPayloadArena()
+    {
+
+    }
+
+    const quint8 *CanPayloadArena::store(const char *data, int length)
+    {
+        Q_ASSERT( length >= 0 && length <= BlockSize );
+
+        if ( m_usedBlockBytes + length > BlockSize )
+        {
+            m_blocks.emplace_back( new quint8[BlockSize] );
+            m_usedBlockBytes = 0;
+        }
+
+        quint8 *destination = m_blocks.back().get() + m_usedBlockBytes;
+
+        std::memcpy(destination, data, size_t(length));
+        m_usedBlockBytes += length;
+
+        return destination;
+    }
+
+    void CanPayloadArena::releaseBefore(const quint8 *data)
+    {
+        const std::less<const quint8*> before;
+
+        for (size_t blockIndex = 0; blockIndex < m_blocks.size(); blockIndex++)
+        {
+            const quint8 *blockStart = m_blocks[blockIndex].get();
+
+            if ( ! before(data, blockStart) && before(data, blockStart + BlockSize) )
+            {
+                m_blocks.erase( m_blocks.begin(), m_blocks.begin() + qint64(blockIndex) );
+                return;
+            }
+        }
+    }
+
+    void CanPayloadArena::releaseFilledBlocks()
+    {
+        // the block currently filled is never released
+        if ( m_blocks.size() > 1 )
+        {
+            m_blocks.erase( m_blocks.begin(), m_blocks.end() - 1 );
+        }
+    }
+
+    qint64 CanPayloadArena::allocatedBytes() const
+    {
+        return qint64( m_blocks.size() ) * BlockSize;
+    }
+}
@@ -0,0 +1,84 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANPAYLOADARENA_H
+#define CANPAYLOADARENA_H
+
+#include "lindwurmlib_global.h"
+
+#include <QtGlobal>
+
+#include <deque>
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanPayloadArena class stores frame payloads which do not fit inline into a CanFrameTracerRecord.
+     *
+     * Payloads are copied into large blocks, which are never moved. The returned pointers therefore stay valid
+     * until their block is released and can be handed to readers in other threads, as long as they are published
+     * after store() returned (e.g. by the release store of a SegmentedAppendStore). Blocks are released in the
+     * order they were filled by releaseBefore(), when the records of a bounded trace are evicted.
+     *
+     * Only a single thread may store payloads at a time.
+     */
+    class LINDWURMLIB_EXPORT CanPayloadArena
+    {
+        public:
+
+            static const int BlockSize = 64 * 1024;
+
+            CanPayloadArena();
+
+            CanPayloadArena(const CanPayloadArena&) = delete;
+            CanPayloadArena& operator=(const CanPayloadArena&) = delete;
+
+            /**
+             * @brief Copies a payload into the arena
+             * @param data      the payload bytes.
+             * @param length    the number of bytes, at most BlockSize.
+             * @return a pointer to the stored copy, which stays valid for the lifetime of the arena.
+             */
+            const quint8*   store(const char *data, int length);
+
+            /**
+             * @brief Releases all blocks filled before the block holding the given payload
+             * @param data a payload returned by store(), all payloads stored before it are no longer referenced. If the
+             *             payload is not stored in the arena (anymore), nothing is released.
+             */
+            void            releaseBefore(const quint8 *data);
+
+            /**
+             * @brief Releases all blocks except the one currently filled, no payload stored before is referenced anymore
+             */
+            void            releaseFilledBlocks();
+
+            /**
+             * @brief Returns the number of bytes allocated by the arena
+             * @return the number of allocated bytes.
+             */
+            qint64          allocatedBytes() const;
+
+        private:
+
+            std::deque< std::unique_ptr<quint8[]> >     m_blocks = {};
+            int                                         m_usedBlockBytes = {BlockSize};
+    };
+}
+
+#endif // CANPAYLOADARENA_H
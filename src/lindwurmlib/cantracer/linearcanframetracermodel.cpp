@@ -33,12 +33,14 @@ namespace Lindwurm::Lib
         : AbstractCanFrameTracerModel(tracer, parent)
         , m_rowCount( m_tracer->frameRecordCount() )
         , m_insertedRowsCount(0)
+        , m_removedRowsCount(0)
         , m_updateTimer()
     {
         m_updateTimer.setSingleShot(true);
         connect(&m_updateTimer, &QTimer::timeout, this, &LinearCanFrameTracerModel::updateModel);
 
-        connect(m_tracer, &CanFrameTracer::frameRecordInserted, this, &LinearCanFrameTracerModel::frameRecordInserted);
+        connect(m_tracer, &CanFrameTracer::frameRecordsInserted, this, &LinearCanFrameTracerModel::frameRecordsInserted);
+        connect(m_tracer, &CanFrameTracer::frameRecordsRemoved, this, &LinearCanFrameTracerModel::frameRecordsRemoved);
     }
 
     int LinearCanFrameTracerModel::rowCount(const QModelIndex &parent) const
@@ -63,30 +65,61 @@ namespace Lindwurm::Lib
 
     QVariant LinearCanFrameTracerModel::data(const QModelIndex &index, int role) const
     {
-        if (index.isValid() && role == Qt::DisplayRole)
+        // rows evicted by the tracer are still shown until the next model update
+        const int recordIndex = index.isValid() ? frameRecordIndexOf( index.row() ) : -1;
+
+        if ( recordIndex < 0 )
         {
-            CanFrameTracerRecord record = m_tracer->frameRecordAt( index.row() );
+            return QVariant();
+        }
+
+        if ( role == Qt::DisplayRole )
+        {
+            const CanFrameTracerRecord &record = m_tracer->frameRecordAt(recordIndex);
 
             switch ( index.column() )
             {
-                case 0:     return index.row() + 1;
-                case 1:     return getFrameTime( record.canFrame().timeStamp() );
-                case 2:     return QString("%1").arg( record.canFrame().frameId(), 3, 16, QLatin1Char(' ') ).toUpper();
+                case 0:     return m_tracer->evictedFrameRecordCount() + recordIndex + 1;
+                case 1:     return getFrameTime( QCanBusFrame::TimeStamp::fromMicroSeconds( record.timestampUSecs() ) );
+                case 2:     return QString("%1").arg( record.frameId(), 3, 16, QLatin1Char(' ') ).toUpper();
                 case 3:     return getFrameTimeDiff( record.timeDifferenceUSecs() );
-                case 4:     return record.canFrame().hasLocalEcho() ? "TX" : "RX";
-                case 5:     return record.sourceInterface();
-                case 6:     return record.canFrame().payload().size();
-                case 7:     return record.canFrame().payload().toHex(' ').toUpper();
-                case 8:     return toASCIIString( record.canFrame().payload() );
+                case 4:     return record.hasLocalEcho() ? "TX" : "RX";
+                case 5:     return interfaceName( record.sourceInterface() );
+                case 6:     return getFrameLength( record.canFrame() );
+                case 7:     return record.payload().toHex(' ').toUpper();
+                case 8:     return toASCIIString( record.payload() );
+                default:    return QVariant();
+            }
+        }
+
+        if ( role == RenderRecordRole )
+        {
+            const CanFrameTracerRecord &record = m_tracer->frameRecordAt(recordIndex);
+
+            CanFrameRenderRecord::Field field;
+
+            switch ( index.column() )
+            {
+                case 1:     field = CanFrameRenderRecord::Time;            break;
+                case 2:     field = CanFrameRenderRecord::FrameId;         break;
+                case 7:     field = CanFrameRenderRecord::HexPayload;      break;
+                case 8:     field = CanFrameRenderRecord::AsciiPayload;    break;
                 default:    return QVariant();
             }
+
+            return renderRecord( field, record.timestampUSecs(), record.frameId(), record.payloadData(), record.payloadLength() );
+        }
+
+        if ( role == Qt::ToolTipRole && index.column() == 1 )
+        {
+            return timestampSourceDescription( m_tracer->frameRecordAt(recordIndex).timestampSource() );
         }
 
-        if ( index.isValid() && role == CopyTextRole )
+        if ( role == CopyTextRole )
         {
-            CanFrameTracerRecord record = m_tracer->frameRecordAt( index.row() );
+            const CanFrameTracerRecord &record = m_tracer->frameRecordAt(recordIndex);
 
-            return QString("%1").arg( record.canFrame().frameId(), 3, 16, QLatin1Char(' ') ).toUpper() + "\t" + record.canFrame().payload().toHex(' ').toUpper() + "\t\t# " + toASCIIString( record.canFrame().payload() );
+            return getCopyText( record.canFrame() );
         }
 
         return QVariant();
@@ -130,9 +163,19 @@ namespace Lindwurm::Lib
         return QVariant();
     }
 
-    void LinearCanFrameTracerModel::frameRecordInserted()
+    void LinearCanFrameTracerModel::frameRecordsInserted(int count)
     {
-        m_insertedRowsCount++;
+        m_insertedRowsCount += count;
+
+        if ( ! m_updateTimer.isActive() )
+        {
+            m_updateTimer.start(ViewUpdateInterval);
+        }
+    }
+
+    void LinearCanFrameTracerModel::frameRecordsRemoved(int count)
+    {
+        m_removedRowsCount += count;
 
         if ( ! m_updateTimer.isActive() )
         {
@@ -142,6 +185,29 @@ namespace Lindwurm::Lib
 
     void LinearCanFrameTracerModel::updateModel()
     {
+        // evicted records are removed from the head, records which were evicted before they were shown
+        // are simply not inserted
+        const int removedRowsCount = qMin(m_removedRowsCount, m_rowCount);
+
+        if ( removedRowsCount > 0 )
+        {
+            beginRemoveRows( QModelIndex(), 0, removedRowsCount - 1 );
+
+            m_rowCount -= removedRowsCount;
+            m_removedRowsCount -= removedRowsCount;
+
+            endRemoveRows();
+        }
+
+        m_insertedRowsCount -= m_removedRowsCount;
+        m_removedRowsCount = 0;
+
+        if ( m_insertedRowsCount <= 0 )
+        {
+            m_insertedRowsCount = 0;
+            return;
+        }
+
         // existing rows are numbered from 0 (!) to _rowCount-1
         // first and last are the row numbers that the new rows will have after they have been inserted.
         // e.g. if 2 rows are inserted they will have the numbers _rowCount and _rowCount + 1 // 2-1
@@ -154,6 +220,13 @@ namespace Lindwurm::Lib
         endInsertRows();
     }
 
+    int LinearCanFrameTracerModel::frameRecordIndexOf(int row) const
+    {
+        const int recordIndex = row - m_removedRowsCount;
+
+        return recordIndex < m_tracer->frameRecordCount() ? recordIndex : -1;
+    }
+
     QString LinearCanFrameTracerModel::getFrameTime(const QCanBusFrame::TimeStamp &frameTimestamp) const
     {
         qint64 timestampMicroSeconds = frameTimestamp.seconds() * 1000000 + frameTimestamp.microSeconds();
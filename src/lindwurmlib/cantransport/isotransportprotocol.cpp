@@ -29,6 +29,9 @@ namespace
     const int DEFAULT_SEPARATION_TIME = 0;
     const int DEFAULT_TIMEOUT = 1000;
     const int MAX_WAIT_CYCLES = 5;
+
+    // received messages are buffered completely, longer messages are refused with an overflow flow control frame
+    const qint64 MAX_RECEIVE_DATA_LENGTH = 64 * 1024 * 1024;
 }
 
 namespace Lindwurm::Lib
@@ -63,14 +66,19 @@ namespace Lindwurm::Lib
         unmountCANInterface();
 
         m_canInterface = interface;
-        connect(m_canInterface.get(), &ICanInterfaceHandle::frameReceived, this, &IsoTransportProtocol::canFrameReceived);
+        connect(m_canInterface.get(), &ICanInterfaceHandle::framesReceived, this, &IsoTransportProtocol::canFramesReceived);
+        connect(m_canInterface.get(), &ICanInterfaceHandle::readyToSend,    this, &IsoTransportProtocol::transmitQueueReady);
+
+        // only frames of the target are relevant, so let the interface discard all other frames as early as possible
+        m_canInterface->subscribe(m_targetAddress);
     }
 
     void IsoTransportProtocol::unmountCANInterface()
     {
         if (m_canInterface)
         {
-            disconnect(m_canInterface.get(), &ICanInterfaceHandle::frameReceived, this, &IsoTransportProtocol::canFrameReceived);
+            disconnect(m_canInterface.get(), &ICanInterfaceHandle::framesReceived, this, &IsoTransportProtocol::canFramesReceived);
+            disconnect(m_canInterface.get(), &ICanInterfaceHandle::readyToSend,    this, &IsoTransportProtocol::transmitQueueReady);
             m_canInterface->unmount();
             m_canInterface.reset();
         }
@@ -81,6 +89,11 @@ namespace Lindwurm::Lib
         m_usePadding = enablePadding;
     }
 
+    void IsoTransportProtocol::setBitrateSwitchEnabled(bool enableBitrateSwitch)
+    {
+        m_useBitrateSwitch = enableBitrateSwitch;
+    }
+
     quint32 IsoTransportProtocol::sourceAddress() const
     {
         return m_sourceAddress;
@@ -108,10 +121,21 @@ namespace Lindwurm::Lib
     }
 
 
-    void IsoTransportProtocol::canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface)
+    void IsoTransportProtocol::canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
     {
         Q_UNUSED(sourceInterface)
 
+        for (const QCanBusFrame &frame : frames)
+        {
+            if ( frame.frameId() == m_targetAddress )
+            {
+                processCanFrame(frame);
+            }
+        }
+    }
+
+    void IsoTransportProtocol::processCanFrame(const QCanBusFrame &frame)
+    {
         if ( frame.frameId() != m_targetAddress )
         {
             return;
@@ -192,14 +216,18 @@ namespace Lindwurm::Lib
             return 0;
         }
 
-        if ( m_canInterface->flexibleDataRateEnabled() )
-        {
-            return 64;
-        }
-        else
+        // CAN FD frames longer than 8 bytes are always padded to the next valid data length
+        return 8;
+    }
+
+    IsoTpFrameFormat IsoTransportProtocol::frameFormat() const
+    {
+        if ( ! m_canInterface->flexibleDataRateEnabled() )
         {
-            return 8;
+            return IsoTpFrameFormat::Classic;
         }
+
+        return m_useBitrateSwitch ? IsoTpFrameFormat::FlexibleDataRateBrs : IsoTpFrameFormat::FlexibleDataRate;
     }
 
     void IsoTransportProtocol::resetSendConnection()
@@ -209,13 +237,16 @@ namespace Lindwurm::Lib
 
         m_sendConnection.state                  = IsoTpConnectionState::Idle;
         m_sendConnection.dataLength             = 0;
+        m_sendConnection.dataOffset             = 0;
+        m_sendConnection.frameFormat            = IsoTpFrameFormat::Classic;
+        m_sendConnection.frameDataLength        = 0;
         m_sendConnection.blockSize              = 0;
         m_sendConnection.minSeparationTime      = 0;
         m_sendConnection.currentBlockNumber     = 0;
         m_sendConnection.currentSequenceNumber  = 1;
         m_sendConnection.currentWaitCycle       = 0;
 
-        m_dataToSentCopy.clear();
+        m_waitingForTransmitQueue = false;
     }
 
     void IsoTransportProtocol::resetReceiveConnection()
@@ -225,6 +256,9 @@ namespace Lindwurm::Lib
 
         m_receiveConnection.state                  = IsoTpConnectionState::Idle;
         m_receiveConnection.dataLength             = 0;
+        m_receiveConnection.dataOffset             = 0;
+        m_receiveConnection.frameFormat            = IsoTpFrameFormat::Classic;
+        m_receiveConnection.frameDataLength        = 0;
         m_receiveConnection.blockSize              = DEFAULT_BLOCK_SIZE;
         m_receiveConnection.minSeparationTime      = DEFAULT_SEPARATION_TIME;
         m_receiveConnection.currentBlockNumber     = 0;
@@ -252,9 +286,38 @@ namespace Lindwurm::Lib
     {
         qDebug(LOG_TAG) << "First frame received. Entering receiveing state.";
 
-        m_receiveConnection.state       = IsoTpConnectionState::Transmission;
-        m_receiveConnection.dataLength  = tpFrame.dataLength();
-        m_receiveConnection.data        = tpFrame.data();
+        // flow control frames are answered in the format of the sender
+        const QCanBusFrame canFrame = tpFrame.canFrame();
+
+        if ( canFrame.hasFlexibleDataRateFormat() )
+        {
+            m_receiveConnection.frameFormat = canFrame.hasBitrateSwitch() ? IsoTpFrameFormat::FlexibleDataRateBrs : IsoTpFrameFormat::FlexibleDataRate;
+        }
+        else
+        {
+            m_receiveConnection.frameFormat = IsoTpFrameFormat::Classic;
+        }
+
+        if ( tpFrame.dataLength() > MAX_RECEIVE_DATA_LENGTH )
+        {
+            qWarning(LOG_TAG) << "Refusing message of" << tpFrame.dataLength() << "bytes, which exceeds the receive buffer.";
+
+            sendFlowControlFrame(IsoTpFlowStatus::Overflow);
+            resetReceiveConnection();
+
+            emit errorOccurred(IsoTpError::OverFlow);
+
+            return;
+        }
+
+        m_receiveConnection.state           = IsoTpConnectionState::Transmission;
+        m_receiveConnection.dataLength      = tpFrame.dataLength();
+        m_receiveConnection.data            = tpFrame.data();
+
+        // the first frame has the length of all following consecutive frames (RX_DL), except the last one
+        m_receiveConnection.frameDataLength = canFrame.payload().size() - 1;
+
+        m_receiveConnection.data.reserve( int(m_receiveConnection.dataLength) );
 
         sendFlowControlFrame();
 
@@ -277,11 +340,11 @@ namespace Lindwurm::Lib
         }
 
         // current received bytes + maximum bytes of one consecutive frame
-        bool isLastFrame = (m_receiveConnection.data.size() + 7) >= m_receiveConnection.dataLength;
+        bool isLastFrame = (m_receiveConnection.data.size() + m_receiveConnection.frameDataLength) >= m_receiveConnection.dataLength;
 
         if ( isLastFrame )
         {
-            int remainingBytes = m_receiveConnection.dataLength - m_receiveConnection.data.size();
+            int remainingBytes = int( m_receiveConnection.dataLength - m_receiveConnection.data.size() );
 
             QByteArray remainingData = tpFrame.data();
 
@@ -331,9 +394,9 @@ namespace Lindwurm::Lib
         m_receiveConnection.timeoutTimer.start();
     }
 
-    void IsoTransportProtocol::sendFlowControlFrame()
+    void IsoTransportProtocol::sendFlowControlFrame(IsoTpFlowStatus flowStatus)
     {
-        IsoTransportProtocolFrame flowControlFrame = IsoTransportProtocolFrame::flowControlFrame(m_sourceAddress, IsoTpFlowStatus::ClearToSend, DEFAULT_BLOCK_SIZE, DEFAULT_SEPARATION_TIME, paddingSize() );
+        IsoTransportProtocolFrame flowControlFrame = IsoTransportProtocolFrame::flowControlFrame(m_sourceAddress, flowStatus, DEFAULT_BLOCK_SIZE, DEFAULT_SEPARATION_TIME, paddingSize(), m_receiveConnection.frameFormat );
 
         if ( flowControlFrame.isValid() )
         {
@@ -343,7 +406,7 @@ namespace Lindwurm::Lib
 
     bool IsoTransportProtocol::sendSingleFrame(const QByteArray &data)
     {
-        IsoTransportProtocolFrame singleFrame = IsoTransportProtocolFrame::singleFrame(m_sourceAddress, data, paddingSize() );
+        IsoTransportProtocolFrame singleFrame = IsoTransportProtocolFrame::singleFrame(m_sourceAddress, data, paddingSize(), m_sendConnection.frameFormat );
 
         return m_canInterface->sendFrame( singleFrame.canFrame() );
     }
@@ -365,9 +428,16 @@ namespace Lindwurm::Lib
             return false;
         }
 
-        if ( data.size() <= 7 )
+        // the format is determined once per message, as querying the interface may block
+        m_sendConnection.frameFormat = frameFormat();
+
+        if ( data.size() <= IsoTransportProtocolFrame::singleFrameCapacity(m_sendConnection.frameFormat) )
         {
-            if ( sendSingleFrame(data) == true )
+            const bool sent = sendSingleFrame(data);
+
+            resetSendConnection();
+
+            if ( sent )
             {
                 emit dataSent(data);
                 return true;
@@ -376,7 +446,6 @@ namespace Lindwurm::Lib
         else
         {
             m_sendConnection.data = data;
-            m_dataToSentCopy = data;
 
             return sendFirstFrame();
         }
@@ -386,19 +455,25 @@ namespace Lindwurm::Lib
 
     bool IsoTransportProtocol::sendFirstFrame()
     {
-        if ( m_sendConnection.data.size() > 4096 )
+        const qint64 dataLength = m_sendConnection.data.size();
+
+        if ( dataLength > IsoTransportProtocolFrame::MaxDataLength )
         {
-            qCritical(LOG_TAG) << "Sending data with size > 4096 is not supported with ISO-TP!";
+            qCritical(LOG_TAG) << "Sending data with size > 4 GiB is not supported with ISO-TP!";
 
             resetSendConnection();
 
             return false;
         }
 
-        m_sendConnection.state = IsoTpConnectionState::Transmission;
+        m_sendConnection.state              = IsoTpConnectionState::Transmission;
+        m_sendConnection.dataLength         = dataLength;
+        m_sendConnection.frameDataLength    = IsoTransportProtocolFrame::consecutiveFrameCapacity(m_sendConnection.frameFormat);
 
-        IsoTransportProtocolFrame firstFrame = IsoTransportProtocolFrame::firstFrame(m_sourceAddress, m_sendConnection.data.size(), m_sendConnection.data.left(6) );
-        m_sendConnection.data.remove(0, 6);
+        const int firstFrameDataLength = IsoTransportProtocolFrame::firstFrameCapacity(m_sendConnection.frameFormat, dataLength);
+
+        IsoTransportProtocolFrame firstFrame = IsoTransportProtocolFrame::firstFrame(m_sourceAddress, dataLength, m_sendConnection.data.left(firstFrameDataLength), m_sendConnection.frameFormat );
+        m_sendConnection.dataOffset = firstFrameDataLength;
 
         if ( m_canInterface->sendFrame( firstFrame.canFrame() ) == false )
         {
@@ -458,27 +533,56 @@ namespace Lindwurm::Lib
 
     bool IsoTransportProtocol::sendNextConsecutiveFrame()
     {
-        IsoTransportProtocolFrame consecutiveFrame = IsoTransportProtocolFrame::consecutiveFrame(m_sourceAddress, m_sendConnection.currentSequenceNumber, m_sendConnection.data.left(7), paddingSize() );
-        m_sendConnection.data.remove(0, 7);
+        const QByteArray frameData = m_sendConnection.data.mid(m_sendConnection.dataOffset, m_sendConnection.frameDataLength);
+
+        IsoTransportProtocolFrame consecutiveFrame = IsoTransportProtocolFrame::consecutiveFrame(m_sourceAddress, m_sendConnection.currentSequenceNumber, frameData, paddingSize(), m_sendConnection.frameFormat );
+
+        if ( ! m_canInterface->sendFrame( consecutiveFrame.canFrame() ) )
+        {
+            return false;
+        }
 
+        // the data is kept intact and only advanced after the frame was queued, so a rejected frame can be sent again
+        m_sendConnection.dataOffset += frameData.size();
         m_sendConnection.currentSequenceNumber = (m_sendConnection.currentSequenceNumber + 1) % 16;
 
-        return m_canInterface->sendFrame( consecutiveFrame.canFrame() );
+        return true;
+    }
+
+    void IsoTransportProtocol::transmitQueueReady()
+    {
+        if ( ! m_waitingForTransmitQueue )
+        {
+            return;
+        }
+
+        m_waitingForTransmitQueue = false;
+        m_sendConnection.timeoutTimer.stop();
+
+        continueSending();
     }
 
     void IsoTransportProtocol::continueSending()
     {
         do
         {
-            sendNextConsecutiveFrame();
+            if ( ! sendNextConsecutiveFrame() )
+            {
+                // the transmit queue of the interface is full, continue as soon as it has drained
+                // if the interface does not recover, the transmission times out
+                m_waitingForTransmitQueue = true;
+                m_sendConnection.timeoutTimer.start();
+
+                return;
+            }
 
-            if ( m_sendConnection.data.size() == 0 )
+            if ( m_sendConnection.dataOffset >= m_sendConnection.data.size() )
             {
-                QByteArray sentDataLocalCopy = m_dataToSentCopy;
+                QByteArray sentData = m_sendConnection.data;
 
                 resetSendConnection();
 
-                emit dataSent(sentDataLocalCopy);
+                emit dataSent(sentData);
 
                 return;
             }
@@ -38,6 +38,10 @@ namespace Lindwurm::Lib
         {
             case 0:
                         if ( m_canFrame.payload().size() < 2)   return;
+
+                        // single frames of CAN FD frames longer than 8 bytes have their length in the second byte
+                        if ( (m_canFrame.payload().at(0) & 0x0F) == 0 && m_canFrame.payload().size() < 3 )   return;
+
                         m_frameType = Type::SingleFrame;
                         break;
 
@@ -66,55 +70,64 @@ namespace Lindwurm::Lib
         return IsoTransportProtocolFrame(canFrame);
     }
 
-    IsoTransportProtocolFrame IsoTransportProtocolFrame::singleFrame(quint32 frameId, const QByteArray &data, int paddingSize)
+    IsoTransportProtocolFrame IsoTransportProtocolFrame::singleFrame(quint32 frameId, const QByteArray &data, int paddingSize, IsoTpFrameFormat format)
     {
-        if ( (data.size() > 7) || (data.size() < 1) )
+        if ( (data.size() > singleFrameCapacity(format)) || (data.size() < 1) )
         {
             return IsoTransportProtocolFrame();
         }
 
         QByteArray payload;
 
-        payload.push_front( static_cast<char>( data.size() ) );
-        payload.push_back( data );
-
-        if (paddingSize > 0)
+        if ( data.size() <= 7 )
         {
-            appendPadding(payload, paddingSize);
+            payload.push_front( static_cast<char>( data.size() ) );
+        }
+        else
+        {
+            // escape sequence for CAN FD frames longer than 8 bytes: the length follows the zero length nibble
+            payload.append( '\x00' );
+            payload.append( static_cast<char>( data.size() ) );
         }
 
-        QCanBusFrame canFrame;
-
-        canFrame.setFrameId(frameId);
-        canFrame.setPayload(payload);
+        payload.push_back( data );
 
-        return IsoTransportProtocolFrame(canFrame);
+        return IsoTransportProtocolFrame( createCanFrame(frameId, payload, paddingSize, format) );
     }
 
-    IsoTransportProtocolFrame IsoTransportProtocolFrame::firstFrame(quint32 frameId, int totalDataLength, const QByteArray &data)
+    IsoTransportProtocolFrame IsoTransportProtocolFrame::firstFrame(quint32 frameId, qint64 totalDataLength, const QByteArray &data, IsoTpFrameFormat format)
     {
-        if ( (totalDataLength > 4096) || (data.size() > 6) )
+        if ( (totalDataLength > MaxDataLength) || (data.size() > firstFrameCapacity(format, totalDataLength)) )
         {
             return IsoTransportProtocolFrame();
         }
 
         QByteArray payload;
 
-        payload.append( 0x10 + ( (totalDataLength >> 8) & 0x0F) );
-        payload.append( totalDataLength & 0xFF );
-        payload.append( data );
-
-        QCanBusFrame canFrame;
+        if ( totalDataLength <= MaxShortDataLength )
+        {
+            payload.append( 0x10 + ( (totalDataLength >> 8) & 0x0F) );
+            payload.append( totalDataLength & 0xFF );
+        }
+        else
+        {
+            // escape sequence: a zero 12 bit length is followed by the 32 bit length
+            payload.append( 0x10 );
+            payload.append( '\x00' );
+            payload.append( (totalDataLength >> 24) & 0xFF );
+            payload.append( (totalDataLength >> 16) & 0xFF );
+            payload.append( (totalDataLength >> 8) & 0xFF );
+            payload.append( totalDataLength & 0xFF );
+        }
 
-        canFrame.setFrameId(frameId);
-        canFrame.setPayload(payload);
+        payload.append( data );
 
-        return IsoTransportProtocolFrame(canFrame);
+        return IsoTransportProtocolFrame( createCanFrame(frameId, payload, 0, format) );
     }
 
-    IsoTransportProtocolFrame IsoTransportProtocolFrame::consecutiveFrame(quint32 frameId, quint8 sequenceNumber, const QByteArray &data, int paddingSize)
+    IsoTransportProtocolFrame IsoTransportProtocolFrame::consecutiveFrame(quint32 frameId, quint8 sequenceNumber, const QByteArray &data, int paddingSize, IsoTpFrameFormat format)
     {
-        if ( (data.size() < 1) || (data.size() > 7) || (sequenceNumber > 15) )
+        if ( (data.size() < 1) || (data.size() > consecutiveFrameCapacity(format)) || (sequenceNumber > 15) )
         {
             return IsoTransportProtocolFrame();
         }
@@ -124,17 +137,10 @@ namespace Lindwurm::Lib
         payload.append( 0x20 + ( sequenceNumber & 0x0F) );
         payload.append( data );
 
-        appendPadding(payload, paddingSize);
-
-        QCanBusFrame canFrame;
-
-        canFrame.setFrameId(frameId);
-        canFrame.setPayload(payload);
-
-        return IsoTransportProtocolFrame(canFrame);
+        return IsoTransportProtocolFrame( createCanFrame(frameId, payload, paddingSize, format) );
     }
 
-    IsoTransportProtocolFrame IsoTransportProtocolFrame::flowControlFrame(quint32 frameId, IsoTpFlowStatus flowStatus, int blockSize, int separationTime, int paddingSize)
+    IsoTransportProtocolFrame IsoTransportProtocolFrame::flowControlFrame(quint32 frameId, IsoTpFlowStatus flowStatus, int blockSize, int separationTime, int paddingSize, IsoTpFrameFormat format)
     {
         if ( (blockSize > 255) || (separationTime > 255) )
         {
@@ -147,17 +153,35 @@ namespace Lindwurm::Lib
         payload.append( static_cast<unsigned char>(blockSize) );
         payload.append( static_cast<unsigned char>(separationTime) );
 
-        if (paddingSize > 0)
+        return IsoTransportProtocolFrame( createCanFrame(frameId, payload, paddingSize, format) );
+    }
+
+    int IsoTransportProtocolFrame::maxFrameLength(IsoTpFrameFormat format)
+    {
+        return (format == IsoTpFrameFormat::Classic) ? 8 : 64;
+    }
+
+    int IsoTransportProtocolFrame::singleFrameCapacity(IsoTpFrameFormat format)
+    {
+        if ( format == IsoTpFrameFormat::Classic )
         {
-            appendPadding(payload, paddingSize);
+            return 7;
         }
 
-        QCanBusFrame canFrame;
+        // two bytes protocol control information with escape sequence
+        return maxFrameLength(format) - 2;
+    }
 
-        canFrame.setFrameId(frameId);
-        canFrame.setPayload(payload);
+    int IsoTransportProtocolFrame::firstFrameCapacity(IsoTpFrameFormat format, qint64 totalDataLength)
+    {
+        const int pciSize = (totalDataLength <= MaxShortDataLength) ? 2 : 6;
 
-        return IsoTransportProtocolFrame(canFrame);
+        return maxFrameLength(format) - pciSize;
+    }
+
+    int IsoTransportProtocolFrame::consecutiveFrameCapacity(IsoTpFrameFormat format)
+    {
+        return maxFrameLength(format) - 1;
     }
 
     IsoTransportProtocolFrame::Type IsoTransportProtocolFrame::frameType() const
@@ -175,12 +199,18 @@ namespace Lindwurm::Lib
         return m_frameType != Type::Invalid;
     }
 
-    int IsoTransportProtocolFrame::dataLength() const
+    qint64 IsoTransportProtocolFrame::dataLength() const
     {
         switch ( m_frameType )
         {
             case Type::SingleFrame:
 
+                if ( (m_canFrame.payload().at(0) & 0x0F) == 0 )
+                {
+                    // escape sequence of CAN FD single frames
+                    return static_cast<quint8>( m_canFrame.payload().at(1) );
+                }
+
                 return (m_canFrame.payload().at(0) & 0x0F);
 
             case Type::FirstFrame:
@@ -188,12 +218,27 @@ namespace Lindwurm::Lib
                 quint8 msb = m_canFrame.payload().at(0) & 0x0F;
                 quint8 lsb = m_canFrame.payload().at(1);
 
-                return (static_cast<quint16>(msb) << 8) | (static_cast<quint16>(lsb) );
+                const qint64 shortDataLength = (static_cast<quint16>(msb) << 8) | (static_cast<quint16>(lsb) );
+
+                if ( shortDataLength != 0 )
+                {
+                    return shortDataLength;
+                }
+
+                // escape sequence for messages exceeding 4095 bytes: 32 bit length
+                qint64 dataLength = 0;
+
+                for (int i = 2; i < 6; i++)
+                {
+                    dataLength = (dataLength << 8) | static_cast<quint8>( m_canFrame.payload().at(i) );
+                }
+
+                return dataLength;
             }
 
             case Type::ConsecutiveFrame:
 
-                // consecutive frames usually have 7 bytes data (8 byte CAN frame -1 byte for PCI)
+                // consecutive frames usually have the full frame length as data (8 or 64 byte CAN frame -1 byte for PCI)
                 // last consecutive frame may have fewer bytes (if no padding is used): payload length -1 byte for PCI
                 // if padding is used dataLength will include this padding bytes - must be cut according to dataLength from first frame
                 return m_canFrame.payload().size() - 1;
@@ -264,15 +309,12 @@ namespace Lindwurm::Lib
         {
             case Type::SingleFrame:
 
-                return m_canFrame.payload().mid(1, dataLength() );
+                return m_canFrame.payload().mid( dataOffset(), int( dataLength() ) );
 
             case Type::FirstFrame:
-
-                return m_canFrame.payload().mid(2, -1);
-
             case Type::ConsecutiveFrame:
 
-                return m_canFrame.payload().mid(1, -1);
+                return m_canFrame.payload().mid( dataOffset(), -1 );
 
             default:
                 break;
@@ -281,6 +323,19 @@ namespace Lindwurm::Lib
         return QByteArray();
     }
 
+    int IsoTransportProtocolFrame::dataOffset() const
+    {
+        const bool lengthEscaped = (m_canFrame.payload().at(0) & 0x0F) == 0;
+
+        switch ( m_frameType )
+        {
+            case Type::SingleFrame:         return lengthEscaped ? 2 : 1;
+            case Type::FirstFrame:          return (lengthEscaped && m_canFrame.payload().at(1) == 0) ? 6 : 2;
+            case Type::ConsecutiveFrame:    return 1;
+            default:                        return 0;
+        }
+    }
+
     quint8 IsoTransportProtocolFrame::flowStatusToNumber(IsoTpFlowStatus status)
     {
         switch (status)
@@ -315,4 +370,49 @@ namespace Lindwurm::Lib
             payload.append('\x00');
         }
     }
+
+    QCanBusFrame IsoTransportProtocolFrame::createCanFrame(quint32 frameId, QByteArray payload, int paddingSize, IsoTpFrameFormat format)
+    {
+        if ( paddingSize > 0 )
+        {
+            appendPadding(payload, paddingSize);
+        }
+
+        QCanBusFrame canFrame;
+
+        canFrame.setFrameId(frameId);
+
+        if ( format != IsoTpFrameFormat::Classic )
+        {
+            // CAN FD frames longer than 8 bytes must be padded to the next valid data length
+            appendPadding( payload, validFrameLength( payload.size() ) );
+
+            canFrame.setFlexibleDataRateFormat(true);
+            canFrame.setBitrateSwitch( format == IsoTpFrameFormat::FlexibleDataRateBrs );
+        }
+
+        canFrame.setPayload(payload);
+
+        return canFrame;
+    }
+
+    int IsoTransportProtocolFrame::validFrameLength(int payloadSize)
+    {
+        static const int validLengths[] = { 12, 16, 20, 24, 32, 48, 64 };
+
+        if ( payloadSize <= 8 )
+        {
+            return payloadSize;
+        }
+
+        for (int length : validLengths)
+        {
+            if ( payloadSize <= length )
+            {
+                return length;
+            }
+        }
+
+        return 64;
+    }
 }
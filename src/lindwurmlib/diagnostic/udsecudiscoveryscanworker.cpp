@@ -35,6 +35,7 @@ namespace Lindwurm::Lib
         , m_delayVerificationTimer(this)
     {
         qRegisterMetaType<QCanBusFrame>();
+        qRegisterMetaType<QVector<QCanBusFrame>>();
 
         m_responseTimeoutTimer.setSingleShot(true);
         m_responseTimeoutTimer.setInterval(m_responseTimeoutMsec);
@@ -48,7 +49,7 @@ namespace Lindwurm::Lib
         m_currentScannedAddress = m_startAddress;
         m_discoveryState        = DiscoveryState::Scanning;
 
-        connect(m_canInterface.get(),       &ICanInterfaceHandle::frameReceived, this, &UdsEcuDiscoveryScanWorker::canFrameReceived);
+        connect(m_canInterface.get(),       &ICanInterfaceHandle::framesReceived, this, &UdsEcuDiscoveryScanWorker::canFramesReceived);
 
         connect(&m_responseTimeoutTimer,    &QTimer::timeout, this, &UdsEcuDiscoveryScanWorker::responseTimeout);
         connect(&m_delayVerificationTimer,  &QTimer::timeout, this, &UdsEcuDiscoveryScanWorker::startVerification);
@@ -73,10 +74,18 @@ namespace Lindwurm::Lib
         return false;
     }
 
-    void UdsEcuDiscoveryScanWorker::canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface)
+    void UdsEcuDiscoveryScanWorker::canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface)
     {
         Q_UNUSED(sourceInterface)
 
+        for (const QCanBusFrame &frame : frames)
+        {
+            processCanFrame(frame);
+        }
+    }
+
+    void UdsEcuDiscoveryScanWorker::processCanFrame(const QCanBusFrame &frame)
+    {
         if ( (! frame.isValid() ) || frame.hasLocalEcho() )
         {
             // this is a self-sent frame
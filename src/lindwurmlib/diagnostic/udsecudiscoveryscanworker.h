@@ -23,8 +23,10 @@
 #include <QTimer>
 #include <QCanBusFrame>
 #include <QSet>
+#include <QVector>
 
 #include "caninterface/icaninterfacehandlesharedptr.h"
+#include "caninterface/caninterfaceindex.h"
 
 namespace Lindwurm::Lib
 {
@@ -49,7 +51,7 @@ namespace Lindwurm::Lib
 
         private slots:
 
-            void    canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface);
+            void    canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
             void    scanCurrentAddress();
             void    responseTimeout();
             void    startVerification();
@@ -57,6 +59,7 @@ namespace Lindwurm::Lib
         private:
 
             bool    isValidResponse(const QCanBusFrame &frame) const;
+            void    processCanFrame(const QCanBusFrame &frame);
 
             enum class DiscoveryState
             {
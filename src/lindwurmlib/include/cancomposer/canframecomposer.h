@@ -58,6 +58,7 @@ namespace Lindwurm::Lib
         private slots:
 
             void            sendNextFrame();
+            void            transmitQueueReady();
 
         private:
 
@@ -71,6 +72,9 @@ namespace Lindwurm::Lib
             unsigned int                    m_updateFrameCounter;
             unsigned int                    m_updateFrameLimit;
             bool                            m_loopComposing;
+            QCanBusFrame                    m_rejectedFrame;
+            bool                            m_frameRejected;
+            bool                            m_waitingForTransmitQueue;
     };
 }
 
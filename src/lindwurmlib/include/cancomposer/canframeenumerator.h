@@ -38,6 +38,14 @@ namespace Lindwurm::Lib
      * 7F0 00 11 22
      * 7F1 00 11 22
      * `
+     *
+     * CAN FD frames are marked like in candump logs by appending `##` and an optional flags nibble to the
+     * frame ID, where `1` sets the bit rate switch and `2` the error state indicator. Frames with more than
+     * 8 bytes of payload are always sent as CAN FD frames:
+     *
+     * `
+     * 7F0##1 00 11 22 33 44 55 66 77 88 99 AA BB
+     * `
      */
     class LINDWURMLIB_EXPORT CanFrameEnumerator
     {
@@ -84,6 +92,7 @@ namespace Lindwurm::Lib
 
         private:
 
+            bool                    parseFrameFormat(QString& idElement);
             bool                    parseFrameID(const QString& idElement);
             bool                    parseStaticPayload(const QStringList& payloadElements);
 
@@ -92,6 +101,9 @@ namespace Lindwurm::Lib
             quint32                 m_startFrameID = {0};
             quint32                 m_endFrameID = {0};
             quint32                 m_currentFrameID = {0};
+            bool                    m_flexibleDataRate = {false};
+            bool                    m_bitrateSwitch = {false};
+            bool                    m_errorStateIndicator = {false};
             bool                    m_hasStaticPayload = {true};
             QByteArray              m_staticPayload = {};
             ByteArrayEnumerator     m_dynamicPayload = {};
@@ -20,7 +20,15 @@
 
 #include "lindwurmlib_global.h"
 #include "icaninterface.h"
+#include "canframedispatchtable.h"
+#include "cantransmitqueue.h"
+#include "cantransmitscheduler.h"
 #include <QStringList>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include <atomic>
 
 namespace Lindwurm::Lib
 {
@@ -42,10 +50,12 @@ namespace Lindwurm::Lib
 
             virtual QString         id() const override;
             virtual QString         name() const override;
+            virtual CanInterfaceIndex interfaceIndex() const override;
             virtual QString         interfaceType() const override;
             virtual QString         device() const override;
 
             virtual void            setName(const QString &name) override;
+            virtual void            setInterfaceIndex(CanInterfaceIndex interfaceIndex) override;
 
             virtual void            mountComponent(const QString &component) override;
             virtual void            unmountComponent(const QString &component) override;
@@ -53,6 +63,100 @@ namespace Lindwurm::Lib
             virtual bool            isMounted() const override;
             virtual QStringList     mountedComponents() const override;
 
+            virtual void            attachReceiver(const CanFrameReceiverSharedPtr &receiver) override;
+            virtual void            detachReceiver(const CanFrameReceiverSharedPtr &receiver) override;
+            virtual void            setReceiverFilters(const CanFrameReceiverSharedPtr &receiver, const CanIdFilters &filters) override;
+
+            virtual bool            sendFrame(const QCanBusFrame &frame) override;
+            virtual int             sendFrames(const QVector<QCanBusFrame> &frames) override;
+            virtual int             transmitQueueDepth() const override;
+            virtual CanTransmitStatistics transmitStatistics() const override;
+            virtual CanInterfaceStatistics statistics() const override;
+
+            virtual int             targetBusLoad() const override;
+            virtual void            setTargetBusLoad(int percent) override;
+
+        protected:
+
+            /**
+             * @brief Called after frames were appended to the transmit queue.
+             *
+             * Implementations write the queued frames to the driver (usually in their I/O thread), take them from
+             * the queue with peekTransmitQueue() and report the result with acknowledgeTransmittedFrames(). This
+             * method may be called from any thread.
+             */
+            virtual void            transmitQueuedFrames() = 0;
+
+            /**
+             * @brief Returns the frames at the front of the transmit queue without removing them.
+             * @param maxCount the maximum number of frames to return.
+             * @return the frames to write next.
+             */
+            QVector<QCanBusFrame>   peekTransmitQueue(int maxCount) const;
+
+            /**
+             * @brief Removes handled frames from the transmit queue.
+             *
+             * Do not call signals of this interface while holding locks the senders might need, as they
+             * may send further frames from the connected slots.
+             *
+             * @param writtenCount  the number of frames written to the driver.
+             * @param failedCount   the number of frames the driver refused (following the written frames).
+             * @return `true` if the queue has drained and readyToSend() has to be emitted by notifyTransmitQueue().
+             */
+            bool                    acknowledgeTransmittedFrames(int writtenCount, int failedCount = 0);
+
+            /**
+             * @brief Counts frames lost by the driver or kernel because its receive queue overflowed.
+             *
+             * Interfaces which are able to detect such losses report them here, so they show up in statistics().
+             *
+             * @param droppedCount the number of frames lost since the last call.
+             */
+            void                    countOverflowFrames(quint64 droppedCount);
+
+            /**
+             * @brief Discards all queued frames, e.g. when the interface gets disconnected.
+             */
+            void                    clearTransmitQueue();
+
+            /**
+             * @brief Emits the transmitQueueDepthChanged() and, if requested, the readyToSend() signal.
+             * @param drained set to `true` to emit the readyToSend() signal.
+             */
+            void                    notifyTransmitQueue(bool drained);
+
+            /**
+             * @brief Called whenever the union of the filters of all attached receivers changes.
+             *
+             * Interfaces which are able to filter frames in the driver or kernel reimplement this method. Frames are
+             * filtered for each receiver in any case, so an implementation may pass more frames than requested.
+             * The default implementation does nothing.
+             *
+             * @param filters the union of all receiver filters; an empty set requests all frames.
+             */
+            virtual void            applyFrameFilters(const CanIdFilters &filters);
+
+            /**
+             * @brief Delivers received frames to all attached receivers and emits the framesReceived() signal.
+             *
+             * This method is intended to be called from the I/O thread of the interface.
+             *
+             * @param frames            the received frames.
+             * @param sourceInterface   the index of the interface the frames were received from.
+             */
+            void                    dispatchFrames(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+
+            /**
+             * @brief Checks whether any attached receiver is falling behind.
+             *
+             * Interfaces which are able to pace the frames they deliver (e.g. a replay) wait while this returns `true`
+             * instead of overflowing the receivers.
+             *
+             * @return `true` if the ring of any attached receiver is filled to at least half of its capacity.
+             */
+            bool                    receiversBacklogged() const;
+
         protected:
 
             QString         m_id;
@@ -60,6 +164,51 @@ namespace Lindwurm::Lib
             QString         m_interfaceType;
             QString         m_device;
             QStringList     m_mountedComponents;
+
+            std::atomic<CanInterfaceIndex>      m_interfaceIndex = { InvalidCanInterfaceIndex };
+
+            // implementations keep the bit rates up to date and admit frames before writing them to the driver
+            CanTransmitScheduler                m_transmitScheduler;
+
+        private:
+
+            /**
+             * @brief The StatisticsSample struct holds the counters the rates of statistics() are calculated from.
+             */
+            struct StatisticsSample
+            {
+                qint64      timeNSecs = {0};
+                quint64     rxFrames = {0};
+                quint64     rxBytes = {0};
+                quint64     txFrames = {0};
+                quint64     txBytes = {0};
+                quint64     busTimeNSecs = {0};
+            };
+
+            void                    countFrames(const QVector<QCanBusFrame> &frames, bool received);
+            void                    updateFrameFilters();
+            void                    deliverFiltered(const CanFrameReceiverSharedPtr &receiver, const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+
+            mutable QMutex                      m_nameMutex;
+            mutable QMutex                      m_receiversMutex;
+            QVector<CanFrameReceiverSharedPtr>  m_receivers;
+            CanIdFilters                        m_frameFilters;
+            CanFrameDispatchTable               m_dispatchTable;
+            CanTransmitQueue                    m_transmitQueue;
+
+            // counted by the I/O threads, so reading the statistics never blocks them
+            std::atomic<quint64>                m_rxFrames = { 0 };
+            std::atomic<quint64>                m_rxBytes = { 0 };
+            std::atomic<quint64>                m_txFrames = { 0 };
+            std::atomic<quint64>                m_txBytes = { 0 };
+            std::atomic<quint64>                m_errorFrames = { 0 };
+            std::atomic<quint64>                m_overflowFrames = { 0 };
+            std::atomic<quint64>                m_busTimeNSecs = { 0 };
+
+            mutable QMutex                      m_statisticsMutex;
+            QElapsedTimer                       m_statisticsClock;
+            mutable StatisticsSample            m_statisticsSample;
+            mutable CanInterfaceStatistics      m_statisticsRates;
     };
 }
 
@@ -21,11 +21,54 @@
 #include "lindwurmlib_global.h"
 #include "abstractcaninterface.h"
 #include "icaninterfacesharedptr.h"
+#include "canframereceiver.h"
+#include "canroutingrule.h"
 #include <QList>
 #include <QStringList>
+#include <QMutex>
+#include <QThread>
+
+#include <array>
+#include <atomic>
 
 namespace Lindwurm::Lib
 {
+    class CanRoutingTable;
+
+    /**
+     * @brief The CanBridgeLatencyHistogram struct holds the forwarding latencies of one bridge direction.
+     *
+     * The latency of a frame is the time between its delivery by the source interface to the bridge and the moment
+     * it was handed to the target interface, both taken from the steady clock. The timestamp of the frame itself is
+     * not used, as it may be taken by a driver or the hardware or may even be recorded. The latencies are counted in logarithmic buckets: bucket 0 counts
+     * latencies below 1 µs, bucket `n` counts latencies from 2^(n-1) µs up to (but excluding) 2^n µs. The last
+     * bucket also counts all larger latencies.
+     */
+    struct LINDWURMLIB_EXPORT CanBridgeLatencyHistogram
+    {
+        static const int BucketCount = 24;
+
+        /**
+         * @brief Returns the bucket index for a specific latency.
+         * @param latencyUSecs the latency in microseconds.
+         * @return the index of the bucket counting this latency.
+         */
+        static int      bucketIndex(qint64 latencyUSecs);
+
+        /**
+         * @brief Returns an upper bound of a specific percentile of the latencies (e.g. 0.99 for the 99th percentile).
+         * @param fraction the percentile as a fraction between 0 and 1.
+         * @return the upper bound in microseconds of the bucket containing the percentile or 0 if no frames were counted.
+         */
+        qint64          percentileUSecs(double fraction) const;
+
+        QString                                 sourceInterfaceId = {};
+        QString                                 targetInterfaceId = {};
+        quint64                                 frameCount = {0};
+        qint64                                  maxLatencyUSecs = {0};
+        std::array<quint64, BucketCount>        buckets = {};
+    };
+
     /**
      * @brief The CanBridge class allows to bridge two or multiple CAN busses.
      *
@@ -34,6 +77,19 @@ namespace Lindwurm::Lib
      * and it will be broadcasted to all bridged interfaces. Also each frame which is received
      * on a mounted interface will be forwarded to all bridged interfaces.
      *
+     * Frames are forwarded by a dedicated forwarding thread. The I/O threads of the mounted interfaces push the
+     * received frames into a ring per mounted interface (a bridge port), which is drained by the forwarding thread
+     * and sent to all other ports. So neither the GUI thread nor any string comparison is involved on the
+     * forwarding path. The latencies of each direction are recorded, see forwardingLatencies().
+     *
+     * Frames sent to the bridge are queued in its transmit queue and passed on to all ports. A frame leaves the
+     * queue once it was handed to every port, frames a full port rejects are retried when it emits readyToSend().
+     * So the bridge emits readyToSend() itself when its queue has drained.
+     *
+     * Which frames are forwarded in which direction is defined by routing rules (see setRoutingRules()).
+     * The rules are compiled into a lookup table, so routing a frame takes constant time independent of the
+     * number of rules.
+     *
      * As all ICanInterface instances a CanBridge should only be created with
      * CanInterfaceManager::addInterface(). To mount and unmount specific interfaces from the bridge
      * use CanInterfaceManager::editInterface.
@@ -49,7 +105,6 @@ namespace Lindwurm::Lib
             virtual bool    connectInterface() override;
             virtual bool    disconnectInterface() override;
 
-            virtual bool    sendFrame(const QCanBusFrame &frame) override;
             virtual QString device() const override;
 
             virtual bool    connected() const override;
@@ -58,6 +113,7 @@ namespace Lindwurm::Lib
             virtual int     bitRate() const override;
             virtual int     dataBitRate() const override;
             virtual bool    localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
 
             virtual void    setFlexibleDataRateEnabled(bool enabled) override;
             virtual void    setBitRate(int bitRate) override;
@@ -84,14 +140,78 @@ namespace Lindwurm::Lib
              */
             QStringList     bridgedInterfaceIds() const;
 
-        private slots:
+            /**
+             * @brief Provides the forwarding latency histograms of all directions of the bridge.
+             *
+             * Each pair of mounted interfaces results in two directions. The histograms are reset as soon as an
+             * interface is mounted or unmounted.
+             *
+             * @return a snapshot of the histograms of all directions.
+             */
+            QVector<CanBridgeLatencyHistogram> forwardingLatencies() const;
 
-            void            frameReceivedForBridge(const QCanBusFrame &frame, const QString &sourceInterface);
+            /**
+             * @brief Replaces the routing rules of the bridge.
+             *
+             * The rules are applied immediately, even while the bridge is connected.
+             *
+             * @param rules         the routing rules, the first matching rule is applied to a frame.
+             * @param defaultAction the action for frames without a matching rule (CanRoutingAction::Remap is treated as CanRoutingAction::Forward).
+             */
+            void            setRoutingRules(const CanRoutingRules &rules, CanRoutingAction defaultAction = CanRoutingAction::Forward);
+
+            /**
+             * @brief Provides the routing rules of the bridge.
+             * @return the routing rules.
+             */
+            CanRoutingRules routingRules() const;
+
+            /**
+             * @brief Provides the action for frames without a matching routing rule.
+             * @return the default routing action.
+             */
+            CanRoutingAction defaultRoutingAction() const;
+
+        protected:
+
+            virtual void    transmitQueuedFrames() override;
 
         private:
 
-            bool                                m_bridgeConnected = {false};
-            QList<ICanInterfaceSharedPtr>       m_mountedInterfaces = {};
+            /**
+             * @brief The BridgePort struct is a mounted interface together with the receiver used to forward its frames.
+             *
+             * The backlog holds the frames sent to the bridge which were not yet accepted by the interface. It is
+             * shared by the copies of the port and guarded by the transmit mutex.
+             */
+            struct BridgePort
+            {
+                ICanInterfaceSharedPtr                  interface;
+                CanFrameReceiverSharedPtr               receiver;
+                std::shared_ptr<QVector<QCanBusFrame>>  backlog;
+            };
+
+            void            forwardFrames(const CanFrameReceiver *receiver);
+            void            resetForwardingLatencies();
+            std::shared_ptr<const CanRoutingTable> compileRoutingTable() const;
+
+            std::atomic<bool>                   m_bridgeConnected = {false};
+
+            // serializes passing the frames of the transmit queue on, locked before the ports mutex
+            QMutex                              m_transmitMutex;
+
+            // the ports are modified by the bridge's thread and read by the forwarding thread
+            mutable QMutex                      m_portsMutex;
+            QVector<BridgePort>                 m_ports = {};
+            CanRoutingRules                     m_routingRules = {};
+            CanRoutingAction                    m_defaultRoutingAction = {CanRoutingAction::Forward};
+            std::shared_ptr<const CanRoutingTable> m_routingTable = {};
+
+            // histogram of direction source -> target at index source * port count + target
+            QVector<CanBridgeLatencyHistogram>  m_forwardingLatencies = {};
+
+            QThread                             m_forwardingThread;
+            QObject*                            m_forwardingContext = {nullptr};
     };
 }
 
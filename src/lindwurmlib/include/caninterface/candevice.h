@@ -22,6 +22,9 @@
 #include "abstractcaninterface.h"
 
 #include <QCanBusDevice>
+#include <QThread>
+
+#include <atomic>
 
 namespace Lindwurm::Lib
 {
@@ -33,6 +36,13 @@ namespace Lindwurm::Lib
      * the ICanInterface wrapps the lower level access. CanDevice therefore is a wrapper for
      * any QCanBusDevice instance and provides the ICanInterface API.
      *
+     * The wrapped QCanBusDevice is moved to a dedicated I/O thread, so frames are read from the driver
+     * independently of the load of the GUI thread. As QCanBusDevice is not thread-safe, all calls to the device
+     * are executed in the I/O thread; configuration calls block until the I/O thread has processed them.
+     * Frames to send are taken from the transmit queue by the I/O thread, which only hands as many frames to the
+     * QCanBusDevice as it has not yet written, so the transmit queue applies backpressure to the senders. If a
+     * target bus load is set, the frames are handed over at the pace admitted by the CanTransmitScheduler.
+     *
      * Generally, it is not neccessary to create a CanDevice instance directly. Instead use
      * CanInterfaceManager::addInterface() to instanciate a specific CAN interface.
      */
@@ -41,7 +51,15 @@ namespace Lindwurm::Lib
         Q_OBJECT
         public:
 
-            CanDevice(QCanBusDevice* canBusDevice, const QString &id, QString interfaceType, QString device);
+            /**
+             * @brief Constructs a CanDevice for the provided QCanBusDevice and moves the device to its own I/O thread.
+             * @param canBusDevice              the device to wrap; the CanDevice takes ownership.
+             * @param id                        the unique id of the interface.
+             * @param interfaceType             the QCanBus plugin the device was created with.
+             * @param device                    the name of the device.
+             * @param supportsFlexibleDataRate  `true` if the device reported CAN FD support (see QCanBusDeviceInfo::hasFlexibleDataRate()).
+             */
+            CanDevice(QCanBusDevice* canBusDevice, const QString &id, QString interfaceType, QString device, bool supportsFlexibleDataRate = false);
             virtual ~CanDevice();
 
             virtual bool    connectInterface() override;
@@ -52,24 +70,37 @@ namespace Lindwurm::Lib
             virtual int     bitRate() const override;
             virtual int     dataBitRate() const override;
             virtual bool    localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
             virtual bool    connected() const override;
 
-            virtual bool    sendFrame(const QCanBusFrame &frame) override;
-
             virtual void    setFlexibleDataRateEnabled(bool enabled) override;
             virtual void    setBitRate(int bitRate) override;
             virtual void    setDataBitRate(int dataBitRate) override;
             virtual void    setLocalEchoEnabled(bool enable) override;
 
+        protected:
+
+            virtual void    transmitQueuedFrames() override;
+
         private slots:
 
             void            stateChanged(QCanBusDevice::CanBusDeviceState state);
-            void            framesReceived();
 
         private:
 
-            QCanBusDevice*  m_canBusDevice;
-            bool            m_connected = {false};
+            void            readFrames();
+            void            writeFrames();
+
+            template <typename Function>
+            auto            runInDeviceThread(Function function) const;
+
+        private:
+
+            QCanBusDevice*      m_canBusDevice;
+            QThread             m_ioThread;
+            std::atomic<bool>   m_connected = {false};
+            std::atomic<bool>   m_writeScheduled = {false};
+            bool                m_supportsFlexibleDataRate = {false};
     };
 }
 
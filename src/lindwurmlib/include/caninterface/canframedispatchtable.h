@@ -0,0 +1,117 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANFRAMEDISPATCHTABLE_H
+#define CANFRAMEDISPATCHTABLE_H
+
+#include "lindwurmlib_global.h"
+#include "canidfilter.h"
+
+#include <QHash>
+#include <QVector>
+
+#include <array>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameDispatchTable class maps frame IDs to the subscribers interested in them.
+     *
+     * Each subscriber occupies a slot and is represented by the corresponding bit of a 64 bit mask. Looking up
+     * the subscribers of a frame ID is a single array access for standard frame IDs and a hash lookup for
+     * extended frame IDs, so the cost of dispatching a frame does not grow with the number of subscribers.
+     * Only subscriptions of extended frame ID blocks (filters with a partial mask above the standard ID range)
+     * are matched one by one.
+     */
+    class LINDWURMLIB_EXPORT CanFrameDispatchTable
+    {
+        public:
+
+            static const int MaxSubscribers = 64;
+
+            CanFrameDispatchTable();
+
+            /**
+             * @brief Sets the subscriptions of a subscriber slot.
+             * @param slot      the slot of the subscriber (0 to MaxSubscribers - 1).
+             * @param filters   the frame IDs the subscriber is interested in; an empty set subscribes all frames.
+             */
+            void            setSubscriber(int slot, const CanIdFilters &filters);
+
+            /**
+             * @brief Removes all subscriptions of a subscriber slot.
+             * @param slot the slot of the subscriber.
+             */
+            void            removeSubscriber(int slot);
+
+            /**
+             * @brief Returns the subscribers which subscribed all frames.
+             * @return the mask of the subscribers.
+             */
+            inline quint64  allFramesSubscribers() const
+            {
+                return m_allFramesSubscribers;
+            }
+
+            /**
+             * @brief Returns the subscribers of a specific frame ID.
+             * @param frameId the frame ID.
+             * @return the mask of all subscribers interested in the frame ID.
+             */
+            inline quint64  subscribers(quint32 frameId) const
+            {
+                if ( frameId < StandardFrameIdCount )
+                {
+                    return m_allFramesSubscribers | m_standardSubscribers[frameId];
+                }
+
+                quint64 subscribers = m_allFramesSubscribers | m_extendedSubscribers.value(frameId, 0);
+
+                for (const MaskedSubscription &subscription : m_maskedExtendedSubscriptions)
+                {
+                    if ( (frameId & subscription.filter.mask) == (subscription.filter.frameId & subscription.filter.mask) )
+                    {
+                        subscribers |= subscription.subscriber;
+                    }
+                }
+
+                return subscribers;
+            }
+
+        private:
+
+            static const quint32 StandardFrameIdCount = 2048;
+
+            struct MaskedSubscription
+            {
+                CanIdFilter     filter;
+                quint64         subscriber;
+            };
+
+            void            rebuild();
+
+            std::array<CanIdFilters, MaxSubscribers>    m_subscriptions = {};
+            quint64                                     m_usedSlots = {0};
+
+            quint64                                     m_allFramesSubscribers = {0};
+            std::array<quint64, StandardFrameIdCount>   m_standardSubscribers = {};
+            QHash<quint32, quint64>                     m_extendedSubscribers = {};
+            QVector<MaskedSubscription>                 m_maskedExtendedSubscriptions = {};
+    };
+}
+
+#endif // CANFRAMEDISPATCHTABLE_H
@@ -0,0 +1,142 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANFRAMERECEIVER_H
+#define CANFRAMERECEIVER_H
+
+#include "lindwurmlib_global.h"
+#include "utils/spscringbuffer.h"
+#include "canidfilter.h"
+#include "caninterfaceindex.h"
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QCanBusFrame>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameBatch struct groups the frames received from one interface with a single read.
+     */
+    struct CanFrameBatch
+    {
+        QVector<QCanBusFrame>   frames;
+        CanInterfaceIndex       sourceInterface;
+        qint64                  deliveredNSecs;     // steady clock time the batch was delivered to the receiver
+    };
+
+    /**
+     * @brief The CanFrameReceiver class transfers received frame batches from an interface's I/O thread to a consumer thread.
+     *
+     * Each receiver owns a lock-free single-producer/single-consumer ring. The interface pushes every received
+     * batch into the rings of all attached receivers, which only increments the reference count of the implicitly
+     * shared frame vector. After pushing, the consumer is notified by a queued call to the provided callback in the
+     * thread of the context object. While a notification is pending no further notifications are posted, so a
+     * consumer that is slow to react drains all batches accumulated meanwhile at once.
+     *
+     * If the ring is full, the batch is dropped and counted instead of blocking the I/O thread.
+     */
+    class LINDWURMLIB_EXPORT CanFrameReceiver
+    {
+        public:
+
+            static const int DefaultCapacity = 1024;
+
+            /**
+             * @brief Constructs a CanFrameReceiver.
+             * @param context           the object in whose thread the callback is invoked.
+             * @param framesAvailable   the callback invoked when new batches are available.
+             * @param capacity          the number of batches the ring can hold.
+             */
+            CanFrameReceiver(QObject *context, std::function<void()> framesAvailable, int capacity = DefaultCapacity);
+
+            /**
+             * @brief Replaces the callback invoked when new batches are available. Must be called before the receiver is attached.
+             * @param framesAvailable   the new callback.
+             */
+            void                    setFramesAvailableCallback(std::function<void()> framesAvailable);
+
+            /**
+             * @brief Sets the frame ID filters of the receiver.
+             *
+             * Only frames matching the filters are delivered; an empty set accepts all frames. The interface resolves
+             * the filters of all its receivers into a dispatch table, so the filters must only be changed with
+             * ICanInterface::setReceiverFilters().
+             *
+             * @param filters the frame ID filters.
+             */
+            void                    setFilters(const CanIdFilters &filters);
+
+            /**
+             * @brief Returns the frame ID filters of the receiver.
+             * @return the frame ID filters.
+             */
+            CanIdFilters            filters() const;
+
+            /**
+             * @brief Delivers a batch of frames to the receiver. Must only be called by one producer at a time.
+             *
+             * The frames are expected to match the receiver's filters already.
+             *
+             * @param frames            the received frames.
+             * @param sourceInterface   the index of the interface the frames were received from.
+             */
+            void                    deliver(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+
+            /**
+             * @brief Takes all batches currently available. Must only be called by the consumer.
+             * @return the available batches in order of reception.
+             */
+            QVector<CanFrameBatch>  takeBatches();
+
+            /**
+             * @brief Returns the number of frames dropped because the ring was full.
+             * @return the number of dropped frames.
+             */
+            quint64                 droppedFrameCount() const;
+
+            /**
+             * @brief Returns the number of batches not yet taken by the consumer. The result is only a snapshot.
+             * @return the number of pending batches.
+             */
+            int                     pendingBatchCount() const;
+
+            /**
+             * @brief Returns the number of batches the ring can hold.
+             * @return the capacity of the ring.
+             */
+            int                     capacity() const;
+
+        private:
+
+            SpscRingBuffer<CanFrameBatch>   m_ring;
+            QObject*                        m_context;
+            std::function<void()>           m_framesAvailable;
+            CanIdFilters                    m_filters = {};
+            std::atomic<bool>               m_notificationPending = { false };
+            std::atomic<quint64>            m_droppedFrames = { 0 };
+    };
+
+    typedef std::shared_ptr<CanFrameReceiver> CanFrameReceiverSharedPtr;
+}
+
+#endif // CANFRAMERECEIVER_H
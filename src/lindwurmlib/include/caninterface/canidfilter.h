@@ -0,0 +1,99 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANIDFILTER_H
+#define CANIDFILTER_H
+
+#include <QVector>
+#include <QCanBusFrame>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanIdFilter struct describes a set of frame IDs by an ID and a mask.
+     *
+     * A frame matches the filter if all bits set in the mask are equal in the frame ID and the filter's ID
+     * (the same semantics as the SocketCAN `CAN_RAW_FILTER` socket option). The frame format is not taken into
+     * account. The default mask matches a single frame ID.
+     */
+    struct CanIdFilter
+    {
+        static const quint32 ExactMatchMask = 0x1FFFFFFF;
+
+        quint32     frameId = {0};
+        quint32     mask = {ExactMatchMask};
+
+        inline bool matches(const QCanBusFrame &frame) const
+        {
+            return (frame.frameId() & mask) == (frameId & mask);
+        }
+
+        inline bool operator==(const CanIdFilter &other) const
+        {
+            return (frameId & mask) == (other.frameId & other.mask) && mask == other.mask;
+        }
+    };
+
+    /**
+     * @brief A set of CanIdFilter. A frame passes the set if it matches any of its filters; an empty set passes all frames.
+     */
+    typedef QVector<CanIdFilter> CanIdFilters;
+
+    /**
+     * @brief Creates the smallest set of filters matching exactly the frame IDs of an inclusive range.
+     * @param first the first frame ID of the range.
+     * @param last  the last frame ID of the range.
+     * @return the filters covering the range.
+     */
+    inline CanIdFilters canIdFiltersFromRange(quint32 first, quint32 last)
+    {
+        CanIdFilters filters;
+
+        first   = qMin(first, CanIdFilter::ExactMatchMask);
+        last    = qMin(last, CanIdFilter::ExactMatchMask);
+
+        if ( first > last )
+        {
+            qSwap(first, last);
+        }
+
+        quint64 begin = first;
+
+        while ( begin <= last )
+        {
+            // find the largest aligned block starting at begin which does not exceed the range
+            quint64 blockSize = 1;
+
+            while ( (begin & (blockSize * 2 - 1)) == 0 && begin + blockSize * 2 - 1 <= last )
+            {
+                blockSize *= 2;
+            }
+
+            CanIdFilter filter;
+
+            filter.frameId  = quint32(begin);
+            filter.mask     = CanIdFilter::ExactMatchMask & ~quint32(blockSize - 1);
+
+            filters.append(filter);
+            begin += blockSize;
+        }
+
+        return filters;
+    }
+}
+
+#endif // CANIDFILTER_H
@@ -19,6 +19,7 @@
 #define CANINTERFACECONFIG_H
 
 #include "lindwurmlib_global.h"
+#include "canroutingrule.h"
 
 #include <QList>
 #include <QStringList>
@@ -39,7 +40,11 @@ namespace Lindwurm::Lib
             int             bitRate = {0};
             int             dataBitRate = {0};
             bool            enableLocalEcho = {true};
+            int             targetBusLoad = {0};
+            double          replaySpeed = {1.0};
             QStringList     bridgedInterfaces = {};
+            CanRoutingRules routingRules = {};
+            CanRoutingAction defaultRoutingAction = {CanRoutingAction::Forward};
     };
 }
 
@@ -20,6 +20,7 @@
 
 #include "icaninterfacehandle.h"
 #include "icaninterfacesharedptr.h"
+#include "canframereceiver.h"
 
 namespace Lindwurm::Lib
 {
@@ -49,6 +50,7 @@ namespace Lindwurm::Lib
 
             virtual QString     id() const override;
             virtual QString     name() const override;
+            virtual CanInterfaceIndex interfaceIndex() const override;
             virtual QString     interfaceType() const override;
             virtual QString     device() const override;
             virtual bool        supportsFlexibleDataRate() const override;
@@ -56,17 +58,33 @@ namespace Lindwurm::Lib
             virtual int         bitRate() const override;
             virtual int         dataBitRate() const override;
             virtual bool        localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
             virtual bool        connected() const override;
 
             virtual bool        sendFrame(const QCanBusFrame &frame) override;
+            virtual int         sendFrames(const QVector<QCanBusFrame> &frames) override;
+            virtual int         transmitQueueDepth() const override;
+            virtual CanTransmitStatistics transmitStatistics() const override;
+
+            virtual void        setFrameFilters(const CanIdFilters &filters) override;
+            virtual CanIdFilters frameFilters() const override;
+
+            virtual void        subscribe(quint32 frameId) override;
+            virtual void        subscribe(const Range<quint32> &frameIds) override;
+            virtual void        subscribeAll() override;
 
             virtual bool        unmount() override;
             virtual bool        isMounted() const override;
 
         private:
 
-            ICanInterfaceSharedPtr  m_interface;
-            QString                 m_mountedComponent;
+            void                drainReceivedFrames();
+
+        private:
+
+            ICanInterfaceSharedPtr      m_interface;
+            QString                     m_mountedComponent;
+            CanFrameReceiverSharedPtr   m_receiver;
     };
 }
 
@@ -0,0 +1,40 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANINTERFACEINDEX_H
+#define CANINTERFACEINDEX_H
+
+#include <QtGlobal>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanInterfaceIndex is a small integer identifying a CAN interface within the running application.
+     *
+     * Each interface gets its index from the CanInterfaceManager when it is added. Indices are not reused while
+     * the application is running, so frames and trace records store the index instead of the interface's name
+     * and resolve the name with ICanInterfaceManager::interfaceNameOf() only when it is displayed.
+     */
+    typedef quint16 CanInterfaceIndex;
+
+    /**
+     * @brief The index of frames which are not associated with a registered interface.
+     */
+    const CanInterfaceIndex InvalidCanInterfaceIndex = 0xFFFF;
+}
+
+#endif // CANINTERFACEINDEX_H
@@ -19,6 +19,7 @@
 #define CANINTERFACEINFO_H
 
 #include "lindwurmlib_global.h"
+#include "caninterfacestatistics.h"
 
 #include <QString>
 #include <memory>
@@ -117,6 +118,18 @@ namespace Lindwurm::Lib
              */
             bool        localEchoEnabled() const;
 
+            /**
+             * @brief Returns the bus load the frames sent by the represented CAN interface should not exceed
+             * @return the target bus load in percent; `0` if not limited.
+             */
+            int         targetBusLoad() const;
+
+            /**
+             * @brief Returns the live traffic statistics of the represented CAN interface
+             * @return the statistics of the represented CAN interface; all counters are `0` if the info is invalid.
+             */
+            CanInterfaceStatistics statistics() const;
+
             /**
              * @brief Returns `true` if the represented CAN inteface is currently connected to the bus
              * @return `true` if the represented CAN inteface is currently connected to the bus.
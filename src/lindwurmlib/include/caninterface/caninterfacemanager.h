@@ -41,6 +41,7 @@ namespace Lindwurm::Lib
             virtual QStringList                     availableDevicesOf(const QString &interfaceType) const override;
             virtual QList<CanInterfaceInfo>         availableInterfaces() const override;
             virtual CanInterfaceInfo                interfaceInfoFor(const QString &interfaceId) override;
+            virtual QString                         interfaceNameOf(CanInterfaceIndex interfaceIndex) const override;
 
             ICanInterfaceSharedPtr                  interfaceById(const QString &interfaceId);
 
@@ -60,11 +61,17 @@ namespace Lindwurm::Lib
 
             ICanInterfaceSharedPtr                  createInterface(const CanInterfaceConfig &config);
             ICanInterfaceSharedPtr                  createBridge(const CanInterfaceConfig &config);
+            ICanInterfaceSharedPtr                  createVirtualCanInterface(const CanInterfaceConfig &config);
+            ICanInterfaceSharedPtr                  createTraceReplayInterface(const CanInterfaceConfig &config);
+#ifdef Q_OS_LINUX
+            ICanInterfaceSharedPtr                  createSocketCanInterface(const CanInterfaceConfig &config);
+#endif
 
         private:
 
             QMap<QString, QString>                  m_interfacesIdByName;
             QMap<QString, ICanInterfaceSharedPtr>   m_interfacesById;
+            QStringList                             m_interfaceNamesByIndex;
             CanInterfaceListModel*                  m_listModel = { nullptr };
     };
 }
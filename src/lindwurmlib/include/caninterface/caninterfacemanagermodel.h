@@ -54,6 +54,16 @@ namespace Lindwurm::Lib
                 InterfaceIdRole = Qt::UserRole + 1
             };
 
+        public slots:
+
+            /**
+             * @brief Notifies the views that the statistics columns changed.
+             *
+             * The statistics of the interfaces are read when displayed, so views call this slot at the rate
+             * the statistics should be refreshed.
+             */
+            void                    refreshStatistics();
+
         private slots:
 
             void                    interfaceAdded(const Lindwurm::Lib::CanInterfaceInfo &interface);
@@ -65,6 +75,8 @@ namespace Lindwurm::Lib
             int                     findRowForInterfaceId(const QString &interfaceId) const;
             bool                    setInterfaceConnected(QString interfaceId, bool connect);
             bool                    setInterfaceLocalEchoEnabled(QString interfaceId, bool enabled);
+            QVariant                statisticsData(const CanInterfaceStatistics &statistics, int column) const;
+            QVariant                statisticsToolTip(const CanInterfaceStatistics &statistics, int column) const;
 
         private:
 
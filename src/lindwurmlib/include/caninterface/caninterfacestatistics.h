@@ -0,0 +1,54 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANINTERFACESTATISTICS_H
+#define CANINTERFACESTATISTICS_H
+
+#include "lindwurmlib_global.h"
+
+#include <QtGlobal>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanInterfaceStatistics struct holds the live traffic counters of a CAN interface.
+     *
+     * The counters accumulate since the interface was created. The rates are averaged over the interval between
+     * two samples, which are taken when the statistics are read, but at most twice per second.
+     * Frames received back by local echo are counted as transmitted frames only.
+     */
+    struct CanInterfaceStatistics
+    {
+        quint64     rxFrames = {0};                 /*! Data and remote frames received from the bus. */
+        quint64     rxBytes = {0};                  /*! Payload bytes of the received frames. */
+        quint64     txFrames = {0};                 /*! Frames written to the driver. */
+        quint64     txBytes = {0};                  /*! Payload bytes of the written frames. */
+        quint64     errorFrames = {0};              /*! Error frames reported by the driver. */
+        quint64     txFailures = {0};               /*! Frames the driver refused to write. */
+        quint64     txDroppedFrames = {0};          /*! Frames rejected by the full transmit queue or discarded on disconnect. */
+        quint64     rxOverflowFrames = {0};         /*! Frames lost by the driver or kernel because the receive queue overflowed, if detectable. */
+        quint64     receiverDroppedFrames = {0};    /*! Frames dropped by the attached receivers because their consumer was too slow. */
+
+        double      rxFramesPerSecond = {0.0};      /*! Received frames per second. */
+        double      rxBytesPerSecond = {0.0};       /*! Received payload bytes per second. */
+        double      txFramesPerSecond = {0.0};      /*! Transmitted frames per second. */
+        double      txBytesPerSecond = {0.0};       /*! Transmitted payload bytes per second. */
+        double      busLoad = {-1.0};               /*! Estimated bus load in percent; negative if unknown because no bit rate is set. */
+    };
+}
+
+#endif // CANINTERFACESTATISTICS_H
@@ -0,0 +1,56 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANROUTINGRULE_H
+#define CANROUTINGRULE_H
+
+#include <QString>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanRoutingAction enum describes how a bridge handles a frame for a specific direction.
+     */
+    enum class CanRoutingAction
+    {
+        Forward,    /*! The frame is forwarded unchanged. */
+        Drop,       /*! The frame is not forwarded. */
+        Remap       /*! The frame is forwarded with a different frame ID. */
+    };
+
+    /**
+     * @brief The CanRoutingRule struct describes how a bridge routes a specific frame ID.
+     *
+     * A rule applies to frames with the given frame ID and frame format, which are received on the source
+     * interface and forwarded to the target interface. An empty source or target interface ID matches all
+     * interfaces mounted to the bridge. If several rules match a frame, the first rule in the list is applied.
+     */
+    struct CanRoutingRule
+    {
+        QString             sourceInterfaceId = {""};
+        QString             targetInterfaceId = {""};
+        quint32             frameId = {0};
+        bool                extendedFrameFormat = {false};
+        CanRoutingAction    action = {CanRoutingAction::Forward};
+        quint32             remappedFrameId = {0};
+    };
+
+    typedef QVector<CanRoutingRule> CanRoutingRules;
+}
+
+#endif // CANROUTINGRULE_H
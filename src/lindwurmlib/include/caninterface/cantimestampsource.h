@@ -0,0 +1,39 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANTIMESTAMPSOURCE_H
+#define CANTIMESTAMPSOURCE_H
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanTimestampSource enum describes where the timestamps of received CAN frames originate from.
+     *
+     * The sources are ordered by their accuracy, so the least accurate source of several interfaces
+     * can be determined by comparison.
+     */
+    enum class CanTimestampSource
+    {
+        Unknown,    /*! The origin of the timestamps is not known. */
+        Driver,     /*! Timestamps are provided by the Qt CAN bus driver plugin. */
+        Kernel,     /*! Timestamps are taken by the kernel on reception (software timestamping). */
+        Hardware,   /*! Timestamps are taken by the CAN controller (hardware timestamping). */
+        Simulated   /*! Timestamps are the exact end of frame times of a simulated bus (see VirtualCanBus). */
+    };
+}
+
+#endif // CANTIMESTAMPSOURCE_H
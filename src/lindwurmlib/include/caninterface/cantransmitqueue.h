@@ -0,0 +1,107 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANTRANSMITQUEUE_H
+#define CANTRANSMITQUEUE_H
+
+#include "lindwurmlib_global.h"
+
+#include <QCanBusFrame>
+#include <QMutex>
+#include <QVector>
+
+#include <atomic>
+#include <deque>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanTransmitStatistics struct holds the transmit counters of a CAN interface.
+     */
+    struct CanTransmitStatistics
+    {
+        quint64     queuedFrames = {0};     /*! Frames accepted by the transmit queue. */
+        quint64     writtenFrames = {0};    /*! Frames written to the driver. */
+        quint64     droppedFrames = {0};    /*! Frames rejected because the queue was full or discarded on disconnect. */
+        quint64     failedFrames = {0};     /*! Frames the driver refused to write. */
+    };
+
+    /**
+     * @brief The CanTransmitQueue class is a bounded multi-producer transmit queue of a CAN interface.
+     *
+     * Any thread may enqueue frames, while the interface writes them from its own thread at the rate the driver
+     * accepts them. If the queue is full, frames are rejected instead of being buffered without limit, so the
+     * producer can slow down. After the queue was full, acknowledge() reports when it has drained below half of
+     * its capacity, which the interface signals as ready to send.
+     */
+    class LINDWURMLIB_EXPORT CanTransmitQueue
+    {
+        public:
+
+            static const int DefaultCapacity = 4096;
+
+            explicit CanTransmitQueue(int capacity = DefaultCapacity);
+
+            /**
+             * @brief Appends frames to the queue.
+             * @param frames the frames to send.
+             * @return the number of frames accepted; frames exceeding the capacity are rejected and counted as dropped.
+             */
+            int                     enqueue(const QVector<QCanBusFrame> &frames);
+
+            /**
+             * @brief Returns the frames at the front of the queue without removing them.
+             * @param maxCount the maximum number of frames to return.
+             * @return the frames at the front of the queue.
+             */
+            QVector<QCanBusFrame>   peek(int maxCount) const;
+
+            /**
+             * @brief Removes frames from the front of the queue after they have been handled by the driver.
+             * @param writtenCount  the number of frames written to the driver.
+             * @param failedCount   the number of frames the driver refused (following the written frames).
+             * @param writtenFrames if not `nullptr`, the written frames are moved to this vector.
+             * @return `true` if the queue was full before and has drained below its low watermark now.
+             */
+            bool                    acknowledge(int writtenCount, int failedCount = 0, QVector<QCanBusFrame> *writtenFrames = nullptr);
+
+            /**
+             * @brief Discards all queued frames, which are counted as dropped.
+             * @return `true` if the queue was full before.
+             */
+            bool                    clear();
+
+            int                     depth() const;
+            int                     capacity() const;
+            CanTransmitStatistics   statistics() const;
+
+        private:
+
+            mutable QMutex              m_mutex;
+            std::deque<QCanBusFrame>    m_frames;
+            const int                   m_capacity;
+            bool                        m_full = {false};
+
+            std::atomic<int>            m_depth = {0};
+            std::atomic<quint64>        m_queuedFrames = {0};
+            std::atomic<quint64>        m_writtenFrames = {0};
+            std::atomic<quint64>        m_droppedFrames = {0};
+            std::atomic<quint64>        m_failedFrames = {0};
+    };
+}
+
+#endif // CANTRANSMITQUEUE_H
@@ -0,0 +1,119 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANTRANSMITSCHEDULER_H
+#define CANTRANSMITSCHEDULER_H
+
+#include "lindwurmlib_global.h"
+
+#include <QCanBusFrame>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanTransmitScheduler class paces the frames sent by a CAN interface to a target bus load.
+     *
+     * The scheduler is a token bucket measured in bus time: each frame costs the time it occupies the bus, which is
+     * estimated from its length and the bit rates of the interface (see frameDurationNSecs()). The bucket is
+     * refilled with the target bus load, e.g. at 70% load every millisecond adds 700 µs of bus time. Frames are
+     * admitted as long as the bucket is not in debt, so a frame is never delayed because it is longer than the
+     * bucket, and the next frame waits until the debt has been paid back.
+     *
+     * The bit stuffing is estimated with its worst case, so the actual bus load stays at or slightly below the
+     * target. The scheduler is inactive (admits all frames) if no target bus load or no bit rate is set.
+     * All methods are thread-safe.
+     */
+    class LINDWURMLIB_EXPORT CanTransmitScheduler
+    {
+        public:
+
+            /**
+             * @brief The bus time the bucket may save up while idle, which limits bursts after idle periods.
+             */
+            static const qint64 MaxBurstNSecs = 2000000;
+
+            CanTransmitScheduler();
+
+            /**
+             * @brief Sets the bus load the sent frames should not exceed.
+             * @param percent the target bus load in percent; `0` or `100` disables the scheduler.
+             */
+            void            setTargetBusLoad(int percent);
+            int             targetBusLoad() const;
+
+            /**
+             * @brief Sets the nominal bit rate used to estimate the duration of the frames.
+             * @param bitRate the nominal bit rate of the interface.
+             */
+            void            setBitRate(int bitRate);
+            int             bitRate() const;
+
+            /**
+             * @brief Sets the data bit rate used to estimate the duration of CAN FD frames with bit rate switch.
+             * @param dataBitRate the data bit rate of the interface; `0` to use the nominal bit rate.
+             */
+            void            setDataBitRate(int dataBitRate);
+            int             dataBitRate() const;
+
+            /**
+             * @brief Returns `true` if the scheduler limits the frames sent.
+             * @return `true` if a target bus load and a bit rate are set.
+             */
+            bool            isActive() const;
+
+            /**
+             * @brief Admits the leading frames which may be sent now and charges their bus time.
+             * @param frames the frames to send in order.
+             * @return the number of leading frames which may be sent now.
+             */
+            int             admit(const QVector<QCanBusFrame> &frames);
+
+            /**
+             * @brief Returns the time until the next frame will be admitted.
+             * @return the time in microseconds; `0` if frames are admitted right now.
+             */
+            qint64          admissionDelayUSecs();
+
+            /**
+             * @brief Estimates how long a frame occupies the bus, including the interframe space.
+             * @param frame         the frame to estimate.
+             * @param bitRate       the nominal bit rate.
+             * @param dataBitRate   the data bit rate of CAN FD frames with bit rate switch; `0` to use the nominal bit rate.
+             * @return the duration of the frame on the bus in nanoseconds.
+             */
+            static qint64   frameDurationNSecs(const QCanBusFrame &frame, int bitRate, int dataBitRate);
+
+        private:
+
+            void            refill();
+
+        private:
+
+            mutable QMutex  m_mutex;
+            QElapsedTimer   m_clock;
+            int             m_targetBusLoad = {0};
+            int             m_bitRate = {0};
+            int             m_dataBitRate = {0};
+            qint64          m_balanceNSecs = {0};
+            qint64          m_lastRefillNSecs = {0};
+    };
+}
+
+#endif // CANTRANSMITSCHEDULER_H
@@ -19,10 +19,16 @@
 #define ICANINTERFACE_H
 
 #include "lindwurmlib_global.h"
+#include "cantimestampsource.h"
+#include "canframereceiver.h"
+#include "caninterfaceindex.h"
+#include "cantransmitqueue.h"
+#include "caninterfacestatistics.h"
 
 #include <QObject>
 #include <QCanBusFrame>
 #include <QStringList>
+#include <QVector>
 
 namespace Lindwurm::Lib
 {
@@ -57,6 +63,12 @@ namespace Lindwurm::Lib
              */
             virtual QString     name() const = 0;
 
+            /**
+             * @brief Returns the index of the CAN interface assigned by the CanInterfaceManager
+             * @return the index of the CAN interface or InvalidCanInterfaceIndex if not yet assigned.
+             */
+            virtual CanInterfaceIndex interfaceIndex() const = 0;
+
             /**
              * @brief Returns the type of the CAN interface
              * @return the type of the CAN interface.
@@ -105,6 +117,12 @@ namespace Lindwurm::Lib
              */
             virtual bool        localEchoEnabled() const = 0;
 
+            /**
+             * @brief Returns the source of the timestamps of frames received by this CAN interface
+             * @return the source of the receive timestamps.
+             */
+            virtual CanTimestampSource timestampSource() const = 0;
+
             /**
              * @brief Returns `true` if the CAN inteface is currently connected to the bus
              * @return `true` if the CAN inteface is currently connected to the bus.
@@ -125,17 +143,67 @@ namespace Lindwurm::Lib
 
             /**
              * @brief Send the provided frame to the CAN bus
+             *
+             * The frame is appended to the transmit queue of the interface and written by its I/O thread. This method
+             * is thread-safe.
+             *
              * @param frame the QCanBusFrame to send.
-             * @return true on success; otherwise false
+             * @return `true` if the frame was queued; `false` if the interface is not connected or the queue is full.
              */
             virtual bool        sendFrame(const QCanBusFrame &frame) = 0;
 
+            /**
+             * @brief Send the provided frames to the CAN bus
+             *
+             * Like sendFrame(), but the frames are queued at once. If the transmit queue cannot take all frames,
+             * the leading frames are queued and the remaining frames are rejected. Wait for readyToSend() before
+             * sending the rejected frames again. This method is thread-safe.
+             *
+             * @param frames the frames to send in order.
+             * @return the number of frames queued.
+             */
+            virtual int         sendFrames(const QVector<QCanBusFrame> &frames) = 0;
+
+            /**
+             * @brief Returns the number of frames waiting in the transmit queue
+             * @return the current depth of the transmit queue.
+             */
+            virtual int         transmitQueueDepth() const = 0;
+
+            /**
+             * @brief Returns the transmit counters of the CAN interface
+             * @return the number of queued, written, dropped and failed frames since the interface was created.
+             */
+            virtual CanTransmitStatistics transmitStatistics() const = 0;
+
+            /**
+             * @brief Returns the live traffic statistics of the CAN interface
+             *
+             * The counters are maintained while frames are received and written, reading them is cheap and
+             * thread-safe. See CanInterfaceStatistics for how the rates and the bus load are averaged.
+             *
+             * @return the counters, rates and the estimated bus load of the interface.
+             */
+            virtual CanInterfaceStatistics statistics() const = 0;
+
+            /**
+             * @brief Returns the bus load the frames sent by this interface should not exceed
+             * @return the target bus load in percent; `0` if the frames are sent as fast as the driver accepts them.
+             */
+            virtual int         targetBusLoad() const = 0;
+
             /**
              * @brief Sets the textual name of the CAN inteface
              * @param the name of the CAN inteface.
              */
             virtual void        setName(const QString &name) = 0;
 
+            /**
+             * @brief Sets the index of the CAN interface. This is done by the CanInterfaceManager when adding the interface.
+             * @param interfaceIndex the index of the CAN inteface.
+             */
+            virtual void        setInterfaceIndex(CanInterfaceIndex interfaceIndex) = 0;
+
             /**
              * @brief Enables or disables flexible data rate for this CAN interface.
              *
@@ -169,6 +237,17 @@ namespace Lindwurm::Lib
              */
             virtual void        setLocalEchoEnabled(bool enable) = 0;
 
+            /**
+             * @brief Sets the bus load the frames sent by this interface should not exceed
+             *
+             * The transmit queue is drained at the pace the frames would take on the bus at this load, which is
+             * estimated from the length of the frames and the bit rates of the interface. All handles mounted to
+             * the interface share this limit.
+             *
+             * @param percent the target bus load in percent; `0` to send frames as fast as the driver accepts them.
+             */
+            virtual void        setTargetBusLoad(int percent) = 0;
+
             /**
              * @brief Mount the CAN interface to the specified component
              * @param component the component name to mount
@@ -193,6 +272,35 @@ namespace Lindwurm::Lib
              */
             virtual QStringList mountedComponents() const = 0;
 
+            /**
+             * @brief Attaches a receiver to which all received frames are delivered
+             *
+             * Frames are pushed to the receiver directly from the I/O thread of the interface. This method is thread-safe.
+             *
+             * @param receiver the receiver to attach.
+             */
+            virtual void        attachReceiver(const CanFrameReceiverSharedPtr &receiver) = 0;
+
+            /**
+             * @brief Detaches a previously attached receiver
+             *
+             * After this method returns, no more frames are pushed to the receiver. This method is thread-safe.
+             *
+             * @param receiver the receiver to detach.
+             */
+            virtual void        detachReceiver(const CanFrameReceiverSharedPtr &receiver) = 0;
+
+            /**
+             * @brief Sets the frame ID filters of an attached receiver
+             *
+             * The interface merges the filters of all attached receivers and, if supported, lets the driver or kernel
+             * discard frames no receiver is interested in. This method is thread-safe.
+             *
+             * @param receiver  the attached receiver.
+             * @param filters   the frame ID filters of the receiver; an empty set accepts all frames.
+             */
+            virtual void        setReceiverFilters(const CanFrameReceiverSharedPtr &receiver, const CanIdFilters &filters) = 0;
+
 
         signals:
 
@@ -207,11 +315,34 @@ namespace Lindwurm::Lib
             void                interfaceDisconnected();
 
             /**
-             * @brief This signal is emitted when a CAN frame have been received
-             * @param frame             the received CAN frame
-             * @param sourceInterface   the textual name of the source CAN interface
+             * @brief This signal is emitted when CAN frames have been received
+             *
+             * All frames which were read from the driver at once are delivered in a single batch,
+             * so the cost of the signal dispatch is paid once per read and not once per frame.
+             *
+             * The signal is emitted from the I/O thread of the interface. Consumers which should not run
+             * in this thread should rather mount an ICanInterfaceHandle, which delivers the frames in its own thread.
+             *
+             * @param frames            the received CAN frames in order of reception
+             * @param sourceInterface   the index of the source CAN interface (see ICanInterfaceManager::interfaceNameOf())
+             */
+            void                framesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+
+            /**
+             * @brief This signal is emitted when the depth of the transmit queue has changed
+             *
+             * The signal may be emitted from any thread which sends frames or from the I/O thread of the interface.
+             *
+             * @param depth the number of frames waiting in the transmit queue.
+             */
+            void                transmitQueueDepthChanged(int depth);
+
+            /**
+             * @brief This signal is emitted when the transmit queue has drained after it rejected frames
+             *
+             * Senders which got frames rejected by sendFrame() or sendFrames() may continue sending now.
              */
-            void                frameReceived(const QCanBusFrame &frame, const QString &sourceInterface);
+            void                readyToSend();
     };
 }
 
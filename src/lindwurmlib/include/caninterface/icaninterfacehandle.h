@@ -19,9 +19,15 @@
 #define ICANINTERFACEHANDLE_H
 
 #include "lindwurmlib_global.h"
+#include "cantimestampsource.h"
+#include "canidfilter.h"
+#include "caninterfaceindex.h"
+#include "cantransmitqueue.h"
+#include "utils/range.h"
 #include <QObject>
 #include <QString>
 #include <QCanBusFrame>
+#include <QVector>
 
 #include "icaninterfacehandlesharedptr.h"
 
@@ -61,6 +67,12 @@ namespace Lindwurm::Lib
              */
             virtual QString     name() const = 0;
 
+            /**
+             * @brief Returns the index of the CAN interface, which identifies the source interface of received frames
+             * @return the index of the CAN interface.
+             */
+            virtual CanInterfaceIndex interfaceIndex() const = 0;
+
             /**
              * @brief Returns the type of the CAN interface
              * @return the type of the CAN interface.
@@ -109,6 +121,12 @@ namespace Lindwurm::Lib
              */
             virtual bool        localEchoEnabled() const = 0;
 
+            /**
+             * @brief Returns the source of the timestamps of frames received by this CAN interface
+             * @return the source of the receive timestamps.
+             */
+            virtual CanTimestampSource timestampSource() const = 0;
+
             /**
              * @brief Returns `true` if the CAN inteface is currently connected to the bus
              * @return `true` if the CAN inteface is currently connected to the bus.
@@ -117,11 +135,75 @@ namespace Lindwurm::Lib
 
             /**
              * @brief Send the provided frame to the CAN bus
+             *
+             * The frame is appended to the transmit queue of the interface, which is shared by all handles. If the
+             * queue is full, the frame is rejected; wait for readyToSend() before sending it again.
+             *
              * @param frame the QCanBusFrame to send.
-             * @return true on success; otherwise false
+             * @return `true` if the frame was queued; `false` if the interface is not connected or the queue is full.
              */
             virtual bool        sendFrame(const QCanBusFrame &frame) = 0;
 
+            /**
+             * @brief Send the provided frames to the CAN bus
+             * @param frames the frames to send in order.
+             * @return the number of frames queued; the remaining frames were rejected.
+             * @see ICanInterface::sendFrames()
+             */
+            virtual int         sendFrames(const QVector<QCanBusFrame> &frames) = 0;
+
+            /**
+             * @brief Returns the number of frames waiting in the transmit queue of the interface
+             * @return the current depth of the transmit queue.
+             */
+            virtual int         transmitQueueDepth() const = 0;
+
+            /**
+             * @brief Returns the transmit counters of the interface
+             * @return the number of queued, written, dropped and failed frames.
+             */
+            virtual CanTransmitStatistics transmitStatistics() const = 0;
+
+            /**
+             * @brief Restricts the frames received by this handle to the frame IDs matching the filters
+             *
+             * The filters of all handles mounted to an interface are merged, so frames no handle is interested
+             * in can already be discarded by the kernel (if supported by the interface). This avoids waking up
+             * the application for unrelated bus traffic.
+             *
+             * @param filters the frame ID filters; an empty set receives all frames (default).
+             */
+            virtual void        setFrameFilters(const CanIdFilters &filters) = 0;
+
+            /**
+             * @brief Returns the frame ID filters of this handle
+             * @return the frame ID filters; an empty set if all frames are received.
+             */
+            virtual CanIdFilters frameFilters() const = 0;
+
+            /**
+             * @brief Subscribes the handle to frames with a specific frame ID
+             *
+             * A newly mounted handle receives all frames. The first subscription restricts the handle to the
+             * subscribed frame IDs; further subscriptions add frame IDs. Frames are dispatched by a per-interface
+             * table, so frames nobody subscribed to do not cost this handle anything.
+             *
+             * @param frameId the frame ID to subscribe.
+             */
+            virtual void        subscribe(quint32 frameId) = 0;
+
+            /**
+             * @brief Subscribes the handle to frames within a range of frame IDs
+             * @param frameIds the inclusive range of frame IDs to subscribe.
+             * @see subscribe(quint32)
+             */
+            virtual void        subscribe(const Range<quint32> &frameIds) = 0;
+
+            /**
+             * @brief Subscribes the handle to all frames, which replaces all previous subscriptions
+             */
+            virtual void        subscribeAll() = 0;
+
             /**
              * @brief Unmount the handle from the actual CAN interface.
              *
@@ -152,11 +234,29 @@ namespace Lindwurm::Lib
             void                interfaceDisconnected();
 
             /**
-             * @brief This signal is emitted when a CAN frame have been received
-             * @param frame             the received CAN frame
-             * @param sourceInterface   the textual name of the source CAN interface
+             * @brief This signal is emitted when CAN frames have been received
+             *
+             * All frames which were read from the driver at once are delivered in a single batch,
+             * so the cost of the signal dispatch is paid once per read and not once per frame.
+             *
+             * The signal is emitted in the thread the handle lives in. The interface's I/O thread
+             * buffers the frames for each handle, so a busy handle thread does not stall the reception.
+             *
+             * @param frames            the received CAN frames in order of reception
+             * @param sourceInterface   the index of the source CAN interface (see ICanInterfaceManager::interfaceNameOf())
+             */
+            void                framesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+
+            /**
+             * @brief This signal is emitted when the depth of the interface's transmit queue has changed
+             * @param depth the number of frames waiting in the transmit queue.
+             */
+            void                transmitQueueDepthChanged(int depth);
+
+            /**
+             * @brief This signal is emitted when the transmit queue has drained after it rejected frames
              */
-            void                frameReceived(const QCanBusFrame &frame, const QString &sourceInterface);
+            void                readyToSend();
     };
 }
 
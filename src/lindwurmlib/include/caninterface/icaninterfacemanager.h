@@ -25,6 +25,7 @@
 
 #include "caninterfaceinfo.h"
 #include "caninterfaceconfig.h"
+#include "caninterfaceindex.h"
 #include "icaninterfacehandlesharedptr.h"
 
 class QAbstractItemModel;
@@ -78,6 +79,16 @@ namespace Lindwurm::Lib
              */
             virtual CanInterfaceInfo                interfaceInfoFor(const QString &interfaceId) = 0;
 
+            /**
+             * @brief Get the name of the interface with a specific index.
+             *
+             * The names of removed interfaces are still resolved, so recorded frames keep their source interface.
+             *
+             * @param interfaceIndex    the index of the interface.
+             * @return the (latest) name of the interface or an empty string if the index is unknown.
+             */
+            virtual QString                         interfaceNameOf(CanInterfaceIndex interfaceIndex) const = 0;
+
             /**
              * @brief Get a list model for the available CAN interfaces.
              *
@@ -0,0 +1,158 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOCKETCANINTERFACE_H
+#define SOCKETCANINTERFACE_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcaninterface.h"
+
+#include <QVector>
+#include <QMutex>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+
+class QSocketNotifier;
+class QThread;
+struct msghdr;
+struct canfd_frame;
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The SocketCanInterface class implements the ICanInterface on top of a native Linux SocketCAN raw socket.
+     *
+     * In contrast to CanDevice, which uses the QtSerialBus socketcan plugin, this interface talks to the
+     * `AF_CAN` socket directly and moves frames in batches: all pending frames are read with a single
+     * `recvmmsg()` call and frames sent within one event loop iteration are written with a single `sendmmsg()`.
+     * The socket is read by a dedicated reader thread, which blocks in `poll()` and hands the received frames
+     * directly to the attached receivers. Frames queued by the thread the interface lives in are written from its
+     * event loop; frames queued by other threads (e.g. a bridge's forwarding thread) are written by the sending thread
+     * right away, unless the socket is busy with previously queued frames.
+     *
+     * If a target bus load is set, the queued frames are written at the pace admitted by the CanTransmitScheduler.
+     *
+     * The frame ID filters of all mounted handles are installed as `CAN_RAW_FILTER`, so the kernel discards
+     * frames no handle is interested in before they reach the reader thread.
+     *
+     * Receive timestamps are taken with `SO_TIMESTAMPING`. If the CAN controller provides hardware timestamps,
+     * these are preferred over the kernel's software timestamps. Hardware timestamps are mapped into the system
+     * time domain, so they stay comparable to timestamps of other interfaces. Frames sent by this interface are
+     * timestamped by their local echo, which the driver generates as soon as the frame was transmitted.
+     *
+     * The socket does not configure the bit rates of the network device (this requires netlink and usually root
+     * privileges). Configure the device with `ip link` before connecting; the bit rates are only stored as
+     * informational values.
+     *
+     * Generally, it is not neccessary to create a SocketCanInterface instance directly. Instead use
+     * CanInterfaceManager::addInterface() with the interface type SocketCanInterface::InterfaceType.
+     */
+    class LINDWURMLIB_EXPORT SocketCanInterface : public AbstractCanInterface
+    {
+        Q_OBJECT
+        public:
+
+            /**
+             * @brief The interface type name used to select this interface in the CanInterfaceManager.
+             */
+            static const char* const InterfaceType;
+
+                            SocketCanInterface(const QString &id, const QString &device);
+            virtual         ~SocketCanInterface();
+
+            /**
+             * @brief Returns the names of all SocketCAN network devices present on this system.
+             * @return a list of SocketCAN device names (e.g. `can0`, `vcan0`).
+             */
+            static QStringList availableDevices();
+
+            virtual bool    connectInterface() override;
+            virtual bool    disconnectInterface() override;
+
+            virtual bool    supportsFlexibleDataRate() const override;
+            virtual bool    flexibleDataRateEnabled() const override;
+            virtual int     bitRate() const override;
+            virtual int     dataBitRate() const override;
+            virtual bool    localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
+            virtual bool    connected() const override;
+
+            virtual void    setFlexibleDataRateEnabled(bool enabled) override;
+            virtual void    setBitRate(int bitRate) override;
+            virtual void    setDataBitRate(int dataBitRate) override;
+            virtual void    setLocalEchoEnabled(bool enable) override;
+
+        protected:
+
+            virtual void    applyFrameFilters(const CanIdFilters &filters) override;
+            virtual void    transmitQueuedFrames() override;
+
+        private slots:
+
+            void            writeFrames();
+
+        private:
+
+            void            readerLoop();
+            void            readFrames();
+            void            socketFailed();
+
+            bool            openSocket();
+            void            closeSocket();
+            bool            startReaderThread();
+            void            stopReaderThread();
+            bool            applySocketOptions();
+            bool            applyKernelFilters();
+            void            enableHardwareTimestamps();
+            bool            flushTransmitQueue();
+            void            setWriteBlocked(bool blocked);
+            void            retryWriteLater(int delayMSecs);
+            static size_t   toRawFrame(const QCanBusFrame &frame, struct canfd_frame &rawFrame);
+            qint64          receiveTimestampUSecs(const struct msghdr &message);
+            void            countSocketDrops(const struct msghdr &message);
+
+            struct MessageBuffers;
+
+            int                             m_socket = { -1 };
+            int                             m_wakeupFd = { -1 };
+            QThread*                        m_readerThread = { nullptr };
+            QSocketNotifier*                m_writeNotifier = { nullptr };
+            std::unique_ptr<MessageBuffers> m_buffers;
+
+            QMutex                          m_txMutex;
+            bool                            m_writeScheduled = { false };
+            bool                            m_writeBlocked = { false };
+
+            std::atomic<bool>               m_connected = { false };
+            bool                            m_flexibleDataRateEnabled = { false };
+            bool                            m_localEchoEnabled = { false };
+
+            QMutex                          m_filterMutex;
+            CanIdFilters                    m_frameFilters = {};
+            int                             m_bitRate = { 0 };
+            int                             m_dataBitRate = { 0 };
+
+            std::atomic<CanTimestampSource> m_timestampSource = { CanTimestampSource::Kernel };
+            qint64                          m_hardwareClockOffsetUSecs = { 0 };
+            bool                            m_hardwareClockOffsetValid = { false };
+            quint32                         m_socketDroppedFrames = { 0 };
+    };
+}
+
+#endif // SOCKETCANINTERFACE_H
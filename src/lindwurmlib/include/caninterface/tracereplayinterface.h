@@ -0,0 +1,112 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACEREPLAYINTERFACE_H
+#define TRACEREPLAYINTERFACE_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcaninterface.h"
+
+#include <QMutex>
+
+#include <atomic>
+
+class QThread;
+
+namespace Lindwurm::Lib
+{
+    class ICanTraceFileReader;
+
+    /**
+     * @brief The TraceReplayInterface class implements the ICanInterface by replaying a recorded trace file.
+     *
+     * The device of the interface is the name of the trace file (see ICanTraceFileReader::createReader() for the
+     * supported formats). When connected, a replay thread reads the file incrementally and delivers the recorded
+     * frames to the mounted handles like any other interface, so tracers, bridges and the transport protocols can
+     * work on a capture without any hardware.
+     *
+     * The frames are replayed with their original inter-frame timing divided by the replay speed, e.g. a speed of
+     * `50` replays an hour of traffic within 72 seconds. A speed of `0` replays the frames as fast as possible, which
+     * is useful to measure the ingest throughput of the consumers. In this mode the replay waits for the
+     * slowest receiver to catch up instead of overflowing it. The frames keep their recorded timestamps.
+     * When the end of the file is reached, the interface disconnects itself.
+     *
+     * Frames sent to this interface are discarded (and echoed if local echo is enabled).
+     */
+    class LINDWURMLIB_EXPORT TraceReplayInterface : public AbstractCanInterface
+    {
+        Q_OBJECT
+        public:
+
+            /**
+             * @brief The interface type name used to select this interface in the CanInterfaceManager.
+             */
+            static const char* const InterfaceType;
+
+                            TraceReplayInterface(const QString &id, const QString &fileName);
+            virtual         ~TraceReplayInterface();
+
+            /**
+             * @brief Sets the speed factor of the replay
+             * @param speed the factor the recorded timing is accelerated by; `0` to replay as fast as possible.
+             */
+            void            setReplaySpeed(double speed);
+            double          replaySpeed() const;
+
+            virtual bool    connectInterface() override;
+            virtual bool    disconnectInterface() override;
+
+            virtual bool    supportsFlexibleDataRate() const override;
+            virtual bool    flexibleDataRateEnabled() const override;
+            virtual int     bitRate() const override;
+            virtual int     dataBitRate() const override;
+            virtual bool    localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
+            virtual bool    connected() const override;
+
+            virtual void    setFlexibleDataRateEnabled(bool enabled) override;
+            virtual void    setBitRate(int bitRate) override;
+            virtual void    setDataBitRate(int dataBitRate) override;
+            virtual void    setLocalEchoEnabled(bool enable) override;
+
+        protected:
+
+            virtual void    transmitQueuedFrames() override;
+
+        private:
+
+            void            replayLoop(ICanTraceFileReader &reader);
+            bool            waitUntil(qint64 steadyNSecs);
+            bool            waitForReceivers();
+            void            stopReplayThread();
+
+        private:
+
+            QThread*            m_replayThread = { nullptr };
+            std::atomic<bool>   m_stopRequested = { false };
+            std::atomic<bool>   m_connected = { false };
+            std::atomic<double> m_replaySpeed = { 1.0 };
+            std::atomic<bool>   m_localEchoEnabled = { false };
+            bool                m_flexibleDataRateEnabled = { true };
+            int                 m_bitRate = { 0 };
+            int                 m_dataBitRate = { 0 };
+
+            QMutex              m_transmitMutex;
+    };
+}
+
+#endif // TRACEREPLAYINTERFACE_H
@@ -0,0 +1,170 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIRTUALCANBUS_H
+#define VIRTUALCANBUS_H
+
+#include "lindwurmlib_global.h"
+
+#include <QCanBusFrame>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+
+class QThread;
+
+namespace Lindwurm::Lib
+{
+    class VirtualCanInterface;
+    class VirtualCanBus;
+
+    typedef std::shared_ptr<VirtualCanBus> VirtualCanBusSharedPtr;
+
+    /**
+     * @brief The VirtualCanBus class simulates a CAN bus connecting any number of VirtualCanInterface endpoints in-process.
+     *
+     * The bus is driven by its own thread, which models the wire: whenever the bus gets idle, the frames at the
+     * front of the transmit queues of all connected endpoints compete for the bus. With arbitration enabled the
+     * frame with the highest priority (the lowest identifier) wins, like on a real bus; otherwise the endpoints
+     * take turns. The winning frame occupies the bus for its estimated wire time at the bit rates of the sending
+     * endpoint (see CanTransmitScheduler::frameDurationNSecs()) plus an optional random jitter. At the end of the
+     * frame it is delivered to all other connected endpoints (and echoed to the sender if local echo is enabled),
+     * unless it gets lost with the configured loss probability.
+     *
+     * Buses are identified by name, endpoints with the same device name share a bus. If no bit rate is set the
+     * frames are delivered without delay. All methods are thread-safe.
+     */
+    class LINDWURMLIB_EXPORT VirtualCanBus
+    {
+        public:
+
+            /**
+             * @brief Returns the bus with the given name, which is created if it does not exist yet.
+             * @param name the name of the bus.
+             * @return the bus; it is destroyed as soon as the last reference is released.
+             */
+            static VirtualCanBusSharedPtr bus(const QString &name);
+
+            /**
+             * @brief Returns the names of the buses offered for new virtual interfaces.
+             * @return a list of bus names.
+             */
+            static QStringList availableBuses();
+
+            explicit VirtualCanBus(const QString &name);
+            ~VirtualCanBus();
+
+            QString         name() const;
+
+            /**
+             * @brief Enables or disables the arbitration by frame ID
+             * @param enabled set to `true` to send the pending frame with the lowest ID first (default).
+             */
+            void            setArbitrationEnabled(bool enabled);
+            bool            arbitrationEnabled() const;
+
+            /**
+             * @brief Sets the probability that a receiving endpoint misses a frame
+             * @param probability the loss probability between `0.0` (default) and `1.0`.
+             */
+            void            setFrameLossProbability(double probability);
+            double          frameLossProbability() const;
+
+            /**
+             * @brief Sets the maximum random delay added to the wire time of each frame
+             * @param jitterUSecs the maximum jitter in microseconds; `0` (default) disables the jitter.
+             */
+            void            setJitterUSecs(int jitterUSecs);
+            int             jitterUSecs() const;
+
+            /**
+             * @brief Returns the number of frames sent over the bus
+             * @return the number of frames which won the arbitration.
+             */
+            quint64         transmittedFrameCount() const;
+
+            /**
+             * @brief Returns the number of frames missed by receiving endpoints due to the simulated loss
+             * @return the number of lost frames.
+             */
+            quint64         lostFrameCount() const;
+
+            /**
+             * @brief Connects an endpoint to the bus.
+             * @param endpoint the endpoint to connect.
+             */
+            void            attach(VirtualCanInterface *endpoint);
+
+            /**
+             * @brief Disconnects an endpoint from the bus. After this method returns, the bus does not access the endpoint anymore.
+             * @param endpoint the endpoint to disconnect.
+             */
+            void            detach(VirtualCanInterface *endpoint);
+
+            /**
+             * @brief Wakes up the bus after an endpoint has queued frames.
+             */
+            void            wake();
+
+        private:
+
+            /**
+             * @brief The Endpoint struct is a connected endpoint and the generation it was attached with.
+             */
+            struct Endpoint
+            {
+                VirtualCanInterface*    interface;
+                quint64                 generation;
+            };
+
+            void            busLoop();
+            bool            nextTransmission(Endpoint &sender, QCanBusFrame &frame, qint64 &durationNSecs, qint64 &waitUSecs);
+            void            completeTransmission(const Endpoint &sender, QCanBusFrame frame);
+            void            waitForFrames(qint64 waitUSecs);
+
+            static quint64  arbitrationKey(const QCanBusFrame &frame);
+
+        private:
+
+            const QString       m_name;
+
+            mutable QMutex      m_endpointsMutex;
+            QVector<Endpoint>   m_endpoints;
+            quint64             m_nextGeneration = {0};
+            int                 m_nextEndpoint = {0};
+
+            QMutex              m_wakeMutex;
+            QWaitCondition      m_wakeCondition;
+            bool                m_wakePending = {false};
+            bool                m_stopRequested = {false};
+
+            QThread*            m_busThread = {nullptr};
+
+            std::atomic<bool>   m_arbitrationEnabled = {true};
+            std::atomic<double> m_frameLossProbability = {0.0};
+            std::atomic<int>    m_jitterUSecs = {0};
+            std::atomic<quint64> m_transmittedFrames = {0};
+            std::atomic<quint64> m_lostFrames = {0};
+    };
+}
+
+#endif // VIRTUALCANBUS_H
@@ -0,0 +1,101 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIRTUALCANINTERFACE_H
+#define VIRTUALCANINTERFACE_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcaninterface.h"
+#include "virtualcanbus.h"
+
+#include <atomic>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The VirtualCanInterface class implements the ICanInterface as an endpoint of an in-process VirtualCanBus.
+     *
+     * The device of the interface is the name of the bus, all virtual interfaces with the same device are
+     * connected to each other. In contrast to a kernel `vcan` device, the bus models the wire time of the frames
+     * at the configured bit rates, so tools, bridges and protocols can be tested and benchmarked at realistic bus
+     * speeds without any privileges or kernel modules.
+     *
+     * Generally, it is not neccessary to create a VirtualCanInterface instance directly. Instead use
+     * CanInterfaceManager::addInterface() with the interface type VirtualCanInterface::InterfaceType.
+     */
+    class LINDWURMLIB_EXPORT VirtualCanInterface : public AbstractCanInterface
+    {
+        Q_OBJECT
+        public:
+
+            /**
+             * @brief The interface type name used to select this interface in the CanInterfaceManager.
+             */
+            static const char* const InterfaceType;
+
+                            VirtualCanInterface(const QString &id, const QString &device);
+            virtual         ~VirtualCanInterface();
+
+            /**
+             * @brief Returns the bus this interface is connected to.
+             * @return the virtual bus, e.g. to configure the simulated arbitration, loss or jitter.
+             */
+            VirtualCanBusSharedPtr bus() const;
+
+            virtual bool    connectInterface() override;
+            virtual bool    disconnectInterface() override;
+
+            virtual bool    supportsFlexibleDataRate() const override;
+            virtual bool    flexibleDataRateEnabled() const override;
+            virtual int     bitRate() const override;
+            virtual int     dataBitRate() const override;
+            virtual bool    localEchoEnabled() const override;
+            virtual CanTimestampSource timestampSource() const override;
+            virtual bool    connected() const override;
+
+            virtual void    setFlexibleDataRateEnabled(bool enabled) override;
+            virtual void    setBitRate(int bitRate) override;
+            virtual void    setDataBitRate(int dataBitRate) override;
+            virtual void    setLocalEchoEnabled(bool enable) override;
+
+        protected:
+
+            virtual void    transmitQueuedFrames() override;
+
+        private:
+
+            friend class VirtualCanBus;
+
+            // called by the bus thread
+            bool            nextFrame(QCanBusFrame &frame, qint64 &admissionDelayUSecs);
+            qint64          frameDurationNSecs(const QCanBusFrame &frame) const;
+            void            frameTransmitted(const QCanBusFrame &frame);
+            void            frameReceived(const QCanBusFrame &frame);
+
+        private:
+
+            VirtualCanBusSharedPtr  m_bus;
+
+            std::atomic<bool>   m_connected = { false };
+            std::atomic<bool>   m_flexibleDataRateEnabled = { false };
+            std::atomic<bool>   m_localEchoEnabled = { false };
+            std::atomic<int>    m_bitRate = { 0 };
+            std::atomic<int>    m_dataBitRate = { 0 };
+    };
+}
+
+#endif // VIRTUALCANINTERFACE_H
@@ -0,0 +1,92 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ABSTRACTCANTRACEFILEREADER_H
+#define ABSTRACTCANTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilereader.h"
+
+#include <QFile>
+
+#include <atomic>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The AbstractCanTraceFileReader class implements the common parts of the block based trace file readers.
+     *
+     * Subclasses parse the header of their format in readHeader() and decode complete records with decodeRecords().
+     * By default the file is read in blocks of BlockSize bytes which are split at line boundaries, which suits text
+     * formats. readFrames() is implemented on top of the blocks, so sequential and parallel reading share the parser.
+     */
+    class LINDWURMLIB_EXPORT AbstractCanTraceFileReader : public ICanTraceFileReader
+    {
+        public:
+
+            static const int BlockSize = 4 * 1024 * 1024;
+
+            AbstractCanTraceFileReader();
+            virtual ~AbstractCanTraceFileReader();
+
+            virtual bool    open(const QString &fileName) override;
+            virtual void    close() override;
+            virtual bool    atEnd() const override;
+            virtual int     readFrames(QVector<QCanBusFrame> &frames, int maxCount) override;
+            virtual bool    readBlock(CanTraceFileBlock &block) override;
+            virtual void    decodeBlock(CanTraceFileBlock &block) const override;
+            virtual void    completeBlock(CanTraceFileBlock &block) override;
+            virtual void    finishBlocks(CanTraceFileBlock &block) override;
+            virtual qint64  position() const override;
+            virtual qint64  size() const override;
+            virtual QString errorString() const override;
+
+        protected:
+
+            /**
+             * @brief Parses the header of the trace file after it has been opened
+             * @return `true` if the header is valid; otherwise the error string is set.
+             */
+            virtual bool    readHeader();
+
+            /**
+             * @brief Decodes complete records, may be called from any thread
+             * @param data      the records.
+             * @param context   the context of the block the records were read with.
+             * @param block     the block which receives the decoded frames.
+             */
+            virtual void    decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const = 0;
+
+            /**
+             * @brief Counts a record which could not be decoded, may be called from any thread
+             */
+            void            skipRecord() const;
+
+            QFile                       m_file = {};
+            QString                     m_errorString = {};
+
+        private:
+
+            mutable std::atomic<quint64>    m_skippedRecords = {0};
+            QByteArray                      m_carry = {};
+            QByteArray                      m_carryContext = {};
+            QVector<QCanBusFrame>           m_pendingFrames = {};
+            int                             m_pendingIndex = {0};
+            bool                            m_blocksFinished = { false };
+    };
+}
+
+#endif // ABSTRACTCANTRACEFILEREADER_H
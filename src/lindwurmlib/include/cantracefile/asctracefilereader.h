@@ -0,0 +1,59 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASCTRACEFILEREADER_H
+#define ASCTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcantracefilereader.h"
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The AscTraceFileReader class reads trace files in the Vector ASCII log format (*.asc).
+     *
+     * The header provides the start of the measurement and the number base of IDs and data bytes. Classic CAN,
+     * CAN FD and error frame events are read, all other events are ignored. Frames sent by the recording tool (`Tx`)
+     * are read as local echo. The channels are named `CAN <n>` after their channel number. Only absolute timestamps
+     * are supported, as timestamps relative to the previous event prevent the blocks from being decoded in parallel.
+     */
+    class LINDWURMLIB_EXPORT AscTraceFileReader : public AbstractCanTraceFileReader
+    {
+        public:
+
+            AscTraceFileReader();
+
+        protected:
+
+            virtual bool    readHeader() override;
+            virtual void    decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const override;
+
+        private:
+
+            bool            parseTimestamp(const QByteArray &field, QCanBusFrame &frame) const;
+            bool            parseFrameId(const QByteArray &field, QCanBusFrame &frame) const;
+            bool            parsePayload(const QList<QByteArray> &fields, int first, int count, QCanBusFrame &frame) const;
+
+            bool            parseClassicFrame(const QList<QByteArray> &fields, QCanBusFrame &frame) const;
+            bool            parseFdFrame(const QList<QByteArray> &fields, QCanBusFrame &frame) const;
+
+            qint64          m_startTimeUSecs = {0};
+            int             m_base = {16};
+    };
+}
+
+#endif // ASCTRACEFILEREADER_H
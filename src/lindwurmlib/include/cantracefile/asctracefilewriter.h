@@ -0,0 +1,69 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASCTRACEFILEWRITER_H
+#define ASCTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilewriter.h"
+
+#include <QFile>
+#include <QStringList>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The AscTraceFileWriter class writes trace files in the Vector ASCII log format (*.asc).
+     *
+     * The measurement starts with the first written frame, whose timestamp is written to the header. Each interface
+     * is assigned a channel number in order of appearance. Frames received by local echo are written as `Tx`.
+     */
+    class LINDWURMLIB_EXPORT AscTraceFileWriter : public ICanTraceFileWriter
+    {
+        public:
+
+            AscTraceFileWriter();
+            virtual ~AscTraceFileWriter();
+
+            virtual bool    open(const QString &fileName) override;
+            virtual void    close() override;
+            virtual bool    writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName) override;
+            virtual QString errorString() const override;
+
+            /**
+             * @brief Formats a frame as an event line of an ASC file
+             * @param frame             the frame to format.
+             * @param channel           the channel number, starting at 1.
+             * @param startTimeUSecs    the start of the measurement in microseconds since epoch.
+             * @return the line without line break.
+             */
+            static QByteArray formatLine(const QCanBusFrame &frame, int channel, qint64 startTimeUSecs);
+
+        private:
+
+            bool            writeHeader(qint64 startTimeUSecs);
+            bool            write(const QByteArray &data);
+
+            QFile           m_file;
+            QString         m_errorString;
+            QStringList     m_channelNames = {};
+            qint64          m_startTimeUSecs = {0};
+            bool            m_headerWritten = { false };
+    };
+}
+
+#endif // ASCTRACEFILEWRITER_H
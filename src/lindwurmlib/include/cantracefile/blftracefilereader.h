@@ -0,0 +1,74 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLFTRACEFILEREADER_H
+#define BLFTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcantracefilereader.h"
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The BlfTraceFileReader class reads trace files in the Vector binary logging format (*.blf).
+     *
+     * A BLF file is a sequence of log containers, each holding a zlib compressed part of a continuous stream of
+     * objects. Objects may be split between containers. readBlock() only reads whole containers, so decodeBlock()
+     * inflates and decodes them in parallel, while the objects split between blocks are joined by completeBlock().
+     * Classic CAN, CAN FD and error frame objects are read, all other objects are ignored. The channels are named
+     * `CAN <n>` after their channel number.
+     */
+    class LINDWURMLIB_EXPORT BlfTraceFileReader : public AbstractCanTraceFileReader
+    {
+        public:
+
+            BlfTraceFileReader();
+
+            virtual bool    readBlock(CanTraceFileBlock &block) override;
+            virtual void    decodeBlock(CanTraceFileBlock &block) const override;
+
+        protected:
+
+            virtual bool    readHeader() override;
+            virtual void    decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const override;
+
+        private:
+
+            /**
+             * @brief Decodes a chain of objects
+             * @param objects   the uncompressed objects.
+             * @param position  the position of the first object.
+             * @param block     the block which receives the decoded frames.
+             * @return the position of the incomplete object at the end; `-1` if the data is no chain of objects.
+             */
+            int             decodeObjects(const QByteArray &objects, int position, CanTraceFileBlock &block) const;
+
+            /**
+             * @brief Decodes a single object
+             * @param object    the object including its header.
+             * @param size      the size of the object.
+             * @param frame     the decoded frame.
+             * @param channel   the channel the frame was recorded from.
+             * @return `true` if the object holds a frame.
+             */
+            bool            decodeObject(const char *object, int size, QCanBusFrame &frame, int &channel) const;
+
+            qint64          m_startTimeUSecs = {0};
+    };
+}
+
+#endif // BLFTRACEFILEREADER_H
@@ -0,0 +1,70 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLFTRACEFILEWRITER_H
+#define BLFTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilewriter.h"
+
+#include <QFile>
+#include <QStringList>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The BlfTraceFileWriter class writes trace files in the Vector binary logging format (*.blf).
+     *
+     * The objects are collected in a buffer, which is written as a zlib compressed log container whenever it exceeds
+     * ContainerSize. The measurement starts with the first written frame. The file header, which holds the number
+     * of objects and the end of the measurement, is completed when the file is closed. Each interface is assigned
+     * a channel number in order of appearance.
+     */
+    class LINDWURMLIB_EXPORT BlfTraceFileWriter : public ICanTraceFileWriter
+    {
+        public:
+
+            static const int ContainerSize = 128 * 1024;
+
+            BlfTraceFileWriter();
+            virtual ~BlfTraceFileWriter();
+
+            virtual bool    open(const QString &fileName) override;
+            virtual void    close() override;
+            virtual bool    writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName) override;
+            virtual QString errorString() const override;
+
+        private:
+
+            void            appendObject(quint32 objectType, qint64 timestampUSecs, const QByteArray &body);
+            bool            writeContainer();
+            bool            writeFileHeader();
+            bool            write(const QByteArray &data);
+
+            QFile           m_file;
+            QString         m_errorString;
+            QStringList     m_channelNames = {};
+            QByteArray      m_objects = {};
+            qint64          m_startTimeUSecs = {0};
+            qint64          m_stopTimeUSecs = {0};
+            bool            m_hasFrames = { false };
+            quint32         m_objectCount = {0};
+            quint64         m_uncompressedSize = {0};
+    };
+}
+
+#endif // BLFTRACEFILEWRITER_H
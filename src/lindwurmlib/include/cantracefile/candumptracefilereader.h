@@ -0,0 +1,55 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANDUMPTRACEFILEREADER_H
+#define CANDUMPTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcantracefilereader.h"
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CandumpTraceFileReader class reads trace files in the log file format of the can-utils `candump -l`.
+     *
+     * Each line holds a single frame, e.g. `(1436509052.249713) can0 123#11223344`. Extended frame IDs have eight
+     * digits, remote frames are written as `123#R`, CAN FD frames as `123##<flags><data>` and error frames carry
+     * the `CAN_ERR_FLAG` in their ID. A trailing `T` marks a frame sent by the recording interface, which is read
+     * as local echo. Lines which cannot be parsed are skipped. The interface names are the channels of the frames.
+     */
+    class LINDWURMLIB_EXPORT CandumpTraceFileReader : public AbstractCanTraceFileReader
+    {
+        public:
+
+            CandumpTraceFileReader();
+
+            /**
+             * @brief Parses a single line of a candump log file
+             * @param line          the line to parse.
+             * @param frame         the parsed frame.
+             * @param interfaceName the name of the interface the frame was recorded from.
+             * @return `true` if the line holds a valid frame.
+             */
+            static bool     parseLine(const QByteArray &line, QCanBusFrame &frame, QByteArray &interfaceName);
+
+        protected:
+
+            virtual void    decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const override;
+    };
+}
+
+#endif // CANDUMPTRACEFILEREADER_H
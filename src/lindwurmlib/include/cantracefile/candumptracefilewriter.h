@@ -0,0 +1,61 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANDUMPTRACEFILEWRITER_H
+#define CANDUMPTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilewriter.h"
+
+#include <QFile>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CandumpTraceFileWriter class writes trace files in the log file format of the can-utils `candump -l`.
+     *
+     * The written files can be read by CandumpTraceFileReader and replayed with `canplayer`. Frames received by
+     * local echo are marked with a trailing `T`.
+     */
+    class LINDWURMLIB_EXPORT CandumpTraceFileWriter : public ICanTraceFileWriter
+    {
+        public:
+
+            CandumpTraceFileWriter();
+            virtual ~CandumpTraceFileWriter();
+
+            virtual bool    open(const QString &fileName) override;
+            virtual void    close() override;
+            virtual bool    writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName) override;
+            virtual QString errorString() const override;
+
+            /**
+             * @brief Formats a frame as a line of a candump log file
+             * @param frame         the frame to format.
+             * @param interfaceName the name of the interface the frame was captured from.
+             * @return the line without line break.
+             */
+            static QByteArray formatLine(const QCanBusFrame &frame, const QByteArray &interfaceName);
+
+        private:
+
+            QFile       m_file;
+            QString     m_errorString;
+    };
+}
+
+#endif // CANDUMPTRACEFILEWRITER_H
@@ -0,0 +1,68 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CANTRACEFILEBLOCK_H
+#define CANTRACEFILEBLOCK_H
+
+#include <QByteArray>
+#include <QCanBusFrame>
+#include <QStringList>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanTraceFileBlock struct holds a part of a trace file, which is decoded independently of the other parts.
+     *
+     * A block is read sequentially by ICanTraceFileReader::readBlock() and decoded by ICanTraceFileReader::decodeBlock()
+     * in any thread. A record may be split between two blocks: its beginning remains as the tail of the first block,
+     * its end as the head of the next one. ICanTraceFileReader::completeBlock() joins them in order of the blocks.
+     */
+    struct CanTraceFileBlock
+    {
+        QByteArray              data;                       // the raw data as read from the file
+        QByteArray              context;                    // format specific state at the start of the block
+
+        bool                    hasBoundary = { false };    // whether a record starts within the block
+        QByteArray              head;                       // the bytes before the first record start
+        QByteArray              tail;                       // the bytes of an incomplete record at the end
+
+        QVector<QCanBusFrame>   frames = {};                // the decoded frames
+        QVector<quint16>        channels = {};              // the channel of each frame, an index into channelNames
+        QStringList             channelNames = {};          // the names of the channels, e.g. the interface names
+
+        /**
+         * @brief Appends a decoded frame
+         * @param frame         the frame.
+         * @param channelName   the name of the channel the frame was recorded from.
+         */
+        void appendFrame(const QCanBusFrame &frame, const QString &channelName)
+        {
+            int channel = channelNames.indexOf(channelName);
+
+            if ( channel < 0 )
+            {
+                channel = channelNames.size();
+                channelNames.append(channelName);
+            }
+
+            frames.append(frame);
+            channels.append( quint16(channel) );
+        }
+    };
+}
+
+#endif // CANTRACEFILEBLOCK_H
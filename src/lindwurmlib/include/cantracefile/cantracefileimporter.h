@@ -0,0 +1,121 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANTRACEFILEIMPORTER_H
+#define CANTRACEFILEIMPORTER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilereader.h"
+#include "utils/spscringbuffer.h"
+
+#include <QObject>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+
+class QThread;
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanTraceFileImporter class reads a trace file in a background thread and decodes it with all cores.
+     *
+     * The import thread reads the blocks of the file sequentially and decodes up to QThread::idealThreadCount() of them
+     * in parallel by a pool of decoder threads owned by the importer. The decoded blocks are completed in order and passed to the consumer through a bounded queue. The
+     * import thread waits while the queue is full, so the memory used by the import does not depend on the size of
+     * the file. The consumer is notified by blocksAvailable() in the thread of the importer, while a notification is
+     * pending no further notifications are posted.
+     */
+    class LINDWURMLIB_EXPORT CanTraceFileImporter : public QObject
+    {
+        Q_OBJECT
+        public:
+
+            static const int QueueCapacity = 4;
+
+            CanTraceFileImporter(QObject *parent = nullptr);
+            virtual ~CanTraceFileImporter();
+
+            /**
+             * @brief Opens the trace file and starts the import
+             * @param fileName the name of the trace file, whose format is determined by its file extension.
+             * @return `true` if the import has been started; otherwise see errorString().
+             */
+            bool                        start(const QString &fileName);
+
+            /**
+             * @brief Cancels the import, the blocks not yet taken are discarded and finished() is emitted
+             */
+            void                        cancel();
+
+            /**
+             * @brief Returns `true` while the import is running
+             * @return `true` if the import is running.
+             */
+            bool                        isRunning() const;
+
+            /**
+             * @brief Takes all decoded blocks currently available. Must only be called in the thread of the importer.
+             * @return the decoded blocks in order of the file.
+             */
+            QVector<CanTraceFileBlock>  takeBlocks();
+
+            /**
+             * @brief Returns a description of the error the import failed with
+             * @return the description of the error.
+             */
+            QString                     errorString() const;
+
+        signals:
+
+            /**
+             * @brief This signal is emitted when decoded blocks are available, see takeBlocks()
+             */
+            void                        blocksAvailable();
+
+            /**
+             * @brief This signal is emitted after a block has been read
+             * @param bytesRead     the number of bytes read from the trace file.
+             * @param totalBytes    the size of the trace file.
+             */
+            void                        progress(qint64 bytesRead, qint64 totalBytes);
+
+            /**
+             * @brief This signal is emitted when the import has ended, after the last blocks have been announced
+             * @param success `true` if the whole file has been imported; `false` on an error or if it was cancelled.
+             */
+            void                        finished(bool success);
+
+        private:
+
+            void                        importLoop(ICanTraceFileReader &reader);
+            bool                        publishBlock(const CanTraceFileBlock &block);
+            void                        stopImportThread();
+
+            QThread*                    m_importThread = { nullptr };
+            std::atomic<bool>           m_cancelRequested = { false };
+            SpscRingBuffer<CanTraceFileBlock> m_blocks;
+            QSemaphore                  m_freeSlots;
+            QThreadPool                 m_decoderPool;
+            std::atomic<bool>           m_notificationPending = { false };
+            QString                     m_errorString = {};
+    };
+}
+
+#endif // CANTRACEFILEIMPORTER_H
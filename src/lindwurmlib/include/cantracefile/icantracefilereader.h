@@ -0,0 +1,134 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICANTRACEFILEREADER_H
+#define ICANTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "cantracefileblock.h"
+
+#include <QCanBusFrame>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    class ICanTraceFileReader;
+
+    typedef std::unique_ptr<ICanTraceFileReader> ICanTraceFileReaderPtr;
+
+    /**
+     * @brief The ICanTraceFileReader class provides an interface to read recorded CAN frames from a trace file.
+     *
+     * Frames are read sequentially in the order they were recorded, keeping their recorded timestamps. Readers
+     * read the file incrementally, so even captures of several hours can be read without loading them into memory.
+     *
+     * Besides readFrames(), the file can be read in blocks: readBlock() and completeBlock() have to be called
+     * sequentially in order of the blocks, while decodeBlock() can be executed for several blocks in parallel. The
+     * CanTraceFileImporter uses this to parse large files with all cores. Both ways must not be mixed.
+     */
+    class LINDWURMLIB_EXPORT ICanTraceFileReader
+    {
+        public:
+
+            virtual ~ICanTraceFileReader() {}
+
+            /**
+             * @brief Creates a reader for the format of the given trace file, which is determined by its file extension
+             * @param fileName the name of the trace file.
+             * @return a reader (not yet opened) or `nullptr` if the format is not supported.
+             */
+            static ICanTraceFileReaderPtr createReader(const QString &fileName);
+
+            /**
+             * @brief Opens the trace file
+             * @param fileName the name of the trace file.
+             * @return `true` if the file was opened successfully; otherwise see errorString().
+             */
+            virtual bool    open(const QString &fileName) = 0;
+
+            /**
+             * @brief Closes the trace file
+             */
+            virtual void    close() = 0;
+
+            /**
+             * @brief Returns `true` if all frames have been read
+             * @return `true` if the end of the trace file has been reached.
+             */
+            virtual bool    atEnd() const = 0;
+
+            /**
+             * @brief Reads the next frames from the trace file
+             * @param frames    the frames read are appended to this vector.
+             * @param maxCount  the maximum number of frames to read.
+             * @return the number of frames read; `0` at the end of the file.
+             */
+            virtual int     readFrames(QVector<QCanBusFrame> &frames, int maxCount) = 0;
+
+            /**
+             * @brief Reads the next block of raw data from the trace file
+             * @param block the block to fill.
+             * @return `true` if a block was read; `false` at the end of the file or on an error (see errorString()).
+             */
+            virtual bool    readBlock(CanTraceFileBlock &block) = 0;
+
+            /**
+             * @brief Decodes the frames of a block, may be called from any thread
+             * @param block the block read by readBlock(), whose data is replaced by the decoded frames.
+             */
+            virtual void    decodeBlock(CanTraceFileBlock &block) const = 0;
+
+            /**
+             * @brief Decodes the records split between the previous block and the given one
+             *
+             * The frames of the split records are prepended to the frames of the block. Must be called for all blocks
+             * in the order they were read.
+             *
+             * @param block the decoded block.
+             */
+            virtual void    completeBlock(CanTraceFileBlock &block) = 0;
+
+            /**
+             * @brief Decodes the incomplete record at the end of the last block, if it can be decoded at all
+             * @param block the block which receives the frames.
+             */
+            virtual void    finishBlocks(CanTraceFileBlock &block) = 0;
+
+            /**
+             * @brief Returns the number of bytes read from the trace file so far
+             * @return the read position in bytes.
+             */
+            virtual qint64  position() const = 0;
+
+            /**
+             * @brief Returns the size of the trace file
+             * @return the size in bytes.
+             */
+            virtual qint64  size() const = 0;
+
+            /**
+             * @brief Returns a description of the last error
+             * @return the description of the last error.
+             */
+            virtual QString errorString() const = 0;
+    };
+}
+
+#endif // ICANTRACEFILEREADER_H
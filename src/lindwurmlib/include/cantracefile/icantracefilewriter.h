@@ -0,0 +1,82 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICANTRACEFILEWRITER_H
+#define ICANTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+
+#include <QCanBusFrame>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    class ICanTraceFileWriter;
+
+    typedef std::unique_ptr<ICanTraceFileWriter> ICanTraceFileWriterPtr;
+
+    /**
+     * @brief The ICanTraceFileWriter class provides an interface to record CAN frames to a trace file.
+     *
+     * Frames are appended in the order they are written, keeping their timestamps. Writers buffer the output and
+     * write it incrementally, so they can record captures of any length.
+     */
+    class LINDWURMLIB_EXPORT ICanTraceFileWriter
+    {
+        public:
+
+            virtual ~ICanTraceFileWriter() {}
+
+            /**
+             * @brief Creates a writer for the format of the given trace file, which is determined by its file extension
+             * @param fileName the name of the trace file.
+             * @return a writer (not yet opened) or `nullptr` if the format is not supported.
+             */
+            static ICanTraceFileWriterPtr createWriter(const QString &fileName);
+
+            /**
+             * @brief Creates the trace file, an existing file is overwritten
+             * @param fileName the name of the trace file.
+             * @return `true` if the file was created successfully; otherwise see errorString().
+             */
+            virtual bool    open(const QString &fileName) = 0;
+
+            /**
+             * @brief Writes the buffered frames and closes the trace file
+             */
+            virtual void    close() = 0;
+
+            /**
+             * @brief Appends frames to the trace file
+             * @param frames        the frames to write.
+             * @param interfaceName the name of the interface the frames were captured from.
+             * @return `true` if the frames were written; otherwise see errorString().
+             */
+            virtual bool    writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName) = 0;
+
+            /**
+             * @brief Returns a description of the last error
+             * @return the description of the last error.
+             */
+            virtual QString errorString() const = 0;
+    };
+}
+
+#endif // ICANTRACEFILEWRITER_H
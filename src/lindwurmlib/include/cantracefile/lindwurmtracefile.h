@@ -0,0 +1,188 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LINDWURMTRACEFILE_H
+#define LINDWURMTRACEFILE_H
+
+#include "lindwurmlib_global.h"
+#include "cantracefile/lindwurmtraceformat.h"
+#include "cantracer/canframetracerrecord.h"
+#include "cantracer/canframeaggregator.h"
+
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The LindwurmTraceFile class opens a Lindwurm trace file (*.lwtrace) by mapping it into memory.
+     *
+     * Opening only reads the header and the index at the end of the file, the chunks of records are served directly
+     * from the mapping and are paged in by the kernel when they are accessed. The file is mapped copy-on-write, so the
+     * records of chunks with CAN FD payloads can be pointed to their mapped payloads without modifying the file. This
+     * relocation is deferred until a chunk is accessed the first time (see relocatePayloadsOf()), so only the pages
+     * of visited chunks with CAN FD payloads are copied.
+     *
+     * A file which was not closed properly (e.g. after a crash during a capture) has no index, in this case the chunk
+     * index is recovered by walking the chunk headers and the aggregate records have to be rebuilt from the records.
+     */
+    class LINDWURMLIB_EXPORT LindwurmTraceFile
+    {
+        public:
+
+            LindwurmTraceFile();
+            ~LindwurmTraceFile();
+
+            LindwurmTraceFile(const LindwurmTraceFile&) = delete;
+            LindwurmTraceFile& operator=(const LindwurmTraceFile&) = delete;
+
+            /**
+             * @brief Maps the trace file and reads its index
+             * @param fileName the name of the trace file.
+             * @return `true` on success; otherwise see errorString().
+             */
+            bool            open(const QString &fileName);
+
+            /**
+             * @brief Unmaps the trace file, all records returned by chunkRecords() become invalid
+             */
+            void            close();
+
+            /**
+             * @brief Returns whether a trace file is mapped
+             * @return `true` if the trace file is open.
+             */
+            bool            isOpen() const;
+
+            /**
+             * @brief Returns the name of the mapped trace file
+             * @return the file name.
+             */
+            QString         fileName() const;
+
+            /**
+             * @brief Returns the start time of the trace
+             * @return the start time in µs.
+             */
+            qint64          startTime() const;
+
+            /**
+             * @brief Returns the number of records in the trace file
+             * @return the number of records.
+             */
+            qint64          recordCount() const;
+
+            /**
+             * @brief Returns the number of chunks in the trace file
+             * @return the number of chunks.
+             */
+            int             chunkCount() const;
+
+            /**
+             * @brief Returns the mapped records of a chunk
+             * @param chunk the index of the chunk.
+             * @return the records, which stay valid until the file is closed.
+             */
+            CanFrameTracerRecord* chunkRecords(int chunk) const;
+
+            /**
+             * @brief Returns the number of records of a chunk
+             * @param chunk the index of the chunk.
+             * @return the number of records; LindwurmTraceFormat::ChunkRecordCount for all but the last chunk.
+             */
+            int             chunkRecordCount(int chunk) const;
+
+            /**
+             * @brief Checks the records of the chunk holding a record and relocates their payloads, unless this has been done before.
+             *
+             * Must be called before a record returned by chunkRecords() is read. May be called from any thread, only
+             * the first access to a chunk blocks. Records of a corrupted file with an undefined frame type are turned
+             * into invalid frames, payload lengths are limited to the longest CAN FD payload and payloads which lie
+             * outside of their chunk are replaced by zeros.
+             *
+             * @param recordIndex the index of the record in the trace file.
+             */
+            inline void     relocatePayloadsOf(qint64 recordIndex) const
+            {
+                const qint64 chunk = recordIndex / LindwurmTraceFormat::ChunkRecordCount;
+
+                if ( chunk >= 0 && chunk < m_chunkEntries.size() && ! m_relocatedChunks[chunk].load(std::memory_order_acquire) )
+                {
+                    relocatePayloads( int(chunk) );
+                }
+            }
+
+            /**
+             * @brief Looks up the first record at or after the given time with the chunk index
+             * @param timestampUSecs the time in µs.
+             * @return the index of the record; recordCount() if all records are earlier.
+             */
+            qint64          recordIndexAtTime(qint64 timestampUSecs) const;
+
+            /**
+             * @brief Returns whether the trace file contains the aggregate records of the trace
+             * @return `true` if aggregators() holds the aggregate records; `false` if they have to be rebuilt.
+             */
+            bool            hasAggregators() const;
+
+            /**
+             * @brief Returns the aggregate records stored in the trace file
+             * @return the aggregate records.
+             */
+            QVector<CanFrameAggregator> aggregators() const;
+
+            /**
+             * @brief Returns the names of the interfaces the records were captured from
+             * @return the interface names by the interface indices stored in the records.
+             */
+            QMap<CanInterfaceIndex, QString> interfaceNames() const;
+
+            /**
+             * @brief Returns a description of the last error
+             * @return the description of the last error.
+             */
+            QString         errorString() const;
+
+        private:
+
+            bool            readIndex(qint64 indexOffset, quint32 version);
+            bool            recoverIndex();
+            bool            validateChunkEntries(qint64 chunkAreaEnd) const;
+            void            relocatePayloads(int chunk) const;
+            bool            fail(const QString &errorString);
+
+            QFile                                       m_file = {};
+            uchar*                                      m_map = { nullptr };
+            qint64                                      m_size = {0};
+            qint64                                      m_startTime = {0};
+            qint64                                      m_recordCount = {0};
+            bool                                        m_hasAggregators = { false };
+            QVector<LindwurmTraceFormat::ChunkEntry>    m_chunkEntries = {};
+            std::unique_ptr<std::atomic<bool>[]>        m_relocatedChunks = {};
+            mutable QMutex                              m_relocationMutex = {};
+            QVector<CanFrameAggregator>                 m_aggregators = {};
+            QMap<CanInterfaceIndex, QString>            m_interfaceNames = {};
+            QString                                     m_errorString = {};
+    };
+}
+
+#endif // LINDWURMTRACEFILE_H
@@ -0,0 +1,117 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LINDWURMTRACEFILEWRITER_H
+#define LINDWURMTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+#include "cantracefile/lindwurmtraceformat.h"
+#include "cantracer/canframetracerrecord.h"
+#include "cantracer/canframeaggregator.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The LindwurmTraceFileWriter class streams frame records into a Lindwurm trace file (*.lwtrace).
+     *
+     * Records are collected into chunks of LindwurmTraceFormat::ChunkRecordCount records, which are written as soon as
+     * they are filled, so a capture of any length can be recorded while it is running. The chunk index, the aggregate
+     * records and the names of the source interfaces are appended by close(). See LindwurmTraceFile for reading.
+     */
+    class LINDWURMLIB_EXPORT LindwurmTraceFileWriter
+    {
+        public:
+
+            LindwurmTraceFileWriter();
+            ~LindwurmTraceFileWriter();
+
+            LindwurmTraceFileWriter(const LindwurmTraceFileWriter&) = delete;
+            LindwurmTraceFileWriter& operator=(const LindwurmTraceFileWriter&) = delete;
+
+            /**
+             * @brief Creates the trace file, an existing file is overwritten
+             * @param fileName the name of the trace file.
+             * @return `true` on success; otherwise see errorString().
+             */
+            bool            open(const QString &fileName);
+
+            /**
+             * @brief Returns whether the trace file is open
+             * @return `true` if records can be appended.
+             */
+            bool            isOpen() const;
+
+            /**
+             * @brief Appends a record to the current chunk and writes the chunk when it is filled
+             * @param record the record, its CAN FD payload is copied.
+             * @return `true` on success; otherwise see errorString().
+             */
+            bool            appendRecord(const CanFrameTracerRecord &record);
+
+            /**
+             * @brief Returns the number of appended records
+             * @return the number of records.
+             */
+            qint64          recordCount() const;
+
+            /**
+             * @brief Returns the indices of the interfaces the appended records were captured from
+             * @return the interface indices, whose names have to be passed to close().
+             */
+            QList<CanInterfaceIndex> sourceInterfaces() const;
+
+            /**
+             * @brief Writes the last chunk and the index and closes the trace file
+             * @param startTimeUSecs    the start time of the trace in µs.
+             * @param aggregators       the aggregate records of the trace, if empty they are rebuilt when the file is opened.
+             * @param interfaceNames    the names of the source interfaces.
+             * @return `true` on success; otherwise see errorString().
+             */
+            bool            close(qint64 startTimeUSecs, const QVector<CanFrameAggregator> &aggregators, const QMap<CanInterfaceIndex, QString> &interfaceNames);
+
+            /**
+             * @brief Returns a description of the last error
+             * @return the description of the last error.
+             */
+            QString         errorString() const;
+
+        private:
+
+            bool            writeChunk();
+            bool            writeIndex(const QVector<CanFrameAggregator> &aggregators, const QMap<CanInterfaceIndex, QString> &interfaceNames);
+            bool            write(const void *data, qint64 size);
+
+            QFile                                       m_file = {};
+            QByteArray                                  m_chunkRecords = {};
+            QByteArray                                  m_chunkPayload = {};
+            int                                         m_chunkRecordCount = {0};
+            qint64                                      m_chunkMinTimestampUSecs = {0};
+            qint64                                      m_chunkMaxTimestampUSecs = {0};
+            qint64                                      m_recordCount = {0};
+            QVector<LindwurmTraceFormat::ChunkEntry>    m_chunkEntries = {};
+            QSet<CanInterfaceIndex>                     m_sourceInterfaces = {};
+            QString                                     m_errorString = {};
+    };
+}
+
+#endif // LINDWURMTRACEFILEWRITER_H
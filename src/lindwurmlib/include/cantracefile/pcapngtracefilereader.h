@@ -0,0 +1,62 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCAPNGTRACEFILEREADER_H
+#define PCAPNGTRACEFILEREADER_H
+
+#include "lindwurmlib_global.h"
+#include "abstractcantracefilereader.h"
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The PcapngTraceFileReader class reads captures in the PCAP-NG format (*.pcapng), e.g. of Wireshark.
+     *
+     * Packets of interfaces with the SocketCAN link type are read as CAN frames, all other packets are ignored.
+     * Outbound packets are read as local echo. The interface names of the capture are the channels of the frames.
+     *
+     * readBlock() only reads whole PCAP-NG blocks and processes the section headers and interface descriptions, so
+     * the blocks of packets are decoded in parallel. The interface descriptions at the start of a block are passed
+     * as its context.
+     */
+    class LINDWURMLIB_EXPORT PcapngTraceFileReader : public AbstractCanTraceFileReader
+    {
+        public:
+
+            PcapngTraceFileReader();
+
+            virtual bool    readBlock(CanTraceFileBlock &block) override;
+            virtual void    decodeBlock(CanTraceFileBlock &block) const override;
+
+        protected:
+
+            virtual bool    readHeader() override;
+            virtual void    decodeRecords(const QByteArray &data, const QByteArray &context, CanTraceFileBlock &block) const override;
+
+        private:
+
+            bool            fillBuffer(int size);
+            bool            readSectionHeader(const char *data);
+            bool            readInterfaceDescription(const char *data, int length);
+
+            QByteArray      m_buffer = {};              // read but not yet processed data
+            bool            m_bigEndian = { false };    // the byte order of the current section
+            QByteArray      m_context = {};             // the serialized interface descriptions of the current section
+    };
+}
+
+#endif // PCAPNGTRACEFILEREADER_H
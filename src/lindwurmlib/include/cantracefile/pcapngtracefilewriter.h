@@ -0,0 +1,57 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCAPNGTRACEFILEWRITER_H
+#define PCAPNGTRACEFILEWRITER_H
+
+#include "lindwurmlib_global.h"
+#include "icantracefilewriter.h"
+
+#include <QFile>
+#include <QStringList>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The PcapngTraceFileWriter class writes captures in the PCAP-NG format (*.pcapng), which Wireshark reads.
+     *
+     * Each interface is described with its name and the SocketCAN link type before its first frame. The frames are
+     * written as packets with microsecond timestamps, frames received by local echo are marked as outbound.
+     */
+    class LINDWURMLIB_EXPORT PcapngTraceFileWriter : public ICanTraceFileWriter
+    {
+        public:
+
+            PcapngTraceFileWriter();
+            virtual ~PcapngTraceFileWriter();
+
+            virtual bool    open(const QString &fileName) override;
+            virtual void    close() override;
+            virtual bool    writeFrames(const QVector<QCanBusFrame> &frames, const QString &interfaceName) override;
+            virtual QString errorString() const override;
+
+        private:
+
+            bool            write(const QByteArray &data);
+
+            QFile           m_file;
+            QString         m_errorString;
+            QStringList     m_interfaceNames = {};
+    };
+}
+
+#endif // PCAPNGTRACEFILEWRITER_H
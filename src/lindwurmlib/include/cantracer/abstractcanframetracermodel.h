@@ -21,6 +21,10 @@
 #include <QAbstractTableModel>
 #include <QCanBusFrame>
 
+#include "caninterface/cantimestampsource.h"
+#include "caninterface/caninterfaceindex.h"
+#include "cantracer/canframerenderrecord.h"
+
 namespace Lindwurm::Lib
 {
     class CanFrameTracer;
@@ -34,7 +38,14 @@ namespace Lindwurm::Lib
 
             enum
             {
-                CopyTextRole = Qt::UserRole + 1
+                CopyTextRole = Qt::UserRole + 1,
+
+                /**
+                 * @brief A `const CanFrameRenderRecord*` for cells which can be painted without display text.
+                 *
+                 * The record is reused by the model and only valid until the next request of this role.
+                 */
+                RenderRecordRole
             };
 
         protected:
@@ -42,10 +53,19 @@ namespace Lindwurm::Lib
             QString             getFrameTime(const QCanBusFrame::TimeStamp &frameTimestamp) const;
             QString             getFrameTimeDiff(qint64 timeDiffMicroSeconds) const;
             QString             toASCIIString(const QByteArray &data) const;
+            QString             timestampSourceDescription(CanTimestampSource source) const;
+            QString             interfaceName(CanInterfaceIndex interfaceIndex) const;
+            QString             getFrameLength(const QCanBusFrame &frame) const;
+            QString             getCopyText(const QCanBusFrame &frame) const;
+            QVariant            renderRecord(CanFrameRenderRecord::Field field, qint64 timestampUSecs, quint32 frameId, const quint8 *payload, int payloadLength) const;
 
         protected:
 
             CanFrameTracer*     m_tracer = { nullptr };
+
+        private:
+
+            mutable CanFrameRenderRecord m_renderRecord = {};
     };
 }
 
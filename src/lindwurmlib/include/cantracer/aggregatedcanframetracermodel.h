@@ -40,10 +40,18 @@ namespace Lindwurm::Lib
             virtual QVariant    data(const QModelIndex &index, int role = Qt::DisplayRole) const ;
             virtual QVariant    headerData(int section, Qt::Orientation orientation, int role) const;
 
+            /**
+             * @brief Returns the model index of the aggregate record of a frame ID.
+             * @param frameId   the frame ID.
+             * @param column    the column of the model index.
+             * @return the model index or an invalid index if the frame ID has not been traced.
+             */
+            QModelIndex         indexOfFrameId(quint32 frameId, int column = 0) const;
+
         private slots:
 
-            void                aggregateRecordInserted();
-            void                aggregateRecordUpdated(int aggregateRecordIndex);
+            void                aggregateRecordsInserted(int count);
+            void                aggregateRecordsUpdated(const QVector<int> &aggregateRecordIndices);
             void                updateModel(void);
 
         private:
@@ -0,0 +1,63 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CANFRAMERENDERRECORD_H
+#define CANFRAMERENDERRECORD_H
+
+#include "lindwurmlib_global.h"
+
+#include <QChar>
+#include <QMetaType>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The CanFrameRenderRecord struct holds the raw values of a single tracer cell for painting.
+     *
+     * The tracer models fill a render record instead of building display strings, a delegate formats it into a
+     * reusable text buffer. The text equals the display text of the cell, but no memory is allocated.
+     */
+    struct LINDWURMLIB_EXPORT CanFrameRenderRecord
+    {
+        enum Field : quint8
+        {
+            Time,
+            FrameId,
+            HexPayload,
+            AsciiPayload
+        };
+
+        static const int MaxPayloadLength   = 64;
+        static const int MaxTextLength      = 3 * MaxPayloadLength;     // the hex payload of a CAN FD frame
+
+        /**
+         * @brief Formats the field into a text buffer.
+         * @param text a buffer for at least MaxTextLength characters.
+         * @return the length of the text.
+         */
+        int             format(QChar *text) const;
+
+        Field           field = { Time };
+        qint64          traceTimeUSecs = {0};
+        quint32         frameId = {0};
+        int             payloadLength = {0};
+        quint8          payload[MaxPayloadLength] = {};
+    };
+}
+
+Q_DECLARE_METATYPE(const Lindwurm::Lib::CanFrameRenderRecord*)
+
+#endif // CANFRAMERENDERRECORD_H
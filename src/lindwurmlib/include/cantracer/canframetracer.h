@@ -28,12 +28,41 @@
 
 #include "cantracer/canframetracerrecord.h"
 #include "cantracer/canframeaggregator.h"
+#include "cantracer/canframeidindex.h"
+#include "cantracer/canframehistoryindex.h"
+#include "cantracer/canpayloadarena.h"
+#include "cantracer/canframerecordspill.h"
+#include "cantracefile/lindwurmtracefile.h"
+#include "cantracefile/lindwurmtracefilewriter.h"
+#include "cantracefile/cantracefileimporter.h"
 #include "caninterface/icaninterfacehandlesharedptr.h"
+#include "utils/segmentedappendstore.h"
+
+#include <memory>
 
 namespace Lindwurm::Lib
 {
     /**
      * @brief The CanFrameTracer allows to create a trace log of a CAN interface.
+     *
+     * Frame records are kept in an append-only SegmentedAppendStore, so they never move once inserted. The models
+     * read them without locking while new frames are appended. CAN FD payloads which do not fit into the packed
+     * records are kept in a CanPayloadArena.
+     *
+     * By default the trace grows without limit. setCaptureLimits() turns it into a ring buffer which keeps only
+     * the latest frame records and evicts the oldest ones from the head, while the aggregate records keep their
+     * statistics over the whole trace.
+     *
+     * With setSpillDirectory() older chunks of the trace are sealed into memory-mapped segment files, so only the
+     * most recent records stay in RAM while all records remain accessible.
+     *
+     * Traces are stored in the indexed Lindwurm trace file format (*.lwtrace). setRecordingFile() streams the records
+     * into a file while capturing, saveTraceFile() writes the retained records afterwards. openTraceFile() maps a
+     * trace file and serves its records to the models without reading or copying them.
+     *
+     * Traces of other tools (candump, Vector ASC and BLF, PCAP-NG) are read in the background with importTraceFile(),
+     * which decodes the file on all cores and appends the frames while it is read. exportTraceFile() writes the
+     * retained frames in one of these formats.
      */
     class LINDWURMLIB_EXPORT CanFrameTracer : public QObject
     {
@@ -61,33 +90,252 @@ namespace Lindwurm::Lib
              */
             qint64                  startTime() const;
 
+            /**
+             * @brief Limits the number of frame records or the memory they occupy, a limit of 0 disables it.
+             *
+             * When a limit is exceeded, the oldest frame records are evicted and frameRecordsRemoved() is emitted.
+             *
+             * @param maxFrameRecords   the maximum number of retained frame records.
+             * @param maxMemoryBytes    the maximum memory in bytes for frame records and CAN FD payloads.
+             */
+            void                    setCaptureLimits(int maxFrameRecords, qint64 maxMemoryBytes);
+
+            /**
+             * @brief Returns the maximum number of retained frame records.
+             * @return the maximum number of frame records; 0 if unlimited.
+             */
+            int                     maxFrameRecords() const;
+
+            /**
+             * @brief Returns the memory budget for the frame records.
+             * @return the memory budget in bytes; 0 if unlimited.
+             */
+            qint64                  maxMemoryBytes() const;
+
+            /**
+             * @brief Returns the memory currently occupied by the frame records and their CAN FD payloads.
+             * @return the occupied memory in bytes.
+             */
+            qint64                  memoryUsage() const;
+
+            /**
+             * @brief Enables spilling older frame records to memory-mapped segment files.
+             *
+             * It has to be set before the first frame is recorded. The segment files are created in a scratch
+             * directory below the given directory, which is removed with the tracer.
+             *
+             * @param directory the directory for the scratch directory; an empty string disables spilling.
+             * @return `true` on success.
+             */
+            bool                    setSpillDirectory(const QString &directory);
+
+            /**
+             * @brief Returns the disk space occupied by spilled frame records.
+             * @return the occupied disk space in bytes.
+             */
+            qint64                  spilledBytes() const;
+
+            /**
+             * @brief Streams all frame records into a Lindwurm trace file while capturing.
+             *
+             * It has to be set before the first frame is recorded. The file is completed when the trace is stopped.
+             * Evicted frame records are kept in the file, so a bounded trace can record a capture of any length.
+             *
+             * @param fileName the name of the trace file; an empty string disables recording.
+             * @return `true` on success.
+             */
+            bool                    setRecordingFile(const QString &fileName);
+
+            /**
+             * @brief Writes the retained frame records and the aggregate records to a Lindwurm trace file.
+             * @param fileName the name of the trace file.
+             * @return `true` on success.
+             */
+            bool                    saveTraceFile(const QString &fileName);
+
+            /**
+             * @brief Opens a Lindwurm trace file, whose records are mapped into memory instead of being read.
+             *
+             * Only an empty tracer which has not been started can open a trace file. The trace is read-only.
+             *
+             * @param fileName the name of the trace file.
+             * @return `true` on success.
+             */
+            bool                    openTraceFile(const QString &fileName);
+
+            /**
+             * @brief Imports a trace file of another tool in the background.
+             *
+             * Only an empty tracer which has not been started can import a trace file. The frames are appended while
+             * the file is read, importProgress() reports the progress and importFinished() the end of the import.
+             * Each channel of the file is assigned an interface index of its own.
+             *
+             * @param fileName the name of the trace file, whose format is determined by its file extension.
+             * @return `true` if the import has been started.
+             */
+            bool                    importTraceFile(const QString &fileName);
+
+            /**
+             * @brief Cancels a running import, the frames imported so far are kept.
+             */
+            void                    cancelImport();
+
+            /**
+             * @brief Returns `true` while a trace file is imported.
+             * @return `true` if an import is running.
+             */
+            bool                    isImporting() const;
+
+            /**
+             * @brief Writes the retained frame records to a trace file of another tool.
+             * @param fileName the name of the trace file, whose format is determined by its file extension.
+             * @return `true` on success.
+             */
+            bool                    exportTraceFile(const QString &fileName);
+
+            /**
+             * @brief Returns the name of the interface with the given index.
+             *
+             * The names of an opened trace file are taken from the file, otherwise from the ICanInterfaceManager.
+             *
+             * @param interfaceIndex the index of the interface as stored in the records.
+             * @return the name of the interface.
+             */
+            QString                 interfaceNameOf(CanInterfaceIndex interfaceIndex) const;
+
+            /**
+             * @brief Returns the number of frame records evicted from the head of the trace.
+             *
+             * The record at index `i` is the `evictedFrameRecordCount() + i`-th record of the whole trace.
+             *
+             * @return the number of evicted frame records.
+             */
+            qint64                  evictedFrameRecordCount() const;
+
+            /**
+             * @brief Returns the number of frame records. May be called from any thread.
+             * @return the number of frame records.
+             */
             int                     frameRecordCount() const;
-            CanFrameTracerRecord    frameRecordAt(int index) const;
+
+            /**
+             * @brief Returns the frame record at the given index. May be called from any thread.
+             *
+             * Only the first access to a chunk of an opened trace file blocks while the chunk is prepared.
+             *
+             * @param index the index of the record, which must be less than frameRecordCount().
+             * @return a reference to the record, which stays valid until the record is evicted.
+             */
+            const CanFrameTracerRecord& frameRecordAt(int index) const;
 
             int                     aggregateRecordCount() const;
             CanFrameAggregator      aggregateRecordAt(int index) const;
 
+            /**
+             * @brief Returns the index of the aggregate record of a frame ID.
+             * @param frameId the frame ID.
+             * @return the index of the aggregate record or -1 if no frame with this ID has been traced.
+             */
+            int                     aggregateRecordIndexOf(quint32 frameId) const;
+
+            /**
+             * @brief Looks up the retained frame records of an aggregate record. Must be called in the thread of the tracer.
+             *
+             * The history of an aggregate record is indexed on the first request by a single scan over the retained
+             * frame records. Afterwards the index is maintained while frames are appended and trimmed when frame
+             * records are evicted, so further requests only take time proportional to the history.
+             *
+             * @param aggregateRecordIndex the index of the aggregate record, see aggregateRecordIndexOf().
+             * @return the indices of the frame records in ascending order.
+             */
+            QVector<int>            frameRecordIndicesOf(int aggregateRecordIndex) const;
+
         signals:
 
-            void                    frameRecordInserted();
-            void                    aggregateRecordInserted();
-            void                    aggregateRecordUpdated(int aggregateRecordIndex);
+            /**
+             * @brief This signal is emitted after a batch of frame records has been appended to the trace.
+             * @param count the number of appended frame records
+             */
+            void                    frameRecordsInserted(int count);
+
+            /**
+             * @brief This signal is emitted after the oldest frame records have been evicted from the trace.
+             * @param count the number of frame records removed from the head of the trace
+             */
+            void                    frameRecordsRemoved(int count);
+
+            /**
+             * @brief This signal is emitted after aggregate records for new distinct frame ids have been appended.
+             * @param count the number of appended aggregate records
+             */
+            void                    aggregateRecordsInserted(int count);
+
+            /**
+             * @brief This signal is emitted after already existing aggregate records have been updated.
+             * @param aggregateRecordIndices the indices of the updated aggregate records
+             */
+            void                    aggregateRecordsUpdated(const QVector<int> &aggregateRecordIndices);
+
+            /**
+             * @brief This signal is emitted while a trace file is imported.
+             * @param bytesRead     the number of bytes read from the trace file
+             * @param totalBytes    the size of the trace file
+             */
+            void                    importProgress(qint64 bytesRead, qint64 totalBytes);
+
+            /**
+             * @brief This signal is emitted when the import of a trace file has ended.
+             * @param success `true` if the whole file has been imported
+             */
+            void                    importFinished(bool success);
 
         private slots:
 
-            void                    canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface);
+            void                    canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
+            void                    importedBlocksAvailable();
+            void                    importEnded(bool success);
             void                    initializeStartTimeFromFirstFrame();
 
         private:
 
+            typedef SegmentedAppendStore<CanFrameTracerRecord> RecordStore;
+
+            static_assert( RecordStore::ChunkSize == LindwurmTraceFormat::ChunkRecordCount, "chunks of trace files are mapped into the record store" );
+
+            void                    appendFrames(const QVector<QCanBusFrame> &frames, const QVector<CanInterfaceIndex> &sourceInterfaces, CanTimestampSource timestampSource);
+            int                     evictFrameRecords();
+            void                    spillFrameRecords();
+            bool                    finishTraceFile(LindwurmTraceFileWriter &writer);
+            void                    rebuildAggregators();
+
+            /**
+             * @brief Returns a frame record whose payload may be read, the chunks of an opened trace file are relocated on first access.
+             */
+            inline const CanFrameTracerRecord& recordAt(int index) const
+            {
+                // an opened trace file is read-only, so its record indices are the indices of the store
+                m_traceFile.relocatePayloadsOf(index);
+
+                return m_frameRecords.at(index);
+            }
+
             ICanInterfaceHandleSharedPtr    m_canInterface = {};
             bool                            m_isRunning = { false };
             qint64                          m_traceStartTimeMicroSeconds = { 0 };
-            QVector<CanFrameTracerRecord>   m_frameRecords = {};
-            mutable QRecursiveMutex         m_frameRecordsMutex = {};
+            CanFrameRecordSpill             m_recordSpill = {};     // must outlive the records mapped from it
+            quint64                         m_sealedChunkEnd = {0};
+            LindwurmTraceFile               m_traceFile = {};       // must outlive the records mapped from it
+            std::unique_ptr<LindwurmTraceFileWriter> m_recordingWriter = {};
+            QMap<CanInterfaceIndex, QString> m_interfaceNames = {};
+            CanTraceFileImporter*           m_importer = { nullptr };
+            RecordStore                     m_frameRecords = {};
+            CanPayloadArena                 m_payloadArena = {};
+            int                             m_maxFrameRecords = {0};
+            qint64                          m_maxMemoryBytes = {0};
 
             QVector<CanFrameAggregator>     m_aggregators = {};
-            QMap<quint32, int>              m_frameIdToAggregatorIndex = {};
+            CanFrameIdIndex                 m_frameIdToAggregatorIndex = {};
+            mutable CanFrameHistoryIndex    m_historyIndex = {};    // built on demand by frameRecordIndicesOf()
             mutable QRecursiveMutex         m_aggregatorsMutex = {};
     };
 }
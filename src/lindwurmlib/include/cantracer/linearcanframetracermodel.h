@@ -41,11 +41,13 @@ namespace Lindwurm::Lib
 
         private slots:
 
-            void                frameRecordInserted();
+            void                frameRecordsInserted(int count);
+            void                frameRecordsRemoved(int count);
             void                updateModel(void);
 
         private:
 
+            int                 frameRecordIndexOf(int row) const;
             QString             getFrameTime(const QCanBusFrame::TimeStamp &frameTimestamp) const;
             QString             getFrameTimeDiff(qint64 timeDiffMicroSeconds) const;
             QString             toASCIIString(const QByteArray &data) const;
@@ -55,6 +57,7 @@ namespace Lindwurm::Lib
 
             int                 m_rowCount;
             int                 m_insertedRowsCount;
+            int                 m_removedRowsCount;
             QTimer              m_updateTimer;
 
     };
@@ -22,10 +22,12 @@
 #include <QObject>
 #include <QCanBusFrame>
 #include <QByteArray>
+#include <QVector>
 #include <QTimer>
 
 #include "cantransport/isotransportprotocolframe.h"
 #include "caninterface/icaninterfacehandlesharedptr.h"
+#include "caninterface/caninterfaceindex.h"
 
 namespace Lindwurm::Lib
 {
@@ -51,6 +53,16 @@ namespace Lindwurm::Lib
 
             void                setPaddingEnabled(bool enablePadding);
 
+            /**
+             * @brief Enables the bit rate switch for the data phase of the sent CAN FD frames.
+             *
+             * CAN FD frames are used if the mounted interface has flexible data rate enabled. The bit rate
+             * switch is enabled by default.
+             *
+             * @param enableBitrateSwitch `true` to send the CAN FD frames with bit rate switch.
+             */
+            void                setBitrateSwitchEnabled(bool enableBitrateSwitch);
+
             quint32             sourceAddress() const;
             quint32             targetAddress() const;
 
@@ -66,14 +78,18 @@ namespace Lindwurm::Lib
 
             void                sendTimeout();
             void                receiveTimeout();
-            void                canFrameReceived(const QCanBusFrame &frame, const QString &sourceInterface);
+            void                canFramesReceived(const QVector<QCanBusFrame> &frames, CanInterfaceIndex sourceInterface);
 
             bool                sendNextConsecutiveFrame();
             void                continueSending();
+            void                transmitQueueReady();
 
         private:
 
             int                 paddingSize() const;
+            IsoTpFrameFormat    frameFormat() const;
+
+            void                processCanFrame(const QCanBusFrame &frame);
 
             void                resetSendConnection();
             void                resetReceiveConnection();
@@ -82,7 +98,7 @@ namespace Lindwurm::Lib
             void                firstFrameReceived(IsoTransportProtocolFrame &tpFrame);
             void                consecutiveFrameReceived(IsoTransportProtocolFrame &tpFrame);
 
-            void                sendFlowControlFrame();
+            void                sendFlowControlFrame(IsoTpFlowStatus flowStatus = IsoTpFlowStatus::ClearToSend);
 
             bool                sendSingleFrame(const QByteArray &data);
             bool                sendFirstFrame();
@@ -103,8 +119,12 @@ namespace Lindwurm::Lib
             struct IsoTpConnection
             {
                 IsoTpConnectionState        state;
-                int                         dataLength;
+                qint64                      dataLength;
                 QByteArray                  data;
+                int                         dataOffset;
+
+                IsoTpFrameFormat            frameFormat;
+                int                         frameDataLength;
 
                 quint8                      blockSize;
                 quint8                      minSeparationTime;
@@ -122,11 +142,8 @@ namespace Lindwurm::Lib
             ICanInterfaceHandleSharedPtr    m_canInterface = {};
 
             bool                            m_usePadding = { true };
-
-            // TODO: While sending we currently remove every sent part of the data from the connection's byte array
-            // To be able to emit the dataSend signal on a successful transmission with the original data, we maintain a temporary copy here
-            // maybe we can refactor this to keep the connection's data buffer intact and use an offset to the remaining data in the array
-            QByteArray                      m_dataToSentCopy;
+            bool                            m_useBitrateSwitch = { true };
+            bool                            m_waitingForTransmitQueue = { false };
 
             QTimer                          m_separationTimer;
 
@@ -30,10 +30,30 @@ namespace Lindwurm::Lib
         Overflow    = 2
     };
 
+    /**
+     * @brief The IsoTpFrameFormat enum defines the CAN frames ISO-TP frames are transported with.
+     */
+    enum class IsoTpFrameFormat
+    {
+        Classic,                /*! Classical CAN frames with up to 8 bytes. */
+        FlexibleDataRate,       /*! CAN FD frames with up to 64 bytes. */
+        FlexibleDataRateBrs     /*! CAN FD frames with up to 64 bytes and bit rate switch in the data phase. */
+    };
+
     class LINDWURMLIB_EXPORT IsoTransportProtocolFrame
     {
         public:
 
+            /**
+             * @brief The maximum data length of a segmented message, which is encoded with the 32 bit escape sequence.
+             */
+            static const qint64 MaxDataLength = 0xFFFFFFFF;
+
+            /**
+             * @brief The largest data length of a first frame encoded without escape sequence.
+             */
+            static const qint64 MaxShortDataLength = 0xFFF;
+
             enum class Type
             {
                 Invalid,
@@ -45,15 +65,39 @@ namespace Lindwurm::Lib
 
             static      IsoTransportProtocolFrame fromRawCanFrame(const QCanBusFrame& canFrame);
 
-            static      IsoTransportProtocolFrame singleFrame(quint32 frameId, const QByteArray &data, int paddingSize = 0);
-            static      IsoTransportProtocolFrame firstFrame(quint32 frameId, int totalDataLength, const QByteArray &data);
-            static      IsoTransportProtocolFrame consecutiveFrame(quint32 frameId, quint8 sequenceNumber, const QByteArray &data, int paddingSize = 0);
-            static      IsoTransportProtocolFrame flowControlFrame(quint32 frameId, IsoTpFlowStatus flowStatus, int blockSize, int separationTime, int paddingSize = 0);
+            static      IsoTransportProtocolFrame singleFrame(quint32 frameId, const QByteArray &data, int paddingSize = 0, IsoTpFrameFormat format = IsoTpFrameFormat::Classic);
+            static      IsoTransportProtocolFrame firstFrame(quint32 frameId, qint64 totalDataLength, const QByteArray &data, IsoTpFrameFormat format = IsoTpFrameFormat::Classic);
+            static      IsoTransportProtocolFrame consecutiveFrame(quint32 frameId, quint8 sequenceNumber, const QByteArray &data, int paddingSize = 0, IsoTpFrameFormat format = IsoTpFrameFormat::Classic);
+            static      IsoTransportProtocolFrame flowControlFrame(quint32 frameId, IsoTpFlowStatus flowStatus, int blockSize, int separationTime, int paddingSize = 0, IsoTpFrameFormat format = IsoTpFrameFormat::Classic);
+
+            /**
+             * @brief Returns the maximum payload of the CAN frames of the provided format (TX_DL).
+             * @return `8` for classical CAN, `64` for CAN FD.
+             */
+            static int      maxFrameLength(IsoTpFrameFormat format);
+
+            /**
+             * @brief Returns the number of data bytes a single frame can transport.
+             * @return `7` for classical CAN, `62` for CAN FD (with escape sequence).
+             */
+            static int      singleFrameCapacity(IsoTpFrameFormat format);
+
+            /**
+             * @brief Returns the number of data bytes a first frame transports for a message of the provided length.
+             * @return the frame length minus the protocol control information, which is longer for messages exceeding MaxShortDataLength.
+             */
+            static int      firstFrameCapacity(IsoTpFrameFormat format, qint64 totalDataLength);
+
+            /**
+             * @brief Returns the number of data bytes a consecutive frame can transport.
+             * @return `7` for classical CAN, `63` for CAN FD.
+             */
+            static int      consecutiveFrameCapacity(IsoTpFrameFormat format);
 
             Type            frameType() const;
             QCanBusFrame    canFrame() const;
             bool            isValid() const;
-            int             dataLength() const;
+            qint64          dataLength() const;
             int             sequenceNumber() const;
             IsoTpFlowStatus flowStatus() const;
             quint8          blockSize() const;
@@ -68,6 +112,9 @@ namespace Lindwurm::Lib
             static quint8           flowStatusToNumber(IsoTpFlowStatus status);
             static IsoTpFlowStatus  numberToFlowStatus(quint8 status);
             static void             appendPadding(QByteArray &payload, int paddingSize);
+            static QCanBusFrame     createCanFrame(quint32 frameId, QByteArray payload, int paddingSize, IsoTpFrameFormat format);
+            static int              validFrameLength(int payloadSize);
+            int                     dataOffset() const;
 
         private:
 
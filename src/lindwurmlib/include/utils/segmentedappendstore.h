@@ -0,0 +1,327 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEGMENTEDAPPENDSTORE_H
+#define SEGMENTEDAPPENDSTORE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The SegmentedAppendStore class implements an append-only sequence for a single writer and many readers.
+     *
+     * Values are stored in fixed-size chunks which are allocated on demand and never moved, so appending takes
+     * constant time without reallocating or copying the stored values. Each appended value is published with a
+     * release store of the end position. Readers may therefore access all values below size() without any locking
+     * while the writer keeps appending. A reference returned by at() stays valid until the value is removed.
+     *
+     * The oldest values can be removed with removeFront(), which frees chunks as soon as they are completely
+     * unused. The chunk directory is a ring, so a store with removals runs indefinitely while the number of
+     * retained values is bounded by Capacity. Indices passed to at() are relative to the oldest retained value,
+     * removedCount() tells how many values were removed before it.
+     *
+     * Completely filled chunks can be replaced by a copy in external memory with replaceChunk(), e.g. to move older
+     * values of trivially copyable types into a memory-mapped file. Whole chunks of external memory, e.g. of a mapped
+     * trace file, are appended with appendChunk(). External chunks are never freed by the store.
+     *
+     * Exactly one thread may append, remove or replace at a time. Readers must not access values concurrently with their
+     * removal or replacement, i.e. both have to be synchronized with the readers, which is trivial if they share
+     * the thread.
+     */
+    template <typename T, int ChunkSizeLog2 = 14, int MaxChunkCount = 16384>
+    class SegmentedAppendStore
+    {
+        static_assert( (MaxChunkCount & (MaxChunkCount - 1)) == 0, "MaxChunkCount must be a power of two" );
+
+        public:
+
+            static constexpr int ChunkSize  = 1 << ChunkSizeLog2;
+            static constexpr int Capacity   = ChunkSize * MaxChunkCount;
+
+            SegmentedAppendStore()
+                : m_chunks( new std::atomic<T*>[MaxChunkCount] )
+                , m_externalChunks( new bool[MaxChunkCount] )
+            {
+                for (int slot = 0; slot < MaxChunkCount; slot++)
+                {
+                    m_chunks[slot].store(nullptr, std::memory_order_relaxed);
+                    m_externalChunks[slot] = false;
+                }
+            }
+
+            ~SegmentedAppendStore()
+            {
+                const quint64 head = m_head.load(std::memory_order_relaxed);
+                const quint64 tail = m_tail.load(std::memory_order_relaxed);
+
+                for (quint64 position = head; position < tail; position++)
+                {
+                    valueAt(position).~T();
+                }
+
+                for (int slot = 0; slot < MaxChunkCount; slot++)
+                {
+                    T *chunk = m_chunks[slot].load(std::memory_order_relaxed);
+
+                    if ( chunk != nullptr && ! m_externalChunks[slot] )
+                    {
+                        m_allocator.deallocate(chunk, ChunkSize);
+                    }
+                }
+            }
+
+            SegmentedAppendStore(const SegmentedAppendStore&) = delete;
+            SegmentedAppendStore& operator=(const SegmentedAppendStore&) = delete;
+
+            /**
+             * @brief Constructs a value at the end of the store and publishes it to the readers. Writer only.
+             * @param args the arguments passed to the constructor of the value.
+             * @return `true` on success; `false` if the capacity is exhausted.
+             */
+            template <typename... Args>
+            bool emplaceBack(Args&&... args)
+            {
+                if ( isFull() )
+                {
+                    return false;
+                }
+
+                const quint64   tail    = m_tail.load(std::memory_order_relaxed);
+                const int       slot    = slotOf(tail);
+                T               *chunk  = m_chunks[slot].load(std::memory_order_relaxed);
+
+                if ( chunk == nullptr )
+                {
+                    chunk = m_allocator.allocate(ChunkSize);
+                    m_chunks[slot].store(chunk, std::memory_order_release);
+                    m_ownedChunkCount.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                new ( chunk + (tail & IndexMask) ) T( std::forward<Args>(args)... );
+
+                m_tail.store(tail + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            /**
+             * @brief Removes the oldest values and frees all chunks which became unused. Writer only.
+             * @param count the number of values to remove, at most size().
+             */
+            void removeFront(int count)
+            {
+                const quint64 head      = m_head.load(std::memory_order_relaxed);
+                const quint64 tail      = m_tail.load(std::memory_order_relaxed);
+                const quint64 newHead   = head + quint64( qBound(0, count, int(tail - head)) );
+
+                for (quint64 position = head; position < newHead; position++)
+                {
+                    valueAt(position).~T();
+                }
+
+                m_head.store(newHead, std::memory_order_release);
+
+                // the chunk of the new head is still in use, all chunks before it are released
+                for (quint64 chunkIndex = head >> ChunkSizeLog2; chunkIndex < (newHead >> ChunkSizeLog2); chunkIndex++)
+                {
+                    releaseChunk( int( chunkIndex & SlotMask ) );
+                }
+            }
+
+            /**
+             * @brief Replaces a completely filled chunk by a copy in external memory. Writer only.
+             *
+             * The copy must hold the same values and stay valid until the chunk is removed or the store is destroyed.
+             * The memory of the replaced chunk is freed.
+             *
+             * @param chunkIndex    the index of the chunk, i.e. the position of its first value divided by ChunkSize.
+             * @param replacement   the external copy of the chunk.
+             * @return `true` on success; `false` if the chunk is not completely filled or has been removed.
+             */
+            bool replaceChunk(quint64 chunkIndex, T *replacement)
+            {
+                static_assert( std::is_trivially_copyable<T>::value, "only chunks of trivially copyable values can be replaced" );
+
+                const quint64 head = m_head.load(std::memory_order_relaxed);
+                const quint64 tail = m_tail.load(std::memory_order_relaxed);
+
+                if ( chunkIndex < (head >> ChunkSizeLog2) || chunkIndex >= (tail >> ChunkSizeLog2) )
+                {
+                    return false;
+                }
+
+                const int slot = int( chunkIndex & SlotMask );
+
+                releaseChunk(slot);
+
+                m_chunks[slot].store(replacement, std::memory_order_release);
+                m_externalChunks[slot] = true;
+
+                return true;
+            }
+
+            /**
+             * @brief Appends a chunk of values in external memory without copying them. Writer only.
+             *
+             * The chunk must stay valid until it is removed or the store is destroyed. If it holds less than ChunkSize
+             * values, values appended afterwards are constructed within the external memory.
+             *
+             * @param chunk the external chunk with room for ChunkSize values.
+             * @param count the number of values within the chunk.
+             * @return `true` on success; `false` if the store does not end at a chunk boundary or is full.
+             */
+            bool appendChunk(T *chunk, int count)
+            {
+                static_assert( std::is_trivially_copyable<T>::value, "only chunks of trivially copyable values can be appended" );
+
+                const quint64 tail = m_tail.load(std::memory_order_relaxed);
+
+                if ( (tail & IndexMask) != 0 || isFull() || count < 0 || count > ChunkSize )
+                {
+                    return false;
+                }
+
+                const int slot = slotOf(tail);
+
+                m_chunks[slot].store(chunk, std::memory_order_release);
+                m_externalChunks[slot] = true;
+
+                m_tail.store(tail + quint64(count), std::memory_order_release);
+
+                return true;
+            }
+
+            /**
+             * @brief Returns the values of a chunk. Writer only.
+             * @param chunkIndex the index of the chunk, which must not have been removed.
+             * @return the ChunkSize values of the chunk, of which only the appended and not removed ones are valid.
+             */
+            const T* chunkData(quint64 chunkIndex) const
+            {
+                return m_chunks[ int(chunkIndex & SlotMask) ].load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Returns the total number of values appended since the store was constructed.
+             */
+            quint64 appendedCount() const
+            {
+                return m_tail.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Returns the value at the given index. May be called from any thread.
+             * @param index the index of the value relative to the oldest retained value, which must be less than size().
+             * @return a reference to the value, which stays valid until the value is removed.
+             */
+            const T& at(int index) const
+            {
+                Q_ASSERT( index >= 0 && index < size() );
+
+                return valueAt( m_head.load(std::memory_order_acquire) + quint64(index) );
+            }
+
+            /**
+             * @brief Returns the number of retained values. May be called from any thread.
+             */
+            int size() const
+            {
+                const quint64 head = m_head.load(std::memory_order_acquire);
+
+                return int( m_tail.load(std::memory_order_acquire) - head );
+            }
+
+            /**
+             * @brief Returns the number of values removed from the front since the store was constructed.
+             */
+            quint64 removedCount() const
+            {
+                return m_head.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Returns the number of bytes allocated for the chunks, not counting external chunks.
+             */
+            qint64 allocatedBytes() const
+            {
+                return qint64( m_ownedChunkCount.load(std::memory_order_relaxed) ) * ChunkSize * qint64( sizeof(T) );
+            }
+
+            /**
+             * @brief Returns `true` if the capacity is exhausted and no further value can be appended.
+             */
+            bool isFull() const
+            {
+                // the tail must not wrap around onto the chunk of the head
+                const quint64 headChunkStart = m_head.load(std::memory_order_acquire) & ~quint64(IndexMask);
+
+                return m_tail.load(std::memory_order_acquire) - headChunkStart >= quint64(Capacity);
+            }
+
+            /**
+             * @brief Returns `true` if no value is retained.
+             */
+            bool isEmpty() const
+            {
+                return size() == 0;
+            }
+
+        private:
+
+            static constexpr int IndexMask  = ChunkSize - 1;
+            static constexpr int SlotMask   = MaxChunkCount - 1;
+
+            static int slotOf(quint64 position)
+            {
+                return int( (position >> ChunkSizeLog2) & SlotMask );
+            }
+
+            T& valueAt(quint64 position) const
+            {
+                return m_chunks[ slotOf(position) ].load(std::memory_order_acquire)[position & IndexMask];
+            }
+
+            void releaseChunk(int slot)
+            {
+                if ( ! m_externalChunks[slot] )
+                {
+                    m_allocator.deallocate( m_chunks[slot].load(std::memory_order_relaxed), ChunkSize );
+                    m_ownedChunkCount.fetch_sub(1, std::memory_order_relaxed);
+                }
+
+                m_chunks[slot].store(nullptr, std::memory_order_relaxed);
+                m_externalChunks[slot] = false;
+            }
+
+            std::unique_ptr<std::atomic<T*>[]>  m_chunks;
+            std::unique_ptr<bool[]>             m_externalChunks;
+            std::allocator<T>                   m_allocator = {};
+            std::atomic<int>                    m_ownedChunkCount = {0};
+            std::atomic<quint64>                m_head = {0};
+            std::atomic<quint64>                m_tail = {0};
+    };
+}
+
+#endif // SEGMENTEDAPPENDSTORE_H
@@ -0,0 +1,192 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QVector>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Lindwurm::Lib
+{
+    /**
+     * @brief The SpscRingBuffer class implements a bounded lock-free single-producer/single-consumer queue.
+     *
+     * Exactly one thread may push into the buffer and exactly one (other) thread may pop from it. The capacity is
+     * rounded up to the next power of two. Pushing into a full buffer fails instead of blocking the producer.
+     */
+    template <typename T>
+    class SpscRingBuffer
+    {
+        public:
+
+            explicit SpscRingBuffer(int capacity)
+                : m_slots( roundUpToPowerOfTwo(capacity) )
+                , m_mask( m_slots.size() - 1 )
+            {
+
+            }
+
+            SpscRingBuffer(const SpscRingBuffer&) = delete;
+            SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+            /**
+             * @brief Appends a value to the buffer. Must only be called by the producer thread.
+             * @param value the value to append.
+             * @return `true` on success; `false` if the buffer is full.
+             */
+            bool push(const T &value)
+            {
+                const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+                if ( tail - m_cachedHead > m_mask )
+                {
+                    // the buffer seems full, refresh our view of the consumer's position
+                    m_cachedHead = m_head.load(std::memory_order_acquire);
+
+                    if ( tail - m_cachedHead > m_mask )
+                    {
+                        return false;
+                    }
+                }
+
+                m_slots[tail & m_mask] = value;
+                m_tail.store(tail + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            /**
+             * @brief Appends as many of the values as fit into the buffer. Must only be called by the producer thread.
+             * @param values the values to append.
+             * @return the number of appended values.
+             */
+            int push(const QVector<T> &values)
+            {
+                int pushed = 0;
+
+                for (const T &value : values)
+                {
+                    if ( ! push(value) )
+                    {
+                        break;
+                    }
+
+                    pushed++;
+                }
+
+                return pushed;
+            }
+
+            /**
+             * @brief Removes the oldest value from the buffer. Must only be called by the consumer thread.
+             * @param value receives the removed value.
+             * @return `true` on success; `false` if the buffer is empty.
+             */
+            bool pop(T &value)
+            {
+                const size_t head = m_head.load(std::memory_order_relaxed);
+
+                if ( head == m_cachedTail )
+                {
+                    m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+                    if ( head == m_cachedTail )
+                    {
+                        return false;
+                    }
+                }
+
+                value = std::move( m_slots[head & m_mask] );
+                m_head.store(head + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            /**
+             * @brief Removes all currently available values from the buffer. Must only be called by the consumer thread.
+             * @param values the vector the removed values are appended to.
+             * @return the number of removed values.
+             */
+            int popAll(QVector<T> &values)
+            {
+                const size_t head = m_head.load(std::memory_order_relaxed);
+                const size_t tail = m_tail.load(std::memory_order_acquire);
+                const int count = static_cast<int>(tail - head);
+
+                values.reserve( values.size() + count );
+
+                for (size_t position = head; position != tail; position++)
+                {
+                    values.append( std::move( m_slots[position & m_mask] ) );
+                }
+
+                m_cachedTail = tail;
+                m_head.store(tail, std::memory_order_release);
+
+                return count;
+            }
+
+            /**
+             * @brief Returns the number of values the buffer can hold.
+             */
+            int capacity() const
+            {
+                return static_cast<int>( m_slots.size() );
+            }
+
+            /**
+             * @brief Returns the number of values currently stored. The result is only a snapshot if called concurrently.
+             */
+            int size() const
+            {
+                return static_cast<int>( m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire) );
+            }
+
+        private:
+
+            static size_t roundUpToPowerOfTwo(int value)
+            {
+                size_t size = 2;
+
+                while ( size < static_cast<size_t>(value) )
+                {
+                    size <<= 1;
+                }
+
+                return size;
+            }
+
+            // producer and consumer positions are kept on separate cache lines to avoid false sharing
+            static constexpr size_t CacheLineSize = 64;
+
+            std::vector<T>                              m_slots;
+            const size_t                                m_mask;
+
+            alignas(CacheLineSize) std::atomic<size_t>  m_head = {0};
+            size_t                                      m_cachedTail = {0};     // consumer's copy of m_tail
+
+            alignas(CacheLineSize) std::atomic<size_t>  m_tail = {0};
+            size_t                                      m_cachedHead = {0};     // producer's copy of m_head
+    };
+}
+
+#endif // SPSCRINGBUFFER_H
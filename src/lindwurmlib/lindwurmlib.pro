@@ -14,8 +14,8 @@
 # You should have received a copy of the GNU Affero General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-QT += widgets \
-    serialbus
+QT -= gui
+QT += serialbus
 
 TEMPLATE = lib
 DEFINES += LINDWURMLIB_LIBRARY
@@ -42,11 +42,24 @@ SOURCES += \
     caninterface/caninterfacelistmodel.cpp \
     caninterface/caninterfacemanagermodel.cpp \
     caninterface/icaninterfacemanager.cpp \
+    caninterface/canframedispatchtable.cpp \
+    caninterface/canframereceiver.cpp \
+    caninterface/canroutingtable.cpp \
+    caninterface/virtualcanbus.cpp \
+    caninterface/virtualcaninterface.cpp \
+    caninterface/tracereplayinterface.cpp \
+    caninterface/cantransmitqueue.cpp \
+    caninterface/cantransmitscheduler.cpp \
     caninterface/caninterfacehandle.cpp \
     caninterface/caninterfacemanager.cpp \
     cantracer/abstractcanframetracermodel.cpp \
+    cantracer/canframerenderrecord.cpp \
     cantracer/canframeaggregator.cpp \
+    cantracer/canframeidindex.cpp \
+    cantracer/canframehistoryindex.cpp \
     cantracer/canframetracerrecord.cpp \
+    cantracer/canpayloadarena.cpp \
+    cantracer/canframerecordspill.cpp \
     cantracer/canframetracer.cpp \
     cantracer/linearcanframetracermodel.cpp \
     cantracer/aggregatedcanframetracermodel.cpp \
@@ -56,6 +69,20 @@ SOURCES += \
     diagnostic/udsdataid.cpp \
     cantransport/isotransportprotocolframe.cpp \
     cantransport/isotransportprotocol.cpp \
+    cantracefile/icantracefilereader.cpp \
+    cantracefile/candumptracefilereader.cpp \
+    cantracefile/icantracefilewriter.cpp \
+    cantracefile/candumptracefilewriter.cpp \
+    cantracefile/lindwurmtracefile.cpp \
+    cantracefile/lindwurmtracefilewriter.cpp \
+    cantracefile/abstractcantracefilereader.cpp \
+    cantracefile/asctracefilereader.cpp \
+    cantracefile/asctracefilewriter.cpp \
+    cantracefile/blftracefilereader.cpp \
+    cantracefile/blftracefilewriter.cpp \
+    cantracefile/pcapngtracefilereader.cpp \
+    cantracefile/pcapngtracefilewriter.cpp \
+    cantracefile/cantracefileimporter.cpp \
     diagnostic/readdatabyidentifiermapper.cpp \
     utils/bytearrayenumerator.cpp
 
@@ -66,13 +93,27 @@ HEADERS += \
     include/cancomposer/canframecomposit.h \
     include/cancomposer/canframeenumerator.h \
     caninterface/caninterfacelistmodel.h \
+    caninterface/canroutingtable.h \
     include/cantracer/abstractcanframetracermodel.h \
+    include/cantracer/canframerenderrecord.h \
     include/caninterface/abstractcaninterface.h \
     include/caninterface/canbridge.h \
     include/caninterface/candevice.h \
     include/caninterface/caninterfaceconfig.h \
+    include/caninterface/caninterfaceindex.h \
+    include/caninterface/cantimestampsource.h \
     include/caninterface/caninterfaceinfo.h \
+    include/caninterface/caninterfacestatistics.h \
     include/caninterface/icaninterface.h \
+    include/caninterface/canframedispatchtable.h \
+    include/caninterface/canframereceiver.h \
+    include/caninterface/canidfilter.h \
+    include/caninterface/canroutingrule.h \
+    include/caninterface/virtualcanbus.h \
+    include/caninterface/virtualcaninterface.h \
+    include/caninterface/tracereplayinterface.h \
+    include/caninterface/cantransmitqueue.h \
+    include/caninterface/cantransmitscheduler.h \
     include/caninterface/caninterfacehandle.h \
     include/caninterface/icaninterfacehandle.h \
     include/caninterface/icaninterfacehandlesharedptr.h \
@@ -81,7 +122,11 @@ HEADERS += \
     include/caninterface/icaninterfacesharedptr.h \
     include/caninterface/caninterfacemanagermodel.h \
     cantracer/canframeaggregator.h \
+    cantracer/canframeidindex.h \
+    cantracer/canframehistoryindex.h \
     cantracer/canframetracerrecord.h \
+    cantracer/canpayloadarena.h \
+    cantracer/canframerecordspill.h \
     include/cantracer/canframetracer.h \
     include/cantracer/linearcanframetracermodel.h \
     include/cantracer/aggregatedcanframetracermodel.h \
@@ -90,10 +135,38 @@ HEADERS += \
     include/diagnostic/udsdataid.h \
     include/cantransport/isotransportprotocol.h \
     include/cantransport/isotransportprotocolframe.h \
+    include/cantracefile/icantracefilereader.h \
+    include/cantracefile/candumptracefilereader.h \
+    include/cantracefile/icantracefilewriter.h \
+    include/cantracefile/candumptracefilewriter.h \
+    include/cantracefile/lindwurmtracefile.h \
+    include/cantracefile/lindwurmtracefilewriter.h \
+    cantracefile/lindwurmtraceformat.h \
+    include/cantracefile/cantracefileblock.h \
+    include/cantracefile/abstractcantracefilereader.h \
+    include/cantracefile/asctracefilereader.h \
+    include/cantracefile/asctracefilewriter.h \
+    include/cantracefile/blftracefilereader.h \
+    include/cantracefile/blftracefilewriter.h \
+    cantracefile/blfformat.h \
+    include/cantracefile/pcapngtracefilereader.h \
+    include/cantracefile/pcapngtracefilewriter.h \
+    cantracefile/pcapngformat.h \
+    include/cantracefile/cantracefileimporter.h \
     include/diagnostic/udsecudiscoveryscanner.h \
     include/utils/bytearrayenumerator.h \
     include/utils/range.h \
-    include/utils/rangeenumerator.h
+    include/utils/rangeenumerator.h \
+    include/utils/segmentedappendstore.h \
+    include/utils/spscringbuffer.h
+
+linux {
+    SOURCES += \
+        caninterface/socketcaninterface.cpp
+
+    HEADERS += \
+        include/caninterface/socketcaninterface.h
+}
 
 DISTFILES += \
     lindwurmlib.pri
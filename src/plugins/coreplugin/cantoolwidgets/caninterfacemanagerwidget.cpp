@@ -25,9 +25,15 @@
 
 #include <QSettings>
 #include <QMessageBox>
+#include <QTimer>
 
 using namespace Lindwurm::Lib;
 
+namespace
+{
+    const int STATISTICS_REFRESH_MSEC = 1000;
+}
+
 namespace Lindwurm::Core
 {
     CanInterfaceManagerWidget::CanInterfaceManagerWidget(QWidget *parent)
@@ -43,6 +49,11 @@ namespace Lindwurm::Core
 
         setInterfaceModel(m_interfaceManagerModel);
 
+        m_statisticsTimer = new QTimer(this);
+        m_statisticsTimer->setInterval(STATISTICS_REFRESH_MSEC);
+        connect(m_statisticsTimer, &QTimer::timeout, m_interfaceManagerModel, &CanInterfaceManagerModel::refreshStatistics);
+        m_statisticsTimer->start();
+
         QSettings settings;
         if ( settings.value("core/autoCreateSocketCAN", true).toBool() )
         {
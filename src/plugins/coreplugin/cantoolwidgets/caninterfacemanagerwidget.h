@@ -29,6 +29,7 @@ namespace Lindwurm::Lib
 }
 
 class QAction;
+class QTimer;
 class QAbstractItemModel;
 
 namespace Lindwurm::Core
@@ -73,6 +74,7 @@ namespace Lindwurm::Core
             QAction*                        m_removeInterfaceAction = { nullptr };
             QAction*                        m_editInterfaceAction = { nullptr };
             CanInterfaceConfigDialog*       m_interfaceConfigDialog = { nullptr };
+            QTimer*                         m_statisticsTimer = { nullptr };
     };
 }
 
@@ -0,0 +1,105 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cantraceritemdelegate.h"
+
+#include "cantracer/abstractcanframetracermodel.h"
+#include "cantracer/canframerenderrecord.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+
+namespace Lindwurm::Core
+{
+    CanTracerItemDelegate::CanTracerItemDelegate(QObject *parent)
+        : QStyledItemDelegate(parent)
+        , m_text(Lib::CanFrameRenderRecord::MaxTextLength, Qt::Uninitialized)
+    {
+
+    }
+
+    void CanTracerItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+    {
+        const Lib::CanFrameRenderRecord *record = index.data(Lib::AbstractCanFrameTracerModel::RenderRecordRole).value<const Lib::CanFrameRenderRecord*>();
+
+        if ( record == nullptr )
+        {
+            QStyledItemDelegate::paint(painter, option, index);
+            return;
+        }
+
+        // the buffer keeps its capacity, so neither resizing nor formatting allocates
+        m_text.resize(Lib::CanFrameRenderRecord::MaxTextLength);
+        m_text.resize( record->format( m_text.data() ) );
+
+        const QWidget   *widget = option.widget;
+        QStyle          *style  = widget != nullptr ? widget->style() : QApplication::style();
+
+        // initStyleOption() is not used, it would fetch the display text of the cell, so the other roles it
+        // applies are taken from the model here
+        QStyleOptionViewItem itemOption(option);
+
+        const QVariant fontData         = index.data(Qt::FontRole);
+        const QVariant alignmentData    = index.data(Qt::TextAlignmentRole);
+        const QVariant foregroundData   = index.data(Qt::ForegroundRole);
+        const QVariant backgroundData   = index.data(Qt::BackgroundRole);
+
+        if ( fontData.isValid() )
+        {
+            itemOption.font = qvariant_cast<QFont>(fontData).resolve(itemOption.font);
+            itemOption.fontMetrics = QFontMetrics(itemOption.font);
+        }
+
+        if ( alignmentData.isValid() )
+        {
+            itemOption.displayAlignment = Qt::Alignment( alignmentData.toInt() );
+        }
+
+        if ( foregroundData.canConvert<QBrush>() )
+        {
+            itemOption.palette.setBrush( QPalette::Text, qvariant_cast<QBrush>(foregroundData) );
+        }
+
+        itemOption.backgroundBrush = qvariant_cast<QBrush>(backgroundData);
+
+        style->drawPrimitive(QStyle::PE_PanelItemViewItem, &itemOption, painter, widget);
+
+        const QPalette::ColorGroup colorGroup = ! ( itemOption.state & QStyle::State_Enabled ) ? QPalette::Disabled
+                                              : ( itemOption.state & QStyle::State_Active )    ? QPalette::Normal
+                                                                                               : QPalette::Inactive;
+
+        const QPalette::ColorRole colorRole = ( itemOption.state & QStyle::State_Selected ) ? QPalette::HighlightedText : QPalette::Text;
+
+        // same text margin as the style uses for item view items
+        const int       textMargin  = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+        const QRect     textRect    = itemOption.rect.adjusted(textMargin, 0, -textMargin, 0);
+
+        // text wider than the cell is elided like QStyledItemDelegate does, which only allocates for these cells
+        if ( itemOption.textElideMode != Qt::ElideNone && itemOption.fontMetrics.horizontalAdvance(m_text) > textRect.width() )
+        {
+            // copied into the buffer, so it keeps its capacity for the following cells
+            const QString elidedText = itemOption.fontMetrics.elidedText(m_text, itemOption.textElideMode, textRect.width());
+            m_text.replace(0, m_text.size(), elidedText);
+        }
+
+        painter->save();
+        painter->setFont(itemOption.font);
+        painter->setPen( itemOption.palette.color(colorGroup, colorRole) );
+        painter->drawText(textRect, int( itemOption.displayAlignment ) | Qt::TextSingleLine, m_text);
+        painter->restore();
+    }
+}
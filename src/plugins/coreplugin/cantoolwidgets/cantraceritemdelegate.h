@@ -0,0 +1,47 @@
+/*  www.lindwurm-can.org
+ *  Copyright (C) 2023 Sascha Muenzberg <sascha@lindwurm-can.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CANTRACERITEMDELEGATE_H
+#define CANTRACERITEMDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+namespace Lindwurm::Core
+{
+    /**
+     * @brief The CanTracerItemDelegate class paints the cells of the tracer models without building display strings.
+     *
+     * Cells which provide a AbstractCanFrameTracerModel::RenderRecordRole are formatted into a text buffer, which is
+     * reused for all cells, so scrolling a large trace does not allocate memory per cell. Like QStyledItemDelegate
+     * the font, alignment, foreground and background roles and the elide mode of the view are applied. All other
+     * cells are painted by QStyledItemDelegate.
+     */
+    class CanTracerItemDelegate : public QStyledItemDelegate
+    {
+        Q_OBJECT
+        public:
+
+            explicit        CanTracerItemDelegate(QObject *parent = nullptr);
+
+            virtual void    paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+        private:
+
+            mutable QString m_text;
+    };
+}
+
+#endif // CANTRACERITEMDELEGATE_H
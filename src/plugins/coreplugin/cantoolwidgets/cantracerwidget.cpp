@@ -16,6 +16,7 @@
  */
 
 #include "cantracerwidget.h"
+#include "cantraceritemdelegate.h"
 #include "ui_cantracerwidget.h"
 #include "caninterface/icaninterfacemanager.h"
 #include "caninterface/caninterfacehandle.h"
@@ -31,10 +32,15 @@
 #include <QLineEdit>
 #include <QKeyEvent>
 #include <QScrollBar>
+#include <QDir>
 #include <QSettings>
 #include <QListIterator>
 #include <QVariantMap>
 #include <QMenu>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QProgressDialog>
 
 #include <QDebug>
 #include <QLoggingCategory>
@@ -44,6 +50,10 @@ namespace
 {
     const char*     COMPONENT_NAME = "CAN Tracer";
     const int       MAX_VIEW_FILTER_HISTORY = 10;
+    const char*     OPEN_TRACE_FILE_FILTER = "Trace files (*.lwtrace *.log *.asc *.blf *.pcapng);;Lindwurm trace (*.lwtrace);;candump log (*.log);;Vector ASC (*.asc);;Vector BLF (*.blf);;PCAP-NG (*.pcapng)";
+    const char*     SAVE_TRACE_FILE_FILTER = "Lindwurm trace (*.lwtrace);;candump log (*.log);;Vector ASC (*.asc);;Vector BLF (*.blf);;PCAP-NG (*.pcapng)";
+    const char*     LINDWURM_TRACE_SUFFIX = "lwtrace";
+    const int       IMPORT_PROGRESS_MAXIMUM = 1000;
     Q_LOGGING_CATEGORY(LOG_TAG, "lindwurm.tracer")
 }
 
@@ -81,6 +91,8 @@ namespace Lindwurm::Core
         loadFilterBookmarks();
         loadRecentUsedFilters();
 
+        ui->traceView->setItemDelegate( new CanTracerItemDelegate(ui->traceView) );
+
         setModel( new Lib::AggregatedCanFrameTracerModel(m_tracer, m_tracer)  );
 
         ui->cmbFilterType->addItem("Pass", false);
@@ -144,22 +156,18 @@ namespace Lindwurm::Core
 
         ui->selectInterfaceBox->setEnabled(false);
 
-        CanFrameTracer* oldTracer = m_tracer;
+        CanFrameTracer* tracer = new CanFrameTracer(this);
 
-        m_tracer = new CanFrameTracer(this);
+        // a limited trace keeps only the latest frames (ring buffer capture mode)
+        QSettings settings;
+        tracer->setCaptureLimits( settings.value("core/tracer.max-frames", 0).toInt(), settings.value("core/tracer.max-memory-mib", 0).toLongLong() * 1024 * 1024 );
 
-        if ( m_toggleViewModeAction->isChecked() )
-        {
-            setModel( new Lib::LinearCanFrameTracerModel(m_tracer, m_tracer)  );
-        }
-        else
+        if ( settings.value("core/tracer.spill-to-disk", false).toBool() )
         {
-            setModel( new Lib::AggregatedCanFrameTracerModel(m_tracer, m_tracer)  );
+            tracer->setSpillDirectory( QDir::tempPath() );
         }
 
-        resizeTraceViewColumnsToContents();
-
-        oldTracer->deleteLater();
+        replaceTracer(tracer);
 
         m_tracer->mountCANInterface(interface);
 
@@ -177,9 +185,123 @@ namespace Lindwurm::Core
         m_startAction->setChecked(false);
         m_stopAction->setEnabled(false);
 
-        // TODO: Enable if actions are implemented
-        //m_openAction->setEnabled(true);
-        //m_saveAction->setEnabled(true);
+        m_openAction->setEnabled(true);
+        m_saveAction->setEnabled(true);
+    }
+
+    void CanTracerWidget::loadTraceFile()
+    {
+        QSettings settings;
+
+        const QString fileName = QFileDialog::getOpenFileName(this, "Open trace file", settings.value("core/tracer.trace-file-directory", QDir::homePath()).toString(), OPEN_TRACE_FILE_FILTER);
+
+        if ( fileName.isEmpty() )
+        {
+            return;
+        }
+
+        settings.setValue( "core/tracer.trace-file-directory", QFileInfo(fileName).absolutePath() );
+
+        if ( QFileInfo(fileName).suffix().toLower() != LINDWURM_TRACE_SUFFIX )
+        {
+            importTraceFile(fileName);
+            return;
+        }
+
+        CanFrameTracer* tracer = new CanFrameTracer(this);
+
+        // only the index is read, the records are mapped from the file
+        if ( ! tracer->openTraceFile(fileName) )
+        {
+            delete tracer;
+            QMessageBox::warning(this, "Open trace file", "The trace file '" + fileName + "' could not be opened.");
+            return;
+        }
+
+        replaceTracer(tracer);
+
+        m_saveAction->setEnabled(true);
+    }
+
+    void CanTracerWidget::importTraceFile(const QString &fileName)
+    {
+        CanFrameTracer* tracer = new CanFrameTracer(this);
+
+        // the frames are shown while the file is decoded in the background
+        if ( ! tracer->importTraceFile(fileName) )
+        {
+            delete tracer;
+            QMessageBox::warning(this, "Open trace file", "The trace file '" + fileName + "' could not be opened.");
+            return;
+        }
+
+        replaceTracer(tracer);
+
+        m_startAction->setEnabled(false);
+        m_openAction->setEnabled(false);
+        m_saveAction->setEnabled(false);
+
+        QProgressDialog *progressDialog = new QProgressDialog("Importing '" + QFileInfo(fileName).fileName() + "'", "Cancel", 0, IMPORT_PROGRESS_MAXIMUM, this);
+        progressDialog->setWindowTitle("Open trace file");
+        progressDialog->setAutoClose(false);
+        progressDialog->setAutoReset(false);
+        progressDialog->setMinimumDuration(0);
+
+        connect(progressDialog, &QProgressDialog::canceled, tracer, &CanFrameTracer::cancelImport);
+
+        connect(tracer, &CanFrameTracer::importProgress, progressDialog, [progressDialog](qint64 bytesRead, qint64 totalBytes)
+        {
+            if ( totalBytes > 0 )
+            {
+                progressDialog->setValue( int( bytesRead * IMPORT_PROGRESS_MAXIMUM / totalBytes ) );
+            }
+        });
+
+        connect(tracer, &CanFrameTracer::importFinished, this, [this, progressDialog, fileName](bool success)
+        {
+            const bool canceled = progressDialog->wasCanceled();
+
+            progressDialog->deleteLater();
+
+            m_startAction->setEnabled(true);
+            m_openAction->setEnabled(true);
+            m_saveAction->setEnabled(true);
+
+            if ( ! success && ! canceled )
+            {
+                QMessageBox::warning(this, "Open trace file", "The trace file '" + fileName + "' could not be read completely.");
+            }
+        });
+    }
+
+    void CanTracerWidget::saveTraceFile()
+    {
+        QSettings settings;
+        QString selectedFilter;
+
+        QString fileName = QFileDialog::getSaveFileName(this, "Save trace file", settings.value("core/tracer.trace-file-directory", QDir::homePath()).toString(), SAVE_TRACE_FILE_FILTER, &selectedFilter);
+
+        if ( fileName.isEmpty() )
+        {
+            return;
+        }
+
+        if ( QFileInfo(fileName).suffix().isEmpty() )
+        {
+            // take the suffix from the selected filter, e.g. "Vector ASC (*.asc)"
+            const int suffixStart = selectedFilter.indexOf("*.");
+            fileName += suffixStart < 0 ? QString(".") + LINDWURM_TRACE_SUFFIX : selectedFilter.mid(suffixStart + 1).remove(')');
+        }
+
+        settings.setValue( "core/tracer.trace-file-directory", QFileInfo(fileName).absolutePath() );
+
+        // other formats than the Lindwurm trace only keep the frames
+        const bool saved = QFileInfo(fileName).suffix().toLower() == LINDWURM_TRACE_SUFFIX ? m_tracer->saveTraceFile(fileName) : m_tracer->exportTraceFile(fileName);
+
+        if ( ! saved )
+        {
+            QMessageBox::warning(this, "Save trace file", "The trace could not be saved to '" + fileName + "'.");
+        }
     }
 
     void CanTracerWidget::applyViewFilter(bool addToRecentUsed)
@@ -387,14 +509,12 @@ namespace Lindwurm::Core
         ui->toolBar->addSeparator();
 
         m_openAction = ui->toolBar->addAction( ActiveTheme::icon("tool-tracer/open-trace"), "Open trace file");
-        // TODO: Implement me and enable action
-        m_openAction->setEnabled(false);
-        //connect(_openAction, &QAction::triggered, this, &CanTracerWidget::loadTraceFile);
+        m_openAction->setEnabled(true);
+        connect(m_openAction, &QAction::triggered, this, &CanTracerWidget::loadTraceFile);
 
         m_saveAction = ui->toolBar->addAction( ActiveTheme::icon("tool-tracer/save-trace"), "Save trace file");
         m_saveAction->setEnabled(false);
-        // TODO: Implement me
-        //connect(_saveAction, &QAction::triggered, this, &CanTracerWidget::saveActionTriggered);
+        connect(m_saveAction, &QAction::triggered, this, &CanTracerWidget::saveTraceFile);
 
         ui->toolBar->addSeparator();
 
@@ -501,6 +621,26 @@ namespace Lindwurm::Core
         ui->traceView->addAction(appendToFilterAction);
     }
 
+    void CanTracerWidget::replaceTracer(Lib::CanFrameTracer *tracer)
+    {
+        CanFrameTracer* oldTracer = m_tracer;
+
+        m_tracer = tracer;
+
+        if ( m_toggleViewModeAction->isChecked() )
+        {
+            setModel( new Lib::LinearCanFrameTracerModel(m_tracer, m_tracer)  );
+        }
+        else
+        {
+            setModel( new Lib::AggregatedCanFrameTracerModel(m_tracer, m_tracer)  );
+        }
+
+        resizeTraceViewColumnsToContents();
+
+        oldTracer->deleteLater();
+    }
+
     void CanTracerWidget::setModel(QAbstractItemModel *model)
     {
         if ( m_filterModel != nullptr )
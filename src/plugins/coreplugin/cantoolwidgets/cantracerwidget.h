@@ -64,6 +64,8 @@ namespace Lindwurm::Core
 
             void                            startTrace();
             void                            stopTrace();
+            void                            loadTraceFile();
+            void                            saveTraceFile();
 
             void                            applyViewFilter(bool addToRecentUsed);
             void                            clearViewFilter();
@@ -84,6 +86,8 @@ namespace Lindwurm::Core
 
             void                            setupToolBar();
             void                            setupContextMenu();
+            void                            importTraceFile(const QString &fileName);
+            void                            replaceTracer(Lib::CanFrameTracer *tracer);
             void                            setModel(QAbstractItemModel *model);
             void                            resizeTraceViewColumnsToContents();
 
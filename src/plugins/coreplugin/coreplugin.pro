@@ -30,6 +30,7 @@ SOURCES += \
     cantoolmanager.cpp \
     cantoolwidgets/caninterfacemanagerwidget.cpp \
     cantoolwidgets/cantracerwidget.cpp \
+    cantoolwidgets/cantraceritemdelegate.cpp \
     cantoolwidgets/loggerwidget.cpp \
     coreplugin.cpp \
     dialogs/aboutdialog.cpp \
@@ -56,6 +57,7 @@ HEADERS += \
     cantoolmanager.h \
     cantoolwidgets/caninterfacemanagerwidget.h \
     cantoolwidgets/cantracerwidget.h \
+    cantoolwidgets/cantraceritemdelegate.h \
     cantoolwidgets/loggerwidget.h \
     coreconstants.h \
     coreplugin_global.h \
@@ -62,6 +62,7 @@ namespace Lindwurm::Core
         ui->deviceBox->setEnabled(true);
 
         ui->localEchoCheckBox->setChecked(false);
+        ui->targetBusLoadBox->setValue(0);
 
         ui->canFDCheckBox->setChecked(false);
         ui->dataBitRateBox->setEnabled(false);
@@ -113,6 +114,7 @@ namespace Lindwurm::Core
         ui->bitRateBox->setCurrentText( QString::number( interfaceInfo.bitRate() ) );
 
         ui->localEchoCheckBox->setChecked( interfaceInfo.localEchoEnabled() );
+        ui->targetBusLoadBox->setValue( interfaceInfo.targetBusLoad() );
 
         if ( interfaceInfo.flexibleDataRateEnabled() == true )
         {
@@ -125,6 +127,12 @@ namespace Lindwurm::Core
             ui->dataBitRateBox->setCurrentText("2000000");
         }
 
+        // CAN FD can only be enabled, if the interface reports support for it
+        if ( interfaceInfo.interfaceType() != "bridge" )
+        {
+            ui->canFDCheckBox->setEnabled( interfaceInfo.supportsFlexibleDataRate() || interfaceInfo.flexibleDataRateEnabled() );
+        }
+
         show();
     }
 
@@ -176,6 +184,10 @@ namespace Lindwurm::Core
         if ( bridge )
         {
             bridgedInterfaceIDs = bridge->bridgedInterfaceIds();
+
+            // routing rules are not editable in this dialog, but must be kept when applying the configuration
+            m_routingRulesToEdit            = bridge->routingRules();
+            m_defaultRoutingActionToEdit    = bridge->defaultRoutingAction();
         }
 
         QList<CanInterfaceInfo> availableInterfaces = m_interfaceManager->availableInterfaces();
@@ -206,6 +218,9 @@ namespace Lindwurm::Core
         // set up the dialog in according to the selected interface type
         ui->deviceBox->clear();
 
+        // the device of a replay interface is the name of the trace file
+        ui->deviceBox->setEditable( interfaceType == "replay" );
+
         if ( interfaceType == "bridge" )
         {
             ui->deviceBox->setEnabled(false);
@@ -213,9 +228,11 @@ namespace Lindwurm::Core
             ui->canFDCheckBox->setEnabled(false);
             ui->dataBitRateBox->setEnabled(false);
             ui->localEchoCheckBox->setEnabled(false);
+            ui->targetBusLoadBox->setEnabled(false);
 
             ui->canFDCheckBox->setChecked(false);
             ui->localEchoCheckBox->setChecked(false);
+            ui->targetBusLoadBox->setValue(0);
             ui->bitRateBox->clear();
             ui->dataBitRateBox->clear();
 
@@ -243,6 +260,7 @@ namespace Lindwurm::Core
                 ui->dataBitRateBox->setEnabled(false);
             }
             ui->localEchoCheckBox->setEnabled(true);
+            ui->targetBusLoadBox->setEnabled(true);
 
             ui->bridgeInterfaceList->setEnabled(false);
 
@@ -347,9 +365,12 @@ namespace Lindwurm::Core
         config.interfaceType            = ui->interfaceTypeBox->currentText();
         config.device                   = ui->deviceBox->currentText();
         config.enableLocalEcho          = ui->localEchoCheckBox->isChecked();
+        config.targetBusLoad            = ui->targetBusLoadBox->value();
         config.enableFlexibleDataRate   = ui->canFDCheckBox->isChecked();
         config.bitRate                  = ui->bitRateBox->currentData().toInt();
         config.dataBitRate              = ui->dataBitRateBox->currentData().toInt();
+        config.routingRules             = m_routingRulesToEdit;
+        config.defaultRoutingAction     = m_defaultRoutingActionToEdit;
 
         int bridgeInterfaceCount = ui->bridgeInterfaceList->count();
 
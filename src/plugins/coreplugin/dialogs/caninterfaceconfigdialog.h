@@ -78,6 +78,8 @@ namespace Lindwurm::Core
             Lib::CanInterfaceManager*       m_interfaceManager;
             int                             m_interfaceAddCounter = { 1 };
             QString                         m_interfaceIdToEdit = { };
+            Lib::CanRoutingRules            m_routingRulesToEdit = { };
+            Lib::CanRoutingAction           m_defaultRoutingActionToEdit = { Lib::CanRoutingAction::Forward };
     };
 }
 
@@ -44,6 +44,9 @@ namespace Lindwurm::Core
         }
 
         ui->autoCreateSocketCAN->setChecked( settings.value("core/autoCreateSocketCAN", true).toBool() );
+        ui->tracerMaxFrames->setValue( settings.value("core/tracer.max-frames", 0).toInt() );
+        ui->tracerMaxMemory->setValue( settings.value("core/tracer.max-memory-mib", 0).toInt() );
+        ui->tracerSpillToDisk->setChecked( settings.value("core/tracer.spill-to-disk", false).toBool() );
     }
 
     GeneralSettingsWidget::~GeneralSettingsWidget()
@@ -59,6 +62,9 @@ namespace Lindwurm::Core
 
         settings.setValue("core/theme.dark", darkModeSetting);
         settings.setValue("core/autoCreateSocketCAN", ui->autoCreateSocketCAN->isChecked() );
+        settings.setValue("core/tracer.max-frames", ui->tracerMaxFrames->value() );
+        settings.setValue("core/tracer.max-memory-mib", ui->tracerMaxMemory->value() );
+        settings.setValue("core/tracer.spill-to-disk", ui->tracerSpillToDisk->isChecked() );
 
         // if dark mode setting is changed a restart is needed
         return (darkModeSetting != m_darkModeInitialSetting);